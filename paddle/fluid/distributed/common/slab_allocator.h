@@ -0,0 +1,303 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <glog/logging.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// Slab allocation of the float arrays held by sparse feature values.
+//
+// Every distinct array length gets its own size class, so the handful of
+// value sizes an accessor produces (with / without mf, one per mf_dim for
+// CtrDymfAccessor) are packed without per-value malloc headers. Blocks are
+// carved out of kPageSize aligned pages, and a page is handed back to the OS
+// as soon as its last block is released. BeginCompact/NeedMove/EndCompact let
+// the owner evacuate sparsely used pages after Shrink.
+//
+// One allocator belongs to one shard. Allocation mostly happens on the shard's
+// own task thread, the lock only guards against the rare cross-thread resize.
+class SlabAllocator {
+ public:
+  static constexpr size_t kPageSize = 256 * 1024;
+  // arrays larger than this go to malloc directly
+  static constexpr size_t kMaxBlockBytes = kPageSize / 16;
+
+  SlabAllocator() {}
+  SlabAllocator(const SlabAllocator&) = delete;
+  ~SlabAllocator() {
+    for (auto& size_class : _classes) {
+      for (Page* page : size_class.pages) {
+        free(page);
+      }
+    }
+  }
+
+  float* Allocate(size_t n) {
+    if (n == 0) {
+      return NULL;
+    }
+    size_t bytes = BlockBytes(n);
+    if (bytes > kMaxBlockBytes) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _large_bytes += bytes;
+      return static_cast<float*>(malloc(bytes));
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    SizeClass& size_class = GetClass(bytes);
+    Page* page = size_class.avail;
+    if (page == NULL) {
+      page = NewPage(&size_class, bytes);
+    }
+    Block* block = page->free_list;
+    if (block != NULL) {
+      page->free_list = block->next;
+    } else {
+      block = reinterpret_cast<Block*>(PageData(page) +
+                                       page->bump * size_class.block_bytes);
+      ++page->bump;
+    }
+    if (++page->live == page->capacity) {
+      Unlink(&size_class, page);
+    }
+    _live_bytes += size_class.block_bytes;
+    return reinterpret_cast<float*>(block);
+  }
+
+  void Deallocate(float* ptr, size_t n) {
+    if (ptr == NULL) {
+      return;
+    }
+    size_t bytes = BlockBytes(n);
+    if (bytes > kMaxBlockBytes) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _large_bytes -= bytes;
+      free(ptr);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    Page* page = PageOf(ptr);
+    SizeClass& size_class = _classes[page->class_idx];
+    bool was_full = page->live == page->capacity;
+    Block* block = reinterpret_cast<Block*>(ptr);
+    block->next = page->free_list;
+    page->free_list = block;
+    --page->live;
+    _live_bytes -= size_class.block_bytes;
+    if (page->live == 0 && (page->evacuating || size_class.pages.size() > 1)) {
+      ReleasePage(&size_class, page);
+    } else if (was_full && !page->evacuating) {
+      Link(&size_class, page);
+    }
+  }
+
+  // Marks the emptiest pages whose live blocks fit into the free space of the
+  // remaining pages of the same class, as long as their occupancy is below
+  // max_occupancy. Returns whether anything needs to be moved.
+  bool BeginCompact(double max_occupancy) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    bool need_move = false;
+    for (auto& size_class : _classes) {
+      std::vector<Page*> pages = size_class.pages;
+      std::sort(pages.begin(), pages.end(), [](Page* a, Page* b) {
+        return a->live < b->live;
+      });
+      size_t kept_free = 0;
+      for (Page* page : pages) {
+        kept_free += page->capacity - page->live;
+      }
+      size_t moving = 0;
+      for (Page* page : pages) {
+        if (page->live >= max_occupancy * page->capacity) {
+          break;
+        }
+        size_t spare = kept_free - (page->capacity - page->live);
+        if (moving + page->live > spare) {
+          break;
+        }
+        moving += page->live;
+        kept_free = spare;
+        page->evacuating = true;
+        Unlink(&size_class, page);
+        need_move = need_move || page->live > 0;
+      }
+    }
+    return need_move;
+  }
+
+  bool NeedMove(const float* ptr, size_t n) const {
+    if (ptr == NULL || BlockBytes(n) > kMaxBlockBytes) {
+      return false;
+    }
+    return PageOf(ptr)->evacuating;
+  }
+
+  void EndCompact() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& size_class : _classes) {
+      std::vector<Page*> pages = size_class.pages;
+      for (Page* page : pages) {
+        if (!page->evacuating) {
+          continue;
+        }
+        page->evacuating = false;
+        if (page->live == 0) {
+          ReleasePage(&size_class, page);
+        } else if (page->live < page->capacity) {
+          Link(&size_class, page);
+        }
+      }
+    }
+  }
+
+  // bytes handed out to values
+  size_t LiveBytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _live_bytes + _large_bytes;
+  }
+  // bytes held from the system
+  size_t ReservedBytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _page_num * kPageSize + _large_bytes;
+  }
+
+ private:
+  static constexpr size_t kHeaderBytes = 64;
+
+  struct Block {
+    Block* next;
+  };
+  struct Page {
+    Page* prev;  // links in the avail list of the class
+    Page* next;
+    Block* free_list;
+    size_t index;  // position in SizeClass::pages
+    uint32_t class_idx;
+    uint32_t capacity;
+    uint32_t live;
+    uint32_t bump;
+    bool evacuating;
+    bool linked;
+  };
+  static_assert(sizeof(Page) <= kHeaderBytes, "slab page header too large");
+
+  struct SizeClass {
+    size_t block_bytes;
+    Page* avail = NULL;  // pages with free blocks
+    std::vector<Page*> pages;
+  };
+
+  static size_t BlockBytes(size_t n) {
+    // 8 bytes granularity keeps the free list pointer aligned
+    return (n * sizeof(float) + 7) & ~static_cast<size_t>(7);
+  }
+  static Page* PageOf(const float* ptr) {
+    return reinterpret_cast<Page*>(reinterpret_cast<uintptr_t>(ptr) &
+                                   ~static_cast<uintptr_t>(kPageSize - 1));
+  }
+  static char* PageData(Page* page) {
+    return reinterpret_cast<char*>(page) + kHeaderBytes;
+  }
+
+  SizeClass& GetClass(size_t bytes) {
+    size_t slot = bytes / 8;
+    if (slot >= _class_index.size()) {
+      _class_index.resize(slot + 1, -1);
+    }
+    if (_class_index[slot] < 0) {
+      _class_index[slot] = static_cast<int>(_classes.size());
+      _classes.emplace_back();
+      _classes.back().block_bytes = bytes;
+    }
+    return _classes[_class_index[slot]];
+  }
+
+  Page* NewPage(SizeClass* size_class, size_t bytes) {
+    void* mem = NULL;
+    CHECK(posix_memalign(&mem, kPageSize, kPageSize) == 0)
+        << "slab page allocation failed";
+    Page* page = static_cast<Page*>(mem);
+    page->prev = NULL;
+    page->next = NULL;
+    page->free_list = NULL;
+    page->index = size_class->pages.size();
+    page->class_idx = static_cast<uint32_t>(size_class - _classes.data());
+    page->capacity = static_cast<uint32_t>((kPageSize - kHeaderBytes) / bytes);
+    page->live = 0;
+    page->bump = 0;
+    page->evacuating = false;
+    page->linked = false;
+    size_class->pages.push_back(page);
+    ++_page_num;
+    Link(size_class, page);
+    return page;
+  }
+
+  void ReleasePage(SizeClass* size_class, Page* page) {
+    Unlink(size_class, page);
+    Page* last = size_class->pages.back();
+    last->index = page->index;
+    size_class->pages[page->index] = last;
+    size_class->pages.pop_back();
+    --_page_num;
+    free(page);
+  }
+
+  void Link(SizeClass* size_class, Page* page) {
+    if (page->linked) {
+      return;
+    }
+    page->prev = NULL;
+    page->next = size_class->avail;
+    if (size_class->avail != NULL) {
+      size_class->avail->prev = page;
+    }
+    size_class->avail = page;
+    page->linked = true;
+  }
+
+  void Unlink(SizeClass* size_class, Page* page) {
+    if (!page->linked) {
+      return;
+    }
+    if (page->prev != NULL) {
+      page->prev->next = page->next;
+    } else {
+      size_class->avail = page->next;
+    }
+    if (page->next != NULL) {
+      page->next->prev = page->prev;
+    }
+    page->prev = NULL;
+    page->next = NULL;
+    page->linked = false;
+  }
+
+  mutable std::mutex _mutex;
+  std::vector<int> _class_index;  // block_bytes / 8 -> index in _classes
+  std::vector<SizeClass> _classes;
+  size_t _page_num = 0;
+  size_t _live_bytes = 0;
+  size_t _large_bytes = 0;
+};
+
+}  // namespace distributed
+}  // namespace paddle
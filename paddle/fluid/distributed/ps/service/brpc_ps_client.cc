@@ -15,6 +15,7 @@
 #include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
 
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
 
@@ -342,6 +343,13 @@ int32_t BrpcPsClient::Initialize() {
       _push_sparse_task_queue_map[table_id] =
           paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
+      const auto &table_param = worker_param.downpour_table_param(i);
+      if (table_param.has_wire_compress()) {
+        _sparse_pull_format_map[table_id] =
+            SparseWireFormat::ForPull(table_param.wire_compress());
+        _sparse_push_format_map[table_id] =
+            SparseWireFormat::ForPush(table_param.wire_compress());
+      }
     }
   }
 
@@ -378,6 +386,15 @@ int32_t BrpcPsClient::Initialize() {
   return 0;
 }
 
+const SparseWireFormat &BrpcPsClient::GetSparseWireFormat(size_t table_id,
+                                                         bool is_pull) {
+  static const SparseWireFormat raw_format;
+  auto &format_map =
+      is_pull ? _sparse_pull_format_map : _sparse_push_format_map;
+  auto itr = format_map.find(table_id);
+  return itr == format_map.end() ? raw_format : itr->second;
+}
+
 int DownpourBrpcClosure::check_response(size_t request_idx, int cmd_id) {
   if (_cntls[request_idx]->Failed()) {
     LOG(ERROR) << "resquest cmd_id:" << cmd_id
@@ -1000,6 +1017,28 @@ std::future<int32_t> BrpcPsClient::PushDenseParam(const Region *regions,
   return fut;
 }
 
+/*
+Compressed Push Content:
+|---keys (8*{num}B or varint delta)---|---num*ValueBytes(dim)---|
+*/
+static void EncodeSparsePushData(const SparseWireFormat &format,
+                                 const uint64_t *keys,
+                                 const float *const *values,
+                                 size_t num,
+                                 size_t dim,
+                                 std::string *push_data) {
+  push_data->clear();
+  format.EncodeKeys(keys, num, push_data);
+  size_t offset = push_data->size();
+  size_t value_bytes = format.ValueBytes(dim);
+  push_data->resize(offset + num * value_bytes);
+  char *push_data_ptr = &(*push_data)[offset];
+  for (size_t i = 0; i < num; ++i) {
+    format.EncodeValue(values[i], dim, push_data_ptr);
+    push_data_ptr += value_bytes;
+  }
+}
+
 std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     size_t table_id,
     const uint64_t *keys,
@@ -1029,6 +1068,7 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     }
   }
 
+  const auto &format = GetSparseWireFormat(table_id, false);
   for (size_t i = 0; i < num; ++i) {
     size_t pserver_idx = get_sparse_shard(shard_num, request_call_num, keys[i]);
     ids[pserver_idx].push_back(keys[i]);
@@ -1049,14 +1089,36 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
     auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
+    if (format.IsCompressed()) {
+      if (format.compress_key) {
+        // delta编码要求key有序, 重复key保持原有顺序
+        std::vector<size_t> order(kv_size);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+          return ids[shard_idx][a] < ids[shard_idx][b];
+        });
+        for (size_t i = 0; i < kv_size; ++i) {
+          kvs[i] = ids[shard_idx][order[i]];
+          value_ptr[i] = value_ptrs[shard_idx][order[i]];
+        }
+      }
+      push_request->add_params(format.Serialize());
+      EncodeSparsePushData(format,
+                           kvs.data(),
+                           value_ptr.data(),
+                           kv_size,
+                           accessor->GetAccessorInfo().update_dim,
+                           push_data);
+    } else {
+      push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
+      char *push_data_ptr = const_cast<char *>(push_data->data());
+      memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
+      push_data_ptr += kv_size * sizeof(uint64_t);
+
+      for (size_t i = 0; i < kv_size; ++i) {
+        memcpy(push_data_ptr, value_ptr[i], value_size);
+        push_data_ptr += value_size;
+      }
     }
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
@@ -1164,11 +1226,16 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   auto *accessor = GetTableAccessor(table_id);
 
   size_t value_size = accessor->GetAccessorInfo().select_size;
+  size_t value_dim = accessor->GetAccessorInfo().select_dim;
+  SparseWireFormat format = GetSparseWireFormat(table_id, true);
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, value_dim, format](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        size_t encoded_size = format.ValueBytes(value_dim);
+        std::vector<char> encoded_value(encoded_size);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
           if (closure->check_response(i, PS_PULL_SPARSE_TABLE) != 0) {
             ret = -1;
@@ -1189,13 +1256,19 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
             } else {
               last_key = kv_pair.first;
               last_value_data = kv_pair.second;
-              if (value_size !=
-                  io_buffer_itr.copy_and_forward(
-                      reinterpret_cast<void *>(last_value_data), value_size)) {
+              void *res_data = format.value_codec == SPARSE_VALUE_FP32
+                                   ? reinterpret_cast<void *>(last_value_data)
+                                   : encoded_value.data();
+              if (encoded_size !=
+                  io_buffer_itr.copy_and_forward(res_data, encoded_size)) {
                 LOG(WARNING) << "res data is lack or not in format";
                 ret = -1;
                 break;
               }
+              if (format.value_codec != SPARSE_VALUE_FP32) {
+                format.DecodeValue(
+                    encoded_value.data(), value_dim, last_value_data);
+              }
             }
           }
         }
@@ -1223,13 +1296,18 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
     request_buffer.append(reinterpret_cast<void *>(&is_training), sizeof(bool));
     std::vector<uint32_t> keys_counter;
     keys_counter.reserve(sorted_kv_size);
+    std::vector<uint64_t> request_keys;
 
     for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
       ++kv_request_count;
       uint32_t keys = 1;
       last_key = sorted_kvs[kv_idx].first;
-      request_buffer.append(reinterpret_cast<void *>(&last_key),
-                            sizeof(uint64_t));
+      if (format.compress_key) {
+        request_keys.push_back(last_key);
+      } else {
+        request_buffer.append(reinterpret_cast<void *>(&last_key),
+                              sizeof(uint64_t));
+      }
       while (kv_idx < sorted_kv_size - 1 &&
              last_key == sorted_kvs[kv_idx + 1].first) {
         ++kv_idx;
@@ -1238,8 +1316,16 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       keys_counter.push_back(keys);
     }
 
-    request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
-                          sizeof(uint32_t) * keys_counter.size());
+    if (format.compress_key) {
+      std::string keys_buffer;
+      format.EncodeKeys(request_keys.data(), request_keys.size(), &keys_buffer);
+      format.EncodeCounts(
+          keys_counter.data(), keys_counter.size(), &keys_buffer);
+      request_buffer.append(keys_buffer);
+    } else {
+      request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
+                            sizeof(uint32_t) * keys_counter.size());
+    }
 
     if (kv_request_count == 0) {
       closure->Run();
@@ -1249,6 +1335,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       closure->request(i)->set_client_id(_client_id);
       closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
                                       sizeof(uint32_t));
+      if (format.IsCompressed()) {
+        closure->request(i)->add_params(format.Serialize());
+      }
       PsService_Stub rpc_stub(GetCmdChannel(i));
       closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
       rpc_stub.service(
@@ -1258,6 +1347,68 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::PrefetchSparse(size_t table_id,
+                                                  const uint64_t *keys,
+                                                  size_t num) {
+  size_t request_call_num = _server_channels.size();
+  const auto &server_param = _config.server_param().downpour_server_param();
+  uint64_t shard_num = FLAGS_pserver_sparse_table_shard_num;
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.table_id() == table_id) {
+      shard_num = table_param.shard_num();
+      break;
+    }
+  }
+
+  std::vector<std::vector<uint64_t>> shard_keys(request_call_num);
+  for (size_t i = 0; i < num; ++i) {
+    size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
+    shard_keys[shard_id].push_back(keys[i]);
+  }
+
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [request_call_num](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        for (size_t i = 0; i < request_call_num; ++i) {
+          if (closure->check_response(i, PS_PREFETCH_SPARSE_TABLE) != 0) {
+            ret = -1;
+            break;
+          }
+        }
+        closure->set_promise_value(ret);
+      });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+
+  for (size_t i = 0; i < request_call_num; ++i) {
+    auto &request_keys = shard_keys[i];
+    std::sort(request_keys.begin(), request_keys.end());
+    request_keys.erase(std::unique(request_keys.begin(), request_keys.end()),
+                       request_keys.end());
+    uint32_t kv_request_count = request_keys.size();
+    if (kv_request_count == 0) {
+      closure->Run();
+      continue;
+    }
+    closure->request(i)->set_cmd_id(PS_PREFETCH_SPARSE_TABLE);
+    closure->request(i)->set_table_id(table_id);
+    closure->request(i)->set_client_id(_client_id);
+    closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
+                                    sizeof(uint32_t));
+    closure->request(i)->set_data(
+        reinterpret_cast<const char *>(request_keys.data()),
+        kv_request_count * sizeof(uint64_t));
+    PsService_Stub rpc_stub(GetCmdChannel(i));
+    closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
+  }
+  return fut;
+}
+
 // for GEO
 std::future<int32_t> BrpcPsClient::PullSparseParam(float **select_values,
                                                    size_t table_id,
@@ -1856,20 +2007,38 @@ int BrpcPsClient::PushSparseAsyncShardPush(
   push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
                            sizeof(uint32_t));  // NOLINT
   auto *push_data = push_request->mutable_data();
-  int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
-  for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
+  const auto &format = GetSparseWireFormat(table_id, false);
+  if (format.IsCompressed()) {
+    // merge后的key已排序去重
+    thread_local std::vector<const float *> merged_value_ptrs;
+    merged_value_ptrs.resize(merged_kv_count);
+    for (size_t i = 0; i < merged_kv_count; ++i) {
+      merged_value_ptrs[i] =
+          reinterpret_cast<const float *>(merged_value_list[i].data());
+    }
+    push_request->add_params(format.Serialize());
+    EncodeSparsePushData(format,
+                         merged_key_list.data(),
+                         merged_value_ptrs.data(),
+                         merged_kv_count,
+                         accessor->GetAccessorInfo().update_dim,
+                         push_data);
+  } else {
+    int update_size = accessor->GetAccessorInfo().update_size;
+    push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
+    char *push_data_ptr = const_cast<char *>(push_data->data());
     memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
+           merged_key_list.data(),
+           merged_kv_count * sizeof(uint64_t));
+    push_data_ptr += merged_kv_count * sizeof(uint64_t);
+    for (size_t i = 0; i < merged_kv_count; ++i) {
+      const char *task_data_ptr = merged_value_list[i].data();
+
+      memcpy(push_data_ptr,
+             (float *)(task_data_ptr),  // NOLINT
+             update_size);
+      push_data_ptr += update_size;
+    }
   }
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
@@ -26,6 +26,7 @@
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_wire_codec.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -266,6 +267,9 @@ class BrpcPsClient : public PSClient {
                                                const uint64_t *keys,
                                                size_t num,
                                                bool is_training);
+  virtual std::future<int32_t> PrefetchSparse(size_t table_id,
+                                              const uint64_t *keys,
+                                              size_t num);
 
   virtual std::future<int32_t> PrintTableStat(uint32_t table_id);
 
@@ -360,6 +364,10 @@ class BrpcPsClient : public PSClient {
   std::unordered_map<uint32_t, paddle::framework::Channel<SparseAsyncTask *>>
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
+  // sparse table 的压缩传输格式, 未配置 wire_compress 的表不在其中
+  std::unordered_map<uint32_t, SparseWireFormat> _sparse_pull_format_map;
+  std::unordered_map<uint32_t, SparseWireFormat> _sparse_push_format_map;
+  const SparseWireFormat &GetSparseWireFormat(size_t table_id, bool is_pull);
 
   std::thread _print_thread;
 
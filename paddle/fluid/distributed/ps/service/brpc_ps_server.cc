@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/sparse_wire_codec.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -193,6 +194,8 @@ int32_t BrpcPsService::Initialize() {
   _service_handler_map[PS_PUSH_DENSE_TABLE] = &BrpcPsService::PushDense;
   _service_handler_map[PS_PULL_SPARSE_TABLE] = &BrpcPsService::PullSparse;
   _service_handler_map[PS_PUSH_SPARSE_TABLE] = &BrpcPsService::PushSparse;
+  _service_handler_map[PS_PREFETCH_SPARSE_TABLE] =
+      &BrpcPsService::PrefetchSparse;
   _service_handler_map[PS_SAVE_ONE_TABLE] = &BrpcPsService::SaveOneTable;
   _service_handler_map[PS_SAVE_ALL_TABLE] = &BrpcPsService::SaveAllTable;
   _service_handler_map[PS_SHRINK_TABLE] = &BrpcPsService::ShrinkTable;
@@ -532,7 +535,34 @@ int32_t BrpcPsService::PullSparse(Table *table,
 
   auto value = PullSparseValue(num, dim);
 
-  value.DeserializeFromBytes(const_cast<void *>(data));
+  SparseWireFormat format;
+  if (request.params_size() > 1 && !format.Deserialize(request.params(1))) {
+    set_response_code(response, -1, "invalid sparse wire format");
+    return 0;
+  }
+  thread_local std::vector<uint64_t> keys;
+  thread_local std::vector<uint32_t> frequencies;
+  if (format.compress_key) {
+    /*
+    |---isTraining---|---varint keys delta---|---varint frequencies---|
+    */
+    const char *begin = reinterpret_cast<const char *>(data);
+    const char *end = begin + req_buffer_size;
+    keys.resize(num);
+    frequencies.resize(num);
+    begin = format.DecodeKeys(begin + sizeof(bool), end, num, keys.data());
+    if (begin != NULL) {
+      begin = format.DecodeCounts(begin, end, num, frequencies.data());
+    }
+    if (begin == NULL) {
+      set_response_code(response, -1, "pull sparse keys are malformed");
+      return 0;
+    }
+    value = PullSparseValue(keys, frequencies, dim);
+    value.is_training_ = reinterpret_cast<const bool *>(data)[0];
+  } else {
+    value.DeserializeFromBytes(const_cast<void *>(data));
+  }
 
   auto res_data = butil::get_object<std::vector<float>>();
   res_data->resize(num * dim);
@@ -543,12 +573,56 @@ int32_t BrpcPsService::PullSparse(Table *table,
   table->Pull(table_context);
   // table->PullSparse(res_data->data(), value);
 
-  cntl->response_attachment().append(reinterpret_cast<char *>(res_data->data()),
-                                     res_data->size() * sizeof(float));
+  if (format.value_codec != SPARSE_VALUE_FP32) {
+    size_t value_bytes = format.ValueBytes(dim);
+    thread_local std::string res_buffer;
+    res_buffer.resize(num * value_bytes);
+    for (size_t i = 0; i < num; ++i) {
+      format.EncodeValue(
+          res_data->data() + i * dim, dim, &res_buffer[i * value_bytes]);
+    }
+    cntl->response_attachment().append(res_buffer.data(), res_buffer.size());
+  } else {
+    cntl->response_attachment().append(
+        reinterpret_cast<char *>(res_data->data()),
+        res_data->size() * sizeof(float));
+  }
   butil::return_object(res_data);
   return 0;
 }
 
+int32_t BrpcPsService::PrefetchSparse(Table *table,
+                                      const PsRequestMessage &request,
+                                      PsResponseMessage &response,
+                                      brpc::Controller *cntl) {
+  platform::RecordEvent record_event(
+      "PsService->PrefetchSparse", platform::TracerEventType::Communication, 1);
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 1) {
+    set_response_code(response,
+                      -1,
+                      "PsRequestMessage.params is requeired at "
+                      "least 1 for num of sparse_key");
+    return 0;
+  }
+  const uint32_t num =
+      *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
+  /*
+  Prefetch Content:
+  |---keysData---|
+  |---8*{num}B---|
+  */
+  auto &prefetch_data = request.data();
+  if (prefetch_data.size() != num * sizeof(uint64_t)) {
+    set_response_code(response, -1, "prefetch sparse keys are malformed");
+    return 0;
+  }
+  // table只把预取任务排进shard线程, 不等预取完成
+  table->PrefetchSparse(
+      reinterpret_cast<const uint64_t *>(prefetch_data.data()), num);
+  return 0;
+}
+
 int32_t BrpcPsService::PushSparse(Table *table,
                                   const PsRequestMessage &request,
                                   PsResponseMessage &response,
@@ -582,6 +656,36 @@ int32_t BrpcPsService::PushSparse(Table *table,
   table_context.push_context.values =
       (const float *)(push_data.data() + sizeof(uint64_t) * num);
   table_context.num = num;
+  SparseWireFormat format;
+  if (request.params_size() > 1 && !format.Deserialize(request.params(1))) {
+    set_response_code(response, -1, "invalid sparse wire format");
+    return 0;
+  }
+  thread_local std::vector<uint64_t> keys;
+  thread_local std::vector<float> values;
+  if (format.IsCompressed()) {
+    /*
+    Compressed Push Content:
+    |---keys (8*{num}B or varint delta)---|---num*ValueBytes(dim)---|
+    */
+    size_t dim = table->ValueAccesor()->GetAccessorInfo().update_dim;
+    size_t value_bytes = format.ValueBytes(dim);
+    const char *begin = push_data.data();
+    const char *end = begin + push_data.size();
+    keys.resize(num);
+    begin = format.DecodeKeys(begin, end, num, keys.data());
+    if (begin == NULL ||
+        static_cast<size_t>(end - begin) != num * value_bytes) {
+      set_response_code(response, -1, "push sparse data is malformed");
+      return 0;
+    }
+    values.resize(num * dim);
+    for (size_t i = 0; i < num; ++i) {
+      format.DecodeValue(begin + i * value_bytes, dim, &values[i * dim]);
+    }
+    table_context.push_context.keys = keys.data();
+    table_context.push_context.values = values.data();
+  }
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
   // num);
@@ -493,11 +493,11 @@ void AsyncCommunicator::SendByCommunicator() {
   tasks.reserve(send_varname_to_ctx_.size());
 
   for (auto &iter : send_varname_to_ctx_) {
+    auto &ctx_name = iter.first;
     auto &ctx = iter.second;
 
-    auto send_recv_task = [this, &ctx] {
+    auto send_recv_task = [this, &ctx_name, &ctx] {
       auto &varnames = ctx.origin_varnames;
-      auto &table_id = ctx.table_id;
       size_t var_nums = varnames.size();
       auto &check_queue = send_varname_to_queue_[varnames[0]];
       std::vector<std::vector<std::shared_ptr<Variable>>> vars;
@@ -525,34 +525,79 @@ void AsyncCommunicator::SendByCommunicator() {
       }
       if (merged_var_num == 0) return;
 
+      // 流水线模式下每个batch merge到独立的scope,
+      // 发送的同时可以继续merge下一个batch
+      auto &pipeline = send_pipelines_.at(ctx_name);
+      std::shared_ptr<Scope> batch_scope;
+      Scope *merge_scope = send_scope_.get();
+      if (send_pipeline_depth_ > 0) {
+        batch_scope = AcquireBatchScope(&pipeline);
+        merge_scope = batch_scope.get();
+      }
+
+      auto merge_start = GetCurrentUS();
       for (size_t i = 0; i < var_nums; i++) {
         auto &var_name = varnames[i];
         if (var_name == STEP_COUNTER) {
-          MergeVars<int64_t>(var_name, vars[i], send_scope_.get(), 1);
+          MergeVars<int64_t>(var_name, vars[i], merge_scope, 1);
         } else {
-          MergeVars<float>(var_name, vars[i], send_scope_.get(), 1);
+          ParallelMergeVars<float>(var_name,
+                                   vars[i],
+                                   merge_scope,
+                                   merge_threadpool_.get(),
+                                   merge_thread_num_,
+                                   1);
         }
       }
-
-      if (ctx.is_tensor_table) {
-        SendGlobalStep(ctx, merged_var_num, send_scope_.get());
-      } else if (ctx.is_sparse) {
-        PADDLE_ENFORCE_EQ(
-            varnames.size(),
-            1,
-            platform::errors::InvalidArgument(
-                "sparse variables can only be merged by one variables"));
-        RpcSendSparse(varnames[0], table_id, *send_scope_);
-      } else {
-        RpcSendDense(ctx, *send_scope_);
-        if (!independent_recv_ &&
-            recv_varname_to_ctx_.find(table_id) != recv_varname_to_ctx_.end()) {
-          auto recv_varnames = recv_varname_to_ctx_.at(table_id);
-          RpcRecvDense(recv_varnames, table_id, recv_scope_);
+      merge_us_ += static_cast<int64_t>(GetCurrentUS() - merge_start);
+      ++merged_batch_num_;
+
+      auto send_task = [this, &ctx, merged_var_num, merge_scope] {
+        auto send_start = GetCurrentUS();
+        auto &varnames = ctx.origin_varnames;
+        auto &table_id = ctx.table_id;
+        if (ctx.is_tensor_table) {
+          SendGlobalStep(ctx, merged_var_num, merge_scope);
+        } else if (ctx.is_sparse) {
+          PADDLE_ENFORCE_EQ(
+              varnames.size(),
+              1,
+              platform::errors::InvalidArgument(
+                  "sparse variables can only be merged by one variables"));
+          RpcSendSparse(varnames[0], table_id, *merge_scope);
+        } else {
+          RpcSendDense(ctx, *merge_scope);
+          if (!independent_recv_ && recv_varname_to_ctx_.find(table_id) !=
+                                        recv_varname_to_ctx_.end()) {
+            auto recv_varnames = recv_varname_to_ctx_.at(table_id);
+            RpcRecvDense(recv_varnames, table_id, recv_scope_);
+          }
         }
-      }
-      if (independent_recv_) {
-        grad_num_.fetch_add(1, std::memory_order_relaxed);
+        if (independent_recv_) {
+          grad_num_.fetch_add(1, std::memory_order_relaxed);
+        }
+        send_us_ += static_cast<int64_t>(GetCurrentUS() - send_start);
+      };
+      if (send_pipeline_depth_ > 0) {
+        // dense的send之后会把参数recv到recv_scope_,
+        // 同一个ctx的send串行执行, merge仍然和send重叠
+        std::shared_future<void> prev_send;
+        if (!ctx.is_sparse && !ctx.is_tensor_table &&
+            !pipeline.sending.empty()) {
+          prev_send = pipeline.sending.back().first;
+        }
+        pipeline.sending.emplace_back(
+            pipeline_send_threadpool_
+                ->enqueue([prev_send, send_task = std::move(send_task)] {
+                  if (prev_send.valid()) {
+                    prev_send.wait();
+                  }
+                  send_task();
+                })
+                .share(),
+            batch_scope);
+      } else {
+        send_task();
       }
     };
     tasks.emplace_back(send_threadpool_->enqueue(std::move(send_recv_task)));
@@ -563,6 +608,62 @@ void AsyncCommunicator::SendByCommunicator() {
   return;
 }
 
+std::shared_ptr<Scope> AsyncCommunicator::AcquireBatchScope(
+    SendPipeline *pipeline) {
+  // back pressure: at most send_pipeline_depth_ batches of a var in flight
+  while (pipeline->sending.size() >=
+         static_cast<size_t>(send_pipeline_depth_)) {
+    auto &front = pipeline->sending.front();
+    auto wait_start = GetCurrentUS();
+    front.first.wait();
+    pipeline_wait_us_ += static_cast<int64_t>(GetCurrentUS() - wait_start);
+    pipeline->free_scopes.push_back(std::move(front.second));
+    pipeline->sending.pop_front();
+  }
+  if (pipeline->free_scopes.empty()) {
+    return std::make_shared<Scope>();
+  }
+  auto scope = std::move(pipeline->free_scopes.back());
+  pipeline->free_scopes.pop_back();
+  return scope;
+}
+
+void AsyncCommunicator::FlushSendPipeline() {
+  for (auto &iter : send_pipelines_) {
+    auto &pipeline = iter.second;
+    while (!pipeline.sending.empty()) {
+      pipeline.sending.front().first.wait();
+      pipeline.free_scopes.push_back(
+          std::move(pipeline.sending.front().second));
+      pipeline.sending.pop_front();
+    }
+  }
+}
+
+AsyncCommunicator::SendPipelineStat AsyncCommunicator::GetSendPipelineStat()
+    const {
+  SendPipelineStat stat;
+  stat.batch_num = merged_batch_num_.load();
+  stat.merge_us = merge_us_.load();
+  stat.send_us = send_us_.load();
+  stat.pipeline_wait_us = pipeline_wait_us_.load();
+  stat.queue_block_num = queue_block_num_.load();
+  stat.queue_block_us = queue_block_us_.load();
+  return stat;
+}
+
+void AsyncCommunicator::PrintSendPipelineStat() const {
+  auto stat = GetSendPipelineStat();
+  LOG(INFO) << "communicator send pipeline depth: " << send_pipeline_depth_
+            << " merge threads: " << merge_thread_num_
+            << " batches: " << stat.batch_num
+            << " merge: " << stat.merge_us / 1000 << " ms"
+            << " send: " << stat.send_us / 1000 << " ms"
+            << " pipeline wait: " << stat.pipeline_wait_us / 1000 << " ms"
+            << " send queue full: " << stat.queue_block_num << " times "
+            << stat.queue_block_us / 1000 << " ms";
+}
+
 void AsyncCommunicator::PushDensePostProcessing() {
   if (independent_recv_) {
     grad_num_.fetch_add(1, std::memory_order_relaxed);
@@ -582,6 +683,8 @@ void AsyncCommunicator::MainThread() {
     SendByCommunicator();
     RpcProfilerControl();
   }
+  FlushSendPipeline();
+  PrintSendPipelineStat();
   VLOG(1) << "communicator stopped, send thread exit";
 }
 
@@ -806,8 +909,21 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
           std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
               send_queue_size_);
     }
+    send_pipelines_[iter.first];
   }
   send_threadpool_ = std::make_unique<::ThreadPool>(thread_pool_size_);
+
+  send_pipeline_depth_ = std::max(FLAGS_communicator_send_pipeline_depth, 0);
+  merge_thread_num_ = std::max(FLAGS_communicator_merge_thread_num, 1);
+  if (send_pipeline_depth_ > 0) {
+    pipeline_send_threadpool_ =
+        std::make_unique<::ThreadPool>(thread_pool_size_);
+  }
+  if (merge_thread_num_ > 1) {
+    merge_threadpool_ = std::make_unique<::ThreadPool>(merge_thread_num_);
+  }
+  VLOG(1) << "AsyncCommunicator send pipeline depth: " << send_pipeline_depth_
+          << " merge thread num: " << merge_thread_num_;
 }
 
 AsyncCommunicator::~AsyncCommunicator() {
@@ -895,7 +1011,16 @@ void AsyncCommunicator::Send(const std::vector<std::string> &var_names,
     auto *var = scope.FindVar(var_name);
     auto tmp_grad_var = std::make_shared<Variable>();
     framework::CopyVariable(*var, tmp_grad_var.get());
-    send_varname_to_queue_[var_name]->Push(tmp_grad_var);
+    auto &var_queue = send_varname_to_queue_[var_name];
+    if (var_queue->Size() >= var_queue->Cap()) {
+      // 发送跟不上训练, 记录trainer被阻塞的时间
+      auto block_start = GetCurrentUS();
+      var_queue->Push(tmp_grad_var);
+      ++queue_block_num_;
+      queue_block_us_ += static_cast<int64_t>(GetCurrentUS() - block_start);
+    } else {
+      var_queue->Push(tmp_grad_var);
+    }
   }
 }
 
@@ -969,12 +1094,20 @@ void HalfAsyncCommunicator::SendByCommunicator() {
 
       std::vector<std::vector<std::shared_ptr<Variable>>> vars;
       vars.resize(var_nums);
+      auto merge_start = GetCurrentUS();
       for (size_t i = 0; i < var_nums; i++) {
         auto &var_name = varnames[i];
         auto &var_queue = send_varname_to_queue_[var_name];
         for (int j = 0; j < batches; j++) vars[i].push_back(var_queue->Pop());
-        MergeVars<float>(var_name, vars[i], send_scope_.get(), 1);
+        ParallelMergeVars<float>(var_name,
+                                 vars[i],
+                                 send_scope_.get(),
+                                 merge_threadpool_.get(),
+                                 merge_thread_num_,
+                                 1);
       }
+      merge_us_ += static_cast<int64_t>(GetCurrentUS() - merge_start);
+      ++merged_batch_num_;
 
       if (ctx.is_sparse) {
         PADDLE_ENFORCE_EQ(
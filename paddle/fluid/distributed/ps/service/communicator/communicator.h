@@ -17,8 +17,10 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
+#include <future>  // NOLINT
 #include <map>
 #include <memory>
 #include <numeric>
@@ -54,6 +56,8 @@ struct CommContext;
 }  // namespace paddle
 
 PHI_DECLARE_bool(communicator_is_sgd_optimizer);
+PHI_DECLARE_int32(communicator_send_pipeline_depth);
+PHI_DECLARE_int32(communicator_merge_thread_num);
 
 namespace paddle {
 namespace distributed {
@@ -228,6 +232,137 @@ inline void MergeVars(const std::string &var_name,
   }
 }
 
+// MergeVars on the threads of pool. Dense tensors are summed range by range,
+// SelectedRows are hash merged in thread_num shards of row id, so the merged
+// rows are not sorted.
+template <typename T>
+inline void ParallelMergeVars(
+    const std::string &var_name,
+    const std::vector<std::shared_ptr<Variable>> &vars,
+    Scope *scope,
+    ::ThreadPool *pool,
+    int thread_num,
+    bool merge_add = true) {
+  if (pool == nullptr || thread_num <= 1 || vars.size() <= 1) {
+    MergeVars<T>(var_name, vars, scope, merge_add);
+    return;
+  }
+  auto cpu_place = platform::CPUPlace();
+  auto &var0 = vars[0];
+  auto *out_var = scope->Var(var_name);
+  std::vector<std::future<void>> tasks;
+
+  if (var0->IsType<phi::DenseTensor>()) {
+    auto dims = var0->Get<phi::DenseTensor>().dims();
+    for (auto &var : vars) {
+      PADDLE_ENFORCE_EQ(
+          var->Get<phi::DenseTensor>().dims(),
+          dims,
+          platform::errors::InvalidArgument("vars should have the same dims."));
+    }
+    auto *out_t = out_var->GetMutable<phi::DenseTensor>();
+    T *out = out_t->mutable_data<T>(dims, cpu_place);
+    int64_t numel = out_t->numel();
+    int64_t chunk = (numel + thread_num - 1) / thread_num;
+    for (int64_t begin = 0; begin < numel; begin += chunk) {
+      int64_t end = std::min(numel, begin + chunk);
+      tasks.emplace_back(pool->enqueue([&, begin, end] {
+        std::fill(out + begin, out + end, static_cast<T>(0));
+        for (auto &var : vars) {
+          const T *in = var->Get<phi::DenseTensor>().data<T>();
+          for (int64_t i = begin; i < end; ++i) {
+            out[i] += in[i];
+          }
+        }
+        if (!merge_add) {
+          for (int64_t i = begin; i < end; ++i) {
+            out[i] /= static_cast<T>(vars.size());
+          }
+        }
+      }));
+    }
+    for (auto &task : tasks) {
+      task.wait();
+    }
+    VLOG(3) << "parallel merge " << var_name << " LoDTensor dims " << dims
+            << "; merge add: " << merge_add;
+  } else if (var0->IsType<phi::SelectedRows>()) {
+    auto &slr0 = var0->Get<phi::SelectedRows>();
+    int64_t width = 0;
+    for (auto &var : vars) {
+      auto &slr = var->Get<phi::SelectedRows>();
+      if (!slr.rows().empty()) {
+        width = slr.value().dims()[1];
+        break;
+      }
+    }
+    struct RowShard {
+      std::unordered_map<int64_t, size_t> index;
+      std::vector<int64_t> rows;
+      std::vector<T> values;
+    };
+    std::vector<RowShard> shards(thread_num);
+    for (int shard_id = 0; shard_id < thread_num; ++shard_id) {
+      tasks.emplace_back(pool->enqueue([&, shard_id] {
+        auto &shard = shards[shard_id];
+        for (auto &var : vars) {
+          auto &slr = var->Get<phi::SelectedRows>();
+          auto &rows = slr.rows();
+          if (rows.empty()) {
+            continue;
+          }
+          const T *in = slr.value().data<T>();
+          for (size_t i = 0; i < rows.size(); ++i) {
+            if (static_cast<uint64_t>(rows[i]) % thread_num !=
+                static_cast<uint64_t>(shard_id)) {
+              continue;
+            }
+            auto ret = shard.index.emplace(rows[i], shard.rows.size());
+            if (ret.second) {
+              shard.rows.push_back(rows[i]);
+              shard.values.resize(shard.values.size() + width, 0);
+            }
+            T *out = shard.values.data() + ret.first->second * width;
+            const T *row_in = in + i * width;
+            for (int64_t j = 0; j < width; ++j) {
+              out[j] += row_in[j];
+            }
+          }
+        }
+      }));
+    }
+    for (auto &task : tasks) {
+      task.wait();
+    }
+
+    size_t row_num = 0;
+    for (auto &shard : shards) {
+      row_num += shard.rows.size();
+    }
+    auto *out_slr = out_var->GetMutable<phi::SelectedRows>();
+    out_slr->set_height(slr0.height());
+    auto *out_rows = out_slr->mutable_rows();
+    out_rows->clear();
+    out_rows->reserve(row_num);
+    T *out = out_slr->mutable_value()->mutable_data<T>(
+        phi::make_ddim({static_cast<int64_t>(row_num), width}), cpu_place);
+    T scale = merge_add ? static_cast<T>(1) : static_cast<T>(vars.size());
+    for (auto &shard : shards) {
+      out_rows->insert(out_rows->end(), shard.rows.begin(), shard.rows.end());
+      for (size_t i = 0; i < shard.values.size(); ++i) {
+        out[i] = shard.values[i] / scale;
+      }
+      out += shard.values.size();
+    }
+    VLOG(3) << "parallel merge " << var_name << " SelectedRows height: "
+            << slr0.height() << " rows: " << row_num
+            << "; merge add: " << merge_add;
+  } else {
+    PADDLE_THROW(platform::errors::InvalidArgument("unsupported var type: %s!",
+                                                   var0->Type()));
+  }
+}
+
 using RpcCtxMap = std::unordered_map<std::string, CommContext>;
 using RecvCtxMap = std::unordered_map<uint64_t, std::vector<std::string>>;
 using SparseValue = std::unordered_map<int64_t, std::vector<float>>;
@@ -497,11 +632,49 @@ class AsyncCommunicator : public Communicator {
                                  const phi::DenseTensor *clicks,
                                  std::vector<phi::DenseTensor *> *outputs);
 
+  // accumulated time (us) of the send path since Start
+  struct SendPipelineStat {
+    int64_t batch_num;
+    int64_t merge_us;
+    int64_t send_us;
+    // merge stage waiting for a batch of the same var to finish sending
+    int64_t pipeline_wait_us;
+    // trainer threads blocked in Send on a full send queue
+    int64_t queue_block_num;
+    int64_t queue_block_us;
+  };
+  SendPipelineStat GetSendPipelineStat() const;
+  void PrintSendPipelineStat() const;
+
  protected:
+  // merged batches of one send ctx still being sent, at most
+  // send_pipeline_depth_ of them. Only touched by the task of that ctx.
+  // The send of a dense ctx waits for the previous one of the same ctx,
+  // since it receives the parameters into recv_scope_ afterwards.
+  struct SendPipeline {
+    std::deque<std::pair<std::shared_future<void>, std::shared_ptr<Scope>>>
+        sending;
+    std::vector<std::shared_ptr<Scope>> free_scopes;
+  };
+  std::shared_ptr<Scope> AcquireBatchScope(SendPipeline *pipeline);
+  void FlushSendPipeline();
+
   std::unordered_map<std::string,
                      std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
       send_varname_to_queue_;
   std::unique_ptr<::ThreadPool> send_threadpool_{nullptr};
+  std::unordered_map<std::string, SendPipeline> send_pipelines_;
+  std::unique_ptr<::ThreadPool> pipeline_send_threadpool_{nullptr};
+  std::unique_ptr<::ThreadPool> merge_threadpool_{nullptr};
+  int send_pipeline_depth_ = 0;
+  int merge_thread_num_ = 1;
+
+  std::atomic<int64_t> merged_batch_num_{0};
+  std::atomic<int64_t> merge_us_{0};
+  std::atomic<int64_t> send_us_{0};
+  std::atomic<int64_t> pipeline_wait_us_{0};
+  std::atomic<int64_t> queue_block_num_{0};
+  std::atomic<int64_t> queue_block_us_{0};
 
   int min_send_grad_num_before_recv_;
   int thread_pool_size_;
@@ -149,6 +149,18 @@ class PSClient {
     return fut;
   }
 
+  // 通知server把keys从ssd预取到内存, 一般是下一个batch的keys
+  // 请求发出后keys缓冲区即可复用, server不等预取完成就返回
+  virtual std::future<int32_t> PrefetchSparse(size_t table_id UNUSED,
+                                              const uint64_t *keys UNUSED,
+                                              size_t num UNUSED) {
+    VLOG(0) << "Did not implement";
+    std::promise<int32_t> promise;
+    std::future<int> fut = promise.get_future();
+    promise.set_value(-1);
+    return fut;
+  }
+
   virtual ::std::future<int32_t> PullSparsePtr(
       int shard_id UNUSED,
       char **select_values UNUSED,
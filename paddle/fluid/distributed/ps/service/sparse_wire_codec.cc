@@ -0,0 +1,286 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_wire_codec.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "glog/logging.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+static uint8_t ParseValueCodec(const std::string &name) {
+  if (name == "fp32") {
+    return SPARSE_VALUE_FP32;
+  } else if (name == "fp16") {
+    return SPARSE_VALUE_FP16;
+  } else if (name == "bf16") {
+    return SPARSE_VALUE_BF16;
+  } else if (name == "int8") {
+    return SPARSE_VALUE_INT8;
+  }
+  LOG(WARNING) << "unknown sparse wire value type: " << name
+               << ", fall back to fp32";
+  return SPARSE_VALUE_FP32;
+}
+
+SparseWireFormat SparseWireFormat::ForPull(
+    const SparseWireCompressParameter &param) {
+  SparseWireFormat format;
+  format.compress_key = param.compress_key() ? 1 : 0;
+  format.value_codec = ParseValueCodec(param.pull_value_type());
+  format.raw_dim = static_cast<uint16_t>(param.pull_raw_dim());
+  return format;
+}
+
+SparseWireFormat SparseWireFormat::ForPush(
+    const SparseWireCompressParameter &param) {
+  SparseWireFormat format;
+  format.compress_key = param.compress_key() ? 1 : 0;
+  format.value_codec = ParseValueCodec(param.push_value_type());
+  format.raw_dim = static_cast<uint16_t>(param.push_raw_dim());
+  return format;
+}
+
+std::string SparseWireFormat::Serialize() const {
+  std::string data(4, '\0');
+  data[0] = static_cast<char>(compress_key);
+  data[1] = static_cast<char>(value_codec);
+  memcpy(&data[2], &raw_dim, sizeof(uint16_t));
+  return data;
+}
+
+bool SparseWireFormat::Deserialize(const std::string &data) {
+  if (data.size() != 4 ||
+      static_cast<uint8_t>(data[1]) > SPARSE_VALUE_INT8) {
+    return false;
+  }
+  compress_key = static_cast<uint8_t>(data[0]);
+  value_codec = static_cast<uint8_t>(data[1]);
+  memcpy(&raw_dim, &data[2], sizeof(uint16_t));
+  return true;
+}
+
+size_t SparseWireFormat::ValueBytes(size_t dim) const {
+  size_t raw = std::min<size_t>(raw_dim, dim);
+  size_t rest = dim - raw;
+  switch (value_codec) {
+    case SPARSE_VALUE_FP16:
+    case SPARSE_VALUE_BF16:
+      return raw * sizeof(float) + rest * sizeof(uint16_t);
+    case SPARSE_VALUE_INT8:
+      return raw * sizeof(float) + (rest > 0 ? sizeof(float) + rest : 0);
+    default:
+      return dim * sizeof(float);
+  }
+}
+
+static void AppendVarint(uint64_t value, std::string *out) {
+  char buf[10];
+  size_t len = 0;
+  while (value >= 0x80) {
+    buf[len++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  buf[len++] = static_cast<char>(value);
+  out->append(buf, len);
+}
+
+static const char *ReadVarint(const char *begin,
+                              const char *end,
+                              uint64_t *value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && begin < end; shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(*begin++);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return begin;
+    }
+  }
+  return NULL;
+}
+
+void SparseWireFormat::EncodeKeys(const uint64_t *keys,
+                                  size_t num,
+                                  std::string *out) const {
+  if (!compress_key) {
+    out->append(reinterpret_cast<const char *>(keys), num * sizeof(uint64_t));
+    return;
+  }
+  // feasigns of one request are close after sorting, most deltas fit in
+  // 2 ~ 4 bytes instead of 8
+  uint64_t last_key = 0;
+  for (size_t i = 0; i < num; ++i) {
+    CHECK(keys[i] >= last_key) << "compressed keys must be sorted";
+    AppendVarint(keys[i] - last_key, out);
+    last_key = keys[i];
+  }
+}
+
+void SparseWireFormat::EncodeCounts(const uint32_t *counts,
+                                    size_t num,
+                                    std::string *out) const {
+  if (!compress_key) {
+    out->append(reinterpret_cast<const char *>(counts),
+                num * sizeof(uint32_t));
+    return;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    AppendVarint(counts[i], out);
+  }
+}
+
+const char *SparseWireFormat::DecodeKeys(const char *begin,
+                                         const char *end,
+                                         size_t num,
+                                         uint64_t *keys) const {
+  if (!compress_key) {
+    size_t bytes = num * sizeof(uint64_t);
+    if (static_cast<size_t>(end - begin) < bytes) {
+      return NULL;
+    }
+    memcpy(keys, begin, bytes);
+    return begin + bytes;
+  }
+  uint64_t last_key = 0;
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t delta = 0;
+    begin = ReadVarint(begin, end, &delta);
+    if (begin == NULL) {
+      return NULL;
+    }
+    last_key += delta;
+    keys[i] = last_key;
+  }
+  return begin;
+}
+
+const char *SparseWireFormat::DecodeCounts(const char *begin,
+                                           const char *end,
+                                           size_t num,
+                                           uint32_t *counts) const {
+  if (!compress_key) {
+    size_t bytes = num * sizeof(uint32_t);
+    if (static_cast<size_t>(end - begin) < bytes) {
+      return NULL;
+    }
+    memcpy(counts, begin, bytes);
+    return begin + bytes;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t count = 0;
+    begin = ReadVarint(begin, end, &count);
+    if (begin == NULL) {
+      return NULL;
+    }
+    counts[i] = static_cast<uint32_t>(count);
+  }
+  return begin;
+}
+
+static uint16_t FloatToBf16(float value) {
+  uint32_t bits = 0;
+  memcpy(&bits, &value, sizeof(float));
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40);  // quiet nan
+  }
+  // round to nearest even, truncation would bias the pushed gradients
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+static float Bf16ToFloat(uint16_t value) {
+  uint32_t bits = static_cast<uint32_t>(value) << 16;
+  float ret = 0;
+  memcpy(&ret, &bits, sizeof(float));
+  return ret;
+}
+
+void SparseWireFormat::EncodeValue(const float *value,
+                                   size_t dim,
+                                   char *out) const {
+  if (value_codec == SPARSE_VALUE_FP32) {
+    memcpy(out, value, dim * sizeof(float));
+    return;
+  }
+  size_t raw = std::min<size_t>(raw_dim, dim);
+  memcpy(out, value, raw * sizeof(float));
+  out += raw * sizeof(float);
+  if (value_codec == SPARSE_VALUE_FP16) {
+    for (size_t i = raw; i < dim; ++i, out += sizeof(uint16_t)) {
+      uint16_t x = phi::dtype::float16(value[i]).x;
+      memcpy(out, &x, sizeof(uint16_t));
+    }
+  } else if (value_codec == SPARSE_VALUE_BF16) {
+    for (size_t i = raw; i < dim; ++i, out += sizeof(uint16_t)) {
+      uint16_t x = FloatToBf16(value[i]);
+      memcpy(out, &x, sizeof(uint16_t));
+    }
+  } else if (raw < dim) {
+    float max_abs = 0;
+    for (size_t i = raw; i < dim; ++i) {
+      max_abs = std::max(max_abs, fabsf(value[i]));
+    }
+    float scale = max_abs / 127.0f;
+    memcpy(out, &scale, sizeof(float));
+    out += sizeof(float);
+    float inv_scale = scale > 0 ? 1.0f / scale : 0;
+    for (size_t i = raw; i < dim; ++i) {
+      float code = roundf(value[i] * inv_scale);
+      *out++ = static_cast<char>(
+          static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, code))));
+    }
+  }
+}
+
+void SparseWireFormat::DecodeValue(const char *in,
+                                   size_t dim,
+                                   float *value) const {
+  if (value_codec == SPARSE_VALUE_FP32) {
+    memcpy(value, in, dim * sizeof(float));
+    return;
+  }
+  size_t raw = std::min<size_t>(raw_dim, dim);
+  memcpy(value, in, raw * sizeof(float));
+  in += raw * sizeof(float);
+  if (value_codec == SPARSE_VALUE_FP16) {
+    phi::dtype::float16 x;
+    for (size_t i = raw; i < dim; ++i, in += sizeof(uint16_t)) {
+      memcpy(&x.x, in, sizeof(uint16_t));
+      value[i] = static_cast<float>(x);
+    }
+  } else if (value_codec == SPARSE_VALUE_BF16) {
+    uint16_t x = 0;
+    for (size_t i = raw; i < dim; ++i, in += sizeof(uint16_t)) {
+      memcpy(&x, in, sizeof(uint16_t));
+      value[i] = Bf16ToFloat(x);
+    }
+  } else if (raw < dim) {
+    float scale = 0;
+    memcpy(&scale, in, sizeof(float));
+    in += sizeof(float);
+    for (size_t i = raw; i < dim; ++i) {
+      value[i] = static_cast<int8_t>(*in++) * scale;
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
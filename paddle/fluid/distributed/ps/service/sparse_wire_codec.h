@@ -0,0 +1,83 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+enum SparseValueCodec {
+  SPARSE_VALUE_FP32 = 0,
+  SPARSE_VALUE_FP16 = 1,
+  SPARSE_VALUE_BF16 = 2,
+  // int8 codes with one fp32 scale (max abs / 127) per value
+  SPARSE_VALUE_INT8 = 3,
+};
+
+// Encoding of the keys and values of one sparse pull/push request.
+//
+// The client builds it from TableParameter.wire_compress and sends it in
+// params(1) of the request, BrpcPsService decodes the request and encodes the
+// pull response with the same format. Requests without params(1) keep the
+// plain uint64 key / fp32 value layout.
+//
+// Compressed keys must be non-decreasing, they are written as varint deltas.
+// The first raw_dim floats of every value stay fp32 so show/click counters
+// and slot ids survive quantization.
+struct SparseWireFormat {
+  uint8_t compress_key = 0;
+  uint8_t value_codec = SPARSE_VALUE_FP32;
+  uint16_t raw_dim = 0;
+
+  static SparseWireFormat ForPull(const SparseWireCompressParameter &param);
+  static SparseWireFormat ForPush(const SparseWireCompressParameter &param);
+
+  bool IsCompressed() const {
+    return compress_key != 0 || value_codec != SPARSE_VALUE_FP32;
+  }
+
+  std::string Serialize() const;
+  bool Deserialize(const std::string &data);
+
+  // encoded bytes of one value of dim floats
+  size_t ValueBytes(size_t dim) const;
+
+  // appends the encoded keys / pull frequencies to out
+  void EncodeKeys(const uint64_t *keys, size_t num, std::string *out) const;
+  void EncodeCounts(const uint32_t *counts,
+                    size_t num,
+                    std::string *out) const;
+  // returns the end of the decoded bytes, NULL when data is malformed
+  const char *DecodeKeys(const char *begin,
+                         const char *end,
+                         size_t num,
+                         uint64_t *keys) const;
+  const char *DecodeCounts(const char *begin,
+                           const char *end,
+                           size_t num,
+                           uint32_t *counts) const;
+
+  // out / in hold ValueBytes(dim) bytes
+  void EncodeValue(const float *value, size_t dim, char *out) const;
+  void DecodeValue(const char *in, size_t dim, float *value) const;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -123,6 +123,8 @@ class ValueAccessor {
   virtual bool SaveSSD(float* value) = 0;
   // 判断热启时是否过滤slot对应的feasign
   virtual bool FilterSlot(float* value UNUSED) { return false; }
+  // 热度分数，用于ssd table决定value留在内存还是落到ssd
+  virtual float HotScore(float* value UNUSED) { return 0.0; }
 
   //
   virtual bool SaveCache(float* value,
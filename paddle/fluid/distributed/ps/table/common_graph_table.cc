@@ -34,6 +34,7 @@
 
 PHI_DECLARE_bool(graph_load_in_parallel);
 PHI_DECLARE_bool(graph_get_neighbor_id);
+PHI_DECLARE_bool(graph_edges_in_csr);
 PHI_DECLARE_int32(gpugraph_storage_mode);
 PHI_DECLARE_uint64(gpugraph_slot_feasign_max_num);
 PHI_DECLARE_bool(graph_metapath_split_opt);
@@ -1150,6 +1151,48 @@ void GraphShard::clear() {
   }
   bucket.clear();
   node_location.clear();
+  csr_edges.reset();
+}
+
+void GraphShard::freeze_edges(const std::string &sample_type) {
+  size_t edge_num = 0;
+  for (auto node : bucket) {
+    edge_num += node->get_neighbor_size();
+  }
+  std::unique_ptr<GraphCSRStorage> storage(new GraphCSRStorage(sample_type));
+  storage->reserve(bucket.size(), edge_num);
+  for (size_t i = 0; i < bucket.size(); i++) {
+    Node *node = bucket[i];
+    size_t neighbor_size = node->get_neighbor_size();
+    for (size_t j = 0; j < neighbor_size; j++) {
+      storage->add_edge(node->get_neighbor_id(j),
+                        node->get_neighbor_weight(j));
+    }
+    uint32_t row = storage->finish_row();
+    bucket[i] = new CSRGraphNode(node->get_id(), storage.get(), row);
+    delete node;
+  }
+  storage->shrink_to_fit();
+  csr_edges = std::move(storage);
+}
+
+GraphNode *GraphShard::unpack_node(int pos) {
+  if (is_frozen()) {
+    CSRGraphNode *packed = dynamic_cast<CSRGraphNode *>(bucket[pos]);
+    if (packed != nullptr) {
+      bucket[pos] = packed->unpack();
+      delete packed;
+    }
+  }
+  return reinterpret_cast<GraphNode *>(bucket[pos]);
+}
+
+void GraphShard::unpack_all_nodes() {
+  if (!is_frozen()) return;
+  for (size_t i = 0; i < bucket.size(); i++) {
+    unpack_node(i);
+  }
+  csr_edges.reset();
 }
 
 GraphShard::~GraphShard() { clear(); }
@@ -1171,7 +1214,8 @@ GraphNode *GraphShard::add_graph_node(uint64_t id) {
     node_location[id] = bucket.size();
     bucket.push_back(new GraphNode(id));
   }
-  return reinterpret_cast<GraphNode *>(bucket[node_location[id]]);
+  // the caller may add edges, which a packed node can not take
+  return unpack_node(node_location[id]);
 }
 
 GraphNode *GraphShard::add_graph_node(Node *node) {
@@ -1197,7 +1241,9 @@ FeatureNode *GraphShard::add_feature_node(uint64_t id, bool is_overlap) {
 }
 
 void GraphShard::add_neighbor(uint64_t id, uint64_t dst_id, float weight) {
-  find_node(id)->add_edge(dst_id, weight);
+  auto iter = node_location.find(id);
+  if (iter == node_location.end()) return;
+  unpack_node(iter->second)->add_edge(dst_id, weight);
 }
 
 Node *GraphShard::find_node(uint64_t id) {
@@ -1840,13 +1886,26 @@ int32_t GraphTable::load_edges(const std::string &path,
     // In order not to affect the sampler function of other scenario,
     // this optimization is only performed in load_edges function.
     VLOG(0) << "run in gpugraph mode!";
+  } else if (FLAGS_graph_edges_in_csr) {
+    VLOG(0) << "freeze edges into csr storage ... ";
+    std::vector<std::future<size_t>> tasks;
+    for (auto &shard : edge_shards[idx]) {
+      tasks.push_back(
+          load_node_edge_task_pool->enqueue([&shard, this]() -> size_t {
+            shard->freeze_edges(node_sampler_type);
+            return shard->get_csr_memory_size();
+          }));
+    }
+    size_t csr_bytes = 0;
+    for (auto &task : tasks) csr_bytes += task.get();
+    VLOG(0) << "edge_type[" << edge_type << "] csr storage takes " << csr_bytes
+            << " bytes";
   } else {
-    std::string sample_type = "random";
-    VLOG(0) << "build sampler ... ";
+    VLOG(0) << "build " << node_sampler_type << " sampler ... ";
     for (auto &shard : edge_shards[idx]) {
       auto bucket = shard->get_bucket();
       for (auto item : bucket) {
-        item->build_sampler(sample_type);
+        item->build_sampler(node_sampler_type);
       }
     }
   }
@@ -2006,7 +2065,11 @@ int32_t GraphTable::random_sample_neighbors(
       LRUResponse response = LRUResponse::blocked;
       if (use_cache) {
         response =
-            scaled_lru->query(i, id_list[i].data(), id_list[i].size(), r);
+            clock_cache != nullptr
+                ? clock_cache->query(
+                      i, id_list[i].data(), id_list[i].size(), r)
+                : scaled_lru->query(
+                      i, id_list[i].data(), id_list[i].size(), r);
       }
       size_t index = 0;
       std::vector<SampleResult> sample_res;
@@ -2070,8 +2133,13 @@ int32_t GraphTable::random_sample_neighbors(
         }
       }
       if (!sample_res.empty()) {
-        scaled_lru->insert(
-            i, sample_keys.data(), sample_res.data(), sample_keys.size());
+        if (clock_cache != nullptr) {
+          clock_cache->insert(
+              i, sample_keys.data(), sample_res.data(), sample_keys.size());
+        } else {
+          scaled_lru->insert(
+              i, sample_keys.data(), sample_res.data(), sample_keys.size());
+        }
       }
       return 0;
     }));
@@ -2541,6 +2609,7 @@ void GraphTable::load_node_weight(int type_id, int idx, std::string path) {
 int32_t GraphTable::Initialize(const GraphParameter &graph) {
   task_pool_size_ = graph.task_pool_size();
   build_sampler_on_cpu = graph.build_sampler_on_cpu();
+  node_sampler_type = graph.sample_type();
 
 #ifdef PADDLE_WITH_HETERPS
   _db = NULL;
@@ -2564,10 +2633,11 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
     _shard_idx = 0;
     shard_num = graph.shard_num();
   }
-  use_cache = graph.use_cache();
-  if (use_cache) {
+  use_cache = false;
+  if (graph.use_cache()) {
     cache_size_limit = graph.cache_size_limit();
     cache_ttl = graph.cache_ttl();
+    sample_cache_type = graph.cache_type();
     make_neighbor_sample_cache(cache_size_limit, cache_ttl);
   }
   _shards_task_pool.resize(task_pool_size_);
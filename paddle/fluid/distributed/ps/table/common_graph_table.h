@@ -42,6 +42,7 @@
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/graph/class_macro.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+#include "paddle/fluid/memory/allocation/spin_lock.h"
 #include "paddle/fluid/string/string_helper.h"
 #include "paddle/phi/core/utils/rw_lock.h"
 
@@ -137,7 +138,18 @@ class GraphShard {
     }
   }
 
+  // Packs the neighbors of all nodes into one CSR storage and replaces them
+  // by CSRGraphNode, releasing the per-node edge blobs and samplers. Calling
+  // it again repacks the shard, including nodes unpacked in between.
+  void freeze_edges(const std::string &sample_type);
+  bool is_frozen() const { return csr_edges != nullptr; }
+  size_t get_csr_memory_size() const {
+    return csr_edges == nullptr ? 0 : csr_edges->memory_size();
+  }
+
   void merge_shard(GraphShard *&shard) {  // NOLINT
+    // nodes of a frozen shard point into its storage, which is freed below
+    shard->unpack_all_nodes();
     bucket.reserve(bucket.size() + shard->bucket.size());
     for (size_t i = 0; i < shard->bucket.size(); i++) {
       auto node_id = shard->bucket[i]->get_id();
@@ -152,9 +164,15 @@ class GraphShard {
     shard = NULL;
   }
 
+ protected:
+  // Replaces bucket[pos] by a standalone GraphNode if it is packed.
+  GraphNode *unpack_node(int pos);
+  void unpack_all_nodes();
+
  public:
   std::unordered_map<uint64_t, int> node_location;
   std::vector<Node *> bucket;
+  std::unique_ptr<GraphCSRStorage> csr_edges;
 };
 
 enum LRUResponse { ok = 0, blocked = 1, err = 2 };
@@ -164,6 +182,7 @@ struct SampleKey {
   uint64_t node_key;
   size_t sample_size;
   bool is_weighted;
+  SampleKey() : idx(0), node_key(0), sample_size(0), is_weighted(false) {}
   SampleKey(int _idx,
             uint64_t _node_key,
             size_t _sample_size,
@@ -183,6 +202,7 @@ class SampleResult {
  public:
   size_t actual_size;
   std::shared_ptr<char> buffer;
+  SampleResult() : actual_size(0) {}
   SampleResult(size_t _actual_size, std::shared_ptr<char> &_buffer)  // NOLINT
       : actual_size(_actual_size), buffer(_buffer) {}
   SampleResult(size_t _actual_size, char *_buffer)
@@ -438,6 +458,188 @@ class ScaledLRU {
   friend class RandomSampleLRU<K, V>;
 };
 
+struct SampleCacheStat {
+  size_t hit = 0;
+  size_t miss = 0;
+  size_t evict = 0;
+  size_t expire = 0;
+  size_t size = 0;
+};
+
+// Sample result cache that can replace ScaledLRU when many sampling threads
+// share it. Keys are hashed into segments guarded by spin locks, and every
+// segment is an open addressing table with linear probing whose entries are
+// evicted in CLOCK order once the segment is full, so no list or map node
+// is allocated per entry. Like ScaledLRU, an entry expires after ttl hits.
+template <typename K, typename V>
+class ClockSampleCache {
+ public:
+  ClockSampleCache(size_t segment_num, size_t size_limit, size_t ttl)
+      : ttl(ttl) {
+    size_t n = 1;
+    while (n < segment_num) n <<= 1;
+    segment_mask = n - 1;
+    size_t segment_limit = std::max<size_t>((size_limit + n - 1) / n, 1);
+    size_t capacity = 16;
+    while (capacity < 2 * segment_limit) capacity <<= 1;
+    for (size_t i = 0; i < n; i++) {
+      segments.emplace_back(new Segment(capacity, segment_limit));
+    }
+  }
+
+  // index is the calling shard thread, kept for ScaledLRU compatibility.
+  // Hits are appended to res in the order of keys.
+  LRUResponse query(size_t index UNUSED,
+                    K *keys,
+                    size_t length,
+                    std::vector<std::pair<K, V>> &res) {  // NOLINT
+    for (size_t i = 0; i < length; i++) {
+      uint64_t h = hash_key(keys[i]);
+      Segment *seg = segments[(h >> 32) & segment_mask].get();
+      std::lock_guard<paddle::memory::SpinLock> guard(seg->lock);
+      int64_t pos = seg->find(h, keys[i]);
+      if (pos < 0) {
+        seg->stat.miss++;
+        continue;
+      }
+      Slot &slot = seg->slots[pos];
+      res.emplace_back(keys[i], slot.value);
+      seg->stat.hit++;
+      slot.referenced = true;
+      if (--slot.ttl == 0) {
+        seg->erase(pos);
+        seg->stat.expire++;
+      }
+    }
+    return LRUResponse::ok;
+  }
+
+  LRUResponse insert(size_t index UNUSED, K *keys, V *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      uint64_t h = hash_key(keys[i]);
+      Segment *seg = segments[(h >> 32) & segment_mask].get();
+      std::lock_guard<paddle::memory::SpinLock> guard(seg->lock);
+      int64_t pos = seg->find(h, keys[i]);
+      if (pos < 0) {
+        if (seg->size >= seg->limit) {
+          seg->evict_one();
+          seg->stat.evict++;
+        }
+        pos = seg->find_empty(h);
+        seg->size++;
+      }
+      Slot &slot = seg->slots[pos];
+      slot.used = true;
+      slot.referenced = true;
+      slot.hash = h;
+      slot.ttl = ttl;
+      slot.key = keys[i];
+      slot.value = data[i];
+    }
+    return LRUResponse::ok;
+  }
+
+  SampleCacheStat stat() {
+    SampleCacheStat total;
+    for (auto &seg : segments) {
+      std::lock_guard<paddle::memory::SpinLock> guard(seg->lock);
+      total.hit += seg->stat.hit;
+      total.miss += seg->stat.miss;
+      total.evict += seg->stat.evict;
+      total.expire += seg->stat.expire;
+      total.size += seg->size;
+    }
+    return total;
+  }
+
+  size_t get_ttl() { return ttl; }
+
+ private:
+  struct Slot {
+    bool used = false;
+    bool referenced = false;
+    size_t ttl = 0;
+    uint64_t hash = 0;
+    K key;
+    V value;
+  };
+
+  struct alignas(64) Segment {
+    Segment(size_t capacity, size_t limit)
+        : slots(capacity), mask(capacity - 1), limit(limit) {}
+
+    int64_t find(uint64_t h, const K &key) {
+      for (size_t i = h & mask;; i = (i + 1) & mask) {
+        if (!slots[i].used) return -1;
+        if (slots[i].hash == h && slots[i].key == key) return i;
+      }
+    }
+    int64_t find_empty(uint64_t h) {
+      size_t i = h & mask;
+      while (slots[i].used) i = (i + 1) & mask;
+      return i;
+    }
+    // CLOCK: give referenced entries a second chance, evict the first
+    // entry whose bit is already cleared.
+    void evict_one() {
+      while (true) {
+        size_t i = hand;
+        hand = (hand + 1) & mask;
+        if (!slots[i].used) continue;
+        if (slots[i].referenced) {
+          slots[i].referenced = false;
+          continue;
+        }
+        erase(i);
+        return;
+      }
+    }
+    // Backward shift deletion keeps probe chains intact without tombstones.
+    void erase(size_t pos) {
+      size_t i = pos;
+      size_t j = pos;
+      while (true) {
+        j = (j + 1) & mask;
+        if (!slots[j].used) break;
+        size_t home = slots[j].hash & mask;
+        bool reachable =
+            i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (reachable) continue;
+        slots[i] = std::move(slots[j]);
+        i = j;
+      }
+      slots[i].used = false;
+      slots[i].referenced = false;
+      slots[i].value = V();
+      size--;
+    }
+
+    paddle::memory::SpinLock lock;
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t limit;
+    size_t size = 0;
+    size_t hand = 0;
+    SampleCacheStat stat;
+  };
+
+  static uint64_t hash_key(const K &key) {
+    // std::hash<SampleKey> only xors the fields, mix the bits before using
+    // them for both the segment and the slot.
+    uint64_t h = std::hash<K>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  size_t ttl;
+  size_t segment_mask;
+  std::vector<std::unique_ptr<Segment>> segments;
+};
+
 /*
 #ifdef PADDLE_WITH_HETERPS
 enum GraphSamplerStatus { waiting = 0, running = 1, terminating = 2 };
@@ -681,13 +883,22 @@ class GraphTable : public Table {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       if (use_cache == false) {
-        scaled_lru.reset(new ScaledLRU<SampleKey, SampleResult>(
-            task_pool_size_, size_limit, ttl));
+        if (sample_cache_type == "clock") {
+          clock_cache.reset(new ClockSampleCache<SampleKey, SampleResult>(
+              task_pool_size_ * 4, size_limit, ttl));
+        } else {
+          scaled_lru.reset(new ScaledLRU<SampleKey, SampleResult>(
+              task_pool_size_, size_limit, ttl));
+        }
         use_cache = true;
       }
     }
     return 0;
   }
+  // Counters are only maintained by the clock cache.
+  virtual SampleCacheStat get_neighbor_sample_cache_stat() {
+    return clock_cache == nullptr ? SampleCacheStat() : clock_cache->stat();
+  }
   virtual void load_node_weight(int type_id, int idx, std::string path);
 #ifdef PADDLE_WITH_HETERPS
   // virtual int32_t start_graph_sampling() {
@@ -775,6 +986,8 @@ class GraphTable : public Table {
   std::vector<std::shared_ptr<std::mt19937_64>> _shards_task_rng_pool;
   std::shared_ptr<::ThreadPool> load_node_edge_task_pool;
   std::shared_ptr<ScaledLRU<SampleKey, SampleResult>> scaled_lru;
+  std::shared_ptr<ClockSampleCache<SampleKey, SampleResult>> clock_cache;
+  std::string sample_cache_type = "lru";
   std::unordered_set<uint64_t> extra_nodes;
   std::unordered_map<uint64_t, size_t> extra_nodes_to_thread_index;
   bool use_cache, use_duplicate_nodes;
@@ -782,6 +995,7 @@ class GraphTable : public Table {
   int cache_ttl;
   mutable std::mutex mutex_;
   bool build_sampler_on_cpu;
+  std::string node_sampler_type = "random";
   bool is_load_reverse_edge = false;
   std::shared_ptr<pthread_rwlock_t> rw_lock;
 #ifdef PADDLE_WITH_HETERPS
@@ -16,6 +16,8 @@
 
 #include <gflags/gflags.h>
 
+#include <algorithm>
+
 #include "glog/logging.h"
 #include "paddle/fluid/string/string_helper.h"
 
@@ -92,6 +94,11 @@ bool CtrCommonAccessor::SaveCache(float* value,
   return false;
 }
 
+float CtrCommonAccessor::HotScore(float* value) {
+  return ShowClickScore(common_feature_value.Show(value),
+                        common_feature_value.Click(value));
+}
+
 bool CtrCommonAccessor::SaveSSD(float* value) {
   if (common_feature_value.UnseenDays(value) > _ssd_unseenday_threshold) {
     return true;
@@ -247,25 +254,13 @@ int32_t CtrCommonAccessor::Merge(float** update_values,
 int32_t CtrCommonAccessor::Update(float** update_values,
                                   const float** push_values,
                                   size_t num) {
+  if (num > 1) {
+    return UpdateBatch(update_values, push_values, num);
+  }
   for (size_t value_item = 0; value_item < num; ++value_item) {
     float* update_value = update_values[value_item];
     const float* push_value = push_values[value_item];
-    float push_show = push_value[CtrCommonPushValue::ShowIndex()];
-    float push_click = push_value[CtrCommonPushValue::ClickIndex()];
-    float slot = push_value[CtrCommonPushValue::SlotIndex()];
-    update_value[common_feature_value.ShowIndex()] += push_show;
-    update_value[common_feature_value.ClickIndex()] += push_click;
-    update_value[common_feature_value.SlotIndex()] = slot;
-    update_value[common_feature_value.DeltaScoreIndex()] +=
-        (push_show - push_click) * _config.ctr_accessor_param().nonclk_coeff() +
-        push_click * _config.ctr_accessor_param().click_coeff();
-    update_value[common_feature_value.UnseenDaysIndex()] = 0;
-    // TODO(zhaocaibei123): add configure show_scale
-    if (!_show_scale) {
-      push_show = 1;
-    }
-    VLOG(3) << "accessor show scale:" << _show_scale
-            << ", push_show:" << push_show;
+    float push_show = UpdateStat(update_value, push_value);
     _embed_sgd_rule->UpdateValue(
         update_value + common_feature_value.EmbedWIndex(),
         update_value + common_feature_value.EmbedG2SumIndex(),
@@ -280,6 +275,60 @@ int32_t CtrCommonAccessor::Update(float** update_values,
   return 0;
 }
 
+// update show/click statistics, returns the show scale of the gradients
+float CtrCommonAccessor::UpdateStat(float* update_value,
+                                    const float* push_value) {
+  float push_show = push_value[CtrCommonPushValue::ShowIndex()];
+  float push_click = push_value[CtrCommonPushValue::ClickIndex()];
+  float slot = push_value[CtrCommonPushValue::SlotIndex()];
+  update_value[common_feature_value.ShowIndex()] += push_show;
+  update_value[common_feature_value.ClickIndex()] += push_click;
+  update_value[common_feature_value.SlotIndex()] = slot;
+  update_value[common_feature_value.DeltaScoreIndex()] +=
+      (push_show - push_click) * _config.ctr_accessor_param().nonclk_coeff() +
+      push_click * _config.ctr_accessor_param().click_coeff();
+  update_value[common_feature_value.UnseenDaysIndex()] = 0;
+  // TODO(zhaocaibei123): add configure show_scale
+  if (!_show_scale) {
+    push_show = 1;
+  }
+  VLOG(3) << "accessor show scale:" << _show_scale
+          << ", push_show:" << push_show;
+  return push_show;
+}
+
+// The gradient update of a value only depends on its own rule state and
+// push_show, so the statistics of a whole chunk go first and the sgd rules
+// then run once per chunk.
+int32_t CtrCommonAccessor::UpdateBatch(float** update_values,
+                                       const float** push_values,
+                                       size_t num) {
+  const size_t kChunkSize = 128;
+  float push_shows[kChunkSize];
+  for (size_t begin = 0; begin < num; begin += kChunkSize) {
+    size_t chunk = std::min(kChunkSize, num - begin);
+    for (size_t i = 0; i < chunk; ++i) {
+      push_shows[i] =
+          UpdateStat(update_values[begin + i], push_values[begin + i]);
+    }
+    _embed_sgd_rule->UpdateValueBatch(update_values + begin,
+                                      common_feature_value.EmbedWIndex(),
+                                      common_feature_value.EmbedG2SumIndex(),
+                                      push_values + begin,
+                                      CtrCommonPushValue::EmbedGIndex(),
+                                      push_shows,
+                                      chunk);
+    _embedx_sgd_rule->UpdateValueBatch(update_values + begin,
+                                       common_feature_value.EmbedxWIndex(),
+                                       common_feature_value.EmbedxG2SumIndex(),
+                                       push_values + begin,
+                                       CtrCommonPushValue::EmbedxGIndex(),
+                                       push_shows,
+                                       chunk);
+  }
+  return 0;
+}
+
 bool CtrCommonAccessor::CreateValue(int stage, const float* value) {
   // stage == 0, pull
   // stage == 1, push
@@ -154,6 +154,7 @@ class CtrCommonAccessor : public ValueAccessor {
                  int param,
                  double global_cache_threshold) override;
   bool SaveSSD(float* value) override;
+  float HotScore(float* value) override;
   // update delta_score and unseen_days after save
   void UpdateStatAfterSave(float* value, int param) override;
   // keys不存在时，为values生成随机值
@@ -188,6 +189,11 @@ class CtrCommonAccessor : public ValueAccessor {
   }
 
  private:
+  float UpdateStat(float* update_value, const float* push_value);
+  // 多个key攒批后调用sgd rule的批量接口
+  int32_t UpdateBatch(float** values,
+                      const float** update_values,
+                      size_t num);
   // float ShowClickScore(float show, float click);
 
   // SparseValueSGDRule* _embed_sgd_rule;
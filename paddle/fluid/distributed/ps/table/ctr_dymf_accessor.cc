@@ -103,6 +103,11 @@ bool CtrDymfAccessor::SaveCache(float* value,
   return false;
 }
 
+float CtrDymfAccessor::HotScore(float* value) {
+  return ShowClickScore(common_feature_value.Show(value),
+                        common_feature_value.Click(value));
+}
+
 bool CtrDymfAccessor::SaveSSD(float* value) {
   if (common_feature_value.UnseenDays(value) > _ssd_unseenday_threshold) {
     return true;
@@ -259,7 +264,9 @@ int32_t CtrDymfAccessor::Merge(float** update_values,
 int32_t CtrDymfAccessor::Update(float** update_values,
                                 const float** push_values,
                                 size_t num) {
-  // currently update in cpu is not supported
+  // currently update in cpu is not supported, so there is no UpdateBatch
+  // as in CtrCommonAccessor: the embedx size of a value depends on its
+  // mf_dim, while UpdateValueBatch takes one fixed embedding dim
   return 0;
 }
 
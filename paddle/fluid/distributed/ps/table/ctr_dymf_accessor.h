@@ -209,6 +209,7 @@ class CtrDymfAccessor : public ValueAccessor {
                  int param,
                  double global_cache_threshold) override;
   bool SaveSSD(float* value) override;
+  float HotScore(float* value) override;
   bool FilterSlot(float* value);
   // update delta_score and unseen_days after save
   void UpdateStatAfterSave(float* value, int param) override;
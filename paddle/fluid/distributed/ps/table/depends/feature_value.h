@@ -14,11 +14,16 @@
 
 #pragma once
 
+#include <string.h>
+
+#include <algorithm>
 #include <mct/hash-map.hpp>
+#include <type_traits>
 #include <vector>
 
 #include "gflags/gflags.h"
 #include "paddle/fluid/distributed/common/chunk_allocator.h"
+#include "paddle/fluid/distributed/common/slab_allocator.h"
 
 namespace paddle {
 namespace distributed {
@@ -27,17 +32,78 @@ static const int CTR_SPARSE_SHARD_BUCKET_NUM_BITS = 6;
 static const size_t CTR_SPARSE_SHARD_BUCKET_NUM =
     static_cast<size_t>(1) << CTR_SPARSE_SHARD_BUCKET_NUM_BITS;
 
+// Float array of one sparse feature. Values created by a SparseTableShard
+// take their storage from the shard's SlabAllocator, standalone values fall
+// back to malloc. resize() always reallocates into the exact size class, new
+// elements are zero filled like std::vector. stamp() records the table save
+// epoch of the last change, it lives in the padding after _size.
 class FixedFeatureValue {
  public:
   FixedFeatureValue() {}
-  ~FixedFeatureValue() {}
-  float* data() { return _data.data(); }
-  size_t size() { return _data.size(); }
-  void resize(size_t size) { _data.resize(size); }
-  void shrink_to_fit() { _data.shrink_to_fit(); }
+  explicit FixedFeatureValue(SlabAllocator* slab) : _slab(slab) {}
+  FixedFeatureValue(const FixedFeatureValue& other) : _slab(other._slab) {
+    *this = other;
+  }
+  FixedFeatureValue& operator=(const FixedFeatureValue& other) {
+    if (this != &other) {
+      resize(other._size);
+      memcpy(_data, other._data, _size * sizeof(float));
+      _stamp = other._stamp;
+    }
+    return *this;
+  }
+  ~FixedFeatureValue() { deallocate(_data, _size); }
+  float* data() { return _data; }
+  size_t size() { return _size; }
+  uint32_t stamp() const { return _stamp; }
+  void set_stamp(uint32_t stamp) { _stamp = stamp; }
+  void resize(size_t size) {
+    if (size == _size) {
+      return;
+    }
+    float* data = allocate(size);
+    size_t keep = std::min<size_t>(size, _size);
+    if (keep > 0) {
+      memcpy(data, _data, keep * sizeof(float));
+    }
+    if (size > keep) {
+      memset(data + keep, 0, (size - keep) * sizeof(float));
+    }
+    deallocate(_data, _size);
+    _data = data;
+    _size = static_cast<uint32_t>(size);
+  }
+  void shrink_to_fit() {}
+  // move out of a slab page that is being evacuated
+  void compact() {
+    if (_slab == NULL || !_slab->NeedMove(_data, _size)) {
+      return;
+    }
+    float* data = _slab->Allocate(_size);
+    memcpy(data, _data, _size * sizeof(float));
+    _slab->Deallocate(_data, _size);
+    _data = data;
+  }
 
  private:
-  std::vector<float> _data;
+  float* allocate(size_t size) {
+    if (_slab != NULL) {
+      return _slab->Allocate(size);
+    }
+    return size == 0 ? NULL : static_cast<float*>(malloc(size * sizeof(float)));
+  }
+  void deallocate(float* data, size_t size) {
+    if (_slab != NULL) {
+      _slab->Deallocate(data, size);
+    } else {
+      free(data);
+    }
+  }
+
+  float* _data = NULL;
+  uint32_t _size = 0;
+  uint32_t _stamp = 0;
+  SlabAllocator* _slab = NULL;
 };
 
 template <class KEY, class VALUE>
@@ -149,7 +215,7 @@ struct alignas(64) SparseTableShard {
     auto res = _buckets[bucket].insert_with_hash({key, NULL}, hash);
 
     if (res.second) {
-      res.first->second = _alloc.acquire(std::forward<ARGS>(args)...);
+      res.first->second = acquire_value(std::forward<ARGS>(args)...);
     }
 
     return {{res.first, bucket, _buckets}, res.second};
@@ -184,6 +250,24 @@ struct alignas(64) SparseTableShard {
     quick_erase(it);
     return 1;
   }
+  // Moves values out of sparsely used slab pages, so that memory freed by
+  // erase() can go back to the OS. Only meaningful for slab backed values.
+  void compact_values(double max_occupancy = 0.5) {
+    if constexpr (std::is_constructible<VALUE, SlabAllocator*>::value) {
+      if (_value_slab.BeginCompact(max_occupancy)) {
+        for (size_t bucket = 0; bucket < CTR_SPARSE_SHARD_BUCKET_NUM;
+             bucket++) {
+          for (auto it = _buckets[bucket].begin(); it != _buckets[bucket].end();
+               ++it) {
+            ((VALUE*)(void*)it->second)->compact();  // NOLINT
+          }
+        }
+      }
+      _value_slab.EndCompact();
+    }
+  }
+  size_t value_live_bytes() const { return _value_slab.LiveBytes(); }
+  size_t value_reserved_bytes() const { return _value_slab.ReservedBytes(); }
   size_t compute_bucket(size_t hash) {
     if (CTR_SPARSE_SHARD_BUCKET_NUM == 1) {
       return 0;
@@ -193,9 +277,29 @@ struct alignas(64) SparseTableShard {
   }
 
  private:
+  template <class... ARGS>
+  VALUE* acquire_value(ARGS&&... args) {
+    if constexpr (std::is_constructible<VALUE, SlabAllocator*>::value) {
+      // copies keep the storage in this shard's slab
+      VALUE* value = _alloc.acquire(&_value_slab);
+      *value = VALUE(std::forward<ARGS>(args)...);
+      return value;
+    } else {
+      return _alloc.acquire(std::forward<ARGS>(args)...);
+    }
+  }
+  VALUE* acquire_value() {
+    if constexpr (std::is_constructible<VALUE, SlabAllocator*>::value) {
+      return _alloc.acquire(&_value_slab);
+    } else {
+      return _alloc.acquire();
+    }
+  }
+
   map_type _buckets[CTR_SPARSE_SHARD_BUCKET_NUM];
   ChunkAllocator<VALUE> _alloc;
   std::hash<KEY> _hasher;
+  SlabAllocator _value_slab;
 };
 
 }  // namespace distributed
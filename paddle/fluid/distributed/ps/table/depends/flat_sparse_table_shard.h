@@ -0,0 +1,353 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace distributed {
+
+// View of a value stored inline in a FlatSparseTableShard slab. It mimics the
+// data()/size()/resize() surface of FixedFeatureValue, but resize() only moves
+// the logical size inside the fixed per-slot capacity (value_dim).
+class FlatFeatureValue {
+ public:
+  FlatFeatureValue(float* data,
+                   uint32_t* size,
+                   uint32_t* stamp,
+                   size_t capacity)
+      : _data(data), _size(size), _stamp(stamp), _capacity(capacity) {}
+  float* data() { return _data; }
+  size_t size() { return *_size; }
+  uint32_t stamp() const { return *_stamp; }
+  void set_stamp(uint32_t stamp) { *_stamp = stamp; }
+  void resize(size_t size) {
+    CHECK_LE(size, _capacity) << "FlatFeatureValue exceeds slot capacity";
+    *_size = static_cast<uint32_t>(size);
+  }
+  void shrink_to_fit() {}
+
+ private:
+  float* _data;
+  uint32_t* _size;
+  uint32_t* _stamp;
+  size_t _capacity;
+};
+
+// Open addressing hash map from uint64 feasign to a fixed width float value.
+// Layout follows the swiss table design: one control byte per slot holding 7
+// bits of the hash (or EMPTY / DELETED), probed 16 slots at a time with SSE2.
+// Keys, value sizes, save stamps and values live in parallel flat arrays, so a
+// hit costs one control group load plus one key compare plus the value line
+// itself, instead of bucket -> node -> FixedFeatureValue -> std::vector data.
+//
+// Values move on rehash, so pointers returned by value().data() are only valid
+// until the next insertion.
+struct alignas(64) FlatSparseTableShard {
+ public:
+  static constexpr size_t kGroupWidth = 16;
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+
+  struct iterator {
+    FlatSparseTableShard* shard;
+    size_t slot;
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.slot == b.slot;
+    }
+    friend bool operator!=(const iterator& a, const iterator& b) {
+      return a.slot != b.slot;
+    }
+    const uint64_t& key() const { return shard->_keys[slot]; }
+    FlatFeatureValue value() const { return shard->value_at(slot); }
+    iterator& operator++() {
+      slot = shard->next_full(slot + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+  };
+
+  FlatSparseTableShard() {}
+  explicit FlatSparseTableShard(size_t value_dim) : _value_dim(value_dim) {}
+
+  // must be called before the first insertion
+  void set_value_dim(size_t value_dim) {
+    CHECK(_size == 0) << "set_value_dim on non-empty FlatSparseTableShard";
+    _value_dim = value_dim;
+    _values.assign(_capacity * _value_dim, 0);
+  }
+  size_t value_dim() const { return _value_dim; }
+
+  bool empty() const { return _size == 0; }
+  size_t size() const { return _size; }
+  size_t capacity() const { return _capacity; }
+  size_t memory_size() const {
+    return _ctrl.capacity() * sizeof(int8_t) +
+           _keys.capacity() * sizeof(uint64_t) +
+           _value_sizes.capacity() * sizeof(uint32_t) +
+           _stamps.capacity() * sizeof(uint32_t) +
+           _values.capacity() * sizeof(float);
+  }
+
+  void clear() {
+    _ctrl.clear();
+    _keys.clear();
+    _value_sizes.clear();
+    _stamps.clear();
+    _values.clear();
+    _ctrl.shrink_to_fit();
+    _keys.shrink_to_fit();
+    _value_sizes.shrink_to_fit();
+    _stamps.shrink_to_fit();
+    _values.shrink_to_fit();
+    _capacity = 0;
+    _size = 0;
+    _growth_left = 0;
+  }
+
+  void reserve(size_t n) {
+    size_t cap = kGroupWidth;
+    while (cap - cap / 8 < n) {
+      cap <<= 1;
+    }
+    if (cap > _capacity) {
+      rehash(cap);
+    }
+  }
+
+  iterator begin() { return {this, next_full(0)}; }
+  iterator end() { return {this, _capacity}; }
+
+  iterator find(const uint64_t& key) {
+    if (_capacity == 0) {
+      return end();
+    }
+    size_t hash = hash_key(key);
+    int8_t h2 = static_cast<int8_t>(hash & 0x7f);
+    size_t mask = _capacity - 1;
+    size_t pos = (hash >> 7) & mask;
+    size_t step = 0;
+    while (true) {
+      const int8_t* group = &_ctrl[pos];
+      uint32_t match = match_byte(group, h2);
+      while (match) {
+        size_t slot = (pos + ctz(match)) & mask;
+        if (_keys[slot] == key) {
+          return {this, slot};
+        }
+        match &= match - 1;
+      }
+      if (match_byte(group, kEmpty)) {
+        return end();
+      }
+      step += kGroupWidth;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  // inserts an empty value (size 0) when the key is absent
+  std::pair<iterator, bool> emplace(const uint64_t& key) {
+    auto it = find(key);
+    if (it != end()) {
+      return {it, false};
+    }
+    if (_capacity == 0) {
+      rehash(kGroupWidth);
+    }
+    size_t hash = hash_key(key);
+    size_t slot = find_non_full(hash);
+    if (_growth_left == 0 && _ctrl[slot] != kDeleted) {
+      // drop tombstones in place when live keys fill less than half of the
+      // load limit, otherwise double the capacity
+      size_t max_size = _capacity - _capacity / 8;
+      rehash(_size * 2 < max_size ? _capacity : _capacity * 2);
+      slot = find_non_full(hash);
+    }
+    if (_ctrl[slot] == kEmpty) {
+      --_growth_left;
+    }
+    set_ctrl(slot, static_cast<int8_t>(hash & 0x7f));
+    _keys[slot] = key;
+    _value_sizes[slot] = 0;
+    _stamps[slot] = 0;
+    ++_size;
+    return {{this, slot}, true};
+  }
+  FlatFeatureValue operator[](const uint64_t& key) {
+    return emplace(key).first.value();
+  }
+
+  iterator erase(iterator it) {
+    set_ctrl(it.slot, kDeleted);
+    --_size;
+    ++it;
+    return it;
+  }
+  size_t erase(const uint64_t& key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+ private:
+  static size_t hash_key(uint64_t key) {
+    // feasigns are routed to shards by key % shard_num, so the low bits are
+    // correlated inside one shard; mix before taking h1/h2
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+  }
+
+  static uint32_t ctz(uint32_t x) { return __builtin_ctz(x); }
+
+  // bit i is set when group[i] == b
+  static uint32_t match_byte(const int8_t* group, int8_t b) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(b), ctrl)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(group[i] == b) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // bit i is set when group[i] is EMPTY or DELETED
+  static uint32_t match_non_full(const int8_t* group) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(group[i] < 0) << i;
+    }
+    return mask;
+#endif
+  }
+
+  size_t find_non_full(size_t hash) const {
+    size_t mask = _capacity - 1;
+    size_t pos = (hash >> 7) & mask;
+    size_t step = 0;
+    while (true) {
+      uint32_t match = match_non_full(&_ctrl[pos]);
+      if (match) {
+        return (pos + ctz(match)) & mask;
+      }
+      step += kGroupWidth;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  // the first kGroupWidth - 1 control bytes are mirrored after the end so an
+  // unaligned group load near the tail wraps around without a branch
+  void set_ctrl(size_t slot, int8_t h) {
+    _ctrl[slot] = h;
+    if (slot < kGroupWidth - 1) {
+      _ctrl[_capacity + slot] = h;
+    }
+  }
+
+  size_t next_full(size_t slot) const {
+    while (slot < _capacity && _ctrl[slot] < 0) {
+      ++slot;
+    }
+    return slot;
+  }
+
+  FlatFeatureValue value_at(size_t slot) {
+    return FlatFeatureValue(&_values[slot * _value_dim],
+                            &_value_sizes[slot],
+                            &_stamps[slot],
+                            _value_dim);
+  }
+
+  void rehash(size_t new_capacity) {
+    if (new_capacity < kGroupWidth) {
+      new_capacity = kGroupWidth;
+    }
+    std::vector<int8_t> old_ctrl;
+    std::vector<uint64_t> old_keys;
+    std::vector<uint32_t> old_value_sizes;
+    std::vector<uint32_t> old_stamps;
+    std::vector<float> old_values;
+    old_ctrl.swap(_ctrl);
+    old_keys.swap(_keys);
+    old_value_sizes.swap(_value_sizes);
+    old_stamps.swap(_stamps);
+    old_values.swap(_values);
+    size_t old_capacity = _capacity;
+
+    _capacity = new_capacity;
+    _ctrl.assign(_capacity + kGroupWidth - 1, kEmpty);
+    _keys.resize(_capacity);
+    _value_sizes.resize(_capacity);
+    _stamps.resize(_capacity);
+    _values.resize(_capacity * _value_dim);
+    _growth_left = _capacity - _capacity / 8 - _size;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] < 0) {
+        continue;
+      }
+      size_t hash = hash_key(old_keys[i]);
+      size_t slot = find_non_full(hash);
+      set_ctrl(slot, static_cast<int8_t>(hash & 0x7f));
+      _keys[slot] = old_keys[i];
+      _value_sizes[slot] = old_value_sizes[i];
+      _stamps[slot] = old_stamps[i];
+      memcpy(&_values[slot * _value_dim],
+             &old_values[i * _value_dim],
+             old_value_sizes[i] * sizeof(float));
+    }
+  }
+
+  size_t _value_dim = 0;
+  size_t _capacity = 0;
+  size_t _size = 0;
+  size_t _growth_left = 0;
+  std::vector<int8_t> _ctrl;
+  std::vector<uint64_t> _keys;
+  std::vector<uint32_t> _value_sizes;
+  std::vector<uint32_t> _stamps;
+  std::vector<float> _values;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -215,6 +215,20 @@ class RocksDBHandler {
     return 0;
   }
 
+  int del_batch(int id,
+                std::vector<std::pair<char*, int>>& ssd_keys,  // NOLINT
+                int n) {
+    rocksdb::WriteOptions options;
+    options.disableWAL = true;
+    rocksdb::WriteBatch batch(n * 32);
+    for (int i = 0; i < n; i++) {
+      batch.Delete(rocksdb::Slice(ssd_keys[i].first, ssd_keys[i].second));
+    }
+    rocksdb::Status s = _dbs[id]->Write(options, &batch);
+    assert(s.ok());
+    return 0;
+  }
+
   int flush(int id) {
     rocksdb::Status s = _dbs[id]->Flush(rocksdb::FlushOptions());
     assert(s.ok());
@@ -0,0 +1,241 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_storage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace paddle {
+namespace distributed {
+
+void GraphCSRStorage::reserve(size_t row_num, size_t edge_num) {
+  offsets.reserve(row_num + 1);
+  id_arr.reserve(edge_num);
+  weight_arr.reserve(edge_num);
+}
+
+void GraphCSRStorage::add_edge(uint64_t id, float weight) {
+  id_arr.push_back(id);
+  weight_arr.push_back(weight);
+  if (weight != 1.) {
+    all_default_weight = false;
+  }
+}
+
+uint32_t GraphCSRStorage::finish_row() {
+  offsets.push_back(id_arr.size());
+  return offsets.size() - 2;
+}
+
+void GraphCSRStorage::shrink_to_fit() {
+  if (all_default_weight) {
+    std::vector<float>().swap(weight_arr);
+  }
+  offsets.shrink_to_fit();
+  id_arr.shrink_to_fit();
+  weight_arr.shrink_to_fit();
+  build_alias_tables();
+}
+
+void GraphCSRStorage::set_sample_type(const std::string &type) {
+  sample_type = type;
+  if (is_weighted_sample()) {
+    build_alias_tables();
+  } else {
+    std::vector<float>().swap(alias_prob);
+    std::vector<uint32_t>().swap(alias_idx);
+  }
+}
+
+void GraphCSRStorage::build_alias_tables() {
+  // build_sampler calls set_sample_type for every node of the shard, the
+  // tables are built by the first one
+  if (!is_weighted_sample() || weight_arr.empty() || !alias_prob.empty()) {
+    return;
+  }
+  alias_prob.assign(weight_arr.size(), 1.0);
+  alias_idx.resize(weight_arr.size());
+  for (size_t row = 0; row < row_num(); row++) {
+    build_alias_row(row);
+  }
+}
+
+void GraphCSRStorage::build_alias_row(uint32_t row) {
+  // Vose's method as in AliasSampler::build, on the slice of the row.
+  int n = degree(row);
+  const float *weights = weight_arr.data() + offsets[row];
+  float *prob = alias_prob.data() + offsets[row];
+  uint32_t *alias = alias_idx.data() + offsets[row];
+  double total_weight = 0;
+  for (int i = 0; i < n; i++) {
+    alias[i] = i;
+    total_weight += std::max(weights[i], 0.0f);
+  }
+  if (n == 0 || total_weight <= 0) {
+    return;
+  }
+  std::vector<double> scaled(n);
+  std::vector<int> small, large;
+  for (int i = 0; i < n; i++) {
+    scaled[i] = std::max(weights[i], 0.0f) * n / total_weight;
+    if (scaled[i] < 1.0) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    int s = small.back();
+    int l = large.back();
+    small.pop_back();
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // leftovers are 1 up to rounding errors
+  for (int i : large) prob[i] = 1.0;
+  for (int i : small) prob[i] = 1.0;
+}
+
+size_t GraphCSRStorage::memory_size() const {
+  return offsets.capacity() * sizeof(uint64_t) +
+         id_arr.capacity() * sizeof(uint64_t) +
+         weight_arr.capacity() * sizeof(float) +
+         alias_prob.capacity() * sizeof(float) +
+         alias_idx.capacity() * sizeof(uint32_t);
+}
+
+std::vector<int> GraphCSRStorage::sample_k(
+    uint32_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  int n = degree(row);
+  if (k <= 0) {
+    return std::vector<int>();
+  }
+  if (k >= n) {
+    std::vector<int> sample_result(n);
+    for (int i = 0; i < n; i++) {
+      sample_result[i] = i;
+    }
+    return sample_result;
+  }
+  if (is_weighted_sample() && !alias_prob.empty()) {
+    return weighted_sample_k(row, k, rng);
+  }
+  return random_sample_k(row, k, rng);
+}
+
+std::vector<int> GraphCSRStorage::random_sample_k(
+    uint32_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  // Same partial Fisher-Yates as RandomSampler, so results only depend on
+  // the rng state and the degree.
+  int n = degree(row);
+  std::vector<int> sample_result;
+  sample_result.reserve(k);
+  std::unordered_map<int, int> replace_map;
+  while (k--) {
+    std::uniform_int_distribution<int> distrib(0, n - 1);
+    int rand_int = distrib(*rng);
+    auto iter = replace_map.find(rand_int);
+    if (iter == replace_map.end()) {
+      sample_result.push_back(rand_int);
+    } else {
+      sample_result.push_back(iter->second);
+    }
+
+    iter = replace_map.find(n - 1);
+    if (iter == replace_map.end()) {
+      replace_map[rand_int] = n - 1;
+    } else {
+      replace_map[rand_int] = iter->second;
+    }
+    --n;
+  }
+  return sample_result;
+}
+
+std::vector<int> GraphCSRStorage::weighted_sample_k(
+    uint32_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  // Same draws as AliasSampler::sample_k: O(1) per draw from the alias
+  // table of the row, rejecting the neighbors picked already.
+  int n = degree(row);
+  const float *prob = alias_prob.data() + offsets[row];
+  const uint32_t *alias = alias_idx.data() + offsets[row];
+  std::vector<int> sample_result;
+  sample_result.reserve(k);
+  // O(1) per rejection check, a sorted vector costs O(k) per insert
+  std::unordered_set<int> picked;
+  picked.reserve(k);
+  std::uniform_int_distribution<int> bucket_distrib(0, n - 1);
+  std::uniform_real_distribution<float> prob_distrib(0, 1.0);
+  int max_reject = 2 * k + 8;
+  while (static_cast<int>(sample_result.size()) < k) {
+    int bucket = bucket_distrib(*rng);
+    int idx = prob_distrib(*rng) < prob[bucket] ? bucket : alias[bucket];
+    if (!picked.insert(idx).second) {
+      if (--max_reject < 0) {
+        weighted_sample_rest(row, k, rng, picked, &sample_result);
+        break;
+      }
+      continue;
+    }
+    sample_result.push_back(idx);
+  }
+  return sample_result;
+}
+
+void GraphCSRStorage::weighted_sample_rest(
+    uint32_t row,
+    int k,
+    const std::shared_ptr<std::mt19937_64> rng,
+    const std::unordered_set<int> &picked,
+    std::vector<int> *sample_result) const {
+  // Efraimidis-Spirakis over the neighbors not picked yet, keeping the ones
+  // with the largest log(u) / w, as AliasSampler::sample_rest.
+  int n = degree(row);
+  const float *weights = weight_arr.data() + offsets[row];
+  int rest = k - sample_result->size();
+  std::uniform_real_distribution<double> distrib(0, 1.0);
+  std::vector<std::pair<double, int>> keys;
+  keys.reserve(n - picked.size());
+  for (int i = 0; i < n; i++) {
+    if (picked.count(i)) {
+      continue;
+    }
+    double key = weights[i] > 0
+                     ? std::log(std::max(distrib(*rng), 1e-300)) / weights[i]
+                     : -std::numeric_limits<double>::infinity();
+    keys.emplace_back(key, i);
+  }
+  std::nth_element(keys.begin(),
+                   keys.begin() + rest - 1,
+                   keys.end(),
+                   [](const std::pair<double, int> &a,
+                      const std::pair<double, int> &b) {
+                     return a.first > b.first;
+                   });
+  for (int i = 0; i < rest; i++) {
+    sample_result->push_back(keys[i].second);
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
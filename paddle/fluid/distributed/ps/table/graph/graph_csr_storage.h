@@ -0,0 +1,104 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// Frozen neighbor storage of a GraphShard in CSR layout. The neighbors of
+// row r live in [offsets[r], offsets[r + 1]) of id_arr (and weight_arr when
+// the edges are weighted), so sampling touches contiguous memory instead of
+// one heap-allocated GraphEdgeBlob and Sampler per node. When the sample type
+// is weighted, the weighted rows also get an alias table (alias_prob,
+// alias_idx) in the same layout, so weighted sampling costs O(k) as
+// AliasSampler does. The tables take 8 more bytes per edge, a storage
+// sampled at random does not build them.
+class GraphCSRStorage {
+ public:
+  explicit GraphCSRStorage(const std::string &sample_type)
+      : sample_type(sample_type), offsets(1, 0) {}
+  ~GraphCSRStorage() {}
+
+  void reserve(size_t row_num, size_t edge_num);
+  // Rows are appended one by one: add the edges of a row, then close it
+  // with finish_row, which returns the index of the new row.
+  void add_edge(uint64_t id, float weight);
+  uint32_t finish_row();
+  // Drop the weight column if every edge has the default weight 1, and build
+  // the alias tables of the rows for weighted sampling. Called once all rows
+  // are added.
+  void shrink_to_fit();
+
+  size_t row_num() const { return offsets.size() - 1; }
+  size_t edge_num() const { return id_arr.size(); }
+  size_t degree(uint32_t row) const {
+    return offsets[row + 1] - offsets[row];
+  }
+  uint64_t get_id(uint32_t row, int idx) const {
+    return id_arr[offsets[row] + idx];
+  }
+  float get_weight(uint32_t row, int idx) const {
+    return weight_arr.empty() ? 1. : weight_arr[offsets[row] + idx];
+  }
+  bool has_weight() const { return !weight_arr.empty(); }
+  // "weighted" and "alias" both sample by edge weight from the alias tables
+  // here; the type is kept so that unpacked nodes build the same sampler.
+  const std::string &get_sample_type() const { return sample_type; }
+  // Builds the alias tables when a frozen storage switches to weighted
+  // sampling and frees them when it switches to random. Not thread safe,
+  // like Node::build_sampler.
+  void set_sample_type(const std::string &type);
+  bool is_weighted_sample() const { return sample_type != "random"; }
+  // Bytes held by the packed arrays, used for load-time logging.
+  size_t memory_size() const;
+
+  // Samples k distinct neighbor indices of the row, same contract as
+  // Sampler::sample_k.
+  std::vector<int> sample_k(uint32_t row,
+                            int k,
+                            const std::shared_ptr<std::mt19937_64> rng) const;
+
+ private:
+  std::vector<int> random_sample_k(
+      uint32_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const;
+  std::vector<int> weighted_sample_k(
+      uint32_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const;
+  void weighted_sample_rest(uint32_t row,
+                            int k,
+                            const std::shared_ptr<std::mt19937_64> rng,
+                            const std::unordered_set<int> &picked,
+                            std::vector<int> *sample_result) const;
+  void build_alias_tables();
+  void build_alias_row(uint32_t row);
+
+  std::string sample_type;
+  bool all_default_weight = true;
+  std::vector<uint64_t> offsets;
+  std::vector<uint64_t> id_arr;
+  std::vector<float> weight_arr;
+  // alias table of every row, the alias indices are relative to the row
+  std::vector<float> alias_prob;
+  std::vector<uint32_t> alias_idx;
+};
+
+}  // namespace distributed
+}  // namespace paddle
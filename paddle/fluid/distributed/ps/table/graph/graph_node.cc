@@ -73,9 +73,27 @@ void GraphNode::build_sampler(std::string sample_type) {
     sampler = new RandomSampler();
   } else if (sample_type == "weighted") {
     sampler = new WeightedSampler();
+  } else if (sample_type == "alias") {
+    sampler = new AliasSampler();
   }
   sampler->build(edges);
 }
+GraphNode* CSRGraphNode::unpack() {
+  GraphNode* node = new GraphNode(id);
+  node->build_edges(storage->has_weight());
+  size_t degree = storage->degree(row);
+  for (size_t i = 0; i < degree; i++) {
+    node->add_edge(storage->get_id(row, i), storage->get_weight(row, i));
+  }
+  // WeightedSampler can not be built over an empty edge list.
+  std::string sample_type = storage->get_sample_type();
+  if (sample_type == "weighted" && degree == 0) {
+    sample_type = "random";
+  }
+  node->build_sampler(sample_type);
+  return node;
+}
+
 void FeatureNode::to_buffer(char* buffer, bool need_feature) {
   memcpy(buffer, &id, id_size);
   buffer += id_size;
@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_storage.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -100,6 +101,37 @@ class GraphNode : public Node {
   GraphEdgeBlob *edges;
 };
 
+// A node whose neighbors were packed into the CSR storage of its shard by
+// GraphShard::freeze_edges. It owns no edges or sampler, the storage must
+// outlive it. Edges can not be added, unpack it into a GraphNode first.
+class CSRGraphNode : public Node {
+ public:
+  CSRGraphNode(uint64_t id, GraphCSRStorage *storage, uint32_t row)
+      : Node(id), storage(storage), row(row) {}
+  virtual ~CSRGraphNode() {}
+  virtual std::vector<int> sample_k(
+      int k, const std::shared_ptr<std::mt19937_64> rng) {
+    return storage->sample_k(row, k, rng);
+  }
+  virtual uint64_t get_neighbor_id(int idx) {
+    return storage->get_id(row, idx);
+  }
+  virtual float get_neighbor_weight(int idx) {
+    return storage->get_weight(row, idx);
+  }
+  virtual size_t get_neighbor_size() { return storage->degree(row); }
+  // The packed nodes of a shard share one sampler, which is the storage.
+  virtual void build_sampler(std::string sample_type) {
+    storage->set_sample_type(sample_type);
+  }
+  // Copy the packed neighbors back into a standalone GraphNode.
+  GraphNode *unpack();
+
+ protected:
+  GraphCSRStorage *storage;
+  uint32_t row;
+};
+
 class FeatureNode : public Node {
  public:
   FeatureNode() : Node() {}
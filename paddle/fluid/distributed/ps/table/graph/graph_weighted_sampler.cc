@@ -14,9 +14,13 @@
 
 #include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <unordered_map>
+#include <utility>
 
 #include "paddle/phi/core/generator.h"
 namespace paddle {
@@ -161,5 +165,120 @@ int WeightedSampler::sample(
   subtract_count_map[this]++;
   return return_idx;
 }
+
+void AliasSampler::build(GraphEdgeBlob *edges) {
+  this->edges = edges;
+  int n = edges->size();
+  prob.assign(n, 1.0);
+  alias.resize(n);
+  total_weight = 0;
+  for (int i = 0; i < n; i++) {
+    alias[i] = i;
+    total_weight += std::max(edges->get_weight(i), 0.0f);
+  }
+  if (n == 0 || total_weight <= 0) {
+    return;
+  }
+  // Vose's method: split the scaled weights into small (< 1) and large
+  // buckets, and let every small bucket borrow its deficit from a large one.
+  std::vector<double> scaled(n);
+  std::vector<int> small, large;
+  for (int i = 0; i < n; i++) {
+    scaled[i] = std::max(edges->get_weight(i), 0.0f) * n / total_weight;
+    if (scaled[i] < 1.0) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    int s = small.back();
+    int l = large.back();
+    small.pop_back();
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // leftovers are 1 up to rounding errors
+  for (int i : large) prob[i] = 1.0;
+  for (int i : small) prob[i] = 1.0;
+}
+
+std::vector<int> AliasSampler::sample_k(
+    int k, const std::shared_ptr<std::mt19937_64> rng) {
+  int n = edges->size();
+  std::vector<int> sample_result;
+  if (k >= n) {
+    for (int i = 0; i < n; i++) {
+      sample_result.push_back(i);
+    }
+    return sample_result;
+  }
+  if (k <= 0) {
+    return sample_result;
+  }
+  sample_result.reserve(k);
+  // sorted indices picked so far, O(k) instead of a per-call O(degree) mask
+  std::vector<int> picked;
+  picked.reserve(k);
+  std::uniform_int_distribution<int> bucket_distrib(0, n - 1);
+  std::uniform_real_distribution<float> prob_distrib(0, 1.0);
+  // rejections allowed before switching to sample_rest
+  int max_reject = 2 * k + 8;
+  while (static_cast<int>(sample_result.size()) < k) {
+    int bucket = bucket_distrib(*rng);
+    int idx = prob_distrib(*rng) < prob[bucket] ? bucket : alias[bucket];
+    auto pos = std::lower_bound(picked.begin(), picked.end(), idx);
+    if (pos != picked.end() && *pos == idx) {
+      if (--max_reject < 0) {
+        sample_rest(k, rng, picked, &sample_result);
+        break;
+      }
+      continue;
+    }
+    picked.insert(pos, idx);
+    sample_result.push_back(idx);
+  }
+  return sample_result;
+}
+
+void AliasSampler::sample_rest(int k,
+                               const std::shared_ptr<std::mt19937_64> rng,
+                               const std::vector<int> &picked,
+                               std::vector<int> *sample_result) {
+  // Efraimidis-Spirakis over the neighbors not picked yet, keeping the ones
+  // with the largest log(u) / w.
+  int n = edges->size();
+  int rest = k - sample_result->size();
+  std::uniform_real_distribution<double> distrib(0, 1.0);
+  std::vector<std::pair<double, int>> keys;
+  keys.reserve(n - picked.size());
+  auto next_picked = picked.begin();
+  for (int i = 0; i < n; i++) {
+    if (next_picked != picked.end() && *next_picked == i) {
+      ++next_picked;
+      continue;
+    }
+    float weight = edges->get_weight(i);
+    double key = weight > 0
+                     ? std::log(std::max(distrib(*rng), 1e-300)) / weight
+                     : -std::numeric_limits<double>::infinity();
+    keys.emplace_back(key, i);
+  }
+  std::nth_element(
+      keys.begin(),
+      keys.begin() + rest - 1,
+      keys.end(),
+      [](const std::pair<double, int> &a, const std::pair<double, int> &b) {
+        return a.first > b.first;
+      });
+  for (int i = 0; i < rest; i++) {
+    sample_result->push_back(keys[i].second);
+  }
+}
 }  // namespace distributed
 }  // namespace paddle
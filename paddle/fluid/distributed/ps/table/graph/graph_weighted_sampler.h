@@ -62,5 +62,30 @@ class WeightedSampler : public Sampler {
       std::unordered_map<WeightedSampler *, int> &subtract_count_map,  // NOLINT
       float &subtract);                                                // NOLINT
 };
+
+// Walker/Vose alias table over the edge weights. Each draw costs O(1), and
+// k distinct neighbors are drawn by rejecting repeated ones, which gives the
+// same distribution as WeightedSampler. If the rejections pile up (a few
+// neighbors hold most of the weight), the rest of the sample is drawn from
+// the remaining neighbors in one linear pass.
+class AliasSampler : public Sampler {
+ public:
+  AliasSampler() : edges(nullptr), total_weight(0) {}
+  virtual ~AliasSampler() {}
+  virtual void build(GraphEdgeBlob *edges);
+  virtual std::vector<int> sample_k(int k,
+                                    const std::shared_ptr<std::mt19937_64> rng);
+  GraphEdgeBlob *edges;
+
+ private:
+  void sample_rest(int k,
+                   const std::shared_ptr<std::mt19937_64> rng,
+                   const std::vector<int> &picked,
+                   std::vector<int> *sample_result);
+
+  std::vector<float> prob;
+  std::vector<int> alias;
+  double total_weight;
+};
 }  // namespace distributed
 }  // namespace paddle
@@ -40,6 +40,191 @@ DEFINE_int32(pserver_table_save_max_retry, 3, "pserver_table_save_max_retry");
 namespace paddle {
 namespace distributed {
 
+// Collects in place updates of fully extended values of one shard, so that
+// the accessor and its sgd rules run them as one batched call instead of one
+// virtual call chain per key.
+class PushUpdateBatch {
+ public:
+  static const size_t kBatchSize = 128;
+
+  explicit PushUpdateBatch(ValueAccessor *accessor) : _accessor(accessor) {
+    _values.reserve(kBatchSize);
+    _updates.reserve(kBatchSize);
+  }
+  ~PushUpdateBatch() { Flush(); }
+
+  void Add(float *value, const float *update) {
+    _values.push_back(value);
+    _updates.push_back(update);
+    if (_values.size() == kBatchSize) {
+      Flush();
+    }
+  }
+  void Flush() {
+    if (_values.empty()) {
+      return;
+    }
+    _accessor->Update(_values.data(), _updates.data(), _values.size());
+    _values.clear();
+    _updates.clear();
+  }
+
+ private:
+  ValueAccessor *_accessor;
+  std::vector<float *> _values;
+  std::vector<const float *> _updates;
+};
+
+// Binary delta of one shard written by incremental save:
+//   header     | magic, version, number of erased keys
+//   erased     | uint64 keys removed by Shrink since the last save
+//   blocks     | uint32 key num, uint32 float num, then the key, value size
+//              | and value columns of up to kDeltaBlockKeys values
+//   terminator | block with zero keys
+// Erased keys are replayed before the blocks, a key shrunk and created again
+// keeps its new value.
+static const uint32_t kDeltaMagic = 0x4c445350;  // "PSDL"
+static const uint32_t kDeltaVersion = 1;
+static const size_t kDeltaBlockKeys = 64 * 1024;
+
+struct DeltaBlock {
+  std::vector<uint64_t> keys;
+  std::vector<uint32_t> sizes;
+  std::vector<float> values;
+
+  void clear() {
+    keys.clear();
+    sizes.clear();
+    values.clear();
+  }
+};
+
+static int WriteDeltaBlock(FsWriteChannel *channel, const DeltaBlock &block) {
+  uint32_t header[2] = {static_cast<uint32_t>(block.keys.size()),
+                        static_cast<uint32_t>(block.values.size())};
+  if (0 != channel->write(reinterpret_cast<const char *>(header),
+                          sizeof(header))) {
+    return -1;
+  }
+  if (block.keys.empty()) {
+    return 0;
+  }
+  if (0 != channel->write(reinterpret_cast<const char *>(block.keys.data()),
+                          block.keys.size() * sizeof(uint64_t)) ||
+      0 != channel->write(reinterpret_cast<const char *>(block.sizes.data()),
+                          block.sizes.size() * sizeof(uint32_t)) ||
+      0 != channel->write(reinterpret_cast<const char *>(block.values.data()),
+                          block.values.size() * sizeof(float))) {
+    return -1;
+  }
+  return 0;
+}
+
+// writes the values of shard stamped after saved_stamp, returns -1 on failure
+template <class SHARD>
+static int WriteDeltaShard(FsWriteChannel *channel,
+                           SHARD &shard,  // NOLINT
+                           const std::vector<uint64_t> &erased_keys,
+                           uint32_t saved_stamp,
+                           int *feasign_size) {
+  uint32_t header[3] = {
+      kDeltaMagic, kDeltaVersion, static_cast<uint32_t>(erased_keys.size())};
+  if (0 != channel->write(reinterpret_cast<const char *>(header),
+                          sizeof(header))) {
+    return -1;
+  }
+  if (!erased_keys.empty() &&
+      0 != channel->write(reinterpret_cast<const char *>(erased_keys.data()),
+                          erased_keys.size() * sizeof(uint64_t))) {
+    return -1;
+  }
+  DeltaBlock block;
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    auto &&value = it.value();
+    if (value.stamp() <= saved_stamp) {
+      continue;
+    }
+    block.keys.push_back(it.key());
+    block.sizes.push_back(static_cast<uint32_t>(value.size()));
+    block.values.insert(
+        block.values.end(), value.data(), value.data() + value.size());
+    ++*feasign_size;
+    if (block.keys.size() == kDeltaBlockKeys) {
+      if (0 != WriteDeltaBlock(channel, block)) {
+        return -1;
+      }
+      block.clear();
+    }
+  }
+  if (!block.keys.empty() && 0 != WriteDeltaBlock(channel, block)) {
+    return -1;
+  }
+  block.clear();
+  return WriteDeltaBlock(channel, block);
+}
+
+static bool ReadDeltaData(FsReadChannel *channel, void *data, size_t size) {
+  return size == 0 ||
+         channel->read(static_cast<char *>(data), size) ==
+             static_cast<int>(size);
+}
+
+// replays one delta file into shard, returns -1 on a truncated or bad file
+template <class SHARD>
+static int ReplayDeltaShard(FsReadChannel *channel,
+                            SHARD &shard,  // NOLINT
+                            size_t value_col) {
+  uint32_t header[3];
+  if (!ReadDeltaData(channel, header, sizeof(header)) ||
+      header[0] != kDeltaMagic || header[1] != kDeltaVersion) {
+    return -1;
+  }
+  std::vector<uint64_t> erased_keys(header[2]);
+  if (!ReadDeltaData(
+          channel, erased_keys.data(), erased_keys.size() * sizeof(uint64_t))) {
+    return -1;
+  }
+  for (auto key : erased_keys) {
+    shard.erase(key);
+  }
+  DeltaBlock block;
+  while (true) {
+    uint32_t block_header[2];
+    if (!ReadDeltaData(channel, block_header, sizeof(block_header))) {
+      return -1;
+    }
+    if (block_header[0] == 0) {
+      return 0;
+    }
+    block.keys.resize(block_header[0]);
+    block.sizes.resize(block_header[0]);
+    block.values.resize(block_header[1]);
+    if (!ReadDeltaData(channel,
+                       block.keys.data(),
+                       block.keys.size() * sizeof(uint64_t)) ||
+        !ReadDeltaData(channel,
+                       block.sizes.data(),
+                       block.sizes.size() * sizeof(uint32_t)) ||
+        !ReadDeltaData(channel,
+                       block.values.data(),
+                       block.values.size() * sizeof(float))) {
+      return -1;
+    }
+    const float *data = block.values.data();
+    const float *data_end = data + block.values.size();
+    for (size_t i = 0; i < block.keys.size(); ++i) {
+      size_t size = block.sizes[i];
+      if (size > value_col || data + size > data_end) {
+        return -1;
+      }
+      auto &&value = shard[block.keys[i]];
+      value.resize(size);
+      memcpy(value.data(), data, size * sizeof(float));
+      data += size;
+    }
+  }
+}
+
 int32_t MemorySparseTable::Initialize() {
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_sparse_update_all");
@@ -74,6 +259,20 @@ int32_t MemorySparseTable::InitializeValue() {
           << " _task_pool_size:" << _task_pool_size;
 
   _local_shards.reset(new shard_type[_real_local_shard_num]);
+  _delta_erased_keys.resize(_real_local_shard_num);
+
+  _use_flat_shard = _config.shard_map_type() == "flat";
+  if (_use_flat_shard) {
+    CHECK(!_config.enable_revert())
+        << "flat shard map does not support patch model";
+    size_t value_col = _value_accesor->GetAccessorInfo().size / sizeof(float);
+    _local_flat_shards.reset(new flat_shard_type[_real_local_shard_num]);
+    for (int i = 0; i < _real_local_shard_num; ++i) {
+      _local_flat_shards[i].set_value_dim(value_col);
+    }
+    VLOG(1) << "memory sparse table use flat shard map, value_col: "
+            << value_col;
+  }
 
   if (_config.enable_revert()) {
     // calculate merged shard number based on config param;
@@ -105,11 +304,19 @@ int32_t MemorySparseTable::InitializeValue() {
 int32_t MemorySparseTable::Load(const std::string &path,
                                 const std::string &param) {
   std::string table_path = TableDir(path);
-  auto file_list = _afs_client.list(table_path);
+  auto all_file_list = _afs_client.list(table_path);
 
-  std::sort(file_list.begin(), file_list.end());
-  for (auto file : file_list) {
+  std::sort(all_file_list.begin(), all_file_list.end());
+  // incremental deltas are named part-SSS-FFFFF.delta-NNNNN
+  std::vector<std::string> file_list;
+  std::vector<std::string> delta_file_list;
+  for (auto file : all_file_list) {
     VLOG(1) << "MemorySparseTable::Load() file list: " << file;
+    if (file.find(".delta-") != std::string::npos) {
+      delta_file_list.push_back(file);
+    } else {
+      file_list.push_back(file);
+    }
   }
 
   int load_param = atoi(param.c_str());
@@ -137,6 +344,29 @@ int32_t MemorySparseTable::Load(const std::string &path,
   size_t feature_value_size =
       _value_accesor->GetAccessorInfo().size / sizeof(float);
 
+  // deltas of every local shard, in save order
+  std::vector<std::vector<std::string>> shard_delta_files(
+      _real_local_shard_num);
+  _delta_seq = 0;
+  for (auto &file : delta_file_list) {
+    int file_idx = -1;
+    int seq = 0;
+    size_t name_pos = file.rfind('/');
+    name_pos = name_pos == std::string::npos ? 0 : name_pos + 1;
+    if (sscanf(file.c_str() + name_pos,  // NOLINT
+               "part-%*d-%d.delta-%d",
+               &file_idx,
+               &seq) != 2) {
+      LOG(WARNING) << "MemorySparseTable skip unknown delta file: " << file;
+      continue;
+    }
+    int local_idx = file_idx - static_cast<int>(file_start_idx);
+    if (local_idx >= 0 && local_idx < _real_local_shard_num) {
+      shard_delta_files[local_idx].push_back(file);
+      _delta_seq = std::max(_delta_seq, seq);
+    }
+  }
+
 #ifdef PADDLE_WITH_HETERPS
   int thread_num = _real_local_shard_num;
 #else
@@ -168,6 +398,14 @@ int32_t MemorySparseTable::Load(const std::string &path,
         while (read_channel->read_line(line_data) == 0 &&
                line_data.size() > 1) {
           uint64_t key = std::strtoul(line_data.data(), &end, 10);
+          if (_use_flat_shard) {
+            auto value = _local_flat_shards[i][key];
+            value.resize(feature_value_size);
+            int parse_size =
+                _value_accesor->ParseFromString(++end, value.data());
+            value.resize(parse_size);
+            continue;
+          }
           auto &value = shard[key];
           value.resize(feature_value_size);
           int parse_size = _value_accesor->ParseFromString(++end, value.data());
@@ -192,10 +430,48 @@ int32_t MemorySparseTable::Load(const std::string &path,
         exit(-1);
       }
     } while (is_read_failed);
+    for (auto &delta_file : shard_delta_files[i]) {
+      LoadDelta(i, delta_file);
+    }
   }
   LOG(INFO) << "MemorySparseTable load success, path from "
             << file_list[file_start_idx] << " to "
-            << file_list[file_start_idx + _real_local_shard_num - 1];
+            << file_list[file_start_idx + _real_local_shard_num - 1]
+            << ", delta num: " << _delta_seq;
+  return 0;
+}
+
+int32_t MemorySparseTable::LoadDelta(int shard_id, const std::string &path) {
+  size_t value_col = _value_accesor->GetAccessorInfo().size / sizeof(float);
+  FsChannelConfig channel_config;
+  channel_config.path = path;
+  int retry_num = 0;
+  while (true) {
+    int err_no = 0;
+    auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
+    int ret = -1;
+    if (_use_flat_shard) {
+      ret = ReplayDeltaShard(
+          read_channel.get(), _local_flat_shards[shard_id], value_col);
+    } else {
+      ret = ReplayDeltaShard(
+          read_channel.get(), _local_shards[shard_id], value_col);
+    }
+    read_channel->close();
+    if (ret == 0 && err_no != -1) {
+      break;
+    }
+    // replay only assigns and erases keys, running it again is harmless
+    ++retry_num;
+    LOG(ERROR) << "MemorySparseTable load delta failed, retry it! path:"
+               << path << " , retry_num=" << retry_num;
+    if (retry_num > FLAGS_pserver_table_save_max_retry) {
+      LOG(ERROR) << "MemorySparseTable load delta failed reach max limit!";
+      exit(-1);
+    }
+  }
+  VLOG(1) << "MemorySparseTable::LoadDelta " << path << " into local shard "
+          << shard_id;
   return 0;
 }
 
@@ -328,6 +604,17 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     return 0;
   }
 
+  // incremental checkpoint
+  if (save_param == 6) {
+    return SaveDelta(dirname);
+  }
+  // xbox and batch model saves reset or decay statistics of the values, those
+  // changes must reach the next delta as well
+  bool track_change = _config.enable_incremental_save() && save_param != 0;
+  uint32_t save_stamp = save_param == 0 ? _delta_stamp.fetch_add(1)
+                                        : _delta_stamp.load();
+  size_t value_col = _value_accesor->GetAccessorInfo().size / sizeof(float);
+
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
   TopkCalculator tk(_real_local_shard_num, tk_size);
@@ -367,61 +654,173 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     int feasign_size = 0;
     int retry_num = 0;
     int err_no = 0;
-    auto &shard = _local_shards[i];
+    std::vector<float> value_before(value_col);
+    auto save_shard = [&](auto &shard) {
+      do {
+        err_no = 0;
+        feasign_size = 0;
+        is_write_failed = false;
+        auto write_channel =
+            _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+        for (auto it = shard.begin(); it != shard.end(); ++it) {
+          if (_config.enable_sparse_table_cache() &&
+              (save_param == 1 || save_param == 2) &&
+              _value_accesor->Save(it.value().data(), 4)) {
+            CostTimer timer10("sprase table top push");
+            tk.push(i, _value_accesor->GetField(it.value().data(), "show"));
+          }
+
+          size_t value_bytes = it.value().size() * sizeof(float);
+          if (track_change) {
+            memcpy(value_before.data(), it.value().data(), value_bytes);
+          }
+          bool need_save = _value_accesor->Save(it.value().data(), save_param);
+          if (track_change && memcmp(value_before.data(),
+                                     it.value().data(),
+                                     value_bytes) != 0) {
+            it.value().set_stamp(save_stamp);
+          }
+          if (need_save) {
+            std::string format_value = _value_accesor->ParseToString(
+                it.value().data(), it.value().size());
+            if (0 != write_channel->write_line(paddle::string::format_string(
+                         "%lu %s", it.key(), format_value.c_str()))) {
+              ++retry_num;
+              is_write_failed = true;
+              LOG(ERROR)
+                  << "MemorySparseTable save prefix failed, retry it! path:"
+                  << channel_config.path << " , retry_num=" << retry_num;
+              break;
+            }
+            ++feasign_size;
+          }
+        }
+        write_channel->close();
+        if (err_no == -1) {
+          ++retry_num;
+          is_write_failed = true;
+          LOG(ERROR)
+              << "MemorySparseTable save prefix failed after write, retry it! "
+              << "path:" << channel_config.path << " , retry_num=" << retry_num;
+        }
+        if (is_write_failed) {
+          _afs_client.remove(channel_config.path);
+        }
+        if (retry_num > FLAGS_pserver_table_save_max_retry) {
+          LOG(ERROR) << "MemorySparseTable save prefix failed reach max limit!";
+          exit(-1);
+        }
+      } while (is_write_failed);
+      feasign_size_all += feasign_size;
+      for (auto it = shard.begin(); it != shard.end(); ++it) {
+        size_t value_bytes = it.value().size() * sizeof(float);
+        if (track_change) {
+          memcpy(value_before.data(), it.value().data(), value_bytes);
+        }
+        _value_accesor->UpdateStatAfterSave(it.value().data(), save_param);
+        if (track_change &&
+            memcmp(value_before.data(), it.value().data(), value_bytes) !=
+                0) {
+          it.value().set_stamp(save_stamp);
+        }
+      }
+    };
+    if (_use_flat_shard) {
+      save_shard(_local_flat_shards[i]);
+    } else {
+      save_shard(_local_shards[i]);
+    }
+    LOG(INFO) << "MemorySparseTable save prefix success, path: "
+              << channel_config.path << " feasign_size: " << feasign_size;
+  }
+  if (save_param == 0) {
+    // a new base, the deltas of the old one were removed with its files
+    _saved_stamp = save_stamp;
+    _delta_seq = 0;
+    for (auto &erased_keys : _delta_erased_keys) {
+      erased_keys.clear();
+    }
+  }
+  _local_show_threshold = tk.top();
+  // int32 may overflow need to change return value
+  return 0;
+}
+
+int32_t MemorySparseTable::SaveDelta(const std::string &dirname) {
+  if (!_config.enable_incremental_save()) {
+    LOG(ERROR) << "MemorySparseTable incremental save needs "
+                  "enable_incremental_save, table_id: "
+               << _config.table_id();
+    return -1;
+  }
+  // changes made while saving get the next stamp and go to the next delta
+  uint32_t save_stamp = _delta_stamp.fetch_add(1);
+  int delta_seq = ++_delta_seq;
+  std::string table_path = TableDir(dirname);
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  std::atomic<uint64_t> feasign_size_all{0};
+
+#ifdef PADDLE_WITH_HETERPS
+  int thread_num = _real_local_shard_num;
+#else
+  int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
+#endif
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config;
+    channel_config.path =
+        paddle::string::format_string("%s/part-%03d-%05d.delta-%05d",
+                                      table_path.c_str(),
+                                      _shard_idx,
+                                      file_start_idx + i,
+                                      delta_seq);
+    bool is_write_failed = false;
+    int feasign_size = 0;
+    int retry_num = 0;
+    int err_no = 0;
     do {
       err_no = 0;
       feasign_size = 0;
       is_write_failed = false;
       auto write_channel =
           _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        if (_config.enable_sparse_table_cache() &&
-            (save_param == 1 || save_param == 2) &&
-            _value_accesor->Save(it.value().data(), 4)) {
-          CostTimer timer10("sprase table top push");
-          tk.push(i, _value_accesor->GetField(it.value().data(), "show"));
-        }
-
-        if (_value_accesor->Save(it.value().data(), save_param)) {
-          std::string format_value = _value_accesor->ParseToString(
-              it.value().data(), it.value().size());
-          if (0 != write_channel->write_line(paddle::string::format_string(
-                       "%lu %s", it.key(), format_value.c_str()))) {
-            ++retry_num;
-            is_write_failed = true;
-            LOG(ERROR)
-                << "MemorySparseTable save prefix failed, retry it! path:"
-                << channel_config.path << " , retry_num=" << retry_num;
-            break;
-          }
-          ++feasign_size;
-        }
+      int ret = 0;
+      if (_use_flat_shard) {
+        ret = WriteDeltaShard(write_channel.get(),
+                              _local_flat_shards[i],
+                              _delta_erased_keys[i],
+                              _saved_stamp,
+                              &feasign_size);
+      } else {
+        ret = WriteDeltaShard(write_channel.get(),
+                              _local_shards[i],
+                              _delta_erased_keys[i],
+                              _saved_stamp,
+                              &feasign_size);
       }
       write_channel->close();
-      if (err_no == -1) {
+      if (ret != 0 || err_no == -1) {
         ++retry_num;
         is_write_failed = true;
-        LOG(ERROR)
-            << "MemorySparseTable save prefix failed after write, retry it! "
-            << "path:" << channel_config.path << " , retry_num=" << retry_num;
-      }
-      if (is_write_failed) {
+        LOG(ERROR) << "MemorySparseTable save delta failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
         _afs_client.remove(channel_config.path);
       }
       if (retry_num > FLAGS_pserver_table_save_max_retry) {
-        LOG(ERROR) << "MemorySparseTable save prefix failed reach max limit!";
+        LOG(ERROR) << "MemorySparseTable save delta failed reach max limit!";
         exit(-1);
       }
     } while (is_write_failed);
     feasign_size_all += feasign_size;
-    for (auto it = shard.begin(); it != shard.end(); ++it) {
-      _value_accesor->UpdateStatAfterSave(it.value().data(), save_param);
-    }
-    LOG(INFO) << "MemorySparseTable save prefix success, path: "
-              << channel_config.path << " feasign_size: " << feasign_size;
+    LOG(INFO) << "MemorySparseTable save delta success, path: "
+              << channel_config.path << " feasign_size: " << feasign_size
+              << " erased_size: " << _delta_erased_keys[i].size();
+    _delta_erased_keys[i].clear();
   }
-  _local_show_threshold = tk.top();
-  // int32 may overflow need to change return value
+  _saved_stamp = save_stamp;
+  LOG(INFO) << "MemorySparseTable save delta " << delta_seq
+            << " done, feasign_size: " << feasign_size_all;
   return 0;
 }
 
@@ -523,6 +922,18 @@ int64_t MemorySparseTable::CacheShuffle(
         &shuffled_channel,
     const std::vector<Table *> &table_ptrs) {
   LOG(INFO) << "cache shuffle with cache threshold: " << cache_threshold;
+  // the shards of table_ptrs are read as shard_type
+  bool use_flat_shard = _use_flat_shard;
+  for (auto table_ptr : table_ptrs) {
+    auto *sparse_table = dynamic_cast<MemorySparseTable *>(table_ptr);
+    if (sparse_table != nullptr && sparse_table->UseFlatShard()) {
+      use_flat_shard = true;
+    }
+  }
+  if (use_flat_shard) {
+    LOG(ERROR) << "cache shuffle is not supported by flat shard map";
+    return -1;
+  }
   int save_param = atoi(param.c_str());  // batch_model:0  xbox:1
   if (!_config.enable_sparse_table_cache() || cache_threshold < 0) {
     LOG(WARNING)
@@ -678,7 +1089,8 @@ int32_t MemorySparseTable::SaveCache(
 int64_t MemorySparseTable::LocalSize() {
   int64_t local_size = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
-    local_size += _local_shards[i].size();
+    local_size += _use_flat_shard ? _local_flat_shards[i].size()
+                                  : _local_shards[i].size();
   }
   return local_size;
 }
@@ -691,12 +1103,18 @@ int64_t MemorySparseTable::LocalMFSize() {
     tasks[shard_id] =
         _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
             [this, shard_id, &size_arr]() -> int {
-              auto &local_shard = _local_shards[shard_id];
-              for (auto it = local_shard.begin(); it != local_shard.end();
-                   ++it) {
-                if (_value_accesor->HasMF(it.value().size())) {
-                  size_arr[shard_id] += 1;
+              auto count_mf = [&](auto &local_shard) {
+                for (auto it = local_shard.begin(); it != local_shard.end();
+                     ++it) {
+                  if (_value_accesor->HasMF(it.value().size())) {
+                    size_arr[shard_id] += 1;
+                  }
                 }
+              };
+              if (_use_flat_shard) {
+                count_mf(_local_flat_shards[shard_id]);
+              } else {
+                count_mf(_local_shards[shard_id]);
               }
               return 0;
             });
@@ -710,9 +1128,35 @@ int64_t MemorySparseTable::LocalMFSize() {
   return ret_size;
 }
 
+std::pair<int64_t, int64_t> MemorySparseTable::LocalValueMemoryStat() {
+  int64_t live_bytes = 0;
+  int64_t reserved_bytes = 0;
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    int64_t shard_live = 0;
+    int64_t shard_reserved = 0;
+    if (_use_flat_shard) {
+      auto &shard = _local_flat_shards[i];
+      shard_live = shard.size() * shard.value_dim() * sizeof(float);
+      shard_reserved = shard.memory_size();
+    } else {
+      shard_live = _local_shards[i].value_live_bytes();
+      shard_reserved = _local_shards[i].value_reserved_bytes();
+    }
+    VLOG(1) << "MemorySparseTable shard " << i
+            << " value live_bytes: " << shard_live
+            << " reserved_bytes: " << shard_reserved;
+    live_bytes += shard_live;
+    reserved_bytes += shard_reserved;
+  }
+  LOG(INFO) << "MemorySparseTable value live_bytes: " << live_bytes
+            << " reserved_bytes: " << reserved_bytes;
+  return {live_bytes, reserved_bytes};
+}
+
 std::pair<int64_t, int64_t> MemorySparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
   int64_t mf_size = LocalMFSize();
+  LocalValueMemoryStat();
   return {feasign_size, mf_size};
 }
 
@@ -744,6 +1188,9 @@ int32_t MemorySparseTable::Push(TableContext &context) {
 
 int32_t MemorySparseTable::PullSparse(float *pull_values,
                                       const PullSparseValue &pull_value) {
+  if (_use_flat_shard) {
+    return PullSparseFlat(pull_values, pull_value);
+  }
   CostTimer timer("pserver_sparse_select_all");
   std::vector<std::future<int>> tasks(_real_local_shard_num);
 
@@ -776,6 +1223,7 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
               auto &local_shard = _local_shards[shard_id];
               float data_buffer[value_size];  // NOLINT
               float *data_buffer_ptr = data_buffer;
+              uint32_t stamp = _delta_stamp.load(std::memory_order_relaxed);
 
               auto &keys = task_keys[shard_id];
               for (auto &item : keys) {
@@ -789,6 +1237,7 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
                   } else {
                     auto &feature_value = local_shard[key];
                     feature_value.resize(data_size);
+                    feature_value.set_stamp(stamp);
                     float *data_ptr = feature_value.data();
                     _value_accesor->Create(&data_buffer_ptr, 1);
                     memcpy(
@@ -824,6 +1273,11 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                                          const uint64_t *keys,
                                          size_t num,
                                          uint16_t pass_id) {
+  if (_use_flat_shard) {
+    // values are relocated on rehash, no stable pointer can be handed out
+    LOG(ERROR) << "PullSparsePtr is not supported by flat shard map";
+    return -1;
+  }
   CostTimer timer("pscore_sparse_select_all");
   size_t value_size = _value_accesor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
@@ -850,6 +1304,8 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
               auto &local_shard = _local_shards[shard_id];
               float data_buffer[value_size];  // NOLINT
               float *data_buffer_ptr = data_buffer;
+              // callers update the values through the returned pointers
+              uint32_t stamp = _delta_stamp.load(std::memory_order_relaxed);
               for (auto &item : keys) {
                 uint64_t key = item.first;
                 auto itr = local_shard.find(key);
@@ -866,6 +1322,7 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                 } else {
                   ret = itr.value_ptr();
                 }
+                ret->set_stamp(stamp);
                 int pull_data_idx = item.second;
                 pull_values[pull_data_idx] = reinterpret_cast<char *>(ret);
               }
@@ -881,6 +1338,9 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
 int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                                       const float *values,
                                       size_t num) {
+  if (_use_flat_shard) {
+    return PushSparseFlat(keys, values, nullptr, num);
+  }
   CostTimer timer("pserver_sparse_update_all");
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
@@ -911,6 +1371,8 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
           auto &local_shard_new = _local_shards_new[shard_id];
           float data_buffer[value_col];  // NOLINT
           float *data_buffer_ptr = data_buffer;
+          uint32_t stamp = _delta_stamp.load(std::memory_order_relaxed);
+          PushUpdateBatch update_batch(_value_accesor.get());
           for (auto &item : keys) {
             uint64_t key = item.first;
             uint64_t push_data_idx = item.second;
@@ -933,10 +1395,15 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
             }
 
             auto &feature_value = itr.value();
+            feature_value.set_stamp(stamp);
             float *value_data = feature_value.data();
             size_t value_size = feature_value.size();
 
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
+            if (value_size == value_col && !_config.enable_revert()) {
+              // 已拓展到最大size, 攒批后就地update
+              update_batch.Add(value_data, update_data);
+              continue;
+            } else if (value_size == value_col) {
               _value_accesor->Update(&value_data, &update_data, 1);
             } else {
               // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
@@ -959,6 +1426,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                      new_size * sizeof(float));
             }
           }
+          update_batch.Flush();
           return 0;
         });
   }
@@ -972,6 +1440,9 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
 int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                                       const float **values,
                                       size_t num) {
+  if (_use_flat_shard) {
+    return PushSparseFlat(keys, nullptr, values, num);
+  }
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
       _real_local_shard_num);
@@ -999,6 +1470,8 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
           auto &local_shard = _local_shards[shard_id];
           float data_buffer[value_col];  // NOLINT
           float *data_buffer_ptr = data_buffer;
+          uint32_t stamp = _delta_stamp.load(std::memory_order_relaxed);
+          PushUpdateBatch update_batch(_value_accesor.get());
           for (auto &item : keys) {
             uint64_t key = item.first;
             uint64_t push_data_idx = item.second;
@@ -1019,10 +1492,12 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               itr = local_shard.find(key);
             }
             auto &feature_value = itr.value();
+            feature_value.set_stamp(stamp);
             float *value_data = feature_value.data();
             size_t value_size = feature_value.size();
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accesor->Update(&value_data, &update_data, 1);
+            if (value_size == value_col) {
+              // 已拓展到最大size, 攒批后就地update
+              update_batch.Add(value_data, update_data);
             } else {
               // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
               memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
@@ -1035,6 +1510,169 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
           }
+          update_batch.Flush();
+          return 0;
+        });
+  }
+
+  for (auto &task : tasks) {
+    task.wait();
+  }
+  return 0;
+}
+
+int32_t MemorySparseTable::PullSparseFlat(float *pull_values,
+                                          const PullSparseValue &pull_value) {
+  CostTimer timer("pserver_sparse_select_all");
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+
+  const size_t value_size =
+      _value_accesor->GetAccessorInfo().size / sizeof(float);
+  size_t mf_value_size =
+      _value_accesor->GetAccessorInfo().mf_size / sizeof(float);
+  size_t select_value_size =
+      _value_accesor->GetAccessorInfo().select_size / sizeof(float);
+
+  std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
+      _real_local_shard_num);
+  size_t num = pull_value.numel_;
+  for (size_t i = 0; i < num; ++i) {
+    int shard_id = (pull_value.feasigns_[i] % _sparse_table_shard_num) %
+                   _avg_local_shard_num;
+    task_keys[shard_id].push_back({pull_value.feasigns_[i], i});
+  }
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this,
+             shard_id,
+             &task_keys,
+             value_size,
+             pull_values,
+             mf_value_size,
+             select_value_size]() -> int {
+              auto &local_shard = _local_flat_shards[shard_id];
+              float data_buffer[value_size];  // NOLINT
+              float *data_buffer_ptr = data_buffer;
+              uint32_t stamp = _delta_stamp.load(std::memory_order_relaxed);
+              for (auto &item : task_keys[shard_id]) {
+                uint64_t key = item.first;
+                auto itr = local_shard.find(key);
+                size_t data_size = value_size - mf_value_size;
+                if (itr == local_shard.end()) {
+                  if (FLAGS_pserver_create_value_when_push) {
+                    memset(data_buffer, 0, sizeof(float) * data_size);
+                  } else {
+                    auto feature_value = local_shard[key];
+                    feature_value.resize(data_size);
+                    feature_value.set_stamp(stamp);
+                    _value_accesor->Create(&data_buffer_ptr, 1);
+                    memcpy(feature_value.data(),
+                           data_buffer_ptr,
+                           data_size * sizeof(float));
+                  }
+                } else {
+                  auto feature_value = itr.value();
+                  data_size = feature_value.size();
+                  memcpy(data_buffer_ptr,
+                         feature_value.data(),
+                         data_size * sizeof(float));
+                }
+                for (size_t mf_idx = data_size; mf_idx < value_size; ++mf_idx) {
+                  data_buffer[mf_idx] = 0.0;
+                }
+                float *select_data =
+                    pull_values + select_value_size * item.second;
+                _value_accesor->Select(
+                    &select_data, (const float **)&data_buffer_ptr, 1);
+              }
+              return 0;
+            });
+  }
+
+  for (auto &task : tasks) {
+    task.wait();
+  }
+  return 0;
+}
+
+int32_t MemorySparseTable::PushSparseFlat(const uint64_t *keys,
+                                          const float *values,
+                                          const float **value_ptrs,
+                                          size_t num) {
+  CostTimer timer("pserver_sparse_update_all");
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+  std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
+      _real_local_shard_num);
+  for (size_t i = 0; i < num; ++i) {
+    int shard_id = (keys[i] % _sparse_table_shard_num) % _avg_local_shard_num;
+    task_keys[shard_id].push_back({keys[i], i});
+  }
+
+  const size_t value_col =
+      _value_accesor->GetAccessorInfo().size / sizeof(float);
+  size_t mf_value_col =
+      _value_accesor->GetAccessorInfo().mf_size / sizeof(float);
+  size_t update_value_col =
+      _value_accesor->GetAccessorInfo().update_size / sizeof(float);
+
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
+        [this,
+         shard_id,
+         value_col,
+         mf_value_col,
+         update_value_col,
+         values,
+         value_ptrs,
+         &task_keys]() -> int {
+          auto &local_shard = _local_flat_shards[shard_id];
+          float data_buffer[value_col];  // NOLINT
+          float *data_buffer_ptr = data_buffer;
+          uint32_t stamp = _delta_stamp.load(std::memory_order_relaxed);
+          PushUpdateBatch update_batch(_value_accesor.get());
+          for (auto &item : task_keys[shard_id]) {
+            uint64_t key = item.first;
+            uint64_t push_data_idx = item.second;
+            const float *update_data =
+                values != nullptr ? values + push_data_idx * update_value_col
+                                  : value_ptrs[push_data_idx];
+            auto itr = local_shard.find(key);
+            if (itr == local_shard.end()) {
+              if (FLAGS_pserver_enable_create_feasign_randomly &&
+                  !_value_accesor->CreateValue(1, update_data)) {
+                continue;
+              }
+              auto value_size = value_col - mf_value_col;
+              // insertion may rehash and move the values queued so far
+              update_batch.Flush();
+              itr = local_shard.emplace(key).first;
+              auto feature_value = itr.value();
+              feature_value.resize(value_size);
+              _value_accesor->Create(&data_buffer_ptr, 1);
+              memcpy(feature_value.data(),
+                     data_buffer_ptr,
+                     value_size * sizeof(float));
+            }
+
+            // slot capacity is value_col, so extending mf never reallocates
+            auto feature_value = itr.value();
+            feature_value.set_stamp(stamp);
+            float *value_data = feature_value.data();
+            size_t value_size = feature_value.size();
+            if (value_size == value_col) {
+              update_batch.Add(value_data, update_data);
+            } else {
+              memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
+              _value_accesor->Update(&data_buffer_ptr, &update_data, 1);
+              if (_value_accesor->NeedExtendMF(data_buffer)) {
+                feature_value.resize(value_col);
+                _value_accesor->Create(&value_data, 1);
+              }
+              memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
+            }
+          }
+          update_batch.Flush();
           return 0;
         });
   }
@@ -1050,17 +1688,35 @@ int32_t MemorySparseTable::Flush() { return 0; }
 int32_t MemorySparseTable::Shrink(const std::string &param) {
   VLOG(0) << "MemorySparseTable::Shrink";
   // TODO(zhaocaibei123): implement with multi-thread
-  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
-    // Shrink
-    auto &shard = _local_shards[shard_id];
+  bool track_erased = _config.enable_incremental_save();
+  uint32_t stamp = _delta_stamp.load();
+  auto shrink_shard = [this, track_erased, stamp](
+                          auto &shard, std::vector<uint64_t> *erased_keys) {
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accesor->Shrink(it.value().data())) {
+        if (track_erased) {
+          erased_keys->push_back(it.key());
+        }
         it = shard.erase(it);
       } else {
+        // show / click of the kept values are decayed
+        it.value().set_stamp(stamp);
         ++it;
       }
     }
+  };
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    // Shrink
+    if (_use_flat_shard) {
+      shrink_shard(_local_flat_shards[shard_id],
+                   &_delta_erased_keys[shard_id]);
+    } else {
+      shrink_shard(_local_shards[shard_id], &_delta_erased_keys[shard_id]);
+      // 回收shrink后空闲的slab页
+      _local_shards[shard_id].compact_values();
+    }
   }
+  LocalValueMemoryStat();
   return 0;
 }
 
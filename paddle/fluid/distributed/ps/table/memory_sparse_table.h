@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <pthread.h>
 
+#include <atomic>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
@@ -29,6 +30,7 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
+#include "paddle/fluid/distributed/ps/table/depends/flat_sparse_table_shard.h"
 #include "paddle/fluid/string/string_helper.h"
 
 #define PSERVER_SAVE_SUFFIX ".shard"
@@ -39,6 +41,7 @@ namespace distributed {
 class MemorySparseTable : public Table {
  public:
   typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  typedef FlatSparseTableShard flat_shard_type;
   MemorySparseTable() {}
   virtual ~MemorySparseTable() {}
 
@@ -65,8 +68,11 @@ class MemorySparseTable : public Table {
   int32_t InitializeShard() override { return 0; }
   int32_t InitializeValue();
 
+  // replays the incremental deltas found next to the base files in order
   int32_t Load(const std::string& path, const std::string& param) override;
 
+  // param 6 appends an incremental delta of the values changed since the last
+  // checkpoint (param 0) or delta, see enable_incremental_save
   int32_t Save(const std::string& path, const std::string& param) override;
 
   int32_t SaveCache(
@@ -86,6 +92,8 @@ class MemorySparseTable : public Table {
       const std::vector<Table*>& table_ptrs) override;
   int64_t LocalSize();
   int64_t LocalMFSize();
+  // live / reserved bytes of the sparse values, logged per shard
+  std::pair<int64_t, int64_t> LocalValueMemoryStat();
 
   std::pair<int64_t, int64_t> PrintTableStat() override;
   int32_t PullSparse(float* values, const PullSparseValue& pull_value);
@@ -104,9 +112,14 @@ class MemorySparseTable : public Table {
   int32_t Shrink(const std::string& param) override;
   void Clear() override;
 
+  // a flat_shard_type* if UseFlatShard(), a shard_type* otherwise
   void* GetShard(size_t shard_idx) override {
+    if (_use_flat_shard) {
+      return &_local_flat_shards[shard_idx];
+    }
     return &_local_shards[shard_idx];
   }
+  bool UseFlatShard() const { return _use_flat_shard; }
 
   virtual void Revert();
   virtual void CheckSavePrePatchDone();
@@ -115,6 +128,15 @@ class MemorySparseTable : public Table {
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
+  // incremental checkpoint, binary columnar delta per shard
+  int32_t SaveDelta(const std::string& path);
+  int32_t LoadDelta(int shard_id, const std::string& path);
+  // shard_map_type: flat, values inlined into the shard slab
+  int32_t PullSparseFlat(float* values, const PullSparseValue& pull_value);
+  int32_t PushSparseFlat(const uint64_t* keys,
+                         const float* values,
+                         const float** value_ptrs,
+                         size_t num);
 
   int _task_pool_size = 24;
   int _avg_local_shard_num;
@@ -122,6 +144,15 @@ class MemorySparseTable : public Table {
   int _sparse_table_shard_num;
   std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
   std::unique_ptr<shard_type[]> _local_shards;
+  bool _use_flat_shard{false};
+  std::unique_ptr<flat_shard_type[]> _local_flat_shards;
+
+  // for incremental save: every change stamps the value with _delta_stamp,
+  // values stamped above _saved_stamp go into the next delta
+  std::atomic<uint32_t> _delta_stamp{1};
+  uint32_t _saved_stamp{0};
+  int _delta_seq{0};
+  std::vector<std::vector<uint64_t>> _delta_erased_keys;  // by Shrink
 
   // for patch model
   int _m_avg_local_shard_num;
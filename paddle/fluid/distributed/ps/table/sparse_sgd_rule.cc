@@ -17,12 +17,260 @@
 #include <gflags/gflags.h>
 
 #include "glog/logging.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
+
+// The SIMD kernels below are compiled with per-function target attributes
+// and picked at runtime, so they do not depend on the -m flags of the build.
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(_WIN32)
+#define PS_SGD_RULE_X86_DISPATCH
+#include <immintrin.h>
+#endif
 
 DEFINE_bool(enable_show_scale_gradient, true, "enable show scale gradient");
 
 namespace paddle {
 namespace distributed {
 
+// Kernels of the batched update path. Bounds follow BoundValue: NaN goes to
+// min_bound, since max(NaN, lo) returns lo for both the intrinsics and the
+// scalar tail below.
+static inline float BoundScalar(float w, float lo, float hi) {
+  if (!(w >= lo)) {
+    return lo;
+  } else if (!(w <= hi)) {
+    return hi;
+  }
+  return w;
+}
+
+#ifdef PS_SGD_RULE_X86_DISPATCH
+enum class SimdLevel { kScalar, kAvx2, kAvx512 };
+
+static SimdLevel GetSimdLevel() {
+  // MayIUse has no FMA bit, every AVX2 cpu has FMA3
+  static const SimdLevel level = [] {
+    if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f)) {
+      return SimdLevel::kAvx512;
+    } else if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx2)) {
+      return SimdLevel::kAvx2;
+    }
+    return SimdLevel::kScalar;
+  }();
+  return level;
+}
+
+// gcc 12 reports the _mm512_undefined_ps inside the avx512 intrinsics as
+// uninitialized
+#ifndef __clang__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#define PS_SGD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define PS_SGD_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+
+// The avx2 kernels handle the multiple-of-8 prefix and return its length,
+// the avx512 kernels handle the tail with masked loads and stores.
+PS_SGD_TARGET_AVX2 static size_t AxpyBoundSquareSumAvx2(size_t n,
+                                                        float a,
+                                                        const float *g,
+                                                        float *w,
+                                                        float lo,
+                                                        float hi,
+                                                        float *square_sum) {
+  size_t i = 0;
+  __m256 va = _mm256_set1_ps(a);
+  __m256 vlo = _mm256_set1_ps(lo);
+  __m256 vhi = _mm256_set1_ps(hi);
+  __m256 vsum = _mm256_setzero_ps();
+  for (; i + 8 <= n; i += 8) {
+    __m256 vg = _mm256_loadu_ps(g + i);
+    __m256 vw = _mm256_fmadd_ps(va, vg, _mm256_loadu_ps(w + i));
+    vw = _mm256_min_ps(_mm256_max_ps(vw, vlo), vhi);
+    _mm256_storeu_ps(w + i, vw);
+    vsum = _mm256_fmadd_ps(vg, vg, vsum);
+  }
+  __m128 vsum4 =
+      _mm_add_ps(_mm256_castps256_ps128(vsum), _mm256_extractf128_ps(vsum, 1));
+  vsum4 = _mm_add_ps(vsum4, _mm_movehl_ps(vsum4, vsum4));
+  vsum4 = _mm_add_ss(vsum4, _mm_movehdup_ps(vsum4));
+  *square_sum += _mm_cvtss_f32(vsum4);
+  return i;
+}
+
+PS_SGD_TARGET_AVX512 static float AxpyBoundSquareSumAvx512(
+    size_t n, float a, const float *g, float *w, float lo, float hi) {
+  __m512 va = _mm512_set1_ps(a);
+  __m512 vlo = _mm512_set1_ps(lo);
+  __m512 vhi = _mm512_set1_ps(hi);
+  __m512 vsum = _mm512_setzero_ps();
+  for (size_t i = 0; i < n; i += 16) {
+    __mmask16 mask = n - i >= 16 ? 0xFFFF : (1u << (n - i)) - 1;
+    __m512 vg = _mm512_maskz_loadu_ps(mask, g + i);
+    __m512 vw = _mm512_fmadd_ps(va, vg, _mm512_maskz_loadu_ps(mask, w + i));
+    vw = _mm512_min_ps(_mm512_max_ps(vw, vlo), vhi);
+    _mm512_mask_storeu_ps(w + i, mask, vw);
+    vsum = _mm512_fmadd_ps(vg, vg, vsum);
+  }
+  return _mm512_reduce_add_ps(vsum);
+}
+
+PS_SGD_TARGET_AVX2 static size_t StdAdaGradKernelAvx2(size_t n,
+                                                      float lr,
+                                                      float init_g2sum,
+                                                      float inv_scale,
+                                                      const float *g,
+                                                      float *w,
+                                                      float *g2sum,
+                                                      float lo,
+                                                      float hi) {
+  size_t i = 0;
+  __m256 vlr = _mm256_set1_ps(lr);
+  __m256 vinit = _mm256_set1_ps(init_g2sum);
+  __m256 vinv = _mm256_set1_ps(inv_scale);
+  __m256 vlo = _mm256_set1_ps(lo);
+  __m256 vhi = _mm256_set1_ps(hi);
+  for (; i + 8 <= n; i += 8) {
+    __m256 vsg = _mm256_mul_ps(_mm256_loadu_ps(g + i), vinv);
+    __m256 vg2 = _mm256_loadu_ps(g2sum + i);
+    __m256 vratio =
+        _mm256_sqrt_ps(_mm256_div_ps(vinit, _mm256_add_ps(vinit, vg2)));
+    __m256 vw = _mm256_fnmadd_ps(
+        vlr, _mm256_mul_ps(vsg, vratio), _mm256_loadu_ps(w + i));
+    vw = _mm256_min_ps(_mm256_max_ps(vw, vlo), vhi);
+    _mm256_storeu_ps(w + i, vw);
+    _mm256_storeu_ps(g2sum + i, _mm256_fmadd_ps(vsg, vsg, vg2));
+  }
+  return i;
+}
+
+PS_SGD_TARGET_AVX512 static void StdAdaGradKernelAvx512(size_t n,
+                                                        float lr,
+                                                        float init_g2sum,
+                                                        float inv_scale,
+                                                        const float *g,
+                                                        float *w,
+                                                        float *g2sum,
+                                                        float lo,
+                                                        float hi) {
+  __m512 vlr = _mm512_set1_ps(lr);
+  __m512 vinit = _mm512_set1_ps(init_g2sum);
+  __m512 vinv = _mm512_set1_ps(inv_scale);
+  __m512 vlo = _mm512_set1_ps(lo);
+  __m512 vhi = _mm512_set1_ps(hi);
+  for (size_t i = 0; i < n; i += 16) {
+    __mmask16 mask = n - i >= 16 ? 0xFFFF : (1u << (n - i)) - 1;
+    __m512 vsg = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, g + i), vinv);
+    __m512 vg2 = _mm512_maskz_loadu_ps(mask, g2sum + i);
+    __m512 vratio =
+        _mm512_sqrt_ps(_mm512_div_ps(vinit, _mm512_add_ps(vinit, vg2)));
+    __m512 vw = _mm512_fnmadd_ps(
+        vlr, _mm512_mul_ps(vsg, vratio), _mm512_maskz_loadu_ps(mask, w + i));
+    vw = _mm512_min_ps(_mm512_max_ps(vw, vlo), vhi);
+    _mm512_mask_storeu_ps(w + i, mask, vw);
+    _mm512_mask_storeu_ps(g2sum + i, mask, _mm512_fmadd_ps(vsg, vsg, vg2));
+  }
+}
+
+PS_SGD_TARGET_AVX2 static size_t BoundRangeAvx2(size_t n,
+                                                float *w,
+                                                float lo,
+                                                float hi) {
+  size_t i = 0;
+  __m256 vlo = _mm256_set1_ps(lo);
+  __m256 vhi = _mm256_set1_ps(hi);
+  for (; i + 8 <= n; i += 8) {
+    __m256 vw = _mm256_loadu_ps(w + i);
+    _mm256_storeu_ps(w + i, _mm256_min_ps(_mm256_max_ps(vw, vlo), vhi));
+  }
+  return i;
+}
+
+PS_SGD_TARGET_AVX512 static void BoundRangeAvx512(size_t n,
+                                                  float *w,
+                                                  float lo,
+                                                  float hi) {
+  __m512 vlo = _mm512_set1_ps(lo);
+  __m512 vhi = _mm512_set1_ps(hi);
+  for (size_t i = 0; i < n; i += 16) {
+    __mmask16 mask = n - i >= 16 ? 0xFFFF : (1u << (n - i)) - 1;
+    __m512 vw = _mm512_maskz_loadu_ps(mask, w + i);
+    _mm512_mask_storeu_ps(
+        w + i, mask, _mm512_min_ps(_mm512_max_ps(vw, vlo), vhi));
+  }
+}
+#ifndef __clang__
+#pragma GCC diagnostic pop
+#endif
+#endif  // PS_SGD_RULE_X86_DISPATCH
+
+// w[i] = bound(w[i] + a * g[i]), returns sum(g[i] * g[i])
+static float AxpyBoundSquareSum(
+    size_t n, float a, const float *g, float *w, float lo, float hi) {
+  size_t i = 0;
+  float square_sum = 0;
+#ifdef PS_SGD_RULE_X86_DISPATCH
+  SimdLevel level = GetSimdLevel();
+  if (level == SimdLevel::kAvx512) {
+    return AxpyBoundSquareSumAvx512(n, a, g, w, lo, hi);
+  } else if (level == SimdLevel::kAvx2) {
+    i = AxpyBoundSquareSumAvx2(n, a, g, w, lo, hi, &square_sum);
+  }
+#endif
+  for (; i < n; ++i) {
+    w[i] = BoundScalar(w[i] + a * g[i], lo, hi);
+    square_sum += g[i] * g[i];
+  }
+  return square_sum;
+}
+
+// w[i] = bound(w[i] - lr * sg * sqrt(init / (init + g2sum[i]))),
+// g2sum[i] += sg * sg, with sg = g[i] * inv_scale
+static void StdAdaGradKernel(size_t n,
+                             float lr,
+                             float init_g2sum,
+                             float inv_scale,
+                             const float *g,
+                             float *w,
+                             float *g2sum,
+                             float lo,
+                             float hi) {
+  size_t i = 0;
+#ifdef PS_SGD_RULE_X86_DISPATCH
+  SimdLevel level = GetSimdLevel();
+  if (level == SimdLevel::kAvx512) {
+    StdAdaGradKernelAvx512(n, lr, init_g2sum, inv_scale, g, w, g2sum, lo, hi);
+    return;
+  } else if (level == SimdLevel::kAvx2) {
+    i = StdAdaGradKernelAvx2(n, lr, init_g2sum, inv_scale, g, w, g2sum, lo, hi);
+  }
+#endif
+  for (; i < n; ++i) {
+    float sg = g[i] * inv_scale;
+    w[i] = BoundScalar(
+        w[i] - lr * sg * sqrtf(init_g2sum / (init_g2sum + g2sum[i])), lo, hi);
+    g2sum[i] += sg * sg;
+  }
+}
+
+static void BoundRange(size_t n, float *w, float lo, float hi) {
+  size_t i = 0;
+#ifdef PS_SGD_RULE_X86_DISPATCH
+  SimdLevel level = GetSimdLevel();
+  if (level == SimdLevel::kAvx512) {
+    BoundRangeAvx512(n, w, lo, hi);
+    return;
+  } else if (level == SimdLevel::kAvx2) {
+    i = BoundRangeAvx2(n, w, lo, hi);
+  }
+#endif
+  for (; i < n; ++i) {
+    w[i] = BoundScalar(w[i], lo, hi);
+  }
+}
+
 void SparseNaiveSGDRule::LoadConfig(const SparseCommonSGDRuleParameter &param,
                                     size_t emb_dim) {
   _embedding_dim = emb_dim;
@@ -106,6 +354,25 @@ void SparseAdaGradSGDRule::UpdateValueWork(float *w,
   g2sum += add_g2sum / _embedding_dim;
 }
 
+void SparseAdaGradSGDRule::UpdateValueBatch(float **values,
+                                            size_t w_offset,
+                                            size_t sgd_offset,
+                                            const float **push_values,
+                                            size_t grad_offset,
+                                            const float *scales,
+                                            size_t num) {
+  for (size_t k = 0; k < num; ++k) {
+    float *w = values[k] + w_offset;
+    float &g2sum = values[k][sgd_offset + G2SumIndex()];
+    const float *grad = push_values[k] + grad_offset;
+    float ratio = learning_rate_ *
+                  sqrtf(_initial_g2sum / (_initial_g2sum + g2sum)) / scales[k];
+    float square_sum = AxpyBoundSquareSum(
+        _embedding_dim, -ratio, grad, w, _min_bound, _max_bound);
+    g2sum += square_sum / (scales[k] * scales[k]) / _embedding_dim;
+  }
+}
+
 void SparseAdaGradSGDRule::InitValueWork(float *value,
                                          float *sgd,
                                          bool zero_init) {
@@ -159,6 +426,26 @@ void StdAdaGradSGDRule::UpdateValueWork(float *w,
   }
 }
 
+void StdAdaGradSGDRule::UpdateValueBatch(float **values,
+                                         size_t w_offset,
+                                         size_t sgd_offset,
+                                         const float **push_values,
+                                         size_t grad_offset,
+                                         const float *scales,
+                                         size_t num) {
+  for (size_t k = 0; k < num; ++k) {
+    StdAdaGradKernel(_embedding_dim,
+                     learning_rate_,
+                     _initial_g2sum,
+                     1.0f / scales[k],
+                     push_values[k] + grad_offset,
+                     values[k] + w_offset,
+                     values[k] + sgd_offset + G2SumIndex(),
+                     _min_bound,
+                     _max_bound);
+  }
+}
+
 void StdAdaGradSGDRule::InitValueWork(float *value,
                                       float *sgd,
                                       bool zero_init) {
@@ -227,6 +514,44 @@ void SparseAdamSGDRule::UpdateValueWork(float *w,
   (*beta2_pow) *= _beta2_decay_rate;
 }
 
+void SparseAdamSGDRule::UpdateValueBatch(float **values,
+                                         size_t w_offset,
+                                         size_t sgd_offset,
+                                         const float **push_values,
+                                         size_t grad_offset,
+                                         const float *scales,
+                                         size_t num) {
+  phi::jit::adam_attr_t attr(_beta1_decay_rate, _beta2_decay_rate);
+  auto adam = phi::jit::KernelFuncs<phi::jit::AdamTuple<float>,
+                                    phi::CPUPlace>::Cache()
+                  .At(attr);
+  for (size_t k = 0; k < num; ++k) {
+    float *w = values[k] + w_offset;
+    float *sgd = values[k] + sgd_offset;
+    float *gsum = sgd + GSumIndex();
+    float *g2sum = sgd + G2SumIndex();
+    float &beta1_pow = sgd[Beta1PowIndex()];
+    float &beta2_pow = sgd[Beta2PowIndex()];
+    float lr = learning_rate_ * sqrtf(1 - beta2_pow) / (1 - beta1_pow);
+    // moments and weights are updated in place
+    adam(_beta1_decay_rate,
+         _beta2_decay_rate,
+         -lr,
+         _ada_epsilon,
+         _embedding_dim,
+         push_values[k] + grad_offset,
+         gsum,
+         g2sum,
+         w,
+         gsum,
+         g2sum,
+         w);
+    BoundRange(_embedding_dim, w, _min_bound, _max_bound);
+    beta1_pow *= _beta1_decay_rate;
+    beta2_pow *= _beta2_decay_rate;
+  }
+}
+
 void SparseAdamSGDRule::InitValueWork(float *value,
                                       float *sgd,
                                       bool zero_init) {
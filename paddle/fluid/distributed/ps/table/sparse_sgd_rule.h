@@ -51,6 +51,23 @@ class SparseValueSGDRule {
                    float scale = 1) {
     UpdateValueWork(w, sgd, push_value, scale);
   }
+  // Batched UpdateValue over num keys. The weights, rule states and gradients
+  // of key k start at values[k] + w_offset, values[k] + sgd_offset and
+  // push_values[k] + grad_offset, scales[k] is its show scale.
+  virtual void UpdateValueBatch(float** values,
+                                size_t w_offset,
+                                size_t sgd_offset,
+                                const float** push_values,
+                                size_t grad_offset,
+                                const float* scales,
+                                size_t num) {
+    for (size_t k = 0; k < num; ++k) {
+      UpdateValueWork(values[k] + w_offset,
+                      values[k] + sgd_offset,
+                      push_values[k] + grad_offset,
+                      scales[k]);
+    }
+  }
   template <class T>
   void BoundValue(T& w) {  // NOLINT
     if (!(w >= _min_bound)) {
@@ -97,6 +114,13 @@ class SparseAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatch(float** values,
+                                size_t w_offset,
+                                size_t sgd_offset,
+                                const float** push_values,
+                                size_t grad_offset,
+                                const float* scales,
+                                size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return 1; }
   size_t G2SumIndex() { return 0; }
@@ -114,6 +138,13 @@ class StdAdaGradSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatch(float** values,
+                                size_t w_offset,
+                                size_t sgd_offset,
+                                const float** push_values,
+                                size_t grad_offset,
+                                const float* scales,
+                                size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim; }
   size_t G2SumIndex() { return 0; }
@@ -131,6 +162,13 @@ class SparseAdamSGDRule : public SparseValueSGDRule {
                                float* sgd,
                                const float* push_value,
                                float scale);
+  virtual void UpdateValueBatch(float** values,
+                                size_t w_offset,
+                                size_t sgd_offset,
+                                const float** push_values,
+                                size_t grad_offset,
+                                const float* scales,
+                                size_t num);
   virtual void InitValueWork(float* value, float* sgd, bool zero_init);
   virtual size_t Dim() { return _embedding_dim * 2 + 2; }
   size_t GSumIndex() { return 0; }
@@ -14,6 +14,9 @@
 
 #include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
 #include "paddle/fluid/distributed/common/topk_calculator.h"
@@ -25,6 +28,18 @@ DECLARE_bool(pserver_create_value_when_push);
 DECLARE_bool(pserver_enable_create_feasign_randomly);
 DEFINE_bool(pserver_open_strict_check, false, "pserver_open_strict_check");
 DEFINE_int32(pserver_load_batch_size, 5000, "load batch size for ssd");
+DEFINE_double(pserver_ssd_admission_threshold,
+              0.0,
+              "values read from ssd by pull or updated by push are only "
+              "moved to memory when their show click score reaches this "
+              "threshold");
+DEFINE_int64(pserver_ssd_mem_max_keys_per_shard,
+             0,
+             "background demotion keeps at most this many keys per shard in "
+             "memory, 0 disables it");
+DEFINE_int32(pserver_ssd_demote_interval_ms,
+             10000,
+             "interval of the background demotion to ssd");
 PADDLE_DEFINE_EXPORTED_string(rocksdb_path,
                               "database",
                               "path of sparse table rocksdb file");
@@ -32,10 +47,28 @@ PADDLE_DEFINE_EXPORTED_string(rocksdb_path,
 namespace paddle {
 namespace distributed {
 
+SSDSparseTable::~SSDSparseTable() {
+  if (_demote_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(_demote_mutex);
+      _stop_demote = true;
+    }
+    _demote_cv.notify_all();
+    _demote_thread.join();
+  }
+}
+
 int32_t SSDSparseTable::Initialize() {
   MemorySparseTable::Initialize();
+  CHECK(!_use_flat_shard) << "SSDSparseTable only supports closed_hash shards";
+  // 异构模式下save 6会被当成xbox delta(6-4=2), 不会写增量checkpoint
+  CHECK(!_config.enable_incremental_save())
+      << "SSDSparseTable does not support enable_incremental_save";
   _db = paddle::distributed::RocksDBHandler::GetInstance();
   _db->initialize(FLAGS_rocksdb_path, _real_local_shard_num);
+  if (FLAGS_pserver_ssd_mem_max_keys_per_shard > 0) {
+    _demote_thread = std::thread([this]() { DemoteLoop(); });
+  }
   VLOG(0) << "initalize SSDSparseTable succ";
   VLOG(0) << "SSD FLAGS_pserver_print_missed_key_num_every_push:"
           << FLAGS_pserver_print_missed_key_num_every_push;
@@ -108,35 +141,88 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                auto select = [&](size_t data_size, int pull_data_idx) {
+                  for (size_t mf_idx = data_size; mf_idx < value_size;
+                       ++mf_idx) {
+                    data_buffer[mf_idx] = 0.0;
+                  }
+                  float* select_data =
+                      pull_values + pull_data_idx * select_value_size;
+                  _value_accesor->Select(
+                      &select_data, (const float**)&data_buffer_ptr, 1);
+                };
+                // 内存命中直接select, 未命中的key攒批后一次MultiGet
+                std::vector<std::pair<uint64_t, int>> ssd_keys;
                 for (size_t i = 0; i < keys.size(); ++i) {
-                  uint64_t key = keys[i].first;
-                  auto itr = local_shard.find(key);
-                  size_t data_size = value_size - mf_value_size;
+                  auto itr = local_shard.find(keys[i].first);
                   if (itr == local_shard.end()) {
-                    // pull rocksdb
-                    std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
+                    ssd_keys.push_back(keys[i]);
+                    continue;
+                  }
+                  size_t data_size = itr.value().size();
+                  memcpy(data_buffer_ptr,
+                         itr.value().data(),
+                         data_size * sizeof(float));
+                  select(data_size, keys[i].second);
+                }
+                _mem_hit_num += keys.size() - ssd_keys.size();
+                if (ssd_keys.empty()) {
+                  return 0;
+                }
+                std::sort(ssd_keys.begin(), ssd_keys.end());
+                // 同一batch中重复的key只MultiGet和初始化一次
+                std::vector<uint64_t> batch_keys;
+                batch_keys.reserve(ssd_keys.size());
+                for (auto& ssd_key : ssd_keys) {
+                  if (batch_keys.empty() ||
+                      batch_keys.back() != ssd_key.first) {
+                    batch_keys.push_back(ssd_key.first);
+                  }
+                }
+                std::vector<std::string> ssd_values;
+                std::vector<bool> found;
+                MultiGetFromSSD(shard_id, batch_keys, &ssd_values, &found);
+
+                size_t ssd_hit = 0;
+                size_t data_size = 0;
+                size_t batch_idx = 0;
+                for (size_t i = 0; i < ssd_keys.size(); ++i) {
+                  uint64_t key = ssd_keys[i].first;
+                  if (i > 0 && key == ssd_keys[i - 1].first) {
+                    // 重复的key复用上一次读出或创建的data_buffer
+                    if (found[batch_idx - 1]) {
+                      ++ssd_hit;
+                    } else {
                       ++missed_keys;
-                      if (FLAGS_pserver_create_value_when_push) {
-                        memset(data_buffer, 0, sizeof(float) * data_size);
-                      } else {
-                        auto& feature_value = local_shard[key];
-                        feature_value.resize(data_size);
-                        float* data_ptr =
-                            const_cast<float*>(feature_value.data());
-                        _value_accesor->Create(&data_buffer_ptr, 1);
-                        memcpy(data_ptr,
-                               data_buffer_ptr,
-                               data_size * sizeof(float));
-                      }
+                    }
+                    select(data_size, ssd_keys[i].second);
+                    continue;
+                  }
+                  size_t idx = batch_idx++;
+                  data_size = value_size - mf_value_size;
+                  if (!found[idx]) {
+                    ++missed_keys;
+                    if (FLAGS_pserver_create_value_when_push) {
+                      memset(data_buffer, 0, sizeof(float) * data_size);
                     } else {
-                      data_size = tmp_string.size() / sizeof(float);
-                      memcpy(data_buffer_ptr,
-                             paddle::string::str_to_float(tmp_string),
-                             data_size * sizeof(float));
+                      auto& feature_value = local_shard[key];
+                      feature_value.resize(data_size);
+                      float* data_ptr =
+                          const_cast<float*>(feature_value.data());
+                      _value_accesor->Create(&data_buffer_ptr, 1);
+                      memcpy(
+                          data_ptr, data_buffer_ptr, data_size * sizeof(float));
+                    }
+                  } else {
+                    ++ssd_hit;
+                    data_size = ssd_values[idx].size() / sizeof(float);
+                    memcpy(data_buffer_ptr,
+                           paddle::string::str_to_float(ssd_values[idx]),
+                           data_size * sizeof(float));
+                    // 热度不够的value只读出来select, 继续留在rocksdb,
+                    // 避免一次性的冷key挤占内存
+                    if (_value_accesor->HotScore(data_buffer_ptr) >=
+                        FLAGS_pserver_ssd_admission_threshold) {
                       // from rocksdb to mem
                       auto& feature_value = local_shard[key];
                       feature_value.resize(data_size);
@@ -147,22 +233,11 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                                     reinterpret_cast<char*>(&key),
                                     sizeof(uint64_t));
                     }
-                  } else {
-                    data_size = itr.value().size();
-                    memcpy(data_buffer_ptr,
-                           itr.value().data(),
-                           data_size * sizeof(float));
-                  }
-                  for (size_t mf_idx = data_size; mf_idx < value_size;
-                       ++mf_idx) {
-                    data_buffer[mf_idx] = 0.0;
                   }
-                  int pull_data_idx = keys[i].second;
-                  float* select_data =
-                      pull_values + pull_data_idx * select_value_size;
-                  _value_accesor->Select(
-                      &select_data, (const float**)&data_buffer_ptr, 1);
+                  select(data_size, ssd_keys[i].second);
                 }
+                _ssd_hit_num += ssd_hit;
+                _ssd_miss_num += ssd_keys.size() - ssd_hit;
                 return 0;
               });
     }
@@ -183,6 +258,11 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                                       size_t num,
                                       uint16_t pass_id) {
   CostTimer timer("pserver_ssd_sparse_select_all");
+  _ptr_pulled = true;
+  // 等正在进行的降级结束, 之后的降级都会看到_ptr_pulled
+  {
+    std::lock_guard<std::mutex> guard(_table_mutex);
+  }
   size_t value_size = _value_accesor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
       _value_accesor->GetAccessorInfo().mf_size / sizeof(float);
@@ -350,9 +430,28 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                // 未准入或已降级的key仍在rocksdb中, 直接在rocksdb里update,
+                // update后达到准入阈值的才搬回内存
+                std::vector<std::pair<uint64_t, const float*>> ssd_updates;
+                for (size_t i = 0; i < keys.size(); ++i) {
+                  if (local_shard.find(keys[i].first) == local_shard.end()) {
+                    uint64_t push_data_idx = keys[i].second;
+                    ssd_updates.emplace_back(
+                        keys[i].first,
+                        values + push_data_idx * update_value_col);
+                  }
+                }
+                std::vector<uint64_t> ssd_updated_keys =
+                    UpdateOnSSD(shard_id, &ssd_updates);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
+                  if (!ssd_updated_keys.empty() &&
+                      std::binary_search(ssd_updated_keys.begin(),
+                                         ssd_updated_keys.end(),
+                                         key)) {
+                    continue;
+                  }
                   const float* update_data =
                       values + push_data_idx * update_value_col;
                   auto itr = local_shard.find(key);
@@ -456,9 +555,27 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                // 未准入或已降级的key仍在rocksdb中, 直接在rocksdb里update,
+                // update后达到准入阈值的才搬回内存
+                std::vector<std::pair<uint64_t, const float*>> ssd_updates;
+                for (size_t i = 0; i < keys.size(); ++i) {
+                  if (local_shard.find(keys[i].first) == local_shard.end()) {
+                    uint64_t push_data_idx = keys[i].second;
+                    ssd_updates.emplace_back(keys[i].first,
+                                             values[push_data_idx]);
+                  }
+                }
+                std::vector<uint64_t> ssd_updated_keys =
+                    UpdateOnSSD(shard_id, &ssd_updates);
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   uint64_t push_data_idx = keys[i].second;
+                  if (!ssd_updated_keys.empty() &&
+                      std::binary_search(ssd_updated_keys.begin(),
+                                         ssd_updated_keys.end(),
+                                         key)) {
+                    continue;
+                  }
                   const float* update_data = values[push_data_idx];
                   auto itr = local_shard.find(key);
                   if (itr == local_shard.end()) {
@@ -508,7 +625,261 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
   return 0;
 }
 
+int32_t SSDSparseTable::PrefetchSparse(const uint64_t* keys, size_t num) {
+  std::vector<std::vector<uint64_t>> task_keys(_real_local_shard_num);
+  for (size_t i = 0; i < num; ++i) {
+    int shard_id = (keys[i] % _sparse_table_shard_num) % _avg_local_shard_num;
+    task_keys[shard_id].push_back(keys[i]);
+  }
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    if (task_keys[shard_id].empty()) {
+      continue;
+    }
+    // shard的task线程是串行的, 预取不会和pull/push/降级并发访问shard
+    _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+        [this, shard_id, shard_keys = std::move(task_keys[shard_id])]() mutable
+        -> int {
+          _prefetch_num += PrefetchShard(shard_id, &shard_keys);
+          return 0;
+        });
+  }
+  return 0;
+}
+
+size_t SSDSparseTable::PrefetchShard(int shard_id,
+                                     std::vector<uint64_t>* keys) {
+  auto& local_shard = _local_shards[shard_id];
+  std::sort(keys->begin(), keys->end());
+  keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+  std::vector<uint64_t> ssd_keys;
+  for (auto key : *keys) {
+    if (local_shard.find(key) == local_shard.end()) {
+      ssd_keys.push_back(key);
+    }
+  }
+  std::vector<std::string> values;
+  std::vector<bool> found;
+  MultiGetFromSSD(shard_id, ssd_keys, &values, &found);
+
+  std::vector<std::pair<char*, int>> del_keys;
+  for (size_t i = 0; i < ssd_keys.size(); ++i) {
+    // 不存在的key留给pull创建
+    if (!found[i]) {
+      continue;
+    }
+    float* data = paddle::string::str_to_float(values[i]);
+    // 和pull使用同样的准入策略, 冷key预取了也会被pull留在rocksdb
+    if (_value_accesor->HotScore(data) <
+        FLAGS_pserver_ssd_admission_threshold) {
+      continue;
+    }
+    uint64_t key = ssd_keys[i];
+    size_t data_size = values[i].size() / sizeof(float);
+    auto& feature_value = local_shard[key];
+    feature_value.resize(data_size);
+    memcpy(const_cast<float*>(feature_value.data()),
+           data,
+           data_size * sizeof(float));
+    del_keys.emplace_back(reinterpret_cast<char*>(&ssd_keys[i]),
+                          sizeof(uint64_t));
+  }
+  if (!del_keys.empty()) {
+    _db->del_batch(shard_id, del_keys, del_keys.size());
+  }
+  return del_keys.size();
+}
+
+void SSDSparseTable::MultiGetFromSSD(int shard_id,
+                                     const std::vector<uint64_t>& keys,
+                                     std::vector<std::string>* values,
+                                     std::vector<bool>* found) {
+  values->assign(keys.size(), std::string());
+  found->assign(keys.size(), false);
+  const size_t batch_size = 1024;
+  std::vector<rocksdb::Slice> batch_keys;
+  std::vector<rocksdb::PinnableSlice> batch_values(batch_size);
+  std::vector<rocksdb::Status> status(batch_size);
+  for (size_t begin = 0; begin < keys.size(); begin += batch_size) {
+    size_t end = std::min(keys.size(), begin + batch_size);
+    batch_keys.clear();
+    for (size_t i = begin; i < end; ++i) {
+      batch_keys.emplace_back(reinterpret_cast<const char*>(&keys[i]),
+                              sizeof(uint64_t));
+    }
+    // keys按数值排序, 与rocksdb按字节比较的顺序不同, 不能声明为有序输入
+    _db->multi_get(shard_id,
+                   batch_keys.size(),
+                   batch_keys.data(),
+                   batch_values.data(),
+                   status.data(),
+                   false);
+    for (size_t i = begin; i < end; ++i) {
+      if (status[i - begin].ok()) {
+        (*found)[i] = true;
+        (*values)[i].assign(batch_values[i - begin].data(),
+                            batch_values[i - begin].size());
+      }
+      batch_values[i - begin].Reset();
+    }
+  }
+}
+
+std::vector<uint64_t> SSDSparseTable::UpdateOnSSD(
+    int shard_id, std::vector<std::pair<uint64_t, const float*>>* updates) {
+  std::vector<uint64_t> updated_keys;
+  if (updates->empty()) {
+    return updated_keys;
+  }
+  // 同一个key的多次update按push的顺序执行
+  std::stable_sort(updates->begin(),
+                   updates->end(),
+                   [](const std::pair<uint64_t, const float*>& a,
+                      const std::pair<uint64_t, const float*>& b) {
+                     return a.first < b.first;
+                   });
+  std::vector<uint64_t> batch_keys;
+  batch_keys.reserve(updates->size());
+  for (auto& update : *updates) {
+    if (batch_keys.empty() || batch_keys.back() != update.first) {
+      batch_keys.push_back(update.first);
+    }
+  }
+  std::vector<std::string> values;
+  std::vector<bool> found;
+  MultiGetFromSSD(shard_id, batch_keys, &values, &found);
+
+  auto& local_shard = _local_shards[shard_id];
+  size_t value_col = _value_accesor->GetAccessorInfo().size / sizeof(float);
+  std::vector<float> data_buffer(value_col);
+  std::vector<float> create_buffer(value_col);
+  float* data_buffer_ptr = data_buffer.data();
+  float* create_buffer_ptr = create_buffer.data();
+  // 写回rocksdb的key攒成一个WriteBatch, 更新后的value写回values[idx]
+  std::vector<std::pair<char*, int>> put_keys;
+  std::vector<std::pair<char*, int>> put_values;
+  std::vector<std::pair<char*, int>> del_keys;
+  size_t begin = 0;
+  for (size_t idx = 0; idx < batch_keys.size(); ++idx) {
+    uint64_t key = batch_keys[idx];
+    size_t end = begin;
+    while (end < updates->size() && (*updates)[end].first == key) {
+      ++end;
+    }
+    if (!found[idx]) {
+      begin = end;
+      continue;
+    }
+    size_t value_size = values[idx].size() / sizeof(float);
+    memcpy(data_buffer_ptr,
+           paddle::string::str_to_float(values[idx]),
+           value_size * sizeof(float));
+    for (size_t i = begin; i < end; ++i) {
+      const float* update_data = (*updates)[i].second;
+      _value_accesor->Update(&data_buffer_ptr, &update_data, 1);
+      // 与内存中的update一致, 需要mf时补上新建的mf部分
+      if (value_size < value_col &&
+          _value_accesor->NeedExtendMF(data_buffer_ptr)) {
+        _value_accesor->Create(&create_buffer_ptr, 1);
+        memcpy(data_buffer_ptr + value_size,
+               create_buffer_ptr + value_size,
+               (value_col - value_size) * sizeof(float));
+        value_size = value_col;
+      }
+    }
+    if (_value_accesor->HotScore(data_buffer_ptr) >=
+        FLAGS_pserver_ssd_admission_threshold) {
+      // from rocksdb to mem
+      auto& feature_value = local_shard[key];
+      feature_value.resize(value_size);
+      memcpy(const_cast<float*>(feature_value.data()),
+             data_buffer_ptr,
+             value_size * sizeof(float));
+      del_keys.emplace_back(reinterpret_cast<char*>(&batch_keys[idx]),
+                            sizeof(uint64_t));
+    } else {
+      values[idx].assign(reinterpret_cast<char*>(data_buffer_ptr),
+                         value_size * sizeof(float));
+      put_keys.emplace_back(reinterpret_cast<char*>(&batch_keys[idx]),
+                            sizeof(uint64_t));
+      put_values.emplace_back(&values[idx][0], values[idx].size());
+    }
+    updated_keys.push_back(key);
+    begin = end;
+  }
+  if (!put_keys.empty()) {
+    _db->put_batch(shard_id, put_keys, put_values, put_keys.size());
+  }
+  if (!del_keys.empty()) {
+    _db->del_batch(shard_id, del_keys, del_keys.size());
+  }
+  return updated_keys;
+}
+
+size_t SSDSparseTable::DemoteShard(int shard_id) {
+  auto& local_shard = _local_shards[shard_id];
+  size_t max_keys =
+      static_cast<size_t>(FLAGS_pserver_ssd_mem_max_keys_per_shard);
+  if (local_shard.size() <= max_keys) {
+    return 0;
+  }
+  // 降到上限的90%, 避免每轮都只写回少量key
+  size_t demote_num = local_shard.size() - max_keys / 10 * 9;
+  std::vector<std::pair<float, uint64_t>> scores;
+  scores.reserve(local_shard.size());
+  for (auto it = local_shard.begin(); it != local_shard.end(); ++it) {
+    scores.emplace_back(_value_accesor->HotScore(it.value().data()), it.key());
+  }
+  std::nth_element(
+      scores.begin(), scores.begin() + demote_num - 1, scores.end());
+  std::vector<std::pair<char*, int>> ssd_keys;
+  std::vector<std::pair<char*, int>> ssd_values;
+  ssd_keys.reserve(demote_num);
+  ssd_values.reserve(demote_num);
+  for (size_t i = 0; i < demote_num; ++i) {
+    auto it = local_shard.find(scores[i].second);
+    ssd_keys.emplace_back(reinterpret_cast<char*>(&scores[i].second),
+                          sizeof(uint64_t));
+    ssd_values.emplace_back(reinterpret_cast<char*>(it.value().data()),
+                            it.value().size() * sizeof(float));
+  }
+  _db->put_batch(shard_id, ssd_keys, ssd_values, demote_num);
+  for (size_t i = 0; i < demote_num; ++i) {
+    local_shard.erase(scores[i].second);
+  }
+  return demote_num;
+}
+
+void SSDSparseTable::DemoteLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_demote_mutex);
+      _demote_cv.wait_for(
+          lock,
+          std::chrono::milliseconds(FLAGS_pserver_ssd_demote_interval_ms),
+          [this] { return _stop_demote; });
+      if (_stop_demote) {
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> guard(_table_mutex);
+    if (_ptr_pulled) {
+      continue;
+    }
+    std::vector<std::future<size_t>> tasks(_real_local_shard_num);
+    for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+      tasks[shard_id] =
+          _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+              [this, shard_id]() -> size_t { return DemoteShard(shard_id); });
+    }
+    for (auto& task : tasks) {
+      _demote_num += task.get();
+    }
+  }
+}
+
 int32_t SSDSparseTable::Shrink(const std::string& param) {
+  // 与后台降级线程互斥, 它也会从_local_shards中erase
+  std::lock_guard<std::mutex> guard(_table_mutex);
   int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
   omp_set_num_threads(thread_num);
 #pragma omp parallel for schedule(dynamic)
@@ -526,6 +897,7 @@ int32_t SSDSparseTable::Shrink(const std::string& param) {
         ++it;
       }
     }
+    shard.compact_values();
     auto* it = _db->get_iterator(i);
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
       if (_value_accesor->Shrink(
@@ -549,6 +921,7 @@ int32_t SSDSparseTable::Shrink(const std::string& param) {
 }
 
 int32_t SSDSparseTable::UpdateTable() {
+  std::lock_guard<std::mutex> guard(_table_mutex);
   int count = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
     auto& shard = _local_shards[i];
@@ -1525,6 +1898,7 @@ int32_t SSDSparseTable::SaveCache(
 
 int32_t SSDSparseTable::Load(const std::string& path,
                              const std::string& param) {
+  std::lock_guard<std::mutex> guard(_table_mutex);
   VLOG(0) << "LOAD FLAGS_rocksdb_path:" << FLAGS_rocksdb_path;
   std::string table_path = TableDir(path);
   auto file_list = _afs_client.list(table_path);
@@ -1944,6 +2318,16 @@ int32_t SSDSparseTable::LoadWithBinary(const std::string& path, int param) {
 
 std::pair<int64_t, int64_t> SSDSparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
+  uint64_t mem_hit = _mem_hit_num.exchange(0);
+  uint64_t ssd_hit = _ssd_hit_num.exchange(0);
+  uint64_t ssd_miss = _ssd_miss_num.exchange(0);
+  uint64_t total = std::max<uint64_t>(mem_hit + ssd_hit + ssd_miss, 1);
+  LOG(INFO) << "SSDSparseTable pull keys:" << mem_hit + ssd_hit + ssd_miss
+            << " mem_hit_rate:" << 1.0 * mem_hit / total
+            << " ssd_hit_rate:" << 1.0 * ssd_hit / total
+            << " miss_rate:" << 1.0 * ssd_miss / total
+            << " demote:" << _demote_num.exchange(0)
+            << " prefetch:" << _prefetch_num.exchange(0);
   return {feasign_size, -1};
 }
 
@@ -2098,6 +2482,9 @@ int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
 
   VLOG(0) << "Table>> cache ssd count: " << count.load();
   VLOG(0) << "Table>> after update, mem feasign size:" << LocalSize();
+  // CacheTable在pass结束时调用, 此时PullSparsePtr交出的指针已不再使用,
+  // 后台降级可以恢复
+  _ptr_pulled = false;
   return 0;
 }
 
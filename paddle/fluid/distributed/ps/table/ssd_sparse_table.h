@@ -14,6 +14,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
 #include "gflags/gflags.h"
 #include "paddle/fluid/distributed/ps/table/depends/rocksdb_warpper.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
@@ -60,7 +67,7 @@ class SSDSparseTable : public MemorySparseTable {
  public:
   typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
   SSDSparseTable() {}
-  virtual ~SSDSparseTable() {}
+  virtual ~SSDSparseTable();
 
   int32_t Initialize() override;
   int32_t InitializeShard() override;
@@ -84,6 +91,7 @@ class SSDSparseTable : public MemorySparseTable {
   int32_t Flush() override { return 0; }
   int32_t Shrink(const std::string& param) override;
   void Clear() override {
+    std::lock_guard<std::mutex> guard(_table_mutex);
     for (int i = 0; i < _real_local_shard_num; ++i) {
       _local_shards[i].clear();
     }
@@ -121,13 +129,62 @@ class SSDSparseTable : public MemorySparseTable {
   std::pair<int64_t, int64_t> PrintTableStat() override;
 
   int32_t CacheTable(uint16_t pass_id) override;
+  // 把keys中在rocksdb里且热度达到准入阈值的value搬到内存,
+  // 任务排进shard线程后立即返回
+  int32_t PrefetchSparse(const uint64_t* keys, size_t num) override;
+
+  // 分层命中统计的快照, 不清零
+  struct TierStat {
+    uint64_t mem_hit;
+    uint64_t ssd_hit;
+    uint64_t ssd_miss;
+    uint64_t demote;
+    uint64_t prefetch;
+  };
+  TierStat GetTierStat() const {
+    return {_mem_hit_num.load(),
+            _ssd_hit_num.load(),
+            _ssd_miss_num.load(),
+            _demote_num.load(),
+            _prefetch_num.load()};
+  }
 
  private:
+  // 对不在内存中的keys做一次MultiGet, found[i]标记values[i]是否有效
+  void MultiGetFromSSD(int shard_id,
+                       const std::vector<uint64_t>& keys,
+                       std::vector<std::string>* values,
+                       std::vector<bool>* found);
+  // 对不在内存中的key直接在rocksdb里读出-update-写回, update后热度达到
+  // 准入阈值的才搬到内存; 返回在rocksdb中命中并已update的key(升序)
+  std::vector<uint64_t> UpdateOnSSD(
+      int shard_id, std::vector<std::pair<uint64_t, const float*>>* updates);
+  // 内存超过FLAGS_pserver_ssd_mem_max_keys_per_shard时，把热度最低的value
+  // 写回rocksdb，返回写回的key数
+  size_t DemoteShard(int shard_id);
+  // 预取一个shard的keys, 返回搬到内存的key数
+  size_t PrefetchShard(int shard_id, std::vector<uint64_t>* keys);
+  void DemoteLoop();
+
   RocksDBHandler* _db;
   int64_t _cache_tk_size;
   double _local_show_threshold{0.0};
   std::vector<paddle::framework::Channel<std::string>> _fs_channel;
   std::mutex _table_mutex;
+
+  // PullSparsePtr把value指针交给调用方后，到CacheTable之前不能再把value移出内存
+  std::atomic<bool> _ptr_pulled{false};
+  bool _stop_demote{false};
+  std::mutex _demote_mutex;
+  std::condition_variable _demote_cv;
+  std::thread _demote_thread;
+
+  // 分层命中统计, PrintTableStat打印后清零
+  std::atomic<uint64_t> _mem_hit_num{0};
+  std::atomic<uint64_t> _ssd_hit_num{0};
+  std::atomic<uint64_t> _ssd_miss_num{0};
+  std::atomic<uint64_t> _demote_num{0};
+  std::atomic<uint64_t> _prefetch_num{0};
 };
 
 }  // namespace distributed
@@ -151,6 +151,11 @@ class Table {
   virtual void *GetShard(size_t shard_idx) = 0;
   virtual std::pair<int64_t, int64_t> PrintTableStat() { return {0, 0}; }
   virtual int32_t CacheTable(uint16_t pass_id UNUSED) { return 0; }
+  // 异步预取下一个batch的keys, 不等预取完成就返回
+  virtual int32_t PrefetchSparse(const uint64_t *keys UNUSED,
+                                 size_t num UNUSED) {
+    return 0;
+  }
 
   // for patch model
   virtual void Revert() {}
@@ -730,6 +730,11 @@ void FleetWrapper::RecvAndSaveTable(const uint64_t table_id,
   }
 }
 
+std::future<int32_t> FleetWrapper::PrefetchSparseAsync(
+    const uint64_t table_id, const std::vector<uint64_t>& keys) {
+  return worker_ptr_->PrefetchSparse(table_id, keys.data(), keys.size());
+}
+
 void FleetWrapper::PrintTableStat(const uint64_t table_id) {
   auto ret = worker_ptr_->PrintTableStat(table_id);
   ret.wait();
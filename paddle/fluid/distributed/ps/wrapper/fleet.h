@@ -105,6 +105,13 @@ class FleetWrapper {
       std::vector<std::vector<float>>* fea_values,
       int fea_dim);
 
+  // Ask the servers to prefetch sparse keys, usually of the next batch, from
+  // ssd into memory. The keys can be reused once it returns, and the future
+  // does not have to be waited.
+  // Param<in>: table_id, keys
+  std::future<int32_t> PrefetchSparseAsync(const uint64_t table_id,
+                                           const std::vector<uint64_t>& keys);
+
   // Pull sparse variables from server in sync mode
   // pull immediately to tensors
   // is_training is true means training, false means inference, the behavior is
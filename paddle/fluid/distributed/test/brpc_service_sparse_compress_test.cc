@@ -0,0 +1,289 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_server.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/sparse_wire_codec.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace distributed {
+DECLARE_int32(pserver_push_sparse_merge_limit);
+}  // namespace distributed
+}  // namespace paddle
+
+namespace framework = paddle::framework;
+namespace distributed = paddle::distributed;
+
+TEST(SparseWireFormat, EncodeDecode) {
+  std::vector<uint64_t> keys = {3, 3, 17, 1ULL << 40, (1ULL << 40) + 5};
+  keys.push_back(UINT64_MAX);
+  std::vector<float> value = {12.0, 3.0, 0.5, -0.25, 1e-3, 7.75, -3.5, 0.0};
+  const size_t dim = value.size();
+
+  for (std::string type : {"fp32", "fp16", "bf16", "int8"}) {
+    distributed::SparseWireCompressParameter param;
+    param.set_compress_key(true);
+    param.set_pull_value_type(type);
+    auto format = distributed::SparseWireFormat::ForPull(param);
+    distributed::SparseWireFormat remote;
+    ASSERT_TRUE(remote.Deserialize(format.Serialize()));
+    ASSERT_EQ(remote.value_codec, format.value_codec);
+    ASSERT_EQ(remote.raw_dim, 2);
+
+    std::string key_buffer;
+    remote.EncodeKeys(keys.data(), keys.size(), &key_buffer);
+    ASSERT_LT(key_buffer.size(), keys.size() * sizeof(uint64_t));
+    std::vector<uint64_t> decoded_keys(keys.size());
+    const char *end = key_buffer.data() + key_buffer.size();
+    ASSERT_EQ(remote.DecodeKeys(
+                  key_buffer.data(), end, keys.size(), decoded_keys.data()),
+              end);
+    ASSERT_EQ(decoded_keys, keys);
+    ASSERT_TRUE(remote.DecodeKeys(key_buffer.data(),
+                                  end - 1,
+                                  keys.size(),
+                                  decoded_keys.data()) == NULL);
+
+    std::string value_buffer(remote.ValueBytes(dim), '\0');
+    remote.EncodeValue(value.data(), dim, &value_buffer[0]);
+    std::vector<float> decoded(dim);
+    remote.DecodeValue(value_buffer.data(), dim, decoded.data());
+    float tolerance = type == "int8" ? 7.75 / 254 : 7.75 / 128;
+    for (size_t i = 0; i < dim; ++i) {
+      if (i < 2 || type == "fp32") {
+        ASSERT_EQ(decoded[i], value[i]);
+      } else {
+        ASSERT_NEAR(decoded[i], value[i], tolerance) << type << " " << i;
+      }
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------*/
+
+// table 0 uses the plain wire format, table 1 the compressed one, both start
+// from zero weights so their values can be compared after the same pushes
+void GetSparseTableProto(distributed::TableParameter *sparse_table_proto,
+                         int table_id) {
+  sparse_table_proto->set_table_id(table_id);
+  sparse_table_proto->set_table_class("MemorySparseTable");
+  sparse_table_proto->set_shard_num(10);
+  sparse_table_proto->set_type(distributed::PS_SPARSE_TABLE);
+  if (table_id == 1) {
+    auto *wire_compress = sparse_table_proto->mutable_wire_compress();
+    wire_compress->set_compress_key(true);
+    wire_compress->set_pull_value_type("bf16");
+    wire_compress->set_push_value_type("int8");
+  }
+  distributed::TableAccessorParameter *accessor_config =
+      sparse_table_proto->mutable_accessor();
+
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(0);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(1.0);
+    naive_param->set_initial_range(0);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+
+void SetServiceProto(distributed::DownpourServerParameter *server_proto) {
+  distributed::ServerServiceParameter *server_service_proto =
+      server_proto->mutable_service_param();
+  server_service_proto->set_service_class("BrpcPsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+  for (int table_id = 0; table_id < 2; ++table_id) {
+    GetSparseTableProto(server_proto->add_downpour_table_param(), table_id);
+  }
+}
+
+distributed::PSParameter GetServerProto() {
+  distributed::PSParameter server_fleet_desc;
+  SetServiceProto(server_fleet_desc.mutable_server_param()
+                      ->mutable_downpour_server_param());
+  return server_fleet_desc;
+}
+
+distributed::PSParameter GetWorkerProto() {
+  distributed::PSParameter worker_fleet_desc;
+  auto *downpour_worker_proto = worker_fleet_desc.mutable_worker_param()
+                                    ->mutable_downpour_worker_param();
+  for (int table_id = 0; table_id < 2; ++table_id) {
+    GetSparseTableProto(downpour_worker_proto->add_downpour_table_param(),
+                        table_id);
+  }
+  SetServiceProto(worker_fleet_desc.mutable_server_param()
+                      ->mutable_downpour_server_param());
+  return worker_fleet_desc;
+}
+
+std::string ip_ = "127.0.0.1";  // NOLINT
+uint32_t port_ = 4219;
+
+std::vector<std::string> host_sign_list_;
+
+std::shared_ptr<distributed::PSServer> pserver_ptr_;
+
+std::shared_ptr<distributed::PSClient> worker_ptr_;
+
+void RunServer() {
+  distributed::PSParameter server_proto = GetServerProto();
+
+  auto _ps_env = distributed::PaddlePSEnvironment();
+  _ps_env.SetPsServers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<distributed::PSServer>(
+      distributed::PSServerFactory::Create(server_proto));
+  std::vector<framework::ProgramDesc> empty_vec;
+  framework::ProgramDesc empty_prog;
+  empty_vec.push_back(empty_prog);
+  pserver_ptr_->Configure(server_proto, _ps_env, 0, empty_vec);
+  pserver_ptr_->Start(ip_, port_);
+}
+
+void RunClient(
+    std::map<uint64_t, std::vector<distributed::Region>> &dense_regions) {
+  distributed::PSParameter worker_proto = GetWorkerProto();
+  distributed::PaddlePSEnvironment _ps_env;
+  _ps_env.SetPsServers(&host_sign_list_, host_sign_list_.size());
+  worker_ptr_ = std::shared_ptr<distributed::PSClient>(
+      distributed::PSClientFactory::Create(worker_proto));
+  worker_ptr_->Configure(worker_proto, dense_regions, _ps_env, 0);
+}
+
+distributed::DownpourBrpcClosure *NewPushClosure() {
+  return new distributed::DownpourBrpcClosure(1, [](void *done) {
+    auto *closure = reinterpret_cast<distributed::DownpourBrpcClosure *>(done);
+    closure->set_promise_value(
+        closure->check_response(0, distributed::PS_PUSH_SPARSE_TABLE));
+  });
+}
+
+void PullTable(int table_id,
+               const std::vector<uint64_t> &keys,
+               std::vector<float> *values,
+               size_t dim) {
+  values->assign(keys.size() * dim, -1);
+  std::vector<float *> value_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    value_ptrs[i] = values->data() + i * dim;
+  }
+  auto status = worker_ptr_->PullSparse(
+      value_ptrs.data(), table_id, keys.data(), keys.size(), true);
+  status.wait();
+  ASSERT_EQ(status.get(), 0);
+}
+
+void RunBrpcPushSparseCompress() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  // send every async push right away
+  distributed::FLAGS_pserver_push_sparse_merge_limit = 0;
+  auto ph_host = distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.SerializeToString());
+
+  std::thread server_thread(RunServer);
+  sleep(1);
+
+  std::map<uint64_t, std::vector<distributed::Region>> dense_regions;
+  RunClient(dense_regions);
+
+  const size_t select_dim = 11;
+  const size_t update_dim = 12;
+  // sparse 64 bit feasigns, some of them repeated
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 200; ++i) {
+    keys.push_back((i * 1000003) ^ (1ULL << 40));
+    if (i % 7 == 0) {
+      keys.push_back((i * 1000003) ^ (1ULL << 40));
+    }
+  }
+  std::vector<float> grads(keys.size() * update_dim);
+  std::vector<const float *> grad_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    float *grad = grads.data() + i * update_dim;
+    grad[0] = 1;  // slot
+    grad[1] = 1;  // show
+    grad[2] = i % 3 == 0 ? 1 : 0;  // click
+    for (size_t j = 3; j < update_dim; ++j) {
+      grad[j] = std::sin(static_cast<float>(i * update_dim + j)) * 0.5;
+    }
+    grad_ptrs[i] = grad;
+  }
+
+  std::vector<float> values[2];
+  for (int table_id = 0; table_id < 2; ++table_id) {
+    PullTable(table_id, keys, &values[table_id], select_dim);
+    // the first push creates embedx, the second one updates it
+    auto status = worker_ptr_->PushSparseRawGradient(
+        table_id, keys.data(), grad_ptrs.data(), keys.size(), NewPushClosure());
+    status.wait();
+    ASSERT_EQ(status.get(), 0);
+    status = worker_ptr_->PushSparse(
+        table_id, keys.data(), grad_ptrs.data(), keys.size());
+    status.wait();
+    ASSERT_EQ(status.get(), 0);
+    PullTable(table_id, keys, &values[table_id], select_dim);
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const float *raw = values[0].data() + i * select_dim;
+    const float *compressed = values[1].data() + i * select_dim;
+    // show / click stay fp32 on the wire
+    ASSERT_FLOAT_EQ(compressed[0], raw[0]);
+    ASSERT_FLOAT_EQ(compressed[1], raw[1]);
+    ASSERT_NE(raw[2], 0);
+    for (size_t j = 2; j < select_dim; ++j) {
+      // int8 push error of two pushes plus bf16 rounding of the pull
+      ASSERT_NEAR(compressed[j], raw[j], 0.02 + std::fabs(raw[j]) / 128)
+          << "key " << keys[i] << " dim " << j;
+    }
+  }
+
+  LOG(INFO) << "Run stop_server";
+  worker_ptr_->StopServer();
+  LOG(INFO) << "Run finalize_worker";
+  worker_ptr_->FinalizeWorker();
+  server_thread.join();
+}
+
+TEST(RunBrpcPushSparseCompress, Run) { RunBrpcPushSparseCompress(); }
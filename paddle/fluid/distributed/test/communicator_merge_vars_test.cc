@@ -0,0 +1,114 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/communicator/communicator.h"
+
+namespace paddle {
+namespace distributed {
+
+static std::vector<std::shared_ptr<Variable>> MakeDenseVars(int num,
+                                                            int64_t numel) {
+  std::vector<std::shared_ptr<Variable>> vars;
+  for (int i = 0; i < num; ++i) {
+    auto var = std::make_shared<Variable>();
+    auto *tensor = var->GetMutable<phi::DenseTensor>();
+    float *data =
+        tensor->mutable_data<float>(phi::make_ddim({numel}), phi::CPUPlace());
+    for (int64_t j = 0; j < numel; ++j) {
+      data[j] = static_cast<float>((i + 1) * (j % 13));
+    }
+    vars.push_back(var);
+  }
+  return vars;
+}
+
+static std::vector<std::shared_ptr<Variable>> MakeSparseVars(int num,
+                                                             int64_t width) {
+  std::vector<std::shared_ptr<Variable>> vars;
+  for (int i = 0; i < num; ++i) {
+    auto var = std::make_shared<Variable>();
+    auto *slr = var->GetMutable<phi::SelectedRows>();
+    slr->set_height(1000);
+    // overlapping rows with duplicates inside one var
+    std::vector<int64_t> rows;
+    for (int64_t r = i; r < 300; r += 3) {
+      rows.push_back(r);
+    }
+    rows.push_back(i);
+    *slr->mutable_rows() = rows;
+    float *data = slr->mutable_value()->mutable_data<float>(
+        phi::make_ddim({static_cast<int64_t>(rows.size()), width}),
+        phi::CPUPlace());
+    for (size_t r = 0; r < rows.size(); ++r) {
+      for (int64_t j = 0; j < width; ++j) {
+        data[r * width + j] = static_cast<float>(rows[r] + j * 0.5 + i);
+      }
+    }
+    vars.push_back(var);
+  }
+  return vars;
+}
+
+TEST(ParallelMergeVars, Dense) {
+  auto vars = MakeDenseVars(5, 1001);
+  Scope expect_scope;
+  Scope scope;
+  ::ThreadPool pool(4);
+  MergeVars<float>("x@GRAD", vars, &expect_scope);
+  ParallelMergeVars<float>("x@GRAD", vars, &scope, &pool, 4);
+
+  auto &expect = expect_scope.FindVar("x@GRAD")->Get<phi::DenseTensor>();
+  auto &out = scope.FindVar("x@GRAD")->Get<phi::DenseTensor>();
+  ASSERT_EQ(out.dims(), expect.dims());
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    ASSERT_FLOAT_EQ(out.data<float>()[i], expect.data<float>()[i]);
+  }
+}
+
+TEST(ParallelMergeVars, SelectedRows) {
+  const int64_t width = 7;
+  auto vars = MakeSparseVars(6, width);
+  for (bool merge_add : {true, false}) {
+    Scope expect_scope;
+    Scope scope;
+    ::ThreadPool pool(3);
+    MergeVars<float>("emb@GRAD", vars, &expect_scope, merge_add);
+    ParallelMergeVars<float>("emb@GRAD", vars, &scope, &pool, 3, merge_add);
+
+    auto &expect = expect_scope.FindVar("emb@GRAD")->Get<phi::SelectedRows>();
+    auto &out = scope.FindVar("emb@GRAD")->Get<phi::SelectedRows>();
+    ASSERT_EQ(out.height(), expect.height());
+    ASSERT_EQ(out.rows().size(), expect.rows().size());
+    std::map<int64_t, const float *> expect_rows;
+    for (size_t i = 0; i < expect.rows().size(); ++i) {
+      expect_rows[expect.rows()[i]] = expect.value().data<float>() + i * width;
+    }
+    for (size_t i = 0; i < out.rows().size(); ++i) {
+      ASSERT_EQ(expect_rows.count(out.rows()[i]), 1UL);
+      const float *expect_value = expect_rows[out.rows()[i]];
+      const float *value = out.value().data<float>() + i * width;
+      for (int64_t j = 0; j < width; ++j) {
+        ASSERT_FLOAT_EQ(value[j], expect_value[j]);
+      }
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,153 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/communicator/communicator.h"
+
+namespace paddle {
+namespace distributed {
+
+// records the merged gradients instead of sending them to the pserver
+class RecordingCommunicator : public AsyncCommunicator {
+ public:
+  explicit RecordingCommunicator(
+      const std::map<std::string, std::string> &envs)
+      : AsyncCommunicator(envs) {}
+
+  void RpcSendDense(const CommContext &ctx, const Scope &scope) override {
+    EXPECT_EQ(in_flight_.fetch_add(1), 0)
+        << "sends of one dense ctx should not overlap";
+    // slow send, so that the next batches are merged while this one is
+    // in flight and a reused batch scope would be caught here
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto &tensor =
+        scope.FindVar(ctx.origin_varnames[0])->Get<phi::DenseTensor>();
+    const float *data = tensor.data<float>();
+    for (int64_t i = 1; i < tensor.numel(); ++i) {
+      EXPECT_EQ(data[i], data[0]);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sent_.push_back(static_cast<int>(data[0]));
+    }
+    in_flight_.fetch_sub(1);
+  }
+
+  void RpcRecvDense(const std::vector<std::string> &varnames,
+                    int table_id,
+                    Scope *scope) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recv_after_.push_back(static_cast<int>(sent_.size()));
+  }
+
+  void Flush() { FlushSendPipeline(); }
+
+  std::vector<int> Sent() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sent_;
+  }
+
+  std::vector<int> RecvAfter() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recv_after_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<int> sent_;
+  // number of sent gradients when each recv happened
+  std::vector<int> recv_after_;
+  std::atomic<int> in_flight_{0};
+};
+
+TEST(AsyncCommunicator, SendPipelineDepth) {
+  const int depth = 3;
+  const int grad_num = 32;
+  const int64_t numel = 64;
+  const std::string grad_name = "w@GRAD";
+  const int table_id = 0;
+
+  int old_depth = FLAGS_communicator_send_pipeline_depth;
+  FLAGS_communicator_send_pipeline_depth = depth;
+
+  std::map<std::string, std::string> envs = {
+      {"barrier_table_id", "-1"},
+      {"trainer_id", "0"},
+      {"trainers", "1"},
+      {"communicator_independent_recv_thread", "0"},
+      {"communicator_min_send_grad_num_before_recv", "1"},
+      {"communicator_thread_pool_size", "2"},
+      // one gradient per batch, so every send carries exactly one of them
+      {"communicator_max_merge_var_num", "1"},
+      {"communicator_send_wait_times", "0"},
+      {"communicator_send_queue_size", "4"},
+      {"need_global_step", "0"}};
+  RecordingCommunicator communicator(envs);
+  communicator.InitEnvs();
+
+  RpcCtxMap send_ctx;
+  send_ctx[grad_name] = CommContext(grad_name,
+                                    {grad_name},
+                                    {"127.0.0.1:0"},
+                                    {numel},
+                                    {grad_name},
+                                    0,
+                                    true,
+                                    false,
+                                    false,
+                                    table_id);
+  RecvCtxMap recv_ctx;
+  recv_ctx[table_id] = {"w"};
+  Scope recv_scope;
+  communicator.InitImpl(send_ctx, recv_ctx, &recv_scope);
+
+  Scope trainer_scope;
+  auto *tensor = trainer_scope.Var(grad_name)->GetMutable<phi::DenseTensor>();
+  float *data =
+      tensor->mutable_data<float>(phi::make_ddim({numel}), phi::CPUPlace());
+  for (int step = 0; step < grad_num; ++step) {
+    std::fill(data, data + numel, static_cast<float>(step));
+    communicator.Send({grad_name}, trainer_scope);
+    communicator.SendByCommunicator();
+  }
+  communicator.Flush();
+
+  std::vector<int> expected(grad_num);
+  for (int i = 0; i < grad_num; ++i) {
+    expected[i] = i;
+  }
+  // every gradient sent exactly once, in the order of Send
+  EXPECT_EQ(communicator.Sent(), expected);
+  // the params of table_id are received right after each send of it
+  std::vector<int> recv_after(grad_num);
+  for (int i = 0; i < grad_num; ++i) {
+    recv_after[i] = i + 1;
+  }
+  EXPECT_EQ(communicator.RecvAfter(), recv_after);
+  EXPECT_EQ(communicator.GetSendPipelineStat().batch_num, grad_num);
+
+  FLAGS_communicator_send_pipeline_depth = old_depth;
+}
+
+}  // namespace distributed
+}  // namespace paddle
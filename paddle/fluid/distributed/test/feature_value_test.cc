@@ -46,5 +46,50 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+TEST(SlabAllocator, ShrinkCompact) {
+  typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  shard_type shard;
+  const size_t dim = 9;
+  const uint64_t key_num = 100000;
+  for (uint64_t key = 0; key < key_num; ++key) {
+    auto& feature_value = shard[key];
+    feature_value.resize(dim);
+    feature_value.data()[0] = static_cast<float>(key);
+  }
+  // extend a part of the values into a second size class
+  for (uint64_t key = 0; key < key_num; key += 4) {
+    auto& feature_value = shard.find(key).value();
+    feature_value.resize(dim * 2);
+    ASSERT_FLOAT_EQ(feature_value.data()[0], static_cast<float>(key));
+    ASSERT_FLOAT_EQ(feature_value.data()[dim], 0.0);
+  }
+  size_t live_bytes = shard.value_live_bytes();
+  size_t reserved_bytes = shard.value_reserved_bytes();
+  ASSERT_GE(reserved_bytes, live_bytes);
+  ASSERT_GE(live_bytes, key_num * dim * sizeof(float));
+
+  // keep every 10th key, as a Shrink pass would
+  for (auto it = shard.begin(); it != shard.end();) {
+    if (it.key() % 10 != 0) {
+      it = shard.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_LT(shard.value_live_bytes(), live_bytes / 5);
+  shard.compact_values();
+  ASSERT_LT(shard.value_reserved_bytes(), reserved_bytes / 2);
+
+  for (uint64_t key = 0; key < key_num; key += 10) {
+    auto itr = shard.find(key);
+    ASSERT_TRUE(itr != shard.end());
+    ASSERT_FLOAT_EQ(itr.value().data()[0], static_cast<float>(key));
+    ASSERT_EQ(itr.value().size(), key % 4 == 0 ? dim * 2 : dim);
+  }
+
+  shard.clear();
+  ASSERT_EQ(shard.value_live_bytes(), 0UL);
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,188 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_storage.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(GraphCSRStorage, Build) {
+  GraphCSRStorage storage("random");
+  storage.reserve(3, 5);
+  storage.add_edge(10, 1.);
+  storage.add_edge(11, 1.);
+  ASSERT_EQ(storage.finish_row(), 0u);
+  ASSERT_EQ(storage.finish_row(), 1u);
+  storage.add_edge(12, 1.);
+  storage.add_edge(13, 1.);
+  storage.add_edge(14, 1.);
+  ASSERT_EQ(storage.finish_row(), 2u);
+  storage.shrink_to_fit();
+
+  ASSERT_EQ(storage.row_num(), 3u);
+  ASSERT_EQ(storage.edge_num(), 5u);
+  ASSERT_FALSE(storage.has_weight());
+  ASSERT_EQ(storage.degree(0), 2u);
+  ASSERT_EQ(storage.degree(1), 0u);
+  ASSERT_EQ(storage.degree(2), 3u);
+  ASSERT_EQ(storage.get_id(2, 1), 13u);
+  ASSERT_FLOAT_EQ(storage.get_weight(2, 1), 1.);
+}
+
+TEST(GraphCSRStorage, RandomSample) {
+  GraphCSRStorage storage("random");
+  for (int i = 0; i < 100; i++) {
+    storage.add_edge(i, 1.);
+  }
+  storage.finish_row();
+  auto rng = std::make_shared<std::mt19937_64>(0);
+
+  ASSERT_EQ(storage.sample_k(0, 200, rng).size(), 100u);
+  ASSERT_TRUE(storage.sample_k(0, 0, rng).empty());
+  for (int t = 0; t < 10; t++) {
+    std::vector<int> res = storage.sample_k(0, 20, rng);
+    ASSERT_EQ(res.size(), 20u);
+    std::set<int> uniq(res.begin(), res.end());
+    ASSERT_EQ(uniq.size(), 20u);
+    for (int x : res) {
+      ASSERT_TRUE(x >= 0 && x < 100);
+    }
+  }
+}
+
+TEST(GraphCSRStorage, WeightedSample) {
+  GraphCSRStorage storage("weighted");
+  // neighbor 0 carries almost all the weight
+  storage.add_edge(100, 1000.);
+  for (int i = 1; i < 10; i++) {
+    storage.add_edge(100 + i, 0.001);
+  }
+  storage.finish_row();
+  storage.shrink_to_fit();
+  ASSERT_TRUE(storage.has_weight());
+  ASSERT_FLOAT_EQ(storage.get_weight(0, 0), 1000.);
+
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  int hit = 0;
+  for (int t = 0; t < 100; t++) {
+    std::vector<int> res = storage.sample_k(0, 3, rng);
+    ASSERT_EQ(res.size(), 3u);
+    std::set<int> uniq(res.begin(), res.end());
+    ASSERT_EQ(uniq.size(), 3u);
+    if (uniq.count(0)) hit++;
+  }
+  ASSERT_GE(hit, 95);
+}
+
+TEST(GraphCSRStorage, AliasDistribution) {
+  GraphCSRStorage storage("alias");
+  // an empty row and a row of zero weights between the weighted rows
+  storage.finish_row();
+  for (int i = 0; i < 4; i++) {
+    storage.add_edge(i, 0.);
+  }
+  storage.finish_row();
+  for (int i = 0; i < 4; i++) {
+    storage.add_edge(i, i + 1.);
+  }
+  storage.finish_row();
+  storage.shrink_to_fit();
+
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  std::vector<int> count(4, 0);
+  const int times = 100000;
+  for (int t = 0; t < times; t++) {
+    std::vector<int> res = storage.sample_k(2, 1, rng);
+    ASSERT_EQ(res.size(), 1u);
+    count[res[0]]++;
+  }
+  // neighbor i is drawn with probability (i + 1) / 10
+  for (int i = 0; i < 4; i++) {
+    EXPECT_NEAR(count[i] / static_cast<double>(times), (i + 1) / 10., 0.01);
+  }
+  ASSERT_TRUE(storage.sample_k(0, 2, rng).empty());
+  std::vector<int> res = storage.sample_k(1, 2, rng);
+  ASSERT_EQ(res.size(), 2u);
+  ASSERT_NE(res[0], res[1]);
+}
+
+// Counts how often each neighbor of the node is drawn by sample_k(k).
+static std::vector<int> CountSamples(Node *node, int k) {
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  std::vector<int> count(node->get_neighbor_size(), 0);
+  for (int t = 0; t < 200; t++) {
+    std::vector<int> res = node->sample_k(k, rng);
+    EXPECT_EQ(res.size(), static_cast<size_t>(k));
+    std::set<int> uniq(res.begin(), res.end());
+    EXPECT_EQ(uniq.size(), res.size());
+    for (int x : res) {
+      count[x]++;
+    }
+  }
+  return count;
+}
+
+TEST(GraphShard, FreezeAndUnpack) {
+  GraphShard shard;
+  for (uint64_t id = 0; id < 4; id++) {
+    GraphNode *node = shard.add_graph_node(id);
+    node->build_edges(true);
+    // the last neighbor has no weight and is never drawn by weight
+    for (uint64_t j = 0; j < 3; j++) {
+      node->add_edge(100 * id + j, 1.);
+    }
+    node->add_edge(100 * id + 3, 0.);
+  }
+  shard.add_graph_node(4);
+
+  shard.freeze_edges("random");
+  ASSERT_TRUE(shard.is_frozen());
+  size_t random_bytes = shard.get_csr_memory_size();
+  ASSERT_EQ(shard.find_node(1)->get_neighbor_size(), 4u);
+  ASSERT_EQ(shard.find_node(1)->get_neighbor_id(2), 102u);
+  ASSERT_GT(CountSamples(shard.find_node(1), 2)[3], 0);
+
+  // as GraphTable::build_sampler does on a loaded shard
+  for (auto node : shard.get_bucket()) {
+    node->build_sampler("alias");
+  }
+  ASSERT_TRUE(shard.is_frozen());
+  ASSERT_EQ(shard.csr_edges->get_sample_type(), "alias");
+  // the alias tables are only built for weighted sampling
+  ASSERT_EQ(shard.get_csr_memory_size(),
+            random_bytes + 16 * (sizeof(float) + sizeof(uint32_t)));
+  ASSERT_EQ(CountSamples(shard.find_node(1), 3)[3], 0);
+  ASSERT_TRUE(shard.find_node(4)->sample_k(2, nullptr).empty());
+
+  // the unpacked node keeps the neighbors and the sampler
+  GraphNode *node = shard.add_graph_node(1);
+  ASSERT_EQ(dynamic_cast<CSRGraphNode *>(shard.find_node(1)), nullptr);
+  ASSERT_EQ(node->get_neighbor_size(), 4u);
+  ASSERT_EQ(node->get_neighbor_id(2), 102u);
+  ASSERT_FLOAT_EQ(node->get_neighbor_weight(3), 0.);
+  ASSERT_EQ(CountSamples(node, 3)[3], 0);
+  ASSERT_EQ(CountSamples(shard.find_node(2), 3)[3], 0);
+  ASSERT_TRUE(shard.add_graph_node(4)->sample_k(2, nullptr).empty());
+}
+
+}  // namespace distributed
+}  // namespace paddle
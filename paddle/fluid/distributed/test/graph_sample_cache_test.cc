@@ -0,0 +1,134 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle {
+namespace distributed {
+
+using ClockCache = ClockSampleCache<SampleKey, SampleResult>;
+using LRUCache = ScaledLRU<SampleKey, SampleResult>;
+
+TEST(ClockSampleCache, QueryInsert) {
+  ClockCache cache(4, 1000, 2);
+  std::vector<SampleKey> keys;
+  std::vector<SampleResult> values;
+  for (int i = 0; i < 100; i++) {
+    keys.emplace_back(0, i, 10, false);
+    values.emplace_back(i, new char[1]);
+  }
+  std::vector<std::pair<SampleKey, SampleResult>> res;
+  cache.query(0, keys.data(), keys.size(), res);
+  ASSERT_TRUE(res.empty());
+
+  cache.insert(0, keys.data(), values.data(), keys.size());
+  cache.query(0, keys.data(), keys.size(), res);
+  ASSERT_EQ(res.size(), 100u);
+  for (size_t i = 0; i < res.size(); i++) {
+    ASSERT_EQ(res[i].first.node_key, i);
+    ASSERT_EQ(res[i].second.actual_size, i);
+  }
+
+  // every entry expires after ttl = 2 hits
+  res.clear();
+  cache.query(0, keys.data(), keys.size(), res);
+  ASSERT_EQ(res.size(), 100u);
+  res.clear();
+  cache.query(0, keys.data(), keys.size(), res);
+  ASSERT_TRUE(res.empty());
+
+  SampleCacheStat stat = cache.stat();
+  ASSERT_EQ(stat.hit, 200u);
+  ASSERT_EQ(stat.miss, 200u);
+  ASSERT_EQ(stat.expire, 100u);
+  ASSERT_EQ(stat.size, 0u);
+}
+
+TEST(ClockSampleCache, Evict) {
+  ClockCache cache(1, 64, 100);
+  std::vector<SampleKey> keys;
+  std::vector<SampleResult> values;
+  for (int i = 0; i < 1000; i++) {
+    keys.emplace_back(0, i, 10, false);
+    values.emplace_back(i, new char[1]);
+  }
+  cache.insert(0, keys.data(), values.data(), keys.size());
+  SampleCacheStat stat = cache.stat();
+  ASSERT_EQ(stat.size, 64u);
+  ASSERT_EQ(stat.evict, 1000u - 64u);
+
+  std::vector<std::pair<SampleKey, SampleResult>> res;
+  cache.query(0, keys.data(), keys.size(), res);
+  ASSERT_EQ(res.size(), 64u);
+  for (auto &item : res) {
+    ASSERT_EQ(item.first.node_key, item.second.actual_size);
+  }
+}
+
+template <typename Cache>
+double BenchCache(Cache *cache, int thread_num, int rounds) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([cache, t, rounds]() {
+      std::mt19937_64 rng(t);
+      std::uniform_int_distribution<uint64_t> distrib(0, 200000);
+      std::vector<SampleKey> keys;
+      std::vector<SampleResult> values;
+      std::vector<std::pair<SampleKey, SampleResult>> res;
+      for (int r = 0; r < rounds; r++) {
+        keys.clear();
+        values.clear();
+        res.clear();
+        for (int i = 0; i < 256; i++) {
+          keys.emplace_back(0, distrib(rng), 10, false);
+        }
+        cache->query(t, keys.data(), keys.size(), res);
+        for (size_t i = 0; i < keys.size(); i++) {
+          values.emplace_back(8, new char[8]);
+        }
+        cache->insert(t, keys.data(), values.data(), keys.size());
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Only logs timings, run it with --gtest_also_run_disabled_tests.
+TEST(ClockSampleCache, DISABLED_Benchmark) {
+  const int rounds = 50;
+  for (int thread_num : {1, 8, 32}) {
+    LRUCache lru(thread_num, 100000, 5);
+    ClockCache clock(thread_num * 4, 100000, 5);
+    double lru_ms = BenchCache(&lru, thread_num, rounds);
+    double clock_ms = BenchCache(&clock, thread_num, rounds);
+    SampleCacheStat stat = clock.stat();
+    VLOG(0) << thread_num << " threads: ScaledLRU " << lru_ms
+            << " ms, ClockSampleCache " << clock_ms << " ms, hit " << stat.hit
+            << " miss " << stat.miss << " evict " << stat.evict;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,125 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_edge.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
+
+namespace paddle {
+namespace distributed {
+
+static std::vector<std::unique_ptr<WeightedGraphEdgeBlob>> BuildEdges(
+    const std::vector<int>& degrees, std::mt19937_64* rng) {
+  std::uniform_real_distribution<float> weight_distrib(0.01, 10.0);
+  std::vector<std::unique_ptr<WeightedGraphEdgeBlob>> edges;
+  for (int degree : degrees) {
+    edges.emplace_back(new WeightedGraphEdgeBlob());
+    for (int i = 0; i < degree; i++) {
+      edges.back()->add_edge(i, weight_distrib(*rng));
+    }
+  }
+  return edges;
+}
+
+template <typename SamplerT>
+static double BenchSampler(
+    const std::vector<std::unique_ptr<WeightedGraphEdgeBlob>>& edges,
+    int k,
+    int rounds) {
+  std::vector<std::unique_ptr<SamplerT>> samplers;
+  for (auto& edge : edges) {
+    samplers.emplace_back(new SamplerT());
+    samplers.back()->build(edge.get());
+  }
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  size_t total = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (auto& sampler : samplers) {
+      total += sampler->sample_k(k, rng).size();
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_GT(total, 0u);
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+TEST(AliasSampler, Distribution) {
+  WeightedGraphEdgeBlob edges;
+  edges.add_edge(0, 8.0);
+  edges.add_edge(1, 1.0);
+  edges.add_edge(2, 1.0);
+  edges.add_edge(3, 0.0);
+  AliasSampler sampler;
+  sampler.build(&edges);
+  auto rng = std::make_shared<std::mt19937_64>(0);
+
+  std::vector<int> count(4, 0);
+  for (int t = 0; t < 10000; t++) {
+    std::vector<int> res = sampler.sample_k(1, rng);
+    ASSERT_EQ(res.size(), 1u);
+    count[res[0]]++;
+  }
+  ASSERT_EQ(count[3], 0);
+  ASSERT_NEAR(count[0] / 10000.0, 0.8, 0.03);
+
+  // the zero-weight neighbor is only picked once the others are used up
+  for (int t = 0; t < 100; t++) {
+    std::vector<int> res = sampler.sample_k(3, rng);
+    std::set<int> uniq(res.begin(), res.end());
+    ASSERT_EQ(uniq.size(), 3u);
+    ASSERT_EQ(uniq.count(3), 0u);
+  }
+  ASSERT_EQ(sampler.sample_k(10, rng).size(), 4u);
+}
+
+// Only logs timings, run it with --gtest_also_run_disabled_tests.
+TEST(AliasSampler, DISABLED_Benchmark) {
+  std::mt19937_64 rng(0);
+  const int k = 10;
+  std::vector<std::pair<std::string, std::vector<int>>> cases;
+  cases.emplace_back("uniform_degree_32", std::vector<int>(2000, 32));
+  cases.emplace_back("uniform_degree_1024", std::vector<int>(200, 1024));
+  // power law degrees: a handful of hubs and a long tail of small nodes
+  std::vector<int> power_law;
+  std::uniform_real_distribution<double> distrib(0.0, 1.0);
+  for (int i = 0; i < 2000; i++) {
+    power_law.push_back(
+        std::min(100000, static_cast<int>(k / std::pow(distrib(rng), 1.2))));
+  }
+  cases.emplace_back("power_law", power_law);
+
+  for (auto& c : cases) {
+    auto edges = BuildEdges(c.second, &rng);
+    double weighted_ms = BenchSampler<WeightedSampler>(edges, k, 10);
+    double alias_ms = BenchSampler<AliasSampler>(edges, k, 10);
+    LOG(INFO) << c.first << ": WeightedSampler " << weighted_ms
+              << " ms, AliasSampler " << alias_ms << " ms, speedup "
+              << weighted_ms / alias_ms;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
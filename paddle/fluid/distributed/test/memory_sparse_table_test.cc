@@ -17,6 +17,8 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <map>
 #include <string>
 #include <thread>  // NOLINT
 
@@ -24,6 +26,7 @@ limitations under the License. */
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/io/fs.h"
 
 namespace paddle {
 namespace distributed {
@@ -152,5 +155,134 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+static void InitIncrementalSaveTable(Table *table) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(10);
+  table_config.set_compress_in_save(false);
+  table_config.set_enable_incremental_save(true);
+  FsClientParameter fs_config;
+  table->SetShard(0, 1);
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  auto *ctr_param = accessor_config->mutable_ctr_accessor_param();
+  ctr_param->set_nonclk_coeff(0.2);
+  ctr_param->set_click_coeff(1);
+  ctr_param->set_delete_threshold(0);
+  ctr_param->set_delete_after_unseen_days(1);
+  ctr_param->set_show_click_decay_rate(0.99);
+
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+  accessor_config->mutable_embedx_sgd_param()->CopyFrom(
+      accessor_config->embed_sgd_param());
+
+  ASSERT_EQ(table->Initialize(table_config, fs_config), 0);
+}
+
+static void PushKeys(Table *table, const std::vector<uint64_t> &keys) {
+  // slot, show, click, embed_g, embedx_g
+  std::vector<float> push_values;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    push_values.insert(push_values.end(), {0.0f, 1.0f, 0.0f});
+    for (int k = 0; k < 9; ++k) {
+      push_values.push_back(0.01 * (keys[i] % 17) + 0.1 * k);
+    }
+  }
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.push_context.keys = keys.data();
+  table_context.push_context.values = push_values.data();
+  table_context.num = keys.size();
+  ASSERT_EQ(table->Push(table_context), 0);
+}
+
+static std::map<uint64_t, std::vector<float>> DumpTable(Table *table) {
+  std::map<uint64_t, std::vector<float>> values;
+  for (size_t i = 0; i < 10; ++i) {
+    auto *shard =
+        static_cast<MemorySparseTable::shard_type *>(table->GetShard(i));
+    for (auto it = shard->begin(); it != shard->end(); ++it) {
+      values[it.key()].assign(it.value().data(),
+                              it.value().data() + it.value().size());
+    }
+  }
+  return values;
+}
+
+TEST(MemorySparseTable, IncrementalSave) {
+  std::string path = "./memory_sparse_table_incremental";
+  std::string batch_model_path = "./memory_sparse_table_batch_model";
+  paddle::framework::fs_remove(path);
+  paddle::framework::fs_remove(batch_model_path);
+
+  std::vector<uint64_t> base_keys;
+  for (uint64_t key = 0; key < 100; ++key) {
+    base_keys.push_back(key);
+  }
+  std::vector<uint64_t> delta_keys = {0, 1, 2, 3, 4, 1000, 1001, 1002, 1003};
+
+  std::unique_ptr<Table> table(new MemorySparseTable());
+  InitIncrementalSaveTable(table.get());
+  PushKeys(table.get(), base_keys);
+  PushKeys(table.get(), base_keys);
+  ASSERT_EQ(table->Save(path, "0"), 0);
+
+  // delta 1: updated and new keys
+  PushKeys(table.get(), delta_keys);
+  ASSERT_EQ(table->Save(path, "6"), 0);
+  auto expect = DumpTable(table.get());
+  {
+    std::unique_ptr<Table> loaded(new MemorySparseTable());
+    InitIncrementalSaveTable(loaded.get());
+    ASSERT_EQ(loaded->Load(path, "0"), 0);
+    auto values = DumpTable(loaded.get());
+    ASSERT_EQ(values.size(), expect.size());
+    for (auto &item : expect) {
+      auto &value = values[item.first];
+      ASSERT_EQ(value.size(), item.second.size());
+      bool in_delta = std::find(delta_keys.begin(),
+                                delta_keys.end(),
+                                item.first) != delta_keys.end();
+      for (size_t i = 0; i < value.size(); ++i) {
+        if (in_delta) {
+          // binary delta keeps the exact value
+          ASSERT_EQ(value[i], item.second[i]);
+        } else {
+          ASSERT_NEAR(value[i], item.second[i], 1e-4);
+        }
+      }
+    }
+  }
+
+  // delta 2: batch model saves age every key, shrink drops the keys unseen
+  // since then and decays the others
+  ASSERT_EQ(table->Save(batch_model_path, "3"), 0);
+  ASSERT_EQ(table->Save(batch_model_path, "3"), 0);
+  PushKeys(table.get(), {0, 1, 2, 50, 1000});
+  ASSERT_EQ(table->Shrink(""), 0);
+  ASSERT_EQ(table->Save(path, "6"), 0);
+  expect = DumpTable(table.get());
+  ASSERT_EQ(expect.size(), 5UL);
+  {
+    std::unique_ptr<Table> loaded(new MemorySparseTable());
+    InitIncrementalSaveTable(loaded.get());
+    ASSERT_EQ(loaded->Load(path, "0"), 0);
+    ASSERT_EQ(DumpTable(loaded.get()), expect);
+  }
+
+  paddle::framework::fs_remove(path);
+  paddle::framework::fs_remove(batch_model_path);
+}
+
 }  // namespace distributed
 }  // namespace paddle
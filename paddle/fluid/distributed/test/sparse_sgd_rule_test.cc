@@ -14,8 +14,10 @@ limitations under the License. */
 
 #include "paddle/fluid/distributed/ps/table/sparse_sgd_rule.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
@@ -205,5 +207,80 @@ TEST(downpour_sparse_adam_test, test_init_and_update) {
     ASSERT_FLOAT_EQ(value[i], label[i]) << "i is " << i;
   }
 }
+static void CheckBatchMatchesSingle(SparseValueSGDRule* rule,
+                                    size_t emb_dim) {
+  const size_t kKeyNum = 40;
+  const size_t sgd_dim = rule->Dim();
+  const size_t value_dim = emb_dim + sgd_dim;
+  std::vector<float> single(kKeyNum * value_dim);
+  std::vector<float> grads(kKeyNum * emb_dim);
+  std::vector<float> scales(kKeyNum);
+  for (size_t k = 0; k < kKeyNum; ++k) {
+    rule->InitValue(
+        &single[k * value_dim], &single[k * value_dim + emb_dim], false);
+    for (size_t i = 0; i < emb_dim; ++i) {
+      grads[k * emb_dim + i] = std::sin(k * 7 + i) * (k % 3 == 0 ? 50 : 1);
+    }
+    scales[k] = 1.0 + k % 4;
+  }
+  std::vector<float> batch = single;
+
+  std::vector<float*> values(kKeyNum);
+  std::vector<const float*> push_values(kKeyNum);
+  for (int round = 0; round < 3; ++round) {
+    for (size_t k = 0; k < kKeyNum; ++k) {
+      rule->UpdateValue(&single[k * value_dim],
+                        &single[k * value_dim + emb_dim],
+                        &grads[k * emb_dim],
+                        scales[k]);
+      values[k] = &batch[k * value_dim];
+      push_values[k] = &grads[k * emb_dim];
+    }
+    rule->UpdateValueBatch(values.data(),
+                           0,
+                           emb_dim,
+                           push_values.data(),
+                           0,
+                           scales.data(),
+                           kKeyNum);
+  }
+  for (size_t i = 0; i < single.size(); ++i) {
+    ASSERT_NEAR(
+        batch[i], single[i], 1e-4 * std::max(1.0f, std::abs(single[i])))
+        << "rule: " << rule->GetName() << " index: " << i;
+  }
+}
+
+TEST(sparse_sgd_rule_batch_test, batch_matches_single_update) {
+  const size_t emb_dim = 13;
+
+  SparseAdaGradSGDRule adagrad_rule;
+  StdAdaGradSGDRule std_adagrad_rule;
+  SparseCommonSGDRuleParameter adagrad_param;
+  adagrad_param.set_name("adagrad");
+  adagrad_param.mutable_adagrad()->set_learning_rate(0.1);
+  adagrad_param.mutable_adagrad()->set_initial_g2sum(0.2);
+  adagrad_param.mutable_adagrad()->set_initial_range(0.3);
+  adagrad_param.mutable_adagrad()->add_weight_bounds(-1.0);
+  adagrad_param.mutable_adagrad()->add_weight_bounds(1.0);
+  adagrad_rule.LoadConfig(adagrad_param, emb_dim);
+  std_adagrad_rule.LoadConfig(adagrad_param, emb_dim);
+  CheckBatchMatchesSingle(&adagrad_rule, emb_dim);
+  CheckBatchMatchesSingle(&std_adagrad_rule, emb_dim);
+
+  SparseAdamSGDRule adam_rule;
+  SparseCommonSGDRuleParameter adam_param;
+  adam_param.set_name("adam");
+  adam_param.mutable_adam()->set_learning_rate(0.1);
+  adam_param.mutable_adam()->set_initial_range(0.3);
+  adam_param.mutable_adam()->set_beta1_decay_rate(0.9);
+  adam_param.mutable_adam()->set_beta2_decay_rate(0.999);
+  adam_param.mutable_adam()->set_ada_epsilon(1e-08);
+  adam_param.mutable_adam()->add_weight_bounds(-1.0);
+  adam_param.mutable_adam()->add_weight_bounds(1.0);
+  adam_rule.LoadConfig(adam_param, emb_dim);
+  CheckBatchMatchesSingle(&adam_rule, emb_dim);
+}
+
 }  // namespace distributed
 }  // namespace paddle
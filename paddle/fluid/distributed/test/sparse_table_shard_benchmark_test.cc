@@ -0,0 +1,199 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/depends/flat_sparse_table_shard.h"
+#include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/ps/table/table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+// run with --sparse_shard_bench_key_num=100000000 for the full size benchmark
+DEFINE_int64(sparse_shard_bench_key_num,
+             1000000,
+             "number of feasigns pulled and pushed by the shard benchmark");
+DEFINE_int32(sparse_shard_bench_batch_size,
+             100000,
+             "number of feasigns in one pull/push request");
+
+namespace paddle {
+namespace distributed {
+
+TEST(FlatSparseTableShard, InsertFindErase) {
+  const size_t dim = 5;
+  FlatSparseTableShard shard(dim);
+  std::unordered_map<uint64_t, float> expect;
+  std::mt19937_64 rng(2023);
+
+  for (int i = 0; i < 20000; ++i) {
+    uint64_t key = rng() % 50000;
+    auto ret = shard.emplace(key);
+    auto value = ret.first.value();
+    if (ret.second) {
+      value.resize(dim);
+    }
+    value.data()[dim - 1] = static_cast<float>(key);
+    expect[key] = static_cast<float>(key);
+  }
+  ASSERT_EQ(shard.size(), expect.size());
+
+  // erase every other key, leaving tombstones behind
+  size_t erased = 0;
+  for (auto it = shard.begin(); it != shard.end();) {
+    if (it.key() % 2 == 0) {
+      expect.erase(it.key());
+      it = shard.erase(it);
+      ++erased;
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_GT(erased, 0UL);
+  ASSERT_EQ(shard.size(), expect.size());
+
+  // reinsert over the tombstones, forcing rehashes on the way
+  for (uint64_t key = 100000; key < 140000; ++key) {
+    auto value = shard[key];
+    value.resize(dim);
+    value.data()[dim - 1] = static_cast<float>(key);
+    expect[key] = static_cast<float>(key);
+  }
+  ASSERT_EQ(shard.size(), expect.size());
+
+  for (auto &kv : expect) {
+    auto it = shard.find(kv.first);
+    ASSERT_TRUE(it != shard.end());
+    ASSERT_EQ(it.value().size(), dim);
+    ASSERT_EQ(it.value().data()[dim - 1], kv.second);
+  }
+  for (uint64_t key = 0; key < 50000; key += 2) {
+    ASSERT_TRUE(shard.find(key) == shard.end());
+  }
+
+  size_t visited = 0;
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    ++visited;
+  }
+  ASSERT_EQ(visited, expect.size());
+
+  shard.clear();
+  ASSERT_TRUE(shard.empty());
+  ASSERT_TRUE(shard.find(1) == shard.end());
+}
+
+static Table *CreateBenchTable(const std::string &shard_map_type) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(24);
+  table_config.set_shard_map_type(shard_map_type);
+  FsClientParameter fs_config;
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return table;
+}
+
+static void RunPullPushBenchmark(const std::string &shard_map_type) {
+  const int emb_dim = 8;
+  const int64_t key_num = FLAGS_sparse_shard_bench_key_num;
+  const int64_t batch_size = FLAGS_sparse_shard_bench_batch_size;
+  Table *table = CreateBenchTable(shard_map_type);
+
+  std::mt19937_64 rng(0);
+  std::vector<uint64_t> keys(batch_size);
+  std::vector<uint32_t> fres(batch_size, 1);
+  std::vector<float> pull_values(batch_size * (emb_dim + 3));
+  std::vector<float> push_values(batch_size * (emb_dim + 4), 0.1);
+
+  double pull_ms = 0;
+  double push_ms = 0;
+  for (int64_t begin = 0; begin < key_num; begin += batch_size) {
+    int64_t num = std::min(batch_size, key_num - begin);
+    keys.resize(num);
+    for (auto &key : keys) {
+      key = rng();
+    }
+    auto pull_value = PullSparseValue(keys, fres, emb_dim);
+
+    TableContext pull_context;
+    pull_context.value_type = Sparse;
+    pull_context.pull_context.pull_value = pull_value;
+    pull_context.pull_context.values = pull_values.data();
+    auto start = std::chrono::steady_clock::now();
+    table->Pull(pull_context);
+    auto end = std::chrono::steady_clock::now();
+    pull_ms +=
+        std::chrono::duration<double, std::milli>(end - start).count();
+
+    TableContext push_context;
+    push_context.value_type = Sparse;
+    push_context.push_context.keys = keys.data();
+    push_context.push_context.values = push_values.data();
+    push_context.num = num;
+    start = std::chrono::steady_clock::now();
+    table->Push(push_context);
+    end = std::chrono::steady_clock::now();
+    push_ms +=
+        std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  auto *sparse_table = dynamic_cast<MemorySparseTable *>(table);
+  EXPECT_EQ(sparse_table->LocalSize(), key_num);
+  LOG(INFO) << "shard_map_type: " << shard_map_type << " keys: " << key_num
+            << " pull: " << pull_ms << " ms (" << key_num / pull_ms * 1000
+            << " keys/s)"
+            << " push: " << push_ms << " ms (" << key_num / push_ms * 1000
+            << " keys/s)";
+  delete table;
+}
+
+// Only logs timings, run it with --gtest_also_run_disabled_tests.
+TEST(MemorySparseTable, DISABLED_ShardMapPullPushBenchmark) {
+  RunPullPushBenchmark("closed_hash");
+  RunPullPushBenchmark("flat");
+}
+
+}  // namespace distributed
+}  // namespace paddle
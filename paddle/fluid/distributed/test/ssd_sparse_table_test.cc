@@ -0,0 +1,309 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+DECLARE_string(rocksdb_path);
+DECLARE_double(pserver_ssd_admission_threshold);
+DECLARE_int64(pserver_ssd_mem_max_keys_per_shard);
+DECLARE_int32(pserver_ssd_demote_interval_ms);
+
+namespace paddle {
+namespace distributed {
+
+static const int kEmbedxDim = 8;
+// show, click, embed_w, embedx_w
+static const int kSelectDim = kEmbedxDim + 3;
+// slot, show, click, embed_g, embedx_g
+static const int kPushDim = kEmbedxDim + 4;
+
+static void InitSSDTable(Table *table, int shard_num) {
+  TableParameter table_config;
+  table_config.set_table_class("SSDSparseTable");
+  table_config.set_shard_num(shard_num);
+  FsClientParameter fs_config;
+  table->SetShard(0, 1);
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(kEmbedxDim);
+  accessor_config->set_embedx_threshold(100);
+  auto *ctr_param = accessor_config->mutable_ctr_accessor_param();
+  ctr_param->set_nonclk_coeff(0.2);
+  ctr_param->set_click_coeff(1);
+  ctr_param->set_delete_threshold(0.1);
+  ctr_param->set_show_click_decay_rate(0.99);
+
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+  accessor_config->mutable_embedx_sgd_param()->CopyFrom(
+      accessor_config->embed_sgd_param());
+
+  ASSERT_EQ(table->Initialize(table_config, fs_config), 0);
+}
+
+static std::vector<float> PullKeys(Table *table,
+                                   const std::vector<uint64_t> &keys) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  std::vector<float> pull_values(keys.size() * kSelectDim);
+  auto value = PullSparseValue(keys, fres, kEmbedxDim);
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = value;
+  table_context.pull_context.values = pull_values.data();
+  EXPECT_EQ(table->Pull(table_context), 0);
+  return pull_values;
+}
+
+static void PushKeys(Table *table, const std::vector<uint64_t> &keys) {
+  std::vector<float> push_values;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    push_values.insert(push_values.end(), {0.0f, 1.0f, 0.0f});
+    for (int k = 0; k < kPushDim - 3; ++k) {
+      push_values.push_back(0.01 * (keys[i] % 7));
+    }
+  }
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.push_context.keys = keys.data();
+  table_context.push_context.values = push_values.data();
+  table_context.num = keys.size();
+  EXPECT_EQ(table->Push(table_context), 0);
+}
+
+static bool WaitLocalSize(SSDSparseTable *table, int64_t max_size) {
+  for (int i = 0; i < 500; ++i) {
+    if (table->LocalSize() <= max_size) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+static void RemoveDB(const std::string &path, int shard_num) {
+  for (int i = 0; i < shard_num; ++i) {
+    paddle::framework::fs_remove(path + "_" + std::to_string(i));
+  }
+}
+
+TEST(SSDSparseTable, AdmissionAndDemotion) {
+  FLAGS_rocksdb_path = "./ssd_sparse_table_admission";
+  // 每次push show=1 click=0, 热度+0.2, 5次push后才准入内存
+  FLAGS_pserver_ssd_admission_threshold = 0.9;
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 10;
+  FLAGS_pserver_ssd_demote_interval_ms = 10;
+
+  std::unique_ptr<SSDSparseTable> table(new SSDSparseTable());
+  InitSSDTable(table.get(), 1);
+
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 100; ++key) {
+    keys.push_back(key);
+  }
+  auto init_values = PullKeys(table.get(), keys);
+  ASSERT_EQ(table->GetTierStat().ssd_miss, keys.size());
+
+  // 后台线程把超出上限的冷key写回rocksdb
+  ASSERT_TRUE(WaitLocalSize(table.get(), 10));
+  ASSERT_GE(table->GetTierStat().demote, 90UL);
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 1000;
+  int64_t mem_keys = table->LocalSize();
+
+  // 冷key从rocksdb读出后不进内存, 值和第一次pull的一致
+  auto stat = table->GetTierStat();
+  auto values = PullKeys(table.get(), keys);
+  ASSERT_EQ(values, init_values);
+  auto new_stat = table->GetTierStat();
+  ASSERT_EQ(new_stat.mem_hit - stat.mem_hit, static_cast<uint64_t>(mem_keys));
+  ASSERT_EQ(new_stat.ssd_hit - stat.ssd_hit, keys.size() - mem_keys);
+  ASSERT_EQ(new_stat.ssd_miss, stat.ssd_miss);
+  ASSERT_EQ(table->LocalSize(), mem_keys);
+
+  // push直接更新rocksdb中的value, 热度不够时不搬回内存
+  for (int i = 0; i < 4; ++i) {
+    PushKeys(table.get(), keys);
+    ASSERT_EQ(table->LocalSize(), mem_keys);
+  }
+  values = PullKeys(table.get(), keys);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i * kSelectDim], 4.0);
+  }
+  ASSERT_EQ(table->LocalSize(), mem_keys);
+
+  // 第5次push后热度达到阈值, 全部搬回内存
+  PushKeys(table.get(), keys);
+  ASSERT_EQ(table->LocalSize(), static_cast<int64_t>(keys.size()));
+  values = PullKeys(table.get(), keys);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i * kSelectDim], 5.0);
+  }
+
+  // 同一batch中重复的新key只创建一次
+  std::vector<uint64_t> dup_keys = {1000, 1000, 1000};
+  values = PullKeys(table.get(), dup_keys);
+  ASSERT_EQ(table->LocalSize(), static_cast<int64_t>(keys.size() + 1));
+  for (int j = 0; j < kSelectDim; ++j) {
+    ASSERT_EQ(values[j], values[kSelectDim + j]);
+    ASSERT_EQ(values[j], values[2 * kSelectDim + j]);
+  }
+
+  table->PrintTableStat();
+  table.reset();
+  RemoveDB(FLAGS_rocksdb_path, 1);
+  FLAGS_pserver_ssd_admission_threshold = 0.0;
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 0;
+}
+
+TEST(SSDSparseTable, DemoteWithShrinkPullPush) {
+  FLAGS_rocksdb_path = "./ssd_sparse_table_demote";
+  FLAGS_pserver_ssd_admission_threshold = 0.5;
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 20;
+  FLAGS_pserver_ssd_demote_interval_ms = 1;
+
+  std::unique_ptr<SSDSparseTable> table(new SSDSparseTable());
+  InitSSDTable(table.get(), 4);
+
+  // 后台降级线程一直在跑, 和pull/push/shrink交错执行
+  for (int round = 0; round < 50; ++round) {
+    std::vector<uint64_t> keys;
+    for (uint64_t key = 0; key < 200; ++key) {
+      keys.push_back((key * 31 + round * 7) % 500);
+    }
+    PullKeys(table.get(), keys);
+    PushKeys(table.get(), keys);
+    if (round % 10 == 9) {
+      ASSERT_EQ(table->Shrink(""), 0);
+    }
+  }
+  ASSERT_GT(table->GetTierStat().demote, 0UL);
+
+  table.reset();
+  RemoveDB(FLAGS_rocksdb_path, 4);
+  FLAGS_pserver_ssd_admission_threshold = 0.0;
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 0;
+}
+
+TEST(SSDSparseTable, Prefetch) {
+  FLAGS_rocksdb_path = "./ssd_sparse_table_prefetch";
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 1000;
+  FLAGS_pserver_ssd_demote_interval_ms = 10;
+
+  std::unique_ptr<SSDSparseTable> table(new SSDSparseTable());
+  InitSSDTable(table.get(), 1);
+
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 100; ++key) {
+    keys.push_back(key);
+  }
+  // 3次push后热度为0.6, 再降级到rocksdb
+  PullKeys(table.get(), keys);
+  for (int i = 0; i < 3; ++i) {
+    PushKeys(table.get(), keys);
+  }
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 10;
+  ASSERT_TRUE(WaitLocalSize(table.get(), 10));
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 1000;
+  int64_t mem_keys = table->LocalSize();
+
+  // 热度不够的key不预取; shard的task线程串行, 之后的pull能看到预取结果
+  FLAGS_pserver_ssd_admission_threshold = 1.0;
+  ASSERT_EQ(table->PrefetchSparse(keys.data(), keys.size()), 0);
+  auto stat = table->GetTierStat();
+  PullKeys(table.get(), keys);
+  auto new_stat = table->GetTierStat();
+  ASSERT_EQ(new_stat.prefetch, 0UL);
+  ASSERT_EQ(new_stat.mem_hit - stat.mem_hit, static_cast<uint64_t>(mem_keys));
+  ASSERT_EQ(table->LocalSize(), mem_keys);
+
+  // 预取把达到准入阈值的key搬到内存, pull全部命中内存
+  FLAGS_pserver_ssd_admission_threshold = 0.5;
+  ASSERT_EQ(table->PrefetchSparse(keys.data(), keys.size()), 0);
+  stat = table->GetTierStat();
+  auto values = PullKeys(table.get(), keys);
+  new_stat = table->GetTierStat();
+  ASSERT_EQ(new_stat.prefetch, keys.size() - mem_keys);
+  ASSERT_EQ(new_stat.mem_hit - stat.mem_hit, keys.size());
+  ASSERT_EQ(table->LocalSize(), static_cast<int64_t>(keys.size()));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i * kSelectDim], 3.0);
+  }
+
+  table.reset();
+  RemoveDB(FLAGS_rocksdb_path, 1);
+  FLAGS_pserver_ssd_admission_threshold = 0.0;
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 0;
+}
+
+TEST(SSDSparseTable, NoDemotionWhilePtrPulled) {
+  FLAGS_rocksdb_path = "./ssd_sparse_table_ptr";
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 10;
+  FLAGS_pserver_ssd_demote_interval_ms = 1;
+
+  std::unique_ptr<SSDSparseTable> table(new SSDSparseTable());
+  InitSSDTable(table.get(), 1);
+
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 100; ++key) {
+    keys.push_back(key);
+  }
+  std::vector<char *> ptr_values(keys.size());
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.keys = keys.data();
+  table_context.pull_context.ptr_values = ptr_values.data();
+  table_context.use_ptr = true;
+  table_context.num = keys.size();
+  table_context.shard_id = 0;
+  table_context.pass_id = 1;
+  ASSERT_EQ(table->Pull(table_context), 0);
+
+  // 指针交出后value不能被写回rocksdb
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(table->LocalSize(), static_cast<int64_t>(keys.size()));
+  ASSERT_EQ(table->GetTierStat().demote, 0UL);
+
+  // pass结束后恢复降级
+  ASSERT_EQ(table->CacheTable(1), 0);
+  for (auto &key : keys) {
+    key += 100;
+  }
+  PullKeys(table.get(), keys);
+  ASSERT_TRUE(WaitLocalSize(table.get(), 10));
+  ASSERT_GT(table->GetTierStat().demote, 0UL);
+
+  table.reset();
+  RemoveDB(FLAGS_rocksdb_path, 1);
+  FLAGS_pserver_ssd_mem_max_keys_per_shard = 0;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,94 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+// Partition the records in place into bucket_num buckets, the bucket of a
+// record is get_bucket(record) % bucket_num. The buckets are laid out in a
+// random order, so that visiting the buckets one by one is a shuffle of the
+// buckets, the records of a bucket are left to the caller to shuffle, e.g. by
+// a thread per bucket. The records are only swapped, never copied, the extra
+// memory is a bucket id per record.
+//
+// Returns the offsets of the buckets in the layout, i.e. the k-th bucket is
+// [offsets[k], offsets[k + 1]) of the records.
+template <typename T, typename BucketFunc, typename RandomEngine>
+std::vector<size_t> PartitionByBucket(std::vector<T>* records,
+                                      size_t bucket_num,
+                                      BucketFunc get_bucket,
+                                      RandomEngine* engine) {
+  PADDLE_ENFORCE_GT(bucket_num,
+                    0,
+                    phi::errors::InvalidArgument(
+                        "The bucket number of the shuffle should be > 0."));
+  PADDLE_ENFORCE_LE(bucket_num,
+                    UINT32_MAX,
+                    phi::errors::InvalidArgument(
+                        "The bucket number of the shuffle should be <= %d, "
+                        "but received %d.",
+                        UINT32_MAX,
+                        bucket_num));
+  auto& data = *records;
+  std::vector<uint32_t> buckets(data.size());
+  std::vector<size_t> counts(bucket_num, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    buckets[i] = static_cast<uint32_t>(get_bucket(data[i]) % bucket_num);
+    ++counts[buckets[i]];
+  }
+
+  // shuffle the bucket indices instead of the records
+  std::vector<uint32_t> order(bucket_num);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), *engine);
+  std::vector<size_t> offsets(bucket_num + 1, 0);
+  std::vector<size_t> next(bucket_num);
+  std::vector<size_t> end(bucket_num);
+  for (size_t k = 0; k < bucket_num; ++k) {
+    offsets[k + 1] = offsets[k] + counts[order[k]];
+    next[order[k]] = offsets[k];
+    end[order[k]] = offsets[k + 1];
+  }
+
+  // swap every record to the next free place of its bucket
+  for (size_t k = 0; k < bucket_num; ++k) {
+    uint32_t bucket = order[k];
+    while (next[bucket] < end[bucket]) {
+      size_t i = next[bucket];
+      uint32_t target = buckets[i];
+      if (target != bucket) {
+        size_t j = next[target]++;
+        std::swap(data[i], data[j]);
+        std::swap(buckets[i], buckets[j]);
+      } else {
+        ++next[bucket];
+      }
+    }
+  }
+
+  return offsets;
+}
+
+}  // namespace framework
+}  // namespace paddle
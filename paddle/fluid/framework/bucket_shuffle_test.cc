@@ -0,0 +1,88 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/bucket_shuffle.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+static void TestPartition(int record_num, size_t bucket_num) {
+  // the records are move only, so that they can not be copied
+  std::vector<std::unique_ptr<int>> records;
+  for (int i = 0; i < record_num; ++i) {
+    records.emplace_back(new int(i));
+  }
+  auto get_bucket = [](const std::unique_ptr<int>& rec) -> uint64_t {
+    return static_cast<uint64_t>(*rec) * 2654435761u;
+  };
+  std::default_random_engine engine(0);
+  std::vector<size_t> offsets =
+      PartitionByBucket(&records, bucket_num, get_bucket, &engine);
+
+  ASSERT_EQ(offsets.size(), bucket_num + 1);
+  ASSERT_EQ(offsets.front(), 0UL);
+  ASSERT_EQ(offsets.back(), records.size());
+  std::set<uint64_t> seen_buckets;
+  std::set<int> seen_records;
+  for (size_t k = 0; k < bucket_num; ++k) {
+    ASSERT_LE(offsets[k], offsets[k + 1]);
+    if (offsets[k] == offsets[k + 1]) {
+      continue;
+    }
+    uint64_t bucket = get_bucket(records[offsets[k]]) % bucket_num;
+    // every bucket is laid out once
+    ASSERT_TRUE(seen_buckets.insert(bucket).second);
+    for (size_t i = offsets[k]; i < offsets[k + 1]; ++i) {
+      ASSERT_EQ(get_bucket(records[i]) % bucket_num, bucket);
+      ASSERT_TRUE(seen_records.insert(*records[i]).second);
+    }
+  }
+  ASSERT_EQ(seen_records.size(), static_cast<size_t>(record_num));
+}
+
+TEST(BucketShuffle, Partition) {
+  TestPartition(0, 1);
+  TestPartition(1, 1);
+  TestPartition(10, 100);
+  TestPartition(1000, 1);
+  TestPartition(100000, 97);
+}
+
+TEST(BucketShuffle, ShuffleBucketOrder) {
+  // the records are sorted by bucket, the buckets should not stay in order
+  std::vector<int> records(1000);
+  for (int i = 0; i < 1000; ++i) {
+    records[i] = i;
+  }
+  auto get_bucket = [](int rec) -> uint64_t { return rec / 10; };
+  std::default_random_engine engine(0);
+  std::vector<size_t> offsets =
+      PartitionByBucket(&records, 100, get_bucket, &engine);
+  int in_order = 0;
+  for (size_t k = 0; k < 100; ++k) {
+    ASSERT_EQ(offsets[k + 1] - offsets[k], 10UL);
+    in_order += records[offsets[k]] / 10 == static_cast<int>(k);
+  }
+  EXPECT_LT(in_order, 10);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -20,6 +20,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_feed.h"
 
 #include "paddle/fluid/framework/fleet/ps_gpu_wrapper.h"
+#include "paddle/fluid/framework/slot_text_parser.h"
 #ifdef _LINUX
 #include <stdio_ext.h>
 #include <sys/mman.h>
@@ -31,6 +32,8 @@ limitations under the License. */
 
 USE_INT_STAT(STAT_total_feasign_num_in_mem);
 PHI_DECLARE_bool(enable_ins_parser_file);
+PHI_DECLARE_bool(enable_slotrecord_columnar);
+PHI_DECLARE_bool(slotrecord_columnar_zero_copy);
 namespace paddle {
 namespace framework {
 
@@ -1133,41 +1136,33 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
   } else {
     const char* str = reader.get();
     std::string line = std::string(str);
+    const char* end = str + line.size();
     // VLOG(3) << line;
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     if (parse_ins_id_) {
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
       CHECK(num == 1);  // NOLINT
       pos = endptr - str + 1;
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
+      size_t len = FindSpace(str + pos, end, 1) - (str + pos);
       instance->ins_id_ = std::string(str + pos, len);
       pos += len + 1;
       VLOG(3) << "ins_id " << instance->ins_id_;
     }
     if (parse_content_) {
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
       CHECK(num == 1);  // NOLINT
       pos = endptr - str + 1;
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
+      size_t len = FindSpace(str + pos, end, 1) - (str + pos);
       instance->content_ = std::string(str + pos, len);
       pos += len + 1;
       VLOG(3) << "content " << instance->content_;
     }
     if (parse_logkey_) {
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
       CHECK(num == 1);  // NOLINT
       pos = endptr - str + 1;
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
+      size_t len = FindSpace(str + pos, end, 1) - (str + pos);
       // parse_logkey
       std::string log_key = std::string(str + pos, len);
       uint64_t search_id;
@@ -1183,7 +1178,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
     }
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
       PADDLE_ENFORCE_NE(
           num,
           0,
@@ -1216,7 +1211,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = ParseFloat(endptr, end, &endptr);
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
             if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
@@ -1228,7 +1223,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = ParseUint64(endptr, end, &endptr);
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
             if (feasign == 0 && !use_slots_is_dense_[i]) {
@@ -1241,12 +1236,8 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
         }
         pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
-        }
+        // skip the number and the values
+        pos = FindSpace(str + pos + 1, end, num + 1) - str;
       }
     }
     instance->float_feasigns_.shrink_to_fit();
@@ -1266,11 +1257,12 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
     VLOG(3) << line;
     // parse line
     const char* str = line.c_str();
+    const char* end = str + line.size();
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
+      int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
       PADDLE_ENFORCE_NE(
           num,
           0,
@@ -1291,7 +1283,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = ParseFloat(endptr, end, &endptr);
             if (fabs(feasign) < 1e-6) {
               continue;
             }
@@ -1301,7 +1293,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = ParseUint64(endptr, end, &endptr);
             if (feasign == 0) {
               continue;
             }
@@ -1312,9 +1304,8 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
         }
         pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
-        }
+        // skip the number and the values
+        pos = FindSpace(str + pos + 1, end, num + 1) - str;
       }
     }
     instance->float_feasigns_.shrink_to_fit();
@@ -2336,6 +2327,30 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
   std::string filename;
   BufferedLineFileReader line_reader;
   line_reader.set_sample_rate(sample_rate_);
+#ifdef PADDLE_WITH_HETERPS
+  // the heterps packs and pulls read the values of every instance in row
+  // layout
+  if (FLAGS_enable_slotrecord_columnar) {
+    LOG_FIRST_N(WARNING, 1)
+        << "FLAGS_enable_slotrecord_columnar is not supported with heterps.";
+  }
+  const bool columnar = false;
+#else
+  const bool columnar = FLAGS_enable_slotrecord_columnar;
+#endif
+  // start a new block when the current one is full
+  auto prepare_columnar_block = [this]() {
+    if (columnar_block_ != nullptr &&
+        columnar_block_->ins_num() < OBJPOOL_BLOCK_SIZE) {
+      return;
+    }
+    auto block = std::make_shared<SlotRecordBlock>(uint64_use_slot_size_,
+                                                   float_use_slot_size_);
+    if (columnar_block_ != nullptr) {
+      block->Reserve(*columnar_block_);
+    }
+    columnar_block_ = block;
+  };
 
   while (this->PickOneFile(&filename)) {
     VLOG(3) << "PickOneFile, filename=" << filename
@@ -2344,10 +2359,48 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
     std::vector<SlotRecord> record_vec;
     platform::Timer timeline;
     timeline.Start();
+    std::string cache_signature;
+    if (!binary_cache_dir_.empty()) {
+      cache_signature = BinaryCacheSignature(filename);
+      if (LoadFromBinaryCache(filename, cache_signature, columnar)) {
+        timeline.Pause();
+        VLOG(3) << "LoadIntoMemory() read binary cache, file=" << filename
+                << ", cost time=" << timeline.ElapsedSec()
+                << " seconds, thread_id=" << thread_id_;
+        continue;
+      }
+    }
+    std::unique_ptr<SlotRecordFileWriter> cache_writer;
+    // the cache is best effort like reading it, e.g. a full disk only drops
+    // the cache of the file, the reset writer removes its temporary file
+    auto drop_cache_writer = [&cache_writer,
+                              &filename](const std::exception& e) {
+      LOG(WARNING) << "Fail to write the binary cache of " << filename
+                   << ", the file is not cached: " << e.what();
+      cache_writer.reset();
+    };
+    if (!binary_cache_dir_.empty()) {
+      try {
+        cache_writer = std::make_unique<SlotRecordFileWriter>(
+            BinaryCachePath(filename),
+            cache_signature,
+            uint64_use_slot_size_,
+            float_use_slot_size_,
+            parse_ins_id_ || parse_logkey_,
+            parse_logkey_,
+            binary_cache_compress_);
+      } catch (const std::exception& e) {
+        drop_cache_writer(e);
+      }
+    }
     SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
     int offset = 0;
 
     do {
+      if (line_reader.is_error()) {
+        // the instances read before the error are not cached again
+        cache_writer.reset();
+      }
       int err_no = 0;
       this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
       CHECK(this->fp_ != nullptr);
@@ -2355,7 +2408,17 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
 
       lines = line_reader.read_file(
           this->fp_.get(),
-          [this, &record_vec, &offset, &filename](const std::string& line) {
+          [this,
+           &record_vec,
+           &offset,
+           &filename,
+           columnar,
+           &prepare_columnar_block,
+           &cache_writer,
+           &drop_cache_writer](const std::string& line) {
+            if (columnar) {
+              prepare_columnar_block();
+            }
             if (ParseOneInstance(line, &record_vec[offset])) {
               ++offset;
             } else {
@@ -2364,6 +2427,14 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
               return false;
             }
             if (offset >= OBJPOOL_BLOCK_SIZE) {
+              if (cache_writer != nullptr) {
+                try {
+                  WriteToBinaryCache(
+                      cache_writer.get(), &record_vec[0], offset);
+                } catch (const std::exception& e) {
+                  drop_cache_writer(e);
+                }
+              }
               input_channel_->Write(std::move(record_vec));
               record_vec.clear();
               SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
@@ -2374,6 +2445,13 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
           lines);
     } while (line_reader.is_error());
     if (offset > 0) {
+      if (cache_writer != nullptr) {
+        try {
+          WriteToBinaryCache(cache_writer.get(), &record_vec[0], offset);
+        } catch (const std::exception& e) {
+          drop_cache_writer(e);
+        }
+      }
       input_channel_->WriteMove(offset, &record_vec[0]);
       if (offset < OBJPOOL_BLOCK_SIZE) {
         SlotRecordPool().put(&record_vec[offset],
@@ -2384,6 +2462,13 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
     }
     record_vec.clear();
     record_vec.shrink_to_fit();
+    if (cache_writer != nullptr) {
+      try {
+        cache_writer->Close();
+      } catch (const std::exception& e) {
+        drop_cache_writer(e);
+      }
+    }
     timeline.Pause();
     VLOG(3) << "LoadIntoMemory() read all lines, file=" << filename
             << ", lines=" << lines
@@ -2391,11 +2476,156 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
             << ", cost time=" << timeline.ElapsedSec()
             << " seconds, thread_id=" << thread_id_;
   }
+  // the records keep their blocks alive
+  columnar_block_ = nullptr;
   VLOG(3) << "LoadIntoMemory() end, thread_id=" << thread_id_
           << ", total size: " << line_reader.file_size();
 #endif
 }
 
+std::string SlotRecordInMemoryDataFeed::BinaryCachePath(
+    const std::string& filename) {
+  // the signature tells the files of the same name apart
+  std::string name = filename;
+  for (auto& c : name) {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-' &&
+        c != '_') {
+      c = '_';
+    }
+  }
+  constexpr size_t kMaxNameLength = 200;
+  if (name.size() > kMaxNameLength) {
+    name = name.substr(name.size() - kMaxNameLength);
+  }
+  return binary_cache_dir_ + "/" + name + ".slotrecord";
+}
+
+// The size and the modification time of the data file, the cached
+// instances of a rewritten file are stale. A file whose status can not be
+// read is assumed not to change under the same name.
+static std::string BinaryCacheFileStat(const std::string& filename) {
+#ifdef _LINUX
+  if (fs_select_internal(filename) != 0) {
+    return paddle::string::trim_spaces(shell_get_command_output(
+        paddle::string::format_string("%s -stat \"%%b %%Y\" %s 2>/dev/null",
+                                      hdfs_command().c_str(),
+                                      filename.c_str())));
+  }
+  struct stat st;
+  if (stat(filename.c_str(), &st) == 0) {
+    return std::to_string(st.st_size) + " " + std::to_string(st.st_mtime);
+  }
+#endif
+  return "";
+}
+
+std::string SlotRecordInMemoryDataFeed::BinaryCacheSignature(
+    const std::string& filename) {
+  std::ostringstream signature;
+  signature << filename << "\n"
+            << BinaryCacheFileStat(filename) << "\n"
+            << pipe_command_ << "\n"
+            << parse_ins_id_ << parse_logkey_ << "\n";
+  for (auto& info : all_slots_info_) {
+    if (info.used_idx != -1) {
+      signature << info.slot << ":" << info.type << ":"
+                << info.slot_value_idx << " ";
+    }
+  }
+  return signature.str();
+}
+
+bool SlotRecordInMemoryDataFeed::LoadFromBinaryCache(
+    const std::string& filename, const std::string& signature, bool columnar) {
+  const std::string path = BinaryCachePath(filename);
+  SlotRecordFileReader reader;
+  if (!reader.Open(path, signature)) {
+    return false;
+  }
+  // the blocks are all decoded before any record is written to the channel,
+  // a corrupted cache falls back to the pipe command without duplicates
+  std::vector<std::vector<SlotRecord>> records;
+  try {
+    SlotRecordFileBlock block(uint64_use_slot_size_, float_use_slot_size_);
+    while (reader.Next(&block)) {
+      int num = static_cast<int>(block.ins_num());
+      if (num == 0) {
+        continue;
+      }
+      const SlotRecordBlock& slots = *block.slots;
+      records.emplace_back();
+      std::vector<SlotRecord>& record_vec = records.back();
+      SlotRecordPool().get(&record_vec, num);
+      for (int i = 0; i < num; ++i) {
+        SlotRecord rec = record_vec[i];
+        if (reader.has_ins_id()) {
+          rec->ins_id_ = std::move(block.ins_ids[i]);
+        }
+        if (reader.has_log_key()) {
+          rec->search_id = block.search_ids[i];
+          rec->cmatch = block.cmatches[i];
+          rec->rank = block.ranks[i];
+        }
+        if (columnar) {
+          rec->block_ = block.slots;
+          rec->block_index_ = i;
+          continue;
+        }
+        size_t value_num = 0;
+        for (int j = 0; j < uint64_use_slot_size_; ++j) {
+          const uint64_t* values = slots.uint64_slot(j).Get(i, &value_num);
+          rec->slot_uint64_feasigns_.add_values(values, value_num);
+        }
+        for (int j = 0; j < float_use_slot_size_; ++j) {
+          const float* values = slots.float_slot(j).Get(i, &value_num);
+          rec->slot_float_feasigns_.add_values(values, value_num);
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "binary cache:[" << path << "] of file:[" << filename
+                 << "] is broken, parse the file again, " << e.what();
+    for (auto& record_vec : records) {
+      SlotRecordPool().put(&record_vec);
+    }
+    reader.Close();
+    fs_remove(path);
+    return false;
+  }
+  for (auto& record_vec : records) {
+    input_channel_->Write(std::move(record_vec));
+  }
+  return true;
+}
+
+void SlotRecordInMemoryDataFeed::WriteToBinaryCache(
+    SlotRecordFileWriter* writer, const SlotRecord* records, int num) {
+  SlotRecordFileBlock block(uint64_use_slot_size_, float_use_slot_size_);
+  SlotRecordBlock* slots = block.slots.get();
+  for (int i = 0; i < num; ++i) {
+    SlotRecord rec = records[i];
+    if (parse_ins_id_ || parse_logkey_) {
+      block.ins_ids.push_back(rec->ins_id_);
+    }
+    if (parse_logkey_) {
+      block.search_ids.push_back(rec->search_id);
+      block.cmatches.push_back(rec->cmatch);
+      block.ranks.push_back(rec->rank);
+    }
+    size_t value_num = 0;
+    for (int j = 0; j < uint64_use_slot_size_; ++j) {
+      const uint64_t* values = rec->get_uint64_values(j, &value_num);
+      slots->mutable_uint64_slot(j)->Append(values, value_num);
+    }
+    for (int j = 0; j < float_use_slot_size_; ++j) {
+      const float* values = rec->get_float_values(j, &value_num);
+      slots->mutable_float_slot(j)->Append(values, value_num);
+    }
+  }
+  slots->set_ins_num(num);
+  writer->Write(block);
+}
+
 static void parser_log_key(const std::string& log_key,
                            uint64_t* search_id,
                            uint32_t* cmatch,
@@ -2414,6 +2644,7 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   SlotRecord& rec = (*ins);
   // parse line
   const char* str = line.c_str();
+  const char* end = str + line.size();
   char* endptr = const_cast<char*>(str);
   int pos = 0;
 
@@ -2423,24 +2654,18 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   slot_uint64_feasigns.resize(uint64_use_slot_size_);
 
   if (parse_ins_id_) {
-    int num = strtol(&str[pos], &endptr, 10);
+    int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
     CHECK(num == 1);  // NOLINT
     pos = endptr - str + 1;
-    size_t len = 0;
-    while (str[pos + len] != ' ') {
-      ++len;
-    }
+    size_t len = FindSpace(str + pos, end, 1) - (str + pos);
     rec->ins_id_ = std::string(str + pos, len);
     pos += len + 1;
   }
   if (parse_logkey_) {
-    int num = strtol(&str[pos], &endptr, 10);
+    int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
     CHECK(num == 1);  // NOLINT
     pos = endptr - str + 1;
-    size_t len = 0;
-    while (str[pos + len] != ' ') {
-      ++len;
-    }
+    size_t len = FindSpace(str + pos, end, 1) - (str + pos);
     // parse_logkey
     std::string log_key = std::string(str + pos, len);
     uint64_t search_id;
@@ -2459,7 +2684,7 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   int uint64_total_slot_num = 0;
 
   for (auto& info : all_slots_info_) {
-    int num = strtol(&str[pos], &endptr, 10);
+    int num = static_cast<int>(ParseUint64(&str[pos], end, &endptr));
     PADDLE_ENFORCE(num,
                    "The number of ids can not be zero, you need padding "
                    "it in data generator; or if there is something wrong with "
@@ -2471,7 +2696,7 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
         auto& slot_fea = slot_float_feasigns[info.slot_value_idx];
         slot_fea.clear();
         for (int j = 0; j < num; ++j) {
-          float feasign = strtof(endptr, &endptr);
+          float feasign = ParseFloat(endptr, end, &endptr);
           if (fabs(feasign) < 1e-6 && !used_slots_info_[info.used_idx].dense) {
             continue;
           }
@@ -2482,21 +2707,25 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
         auto& slot_fea = slot_uint64_feasigns[info.slot_value_idx];
         slot_fea.clear();
         for (int j = 0; j < num; ++j) {
-          uint64_t feasign =
-              static_cast<uint64_t>(strtoull(endptr, &endptr, 10));
+          uint64_t feasign = ParseUint64(endptr, end, &endptr);
           slot_fea.push_back(feasign);
           ++uint64_total_slot_num;
         }
       }
       pos = endptr - str;
     } else {
-      for (int j = 0; j <= num; ++j) {
-        // pos = line.find_first_of(' ', pos + 1);
-        while (line[pos + 1] != ' ') {
-          pos++;
-        }
-      }
+      // skip the number and the values
+      pos = FindSpace(str + pos + 1, end, num + 1) - str;
+    }
+  }
+  if (columnar_block_ != nullptr) {
+    if (uint64_total_slot_num == 0) {
+      return false;
     }
+    rec->block_ = columnar_block_;
+    rec->block_index_ =
+        columnar_block_->AddInstance(slot_uint64_feasigns, slot_float_feasigns);
+    return true;
   }
   rec->slot_float_feasigns_.add_slot_feasigns(slot_float_feasigns,
                                               float_total_slot_num);
@@ -2526,6 +2755,22 @@ void SlotRecordInMemoryDataFeed::AssignFeedVar(const Scope& scope) {
 #endif
 }
 
+namespace {
+// The values of a column range fed without copying, which keep the block
+// alive as long as the feed tensor holds them.
+class SlotColumnAllocation : public phi::Allocation {
+ public:
+  SlotColumnAllocation(const std::shared_ptr<SlotRecordBlock>& block,
+                       const void* ptr,
+                       size_t size)
+      : phi::Allocation(const_cast<void*>(ptr), size, platform::CPUPlace()),
+        block_(block) {}
+
+ private:
+  std::shared_ptr<SlotRecordBlock> block_;
+};
+}  // namespace
+
 void SlotRecordInMemoryDataFeed::PutToFeedVec(const SlotRecord* ins_vec,
                                               int num) {
   // set ins id
@@ -2539,29 +2784,45 @@ void SlotRecordInMemoryDataFeed::PutToFeedVec(const SlotRecord* ins_vec,
 #if defined(PADDLE_WITH_CUDA) && defined(PADDLE_WITH_HETERPS)
   // do nothing
 #else
+  // the instances consecutive in a columnar block are fed as column ranges
+  std::shared_ptr<SlotRecordBlock> block =
+      num > 0 ? ins_vec[0]->block_ : nullptr;
+  size_t block_begin = num > 0 ? ins_vec[0]->block_index_ : 0;
+  for (int i = 1; i < num && block != nullptr; ++i) {
+    if (ins_vec[i]->block_ != block ||
+        ins_vec[i]->block_index_ != block_begin + i) {
+      block = nullptr;
+    }
+  }
+
   for (int j = 0; j < use_slot_size_; ++j) {
     auto& feed = feed_vec_[j];
     if (feed == nullptr) {
       continue;
     }
+    // never write the next batch into the values of a block
+    if (dynamic_cast<SlotColumnAllocation*>(feed->Holder().get()) != nullptr) {
+      feed->clear();
+    }
 
     auto& slot_offset = offset_[j];
-    slot_offset.clear();
-    slot_offset.reserve(num + 1);
-    slot_offset.push_back(0);
-
     int total_instance = 0;
     auto& info = used_slots_info_[j];
-    // fill slot value with default value 0
-    if (info.type[0] == 'f') {  // float
+    if (block != nullptr &&
+        PutColumnRangeToFeedVec(j, block, block_begin, num, &total_instance)) {
+      // the values are fed from the columns without gathering
+    } else if (info.type[0] == 'f') {  // float
+      slot_offset.clear();
+      slot_offset.reserve(num + 1);
+      slot_offset.push_back(0);
       auto& batch_fea = batch_float_feasigns_[j];
       batch_fea.clear();
 
       for (int i = 0; i < num; ++i) {
         auto r = ins_vec[i];
         size_t fea_num = 0;
-        float* slot_values =
-            r->slot_float_feasigns_.get_values(info.slot_value_idx, &fea_num);
+        const float* slot_values =
+            r->get_float_values(info.slot_value_idx, &fea_num);
         batch_fea.resize(total_instance + fea_num);
         memcpy(
             &batch_fea[total_instance], slot_values, sizeof(float) * fea_num);
@@ -2575,14 +2836,18 @@ void SlotRecordInMemoryDataFeed::PutToFeedVec(const SlotRecord* ins_vec,
       CopyToFeedTensor(tensor_ptr, feasign, total_instance * sizeof(float));
 
     } else if (info.type[0] == 'u') {  // uint64
+      slot_offset.clear();
+      slot_offset.reserve(num + 1);
+      slot_offset.push_back(0);
+      // fill slot value with default value 0
       auto& batch_fea = batch_uint64_feasigns_[j];
       batch_fea.clear();
 
       for (int i = 0; i < num; ++i) {
         auto r = ins_vec[i];
         size_t fea_num = 0;
-        uint64_t* slot_values =
-            r->slot_uint64_feasigns_.get_values(info.slot_value_idx, &fea_num);
+        const uint64_t* slot_values =
+            r->get_uint64_values(info.slot_value_idx, &fea_num);
         if (fea_num > 0) {
           batch_fea.resize(total_instance + fea_num);
           memcpy(&batch_fea[total_instance],
@@ -2619,6 +2884,57 @@ void SlotRecordInMemoryDataFeed::PutToFeedVec(const SlotRecord* ins_vec,
 #endif
 }
 
+#if !defined(PADDLE_WITH_CUDA) || !defined(PADDLE_WITH_HETERPS)
+bool SlotRecordInMemoryDataFeed::PutColumnRangeToFeedVec(
+    int slot,
+    const std::shared_ptr<SlotRecordBlock>& block,
+    size_t begin,
+    int num,
+    int* total_instance) {
+  auto& feed = feed_vec_[slot];
+  auto& info = used_slots_info_[slot];
+  size_t end = begin + num;
+  const void* values = nullptr;
+  size_t value_num = 0;
+  size_t value_size = 0;
+  phi::DataType dtype;
+  if (info.type[0] == 'f') {  // float
+    auto& column = block->float_slot(info.slot_value_idx);
+    values = column.Range(begin, end, &value_num);
+    column.RangeLoD(begin, end, &offset_[slot]);
+    value_size = sizeof(float);
+    dtype = phi::DataType::FLOAT32;
+  } else if (info.type[0] == 'u') {  // uint64
+    auto& column = block->uint64_slot(info.slot_value_idx);
+    // the empty instances are filled with 0, which is not in the column
+    if (!column.NoEmpty(begin, end)) {
+      return false;
+    }
+    values = column.Range(begin, end, &value_num);
+    column.RangeLoD(begin, end, &offset_[slot]);
+    // no uint64_t type in paddlepaddle
+    value_size = sizeof(int64_t);
+    dtype = phi::DataType::INT64;
+  } else {
+    return false;
+  }
+
+  *total_instance = static_cast<int>(value_num);
+  feed->Resize({*total_instance, 1});
+  if (FLAGS_slotrecord_columnar_zero_copy && value_num > 0 &&
+      platform::is_cpu_place(this->place_)) {
+    feed->ResetHolderWithType(
+        std::make_shared<SlotColumnAllocation>(
+            block, values, value_num * value_size),
+        dtype);
+  } else {
+    void* tensor_ptr = feed->mutable_data(this->place_, dtype);
+    CopyToFeedTensor(tensor_ptr, values, value_num * value_size);
+  }
+  return true;
+}
+#endif
+
 void SlotRecordInMemoryDataFeed::ExpandSlotRecord(SlotRecord* rec) {
   SlotRecord& ins = (*rec);
   if (ins->slot_float_feasigns_.slot_offsets.empty()) {
@@ -2793,6 +3109,43 @@ int SlotRecordInMemoryDataFeed::Next() {
 #endif
 }
 
+bool SlotRecordInMemoryDataFeed::GetNextBatchFeasigns(
+    const std::vector<std::string>& slots, std::vector<uint64_t>* feasigns) {
+#if defined(PADDLE_WITH_CUDA) && defined(PADDLE_WITH_HETERPS)
+  return false;
+#else
+  if (gpu_graph_mode_ || offset_index_ >= batch_offsets_.size()) {
+    return false;
+  }
+  std::vector<int> slot_value_idx;
+  for (auto& slot : slots) {
+    for (int j = 0; j < use_slot_size_; ++j) {
+      auto& info = used_slots_info_[j];
+      if (info.slot == slot && info.type[0] == 'u') {
+        slot_value_idx.push_back(info.slot_value_idx);
+        break;
+      }
+    }
+  }
+  feasigns->clear();
+  auto& batch = batch_offsets_[offset_index_];
+  for (int i = 0; i < batch.second; ++i) {
+    auto& rec = records_[batch.first + i];
+    for (int idx : slot_value_idx) {
+      size_t num = 0;
+      const uint64_t* values = rec->get_uint64_values(idx, &num);
+      for (size_t k = 0; k < num; ++k) {
+        // 0 is the padding feasign, which is never pulled
+        if (values[k] != 0) {
+          feasigns->push_back(values[k]);
+        }
+      }
+    }
+  }
+  return true;
+#endif
+}
+
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
 void SlotRecordInMemoryDataFeed::DoWalkandSage() {
   gpu_graph_data_generator_.DoWalkandSage();
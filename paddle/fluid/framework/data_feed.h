@@ -38,6 +38,8 @@ limitations under the License. */
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/framework/slot_record_block.h"
+#include "paddle/fluid/framework/slot_record_file.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/platform/timer.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -185,12 +187,29 @@ struct SlotRecordObject {
   std::string ins_id_;
   SlotValues<uint64_t> slot_uint64_feasigns_;
   SlotValues<float> slot_float_feasigns_;
+  // the block holding the values in columnar layout, the values are in
+  // slot_uint64_feasigns_ and slot_float_feasigns_ if it is nullptr
+  std::shared_ptr<SlotRecordBlock> block_;
+  uint32_t block_index_ = 0;
 
   ~SlotRecordObject() { clear(true); }
   void reset(void) { clear(FLAGS_enable_slotrecord_reset_shrink); }
   void clear(bool shrink) {
     slot_uint64_feasigns_.clear(shrink);
     slot_float_feasigns_.clear(shrink);
+    block_.reset();
+  }
+  const uint64_t* get_uint64_values(int slot_value_idx, size_t* num) {
+    if (block_ != nullptr) {
+      return block_->uint64_slot(slot_value_idx).Get(block_index_, num);
+    }
+    return slot_uint64_feasigns_.get_values(slot_value_idx, num);
+  }
+  const float* get_float_values(int slot_value_idx, size_t* num) {
+    if (block_ != nullptr) {
+      return block_->float_slot(slot_value_idx).Get(block_index_, num);
+    }
+    return slot_float_feasigns_.get_values(slot_value_idx, num);
   }
 };
 using SlotRecord = SlotRecordObject*;
@@ -1181,6 +1200,10 @@ class DataFeed {
   virtual void SetParseUid(bool parse_uid UNUSED) {}
   virtual void SetParseContent(bool parse_content UNUSED) {}
   virtual void SetParseLogKey(bool parse_logkey UNUSED) {}
+  // set the local directory caching the parsed files in binary, empty to
+  // disable
+  virtual void SetBinaryCacheDir(const std::string& cache_dir UNUSED,
+                                 bool compress UNUSED) {}
   virtual void SetEnablePvMerge(bool enable_pv_merge UNUSED) {}
   virtual void SetCurrentPhase(int current_phase UNUSED) {}
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
@@ -1210,6 +1233,14 @@ class DataFeed {
     batch_size_ = batch_size;
   }
   virtual int GetCurBatchSize() { return batch_size_; }
+  // Get the non-zero feasigns of the given uint64 slots in the next batch
+  // without consuming it, returns false if there is no next batch or the data
+  // feed can not look ahead.
+  virtual bool GetNextBatchFeasigns(
+      const std::vector<std::string>& slots UNUSED,
+      std::vector<uint64_t>* feasigns UNUSED) {
+    return false;
+  }
   virtual int GetGraphPathNum() {
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
     return gpu_graph_data_generator_.GetPathNum();
@@ -1826,6 +1857,12 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   void Init(const DataFeedDesc& data_feed_desc) override;
   void LoadIntoMemory() override;
   void ExpandSlotRecord(SlotRecord* ins);
+  void SetBinaryCacheDir(const std::string& cache_dir, bool compress) override {
+    binary_cache_dir_ = cache_dir;
+    binary_cache_compress_ = compress;
+  }
+  bool GetNextBatchFeasigns(const std::vector<std::string>& slots,
+                            std::vector<uint64_t>* feasigns) override;
 
  protected:
   bool Start() override;
@@ -1846,7 +1883,26 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
     input_channel_ = static_cast<ChannelObject<SlotRecord>*>(channel);
   }
   bool ParseOneInstance(const std::string& line, SlotRecord* rec);
+  // The slot record file of filename in the binary cache, the signature of
+  // which is what the instances are parsed with.
+  std::string BinaryCachePath(const std::string& filename);
+  std::string BinaryCacheSignature(const std::string& filename);
+  // Load the instances of filename from the binary cache, returns false if
+  // they are not cached with the signature or the cache is broken.
+  bool LoadFromBinaryCache(const std::string& filename,
+                           const std::string& signature,
+                           bool columnar);
+  void WriteToBinaryCache(SlotRecordFileWriter* writer,
+                          const SlotRecord* records,
+                          int num);
   void PutToFeedVec(const SlotRecord* ins_vec, int num) override;
+  // Feed the slot of a batch of consecutive instances in a columnar block,
+  // returns false if the slot can not be fed as a range of the block.
+  bool PutColumnRangeToFeedVec(int slot,
+                               const std::shared_ptr<SlotRecordBlock>& block,
+                               size_t begin,
+                               int num,
+                               int* total_instance);
   void AssignFeedVar(const Scope& scope) override;
   std::vector<std::string> GetInputVarNames() override {
     std::vector<std::string> var_names;
@@ -1913,6 +1969,11 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   std::vector<UsedSlotInfo> used_slots_info_;
   size_t float_total_dims_size_ = 0;
   std::vector<int> float_total_dims_without_inductives_;
+  // the block ParseOneInstance appends to, nullptr unless the columnar
+  // layout is enabled
+  std::shared_ptr<SlotRecordBlock> columnar_block_;
+  std::string binary_cache_dir_;
+  bool binary_cache_compress_ = false;
 
 #if defined(PADDLE_WITH_CUDA) && defined(PADDLE_WITH_HETERPS)
   int pack_thread_num_{5};
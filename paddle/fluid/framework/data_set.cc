@@ -18,6 +18,7 @@
 #if (defined PADDLE_WITH_DISTRIBUTE) && (defined PADDLE_WITH_PSCORE)
 #include "paddle/fluid/distributed/index_dataset/index_sampler.h"
 #endif
+#include "paddle/fluid/framework/bucket_shuffle.h"
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/io/fs.h"
@@ -165,6 +166,22 @@ void DatasetImpl<T>::SetParseLogKey(bool parse_logkey) {
   parse_logkey_ = parse_logkey;
 }
 
+template <typename T>
+void DatasetImpl<T>::SetBinaryCacheDir(const std::string& cache_dir,
+                                       bool compress) {
+  if (!cache_dir.empty()) {
+    localfs_mkdir(cache_dir);
+  }
+  binary_cache_dir_ = cache_dir;
+  binary_cache_compress_ = compress;
+  for (auto& reader : readers_) {
+    reader->SetBinaryCacheDir(binary_cache_dir_, binary_cache_compress_);
+  }
+  for (auto& reader : preload_readers_) {
+    reader->SetBinaryCacheDir(binary_cache_dir_, binary_cache_compress_);
+  }
+}
+
 template <typename T>
 void DatasetImpl<T>::SetMergeByInsId(int merge_size) {
   merge_by_insid_ = true;
@@ -657,6 +674,81 @@ void DatasetImpl<T>::LocalShuffle() {
           << timeline.ElapsedSec() << " seconds";
 }
 
+// the key to shuffle a record by, nullptr if it is shuffled randomly
+static const std::string* GetShuffleKey(const Record& rec,
+                                        bool by_insid,
+                                        bool by_uid) {
+  if (by_insid) {
+    return &rec.ins_id_;
+  } else if (by_uid) {
+    return &rec.uid_;
+  }
+  return nullptr;
+}
+
+static const std::string* GetShuffleKey(const SlotRecord& rec,
+                                        bool by_insid,
+                                        bool by_uid UNUSED) {
+  return by_insid ? &rec->ins_id_ : nullptr;
+}
+
+template <typename T>
+void DatasetImpl<T>::BucketShuffle(
+    int thread_num, std::vector<paddle::framework::Channel<T>>* channels) {
+  input_channel_->Close();
+  std::vector<T> data;
+  input_channel_->ReadAll(data);
+  // a bucket is about a send batch, the records of the same key are in the
+  // same bucket, like they are sent to the same trainer
+  size_t bucket_num = std::max<size_t>(
+      data.size() / std::max<int64_t>(fleet_send_batch_size_, 1), 1);
+  auto get_bucket = [this](const T& rec) -> uint64_t {
+    const std::string* key =
+        GetShuffleKey(rec, this->merge_by_insid_, this->shuffle_by_uid_);
+    if (key == nullptr) {
+      return framework::FleetWrapper::GetInstance()->LocalRandomEngine()();
+    }
+    return XXH64(key->data(), key->length(), 0);
+  };
+  std::vector<size_t> offsets = PartitionByBucket(
+      &data,
+      bucket_num,
+      get_bucket,
+      &framework::FleetWrapper::GetInstance()->LocalRandomEngine());
+  VLOG(3) << "DatasetImpl<T>::BucketShuffle() partition " << data.size()
+          << " records into " << bucket_num << " buckets";
+
+  for (auto& channel : *channels) {
+    channel->Open();
+  }
+  // the buckets are taken in the shuffled order, and every record is moved to
+  // the channel, so the records are not copied
+  std::atomic<size_t> next_bucket(0);
+  auto stream_func = [&data, &offsets, &next_bucket, bucket_num, channels]() {
+    auto& engine = framework::FleetWrapper::GetInstance()->LocalRandomEngine();
+    for (size_t k = next_bucket++; k < bucket_num; k = next_bucket++) {
+      std::shuffle(
+          data.begin() + offsets[k], data.begin() + offsets[k + 1], engine);
+      auto& channel = (*channels)[k % channels->size()];
+      channel->WriteMove(offsets[k + 1] - offsets[k], data.data() + offsets[k]);
+    }
+  };
+  if (thread_num <= 0) {
+    thread_num = thread_num_;
+  }
+  thread_num = static_cast<int>(
+      std::min<size_t>(std::max(thread_num, 1), bucket_num));
+  std::vector<std::thread> stream_threads;
+  for (int i = 0; i < thread_num; ++i) {
+    stream_threads.emplace_back(stream_func);
+  }
+  for (std::thread& t : stream_threads) {
+    t.join();
+  }
+  data.clear();
+  data.shrink_to_fit();
+}
+
 template <typename T>
 void DatasetImpl<T>::DumpWalkPath(std::string dump_path, size_t dump_rate) {
   VLOG(3) << "DatasetImpl<T>::DumpWalkPath() begin";
@@ -770,6 +862,17 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
     return;
   }
 
+  // all the records stay on this node, so they are shuffled in place instead
+  // of being sent to itself through the client to client messages
+  if (trainer_num_ == 1) {
+    BucketShuffle(thread_num, &multi_output_channel_);
+    input_channel_->Clear();
+    timeline.Pause();
+    VLOG(3) << "MultiSlotDataset::GlobalShuffle() end, cost time="
+            << timeline.ElapsedSec() << " seconds";
+    return;
+  }
+
   // local shuffle
   input_channel_->Close();
   std::vector<Record> data;
@@ -1030,6 +1133,7 @@ void DatasetImpl<T>::CreateReaders() {
     readers_[i]->SetParseUid(parse_uid_);
     readers_[i]->SetParseContent(parse_content_);
     readers_[i]->SetParseLogKey(parse_logkey_);
+    readers_[i]->SetBinaryCacheDir(binary_cache_dir_, binary_cache_compress_);
     readers_[i]->SetEnablePvMerge(enable_pv_merge_);
     // Notice: it is only valid for untest of test_paddlebox_datafeed.
     // In fact, it does not affect the train process when paddle is
@@ -1101,6 +1205,8 @@ void DatasetImpl<T>::CreatePreLoadReaders() {
     preload_readers_[i]->SetParseUid(parse_uid_);
     preload_readers_[i]->SetParseContent(parse_content_);
     preload_readers_[i]->SetParseLogKey(parse_logkey_);
+    preload_readers_[i]->SetBinaryCacheDir(binary_cache_dir_,
+                                           binary_cache_compress_);
     preload_readers_[i]->SetEnablePvMerge(enable_pv_merge_);
     preload_readers_[i]->SetInputChannel(input_channel_.get());
     preload_readers_[i]->SetOutputChannel(nullptr);
@@ -1801,6 +1907,7 @@ void SlotRecordDataset::CreateReaders() {
     readers_[i]->SetParseInsId(parse_ins_id_);
     readers_[i]->SetParseContent(parse_content_);
     readers_[i]->SetParseLogKey(parse_logkey_);
+    readers_[i]->SetBinaryCacheDir(binary_cache_dir_, binary_cache_compress_);
     readers_[i]->SetEnablePvMerge(enable_pv_merge_);
     readers_[i]->SetCurrentPhase(current_phase_);
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
@@ -1844,8 +1951,26 @@ void SlotRecordDataset::ReleaseMemory() {
   STAT_SUB(STAT_total_feasign_num_in_mem, total_fea_num_);
 }
 void SlotRecordDataset::GlobalShuffle(int thread_num) {
-  // TODO(yaoxuefeng)
-  return;
+  VLOG(3) << "SlotRecordDataset::GlobalShuffle() begin";
+  platform::Timer timeline;
+  timeline.Start();
+  if (!input_channel_ || input_channel_->Size() == 0) {
+    VLOG(3) << "SlotRecordDataset::GlobalShuffle() end, no data to shuffle";
+    return;
+  }
+  // TODO(yaoxuefeng) send the records to the other trainers
+  if (trainer_num_ > 1) {
+    LOG(WARNING) << "SlotRecordDataset::GlobalShuffle() only shuffles the "
+                    "records on this node, trainer num "
+                 << trainer_num_;
+  }
+  // the readers of SlotRecordDataset read from input_channel_
+  std::vector<paddle::framework::Channel<SlotRecord>> channels{input_channel_};
+  BucketShuffle(thread_num, &channels);
+  input_channel_->Close();
+  timeline.Pause();
+  VLOG(3) << "SlotRecordDataset::GlobalShuffle() end, cost time="
+          << timeline.ElapsedSec() << " seconds";
 }
 
 void SlotRecordDataset::DynamicAdjustChannelNum(int channel_num,
@@ -114,6 +114,10 @@ class Dataset {
   virtual void CreateChannel() = 0;
   // register message handler between workers
   virtual void RegisterClientToClientMsgHandler() = 0;
+  // set the local directory caching the parsed files in binary, so that they
+  // are loaded again without parsing, empty to disable
+  virtual void SetBinaryCacheDir(const std::string& cache_dir,
+                                 bool compress) = 0;
   // load all data into memory
   virtual void LoadIntoMemory() = 0;
   // load all data into memory in async mode
@@ -234,6 +238,7 @@ class DatasetImpl : public Dataset {
   virtual std::vector<paddle::framework::DataFeed*> GetReaders();
   virtual void CreateChannel();
   virtual void RegisterClientToClientMsgHandler();
+  virtual void SetBinaryCacheDir(const std::string& cache_dir, bool compress);
   virtual void LoadIntoMemory();
   virtual void PreLoadIntoMemory();
   virtual void WaitPreLoadDone();
@@ -290,6 +295,10 @@ class DatasetImpl : public Dataset {
   virtual uint32_t GetPassID() { return pass_id_; }
 
  protected:
+  // Shuffle the records of input_channel_ on this node by buckets, without
+  // copying them, and stream the buckets to channels by thread_num threads.
+  void BucketShuffle(int thread_num,
+                     std::vector<paddle::framework::Channel<T>>* channels);
   virtual int ReceiveFromClient(int msg_type UNUSED,
                                 int client_id UNUSED,
                                 const std::string& msg UNUSED) {
@@ -351,6 +360,8 @@ class DatasetImpl : public Dataset {
   std::vector<std::vector<std::vector<uint64_t>>> gpu_graph_type_keys_;
   std::vector<uint64_t> gpu_graph_total_keys_;
   uint32_t pass_id_ = 0;
+  std::string binary_cache_dir_;
+  bool binary_cache_compress_ = false;
 };
 
 // use std::vector<MultiSlotType> or Record as data type
@@ -390,6 +390,8 @@ class DownpourLiteWorker : public HogwildWorker {
   void CopySparseTable();
   void CopyDenseTable();
   void CopyDenseVars();
+  // ask the pservers to prefetch the sparse keys of the next batch
+  void PrefetchNextBatch();
 
   DownpourWorkerParameter param_;
   // copy table
@@ -431,6 +433,8 @@ class DownpourLiteWorker : public HogwildWorker {
   std::map<int32_t, uint64_t> cond2table_map_;
   std::set<uint64_t> condvalue_set_;
   bool flag_partial_push_;
+  // sparse keys of the next batch to prefetch
+  std::vector<uint64_t> prefetch_keys_;
 
  private:
   // std::vector<std::string> dump_param_;
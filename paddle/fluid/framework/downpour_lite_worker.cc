@@ -17,6 +17,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/fleet/metrics.h"
 #include "paddle/fluid/operators/isfinite_op.h"
 #include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/phi/core/flags.h"
+
+PHI_DECLARE_bool(enable_sparse_prefetch);
 
 namespace phi {
 class DenseTensor;
@@ -225,6 +228,21 @@ void DownpourLiteWorker::CopyDenseVars() {
   }
 }
 
+void DownpourLiteWorker::PrefetchNextBatch() {
+  if (!FLAGS_enable_sparse_prefetch) {
+    return;
+  }
+  for (auto& it : sparse_key_names_) {
+    if (!device_reader_->GetNextBatchFeasigns(it.second, &prefetch_keys_)) {
+      return;
+    }
+    if (!prefetch_keys_.empty()) {
+      // the keys are copied into the requests, the result is not waited
+      fleet_ptr_->PrefetchSparseAsync(it.first, prefetch_keys_);
+    }
+  }
+}
+
 void DownpourLiteWorker::TrainFilesWithProfiler() {
   VLOG(3) << "Begin to train files with profiler";
   platform::SetNumThreads(1);
@@ -267,6 +285,8 @@ void DownpourLiteWorker::TrainFilesWithProfiler() {
     timeline.Pause();
     read_time += timeline.ElapsedSec();
     total_time += timeline.ElapsedSec();
+    // the next batch is prefetched while the ops of this one run
+    PrefetchNextBatch();
 
     timeline.Start();
     if (copy_table_config_.need_copy()) {
@@ -446,6 +466,7 @@ void DownpourLiteWorker::TrainFiles() {
   int batch_cnt = 0;
   int cur_batch;
   while ((cur_batch = device_reader_->Next()) > 0) {
+    PrefetchNextBatch();
     if (copy_table_config_.need_copy()) {
       VLOG(3) << "Begin to copy table";
       if (batch_cnt % copy_table_config_.batch_num() == 0) {
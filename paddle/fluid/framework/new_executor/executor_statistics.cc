@@ -14,16 +14,23 @@
 
 #include "paddle/fluid/framework/new_executor/executor_statistics.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <functional>
+#include <iomanip>
 #include <map>
 #include <ostream>
 #include <queue>
 #include <set>
+#include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "glog/logging.h"
+#include "paddle/fluid/memory/stats.h"
 #include "paddle/fluid/platform/flags.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/utils.h"
@@ -631,5 +638,345 @@ void StaticGraphExecutorPerfStatistics(
   }
 }
 
+namespace {
+
+// The living InstructionStatistics, sorted by id.
+std::mutex& StatisticsRegistryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<InstructionStatistics*>& StatisticsRegistry() {
+  static std::vector<InstructionStatistics*> registry;
+  return registry;
+}
+
+// Entries of a thread local counters map checked for destroyed interpreters
+// when a new one is added.
+constexpr size_t kPruneThreadCountersSize = 16;
+
+template <typename CountersMap>
+void EraseDestroyedCounters(CountersMap* counters_map) {
+  std::unordered_set<uint64_t> living_ids;
+  {
+    std::lock_guard<std::mutex> guard(StatisticsRegistryMutex());
+    for (const InstructionStatistics* statistics : StatisticsRegistry()) {
+      living_ids.insert(statistics->Id());
+    }
+  }
+  for (auto iter = counters_map->begin(); iter != counters_map->end();) {
+    if (living_ids.count(iter->first) == 0) {
+      iter = counters_map->erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+// Bucket 0 holds the values less than 2^kMinBucketShift ns, then every power
+// of two is split into two buckets.
+constexpr int kMinBucketShift = 7;
+
+int BucketIndex(uint64_t ns) {
+  if (ns < (1ULL << kMinBucketShift)) {
+    return 0;
+  }
+  int shift = kMinBucketShift;
+  while (shift < 63 && (ns >> (shift + 1)) != 0) {
+    ++shift;
+  }
+  int half = static_cast<int>((ns >> (shift - 1)) & 1);
+  int index = 1 + 2 * (shift - kMinBucketShift) + half;
+  return std::min(index, InstructionStatistics::kBucketNum - 1);
+}
+
+double BucketLowerBound(int index) {
+  if (index == 0) {
+    return 0;
+  }
+  int shift = kMinBucketShift + (index - 1) / 2;
+  int half = (index - 1) % 2;
+  return std::ldexp(1.0, shift) + half * std::ldexp(1.0, shift - 1);
+}
+
+double BucketUpperBound(int index) {
+  if (index == 0) {
+    return std::ldexp(1.0, kMinBucketShift);
+  }
+  int shift = kMinBucketShift + (index - 1) / 2;
+  return BucketLowerBound(index) + std::ldexp(1.0, shift - 1);
+}
+
+// The quantile in us, interpolated linearly in the bucket.
+double Quantile(const std::array<uint64_t, InstructionStatistics::kBucketNum>&
+                    buckets,
+                uint64_t count,
+                double quantile) {
+  if (count == 0) {
+    return 0;
+  }
+  double rank = quantile * count;
+  uint64_t seen = 0;
+  for (int i = 0; i < InstructionStatistics::kBucketNum; ++i) {
+    if (buckets[i] == 0) {
+      continue;
+    }
+    if (seen + buckets[i] >= rank) {
+      double ratio = (rank - seen) / buckets[i];
+      double lower = BucketLowerBound(i);
+      double upper = BucketUpperBound(i);
+      return (lower + (upper - lower) * ratio) / 1000.0;
+    }
+    seen += buckets[i];
+  }
+  return BucketUpperBound(InstructionStatistics::kBucketNum - 1) / 1000.0;
+}
+
+}  // namespace
+
+InstructionStatistics::InstructionStatistics(
+    const std::vector<std::string>& op_types)
+    : id_([] {
+        static std::atomic<uint64_t> next_id{0};
+        return next_id.fetch_add(1);
+      }()),
+      op_types_(op_types),
+      ready_ns_(new std::atomic<uint64_t>[op_types.size()]) {
+  for (size_t i = 0; i < op_types_.size(); ++i) {
+    ready_ns_[i].store(0, std::memory_order_relaxed);
+  }
+  std::lock_guard<std::mutex> guard(StatisticsRegistryMutex());
+  StatisticsRegistry().push_back(this);
+}
+
+InstructionStatistics::~InstructionStatistics() {
+  std::lock_guard<std::mutex> guard(StatisticsRegistryMutex());
+  auto& registry = StatisticsRegistry();
+  registry.erase(std::find(registry.begin(), registry.end(), this));
+}
+
+uint64_t InstructionStatistics::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t InstructionStatistics::ThreadAllocatedBytes(
+    const platform::Place& place) {
+  if (platform::is_cpu_place(place) || platform::is_cuda_pinned_place(place)) {
+    return HOST_MEMORY_STAT_THREAD_LOCAL_VALUE(Allocated, 0);
+  }
+  return DEVICE_MEMORY_STAT_THREAD_LOCAL_VALUE(Allocated,
+                                               place.GetDeviceId());
+}
+
+InstructionStatistics::Counter* InstructionStatistics::ThreadCounters() {
+  // ids are never reused, so an entry of a destroyed object is never hit
+  thread_local uint64_t cached_id = UINT64_MAX;
+  thread_local Counter* cached_counters = nullptr;
+  thread_local std::unordered_map<uint64_t, Counter*> counters_map;
+  if (cached_id == id_) {
+    return cached_counters;
+  }
+  auto iter = counters_map.find(id_);
+  if (iter == counters_map.end()) {
+    // a thread serving many short-lived interpreters drops the entries of
+    // the destroyed ones here, so the map is bounded by the living ones
+    if (counters_map.size() >= kPruneThreadCountersSize) {
+      EraseDestroyedCounters(&counters_map);
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    thread_counters_.emplace_back(new Counter[op_types_.size()]);
+    iter = counters_map.emplace(id_, thread_counters_.back().get()).first;
+  }
+  cached_id = id_;
+  cached_counters = iter->second;
+  return cached_counters;
+}
+
+void InstructionStatistics::Record(size_t instr_id,
+                                   uint64_t start_ns,
+                                   uint64_t end_ns,
+                                   int64_t allocated_bytes) {
+  Counter& counter = ThreadCounters()[instr_id];
+  uint64_t latency_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+  counter.Add(&counter.count, 1);
+  counter.Add(&counter.latency_ns, latency_ns);
+  counter.Add(&counter.latency_buckets[BucketIndex(latency_ns)], 1);
+  counter.Add(&counter.allocated_bytes, static_cast<uint64_t>(allocated_bytes));
+  // not recorded for the instructions run in a fixed order
+  uint64_t ready_ns =
+      ready_ns_[instr_id].exchange(0, std::memory_order_relaxed);
+  if (ready_ns != 0) {
+    uint64_t queue_wait_ns = start_ns > ready_ns ? start_ns - ready_ns : 0;
+    counter.Add(&counter.queue_wait_ns, queue_wait_ns);
+    counter.Add(&counter.queue_wait_buckets[BucketIndex(queue_wait_ns)], 1);
+  }
+}
+
+std::vector<InstructionStatistics::Summary> InstructionStatistics::Summarize()
+    const {
+  std::vector<Summary> summaries(op_types_.size());
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (size_t instr_id = 0; instr_id < op_types_.size(); ++instr_id) {
+    uint64_t latency_ns = 0;
+    uint64_t queue_wait_ns = 0;
+    std::array<uint64_t, kBucketNum> latency_buckets{};
+    std::array<uint64_t, kBucketNum> queue_wait_buckets{};
+    Summary& summary = summaries[instr_id];
+    summary.op_type = op_types_[instr_id];
+    for (const auto& counters : thread_counters_) {
+      const Counter& counter = counters[instr_id];
+      summary.count += counter.Load(counter.count);
+      latency_ns += counter.Load(counter.latency_ns);
+      queue_wait_ns += counter.Load(counter.queue_wait_ns);
+      summary.allocated_bytes +=
+          static_cast<int64_t>(counter.Load(counter.allocated_bytes));
+      for (int i = 0; i < kBucketNum; ++i) {
+        latency_buckets[i] += counter.Load(counter.latency_buckets[i]);
+        queue_wait_buckets[i] += counter.Load(counter.queue_wait_buckets[i]);
+      }
+    }
+    for (int i = 0; i < kBucketNum; ++i) {
+      summary.queue_wait_count += queue_wait_buckets[i];
+    }
+    if (summary.count > 0) {
+      summary.latency_mean_us = latency_ns / 1000.0 / summary.count;
+      summary.latency_p50_us = Quantile(latency_buckets, summary.count, 0.5);
+      summary.latency_p99_us = Quantile(latency_buckets, summary.count, 0.99);
+    }
+    if (summary.queue_wait_count > 0) {
+      summary.queue_wait_mean_us =
+          queue_wait_ns / 1000.0 / summary.queue_wait_count;
+      summary.queue_wait_p50_us =
+          Quantile(queue_wait_buckets, summary.queue_wait_count, 0.5);
+      summary.queue_wait_p99_us =
+          Quantile(queue_wait_buckets, summary.queue_wait_count, 0.99);
+    }
+  }
+  return summaries;
+}
+
+std::string InstructionStatisticsToJson() {
+  std::ostringstream os;
+  os << std::setprecision(6) << "{\"interpreters\":[";
+  std::lock_guard<std::mutex> guard(StatisticsRegistryMutex());
+  bool first_interpreter = true;
+  for (const InstructionStatistics* statistics : StatisticsRegistry()) {
+    os << (first_interpreter ? "" : ",") << "{\"id\":" << statistics->Id()
+       << ",\"instructions\":[";
+    first_interpreter = false;
+    auto summaries = statistics->Summarize();
+    bool first_instruction = true;
+    for (size_t instr_id = 0; instr_id < summaries.size(); ++instr_id) {
+      const auto& summary = summaries[instr_id];
+      if (summary.count == 0) {
+        continue;
+      }
+      os << (first_instruction ? "" : ",") << "{\"id\":" << instr_id
+         << ",\"op\":\"" << summary.op_type << "\""
+         << ",\"count\":" << summary.count << ",\"latency_us\":{\"mean\":"
+         << summary.latency_mean_us << ",\"p50\":" << summary.latency_p50_us
+         << ",\"p99\":" << summary.latency_p99_us << "}"
+         << ",\"queue_wait_us\":{\"count\":" << summary.queue_wait_count
+         << ",\"mean\":" << summary.queue_wait_mean_us
+         << ",\"p50\":" << summary.queue_wait_p50_us
+         << ",\"p99\":" << summary.queue_wait_p99_us << "}"
+         << ",\"allocated_bytes\":" << summary.allocated_bytes << "}";
+      first_instruction = false;
+    }
+    os << "]}";
+  }
+  os << "]}";
+  return os.str();
+}
+
+std::string InstructionStatisticsToPrometheus() {
+  using Summary = InstructionStatistics::Summary;
+  struct Metric {
+    const char* name;
+    const char* type;
+    const char* help;
+    std::function<void(std::ostream&, const std::string&, const Summary&)>
+        write;
+  };
+  auto write_summary = [](std::ostream& os,
+                          const std::string& name,
+                          const std::string& labels,
+                          uint64_t count,
+                          double mean_us,
+                          double p50_us,
+                          double p99_us) {
+    os << name << "{" << labels << ",quantile=\"0.5\"} " << p50_us / 1e6
+       << "\n";
+    os << name << "{" << labels << ",quantile=\"0.99\"} " << p99_us / 1e6
+       << "\n";
+    os << name << "_sum{" << labels << "} " << mean_us * count / 1e6 << "\n";
+    os << name << "_count{" << labels << "} " << count << "\n";
+  };
+  const std::vector<Metric> metrics = {
+      {"paddle_instruction_latency_seconds",
+       "summary",
+       "Latency of the instruction.",
+       [&](std::ostream& os, const std::string& labels, const Summary& s) {
+         write_summary(os,
+                       "paddle_instruction_latency_seconds",
+                       labels,
+                       s.count,
+                       s.latency_mean_us,
+                       s.latency_p50_us,
+                       s.latency_p99_us);
+       }},
+      {"paddle_instruction_queue_wait_seconds",
+       "summary",
+       "Time from the instruction is ready to it starts.",
+       [&](std::ostream& os, const std::string& labels, const Summary& s) {
+         write_summary(os,
+                       "paddle_instruction_queue_wait_seconds",
+                       labels,
+                       s.queue_wait_count,
+                       s.queue_wait_mean_us,
+                       s.queue_wait_p50_us,
+                       s.queue_wait_p99_us);
+       }},
+      {"paddle_instruction_allocated_bytes",
+       "gauge",
+       "Net bytes allocated by the instruction.",
+       [](std::ostream& os, const std::string& labels, const Summary& s) {
+         os << "paddle_instruction_allocated_bytes{" << labels << "} "
+            << s.allocated_bytes << "\n";
+       }},
+  };
+
+  std::vector<std::pair<std::string, Summary>> labeled_summaries;
+  {
+    std::lock_guard<std::mutex> guard(StatisticsRegistryMutex());
+    for (const InstructionStatistics* statistics : StatisticsRegistry()) {
+      auto summaries = statistics->Summarize();
+      for (size_t instr_id = 0; instr_id < summaries.size(); ++instr_id) {
+        if (summaries[instr_id].count == 0) {
+          continue;
+        }
+        labeled_summaries.emplace_back(
+            "interpreter=\"" + std::to_string(statistics->Id()) +
+                "\",instruction=\"" + std::to_string(instr_id) +
+                "\",op=\"" + summaries[instr_id].op_type + "\"",
+            summaries[instr_id]);
+      }
+    }
+  }
+
+  std::ostringstream os;
+  os << std::setprecision(6);
+  for (const Metric& metric : metrics) {
+    os << "# HELP " << metric.name << " " << metric.help << "\n";
+    os << "# TYPE " << metric.name << " " << metric.type << "\n";
+    for (const auto& item : labeled_summaries) {
+      metric.write(os, item.first, item.second);
+    }
+  }
+  return os.str();
+}
+
 }  // namespace framework
 }  // namespace paddle
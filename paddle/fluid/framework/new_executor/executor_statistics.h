@@ -14,8 +14,15 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
+#include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler/event_node.h"
 
 namespace paddle {
@@ -24,5 +31,88 @@ namespace framework {
 void StaticGraphExecutorPerfStatistics(
     std::shared_ptr<const platform::NodeTrees> profiling_data);
 
+// Always-on counters of the instructions of one interpreter, enabled by
+// FLAGS_new_executor_instruction_statistics.
+//
+// Every thread running the instructions writes its own buffer without any
+// lock or atomic read-modify-write, the buffers are merged when dumping. The
+// latency and the queue wait (from ready to start) are kept in log scale
+// histograms with two buckets per power of two, so the quantiles are accurate
+// to about 25%.
+class InstructionStatistics {
+ public:
+  static constexpr int kBucketNum = 64;
+
+  // op_types[i] is the type of the i-th instruction.
+  explicit InstructionStatistics(const std::vector<std::string>& op_types);
+  ~InstructionStatistics();
+
+  static uint64_t NowNs();
+
+  // Net bytes allocated on place by the current thread since it started.
+  static int64_t ThreadAllocatedBytes(const platform::Place& place);
+
+  // Called when all the dependences of the instruction are done.
+  void RecordReady(size_t instr_id) {
+    ready_ns_[instr_id].store(NowNs(), std::memory_order_relaxed);
+  }
+
+  // Called by the thread that ran the instruction.
+  void Record(size_t instr_id,
+              uint64_t start_ns,
+              uint64_t end_ns,
+              int64_t allocated_bytes);
+
+  struct Summary {
+    std::string op_type;
+    uint64_t count = 0;
+    double latency_mean_us = 0;
+    double latency_p50_us = 0;
+    double latency_p99_us = 0;
+    uint64_t queue_wait_count = 0;
+    double queue_wait_mean_us = 0;
+    double queue_wait_p50_us = 0;
+    double queue_wait_p99_us = 0;
+    int64_t allocated_bytes = 0;
+  };
+
+  // The merged counters of all threads, one for each instruction.
+  std::vector<Summary> Summarize() const;
+
+  uint64_t Id() const { return id_; }
+
+ private:
+  struct Counter {
+    uint64_t Load(const std::atomic<uint64_t>& value) const {
+      return value.load(std::memory_order_relaxed);
+    }
+    // only the owner thread writes, so a plain load and store is enough
+    void Add(std::atomic<uint64_t>* value, uint64_t increment) {
+      value->store(Load(*value) + increment, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> latency_ns{0};
+    std::atomic<uint64_t> queue_wait_ns{0};
+    std::atomic<uint64_t> allocated_bytes{0};
+    std::array<std::atomic<uint64_t>, kBucketNum> latency_buckets{};
+    std::array<std::atomic<uint64_t>, kBucketNum> queue_wait_buckets{};
+  };
+
+  Counter* ThreadCounters();
+
+  const uint64_t id_;
+  const std::vector<std::string> op_types_;
+  std::unique_ptr<std::atomic<uint64_t>[]> ready_ns_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Counter[]>> thread_counters_;
+};
+
+// Dump the counters of all the living interpreters in JSON or in the text
+// format of Prometheus, the instructions never run are skipped.
+std::string InstructionStatisticsToJson();
+std::string InstructionStatisticsToPrometheus();
+
 }  // namespace framework
 }  // namespace paddle
@@ -127,6 +127,15 @@ void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type,
   queue_group_->AddTask(op_func_type == OpFuncType::kGpuAsync, std::move(fn));
 }
 
+void AsyncWorkQueue::AddTaskWithHint(const OpFuncType& op_func_type,
+                                     size_t thread_hint,
+                                     std::function<void()> fn) {
+  size_t queue_idx = op_func_type == OpFuncType::kGpuAsync;
+  int start =
+      static_cast<int>(thread_hint % queue_group_->QueueNumThreads(queue_idx));
+  queue_group_->AddTaskWithHint(queue_idx, std::move(fn), start, start + 1);
+}
+
 bool IsCommunicationOp(const OperatorBase* op) {
   const std::string& op_name = op->Type();
   const std::set<std::string> special_comm_op_set = {
@@ -55,6 +55,12 @@ class AsyncWorkQueue {
 
   void AddTask(const OpFuncType& op_func_type, std::function<void()> fn);
 
+  // Run fn on the (thread_hint % num_threads)-th thread of the queue, used to
+  // spread the first ready ops of a run over different threads.
+  void AddTaskWithHint(const OpFuncType& op_func_type,
+                       size_t thread_hint,
+                       std::function<void()> fn);
+
   void Cancel() { queue_group_->Cancel(); }
 
   size_t QueueNumThreads(size_t idx) {
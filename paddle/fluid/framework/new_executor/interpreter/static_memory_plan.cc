@@ -0,0 +1,73 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
+
+#include <algorithm>
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+void StaticMemoryPlan::Build(
+    const std::vector<size_t>& sizes,
+    const std::function<bool(size_t, size_t)>& conflict) {
+  size_t buffer_num = sizes.size();
+  sizes_.resize(buffer_num);
+  offsets_.assign(buffer_num, 0);
+  arena_bytes_ = 0;
+  naive_bytes_ = 0;
+  for (size_t i = 0; i < buffer_num; ++i) {
+    sizes_[i] = AlignedSize(sizes[i]);
+    naive_bytes_ += sizes_[i];
+  }
+
+  std::vector<size_t> order(buffer_num);
+  for (size_t i = 0; i < buffer_num; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+    return sizes_[lhs] > sizes_[rhs];
+  });
+
+  // placed buffers sorted by offset
+  std::vector<size_t> placed;
+  placed.reserve(buffer_num);
+  for (size_t id : order) {
+    size_t offset = 0;
+    for (size_t other : placed) {
+      if (!conflict(id, other)) {
+        continue;
+      }
+      if (offsets_[other] >= offset + sizes_[id]) {
+        // the gap before other is large enough
+        break;
+      }
+      offset = std::max(offset, offsets_[other] + sizes_[other]);
+    }
+    offsets_[id] = offset;
+    arena_bytes_ = std::max(arena_bytes_, offset + sizes_[id]);
+    placed.insert(std::upper_bound(placed.begin(),
+                                   placed.end(),
+                                   id,
+                                   [this](size_t lhs, size_t rhs) {
+                                     return offsets_[lhs] < offsets_[rhs];
+                                   }),
+                  id);
+  }
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,78 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "paddle/phi/core/allocator.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// Assigns every buffer a fixed offset in one arena, so that two buffers whose
+// lifetimes may overlap never share bytes.
+//
+// Buffers are placed greedily by size, the largest first, each at the lowest
+// offset not used by an already placed buffer it conflicts with.
+class StaticMemoryPlan {
+ public:
+  static constexpr size_t kAlignment = 64;
+
+  // conflict(i, j) returns whether the i-th and j-th buffers may be alive at
+  // the same time.
+  void Build(const std::vector<size_t>& sizes,
+             const std::function<bool(size_t, size_t)>& conflict);
+
+  size_t Offset(size_t i) const { return offsets_.at(i); }
+  size_t Size(size_t i) const { return sizes_.at(i); }
+  size_t BufferNum() const { return sizes_.size(); }
+
+  // bytes of the arena holding all buffers
+  size_t ArenaBytes() const { return arena_bytes_; }
+  // bytes of all buffers without any reuse
+  size_t NaiveBytes() const { return naive_bytes_; }
+
+  static size_t AlignedSize(size_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+ private:
+  std::vector<size_t> sizes_;
+  std::vector<size_t> offsets_;
+  size_t arena_bytes_{0};
+  size_t naive_bytes_{0};
+};
+
+// A planned buffer, it keeps the arena alive as long as any tensor holds it.
+class StaticMemoryPlanSlice : public phi::Allocation {
+ public:
+  StaticMemoryPlanSlice(const std::shared_ptr<phi::Allocation>& arena,
+                        size_t offset,
+                        size_t size)
+      : phi::Allocation(static_cast<char*>(arena->ptr()) + offset,
+                        size,
+                        arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<phi::Allocation> arena_;
+};
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -24,6 +24,7 @@
 #include "paddle/fluid/platform/flags.h"
 
 #include "paddle/fluid/framework/details/exception_holder.h"
+#include "paddle/fluid/framework/new_executor/executor_statistics.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/interpreter/dependency_builder.h"
 #include "paddle/fluid/framework/new_executor/interpreter/execution_config.h"
@@ -42,6 +43,10 @@ DECLARE_bool(new_executor_serial_run);
 DECLARE_bool(new_executor_static_build);
 DECLARE_bool(new_executor_use_inplace);
 DECLARE_bool(new_executor_use_local_scope);
+DECLARE_bool(new_executor_critical_path_schedule);
+DECLARE_int32(new_executor_critical_path_profile_steps);
+DECLARE_bool(new_executor_static_memory_plan);
+DECLARE_bool(new_executor_instruction_statistics);
 
 PHI_DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
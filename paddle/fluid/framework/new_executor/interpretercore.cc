@@ -34,6 +34,31 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                             true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_critical_path_schedule,
+    false,
+    "Dispatch ready ops of the new executor by the length of the critical "
+    "path they start, instead of program order.");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_static_memory_plan,
+    false,
+    "Place the intermediate dense tensors of the new executor at fixed "
+    "offsets of one arena planned after the first run, instead of freeing "
+    "and allocating them every step. Only for CPU and fixed shapes, the plan "
+    "is dropped when a shape grows.");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_instruction_statistics,
+    false,
+    "Count the runs, latency, queue wait and allocated bytes of every "
+    "instruction of the new executor, dumped by "
+    "core.instruction_statistics_to_json and "
+    "core.instruction_statistics_to_prometheus.");
+PADDLE_DEFINE_EXPORTED_int32(
+    new_executor_critical_path_profile_steps,
+    3,
+    "Number of runs whose op time is measured to estimate the critical path "
+    "when new_executor_critical_path_schedule is on, 0 keeps the op count "
+    "estimate.");
 
 namespace paddle {
 namespace framework {
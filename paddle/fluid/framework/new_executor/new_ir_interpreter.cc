@@ -912,6 +912,7 @@ void NewIRInterpreter::TraceRunImpl() {
   }
 
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
+  PrepareInstructionStatistics();
   VLOG(4) << "Tracing Instruction List";
 
   TraceRunInstructionList(vec_instruction_base_);
@@ -925,6 +926,7 @@ void NewIRInterpreter::MultiThreadRunImpl() {
   }
 
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
+  PrepareInstructionStatistics();
   VLOG(4) << "Multi Thread Run Instruction List";
 
   async_work_queue_ = GetWorkQueue();
@@ -932,6 +934,21 @@ void NewIRInterpreter::MultiThreadRunImpl() {
   VLOG(4) << "Done MultiThreadRunInstructionList";
 }
 
+void NewIRInterpreter::PrepareInstructionStatistics() {
+  if (!FLAGS_new_executor_instruction_statistics) {
+    instruction_statistics_.reset();
+    return;
+  }
+  if (instruction_statistics_ == nullptr) {
+    std::vector<std::string> op_types;
+    op_types.reserve(vec_instruction_base_.size());
+    for (auto& instr : vec_instruction_base_) {
+      op_types.push_back(instr->Name());
+    }
+    instruction_statistics_ = std::make_unique<InstructionStatistics>(op_types);
+  }
+}
+
 void NewIRInterpreter::TraceRunInstructionList(
     const std::vector<std::unique_ptr<InstructionBase>>& vec_instr) {
   unfinished_op_number_ = vec_instr.size();
@@ -990,6 +1007,9 @@ void NewIRInterpreter::MultiThreadRunInstructionList(
     if ((*dependecy_count_)[i] == 0) {
       // NOTE(zhiqiu): hot fix for jit input var
       RecordMemcpyD2H(vec_instr.at(i).get());
+      if (instruction_statistics_) {
+        instruction_statistics_->RecordReady(i);
+      }
       if (FLAGS_new_executor_serial_run) {
         RunInstructionBaseAsync(i);
       } else {
@@ -1099,7 +1119,13 @@ void NewIRInterpreter::RunNextInstructions(InstructionBase* instr,
   auto IsReady = [this](size_t next_id) {
     VLOG(4) << "op_id: " << next_id
             << ", remain deps: " << deps_[next_id]->DynamicDep();
-    return deps_[next_id]->CheckAndDecrease();
+    if (!deps_[next_id]->CheckAndDecrease()) {
+      return false;
+    }
+    if (instruction_statistics_) {
+      instruction_statistics_->RecordReady(next_id);
+    }
+    return true;
   };
 
   for (size_t next_instr_id : instr->NextInstrsInDifferenceThread()) {
@@ -1128,7 +1154,23 @@ void NewIRInterpreter::RunInstructionBase(InstructionBase* instr_node) {
 
     VLOG(5) << "begin to run op " << instr_node->Name();
     if (!instr_node->IsArtificial()) {
+      uint64_t start_ns = 0;
+      int64_t start_allocated_bytes = 0;
+      if (instruction_statistics_) {
+        start_ns = InstructionStatistics::NowNs();
+        start_allocated_bytes = InstructionStatistics::ThreadAllocatedBytes(
+            instr_node->DeviceContext().GetPlace());
+      }
       instr_node->Run();
+      if (instruction_statistics_) {
+        instruction_statistics_->Record(
+            instr_node->Id(),
+            start_ns,
+            InstructionStatistics::NowNs(),
+            InstructionStatistics::ThreadAllocatedBytes(
+                instr_node->DeviceContext().GetPlace()) -
+                start_allocated_bytes);
+      }
       VLOG(4) << "done instruction node run";
       CheckGC(instr_node);
       VLOG(4) << "done CheckGC";
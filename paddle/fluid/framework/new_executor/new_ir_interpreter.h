@@ -135,6 +135,9 @@ class NewIRInterpreter : public InterpreterBaseImpl {
 
   std::unique_ptr<InterpreterCoreGarbageCollector> gc_;
 
+  // always-on counters of every instruction, null if disabled
+  std::unique_ptr<InstructionStatistics> instruction_statistics_;
+
   // last_live_ops_[i] contains the id of operators that last access the i-th
   // var
   std::map<size_t, std::set<size_t>> last_live_ops_;
@@ -180,6 +183,9 @@ class NewIRInterpreter : public InterpreterBaseImpl {
 
   void RunInstructionBase(InstructionBase* instr_node);
 
+  // create or destroy the statistics by the flag before a run
+  void PrepareInstructionStatistics();
+
   void RecordMemcpyD2H(InstructionBase* instr_node);
 
   ::ir::Value GetValueByName(const std::string& var_name);
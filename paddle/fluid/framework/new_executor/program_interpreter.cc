@@ -14,11 +14,16 @@
 
 #include "paddle/fluid/framework/new_executor/program_interpreter.h"
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/static_build.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
@@ -67,12 +72,21 @@ ProgramInterpreter::ProgramInterpreter(const platform::Place& place,
   }
   var_scope_.SetLocalScope(local_scope_);
 
+  // NOTE: in serial run every op is scheduled in the same thread, there is
+  // nothing to gain from the critical path
+  critical_path_schedule_ = FLAGS_new_executor_critical_path_schedule &&
+                            !FLAGS_new_executor_serial_run;
+
   instruction_scheduling_priority_less = [this](size_t lhs, size_t rhs) {
     SchedulingPriority lhs_scheduling_priority =
         vec_instruction_[lhs].GetSchedulingPriority();
     SchedulingPriority rhs_scheduling_priority =
         vec_instruction_[rhs].GetSchedulingPriority();
     if (lhs_scheduling_priority == rhs_scheduling_priority) {
+      if (critical_path_schedule_ &&
+          critical_path_[lhs] != critical_path_[rhs]) {
+        return critical_path_[lhs] < critical_path_[rhs];
+      }
       return lhs < rhs;
     }
     return lhs_scheduling_priority > rhs_scheduling_priority;
@@ -101,6 +115,11 @@ void ProgramInterpreter::RunImpl() {
   }
 
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
+  PrepareInstructionStatistics();
+
+  if (memory_plan_state_ == MemoryPlanState::kUnplanned) {
+    PrepareStaticMemoryPlan();
+  }
 
   if ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
       (sync_op_num_ == 0)) {
@@ -113,6 +132,14 @@ void ProgramInterpreter::RunImpl() {
     // until the second step run.
     async_work_queue_ = GetWorkQueue();
     ExecuteInstructionList(vec_instruction_);
+    if (critical_path_schedule_) {
+      UpdateCriticalPathByProfile();
+    }
+  }
+  if (memory_plan_state_ == MemoryPlanState::kProfiling) {
+    BuildStaticMemoryPlan();
+  } else if (memory_plan_state_ == MemoryPlanState::kPlanned) {
+    CheckStaticMemoryPlan();
   }
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
   if (platform::is_custom_place(place_)) {
@@ -121,6 +148,21 @@ void ProgramInterpreter::RunImpl() {
 #endif
 }
 
+void ProgramInterpreter::PrepareInstructionStatistics() {
+  if (!FLAGS_new_executor_instruction_statistics) {
+    instruction_statistics_.reset();
+    return;
+  }
+  if (instruction_statistics_ == nullptr) {
+    std::vector<std::string> op_types;
+    op_types.reserve(vec_instruction_.size());
+    for (auto& instr : vec_instruction_) {
+      op_types.push_back(instr.OpBase()->Type());
+    }
+    instruction_statistics_ = std::make_unique<InstructionStatistics>(op_types);
+  }
+}
+
 FetchList ProgramInterpreter::Run(
     const std::vector<std::string>& feed_names,
     const std::vector<phi::DenseTensor>& feed_tensors) {
@@ -587,6 +629,111 @@ void ProgramInterpreter::BuildOperatorDependences() {
       }
     }
   }
+
+  if (critical_path_schedule_) {
+    // before any op is timed, the critical path is the longest chain in
+    // number of ops
+    std::vector<double> instr_cost(instr_num, 1.0);
+    for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
+      if (vec_instruction_[instr_id].IsArtificial()) {
+        instr_cost[instr_id] = 0.0;
+      }
+    }
+    BuildCriticalPath(instr_cost);
+    instr_cost_us_.assign(instr_num, 0.0);
+    critical_path_profiled_steps_ = 0;
+  }
+}
+
+void ProgramInterpreter::BuildCriticalPath(
+    const std::vector<double>& instr_cost) {
+  size_t instr_num = vec_instruction_.size();
+  const std::map<size_t, std::set<size_t>>& downstream_map =
+      dependency_builder_.OpDownstreamMap();
+
+  // topological order of the instructions
+  std::vector<size_t> in_degree(instr_num, 0);
+  for (auto& item : downstream_map) {
+    for (size_t next_instr_id : item.second) {
+      ++in_degree[next_instr_id];
+    }
+  }
+  std::vector<size_t> topo_order;
+  topo_order.reserve(instr_num);
+  for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
+    if (in_degree[instr_id] == 0) {
+      topo_order.push_back(instr_id);
+    }
+  }
+  for (size_t i = 0; i < topo_order.size(); ++i) {
+    auto iter = downstream_map.find(topo_order[i]);
+    if (iter == downstream_map.end()) {
+      continue;
+    }
+    for (size_t next_instr_id : iter->second) {
+      if (--in_degree[next_instr_id] == 0) {
+        topo_order.push_back(next_instr_id);
+      }
+    }
+  }
+  PADDLE_ENFORCE_EQ(topo_order.size(),
+                    instr_num,
+                    platform::errors::PreconditionNotMet(
+                        "The op dependency graph has a cycle, only %d of %d "
+                        "ops are sorted.",
+                        topo_order.size(),
+                        instr_num));
+
+  critical_path_.assign(instr_num, 0.0);
+  for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+    double longest_next = 0.0;
+    auto iter = downstream_map.find(*it);
+    if (iter != downstream_map.end()) {
+      for (size_t next_instr_id : iter->second) {
+        longest_next = std::max(longest_next, critical_path_[next_instr_id]);
+      }
+    }
+    critical_path_[*it] = instr_cost[*it] + longest_next;
+  }
+  VLOG(4) << "Critical path length: "
+          << (instr_num == 0 ? 0.0
+                             : *std::max_element(critical_path_.begin(),
+                                                 critical_path_.end()));
+}
+
+void ProgramInterpreter::SortByCriticalPath(
+    std::vector<size_t>* instr_ids) const {
+  std::sort(instr_ids->begin(),
+            instr_ids->end(),
+            [this](size_t lhs, size_t rhs) {
+              return instruction_scheduling_priority_less(rhs, lhs);
+            });
+}
+
+void ProgramInterpreter::UpdateCriticalPathByProfile() {
+  if (critical_path_profiled_steps_ >=
+      FLAGS_new_executor_critical_path_profile_steps) {
+    return;
+  }
+  if (++critical_path_profiled_steps_ <
+      FLAGS_new_executor_critical_path_profile_steps) {
+    return;
+  }
+  // every profiled op costs at least 1us, so that the chains of cheap ops
+  // still rank by their length
+  std::vector<double> instr_cost(instr_cost_us_.size());
+  for (size_t instr_id = 0; instr_id < instr_cost.size(); ++instr_id) {
+    instr_cost[instr_id] =
+        vec_instruction_[instr_id].IsArtificial()
+            ? 0.0
+            : std::max(1.0,
+                       instr_cost_us_[instr_id] /
+                           critical_path_profiled_steps_);
+  }
+  BuildCriticalPath(instr_cost);
+  VLOG(1) << "Update critical path of " << instr_cost.size()
+          << " ops by the time of " << critical_path_profiled_steps_
+          << " runs";
 }
 
 // At the end of each step, the holder of phi::DenseTensor in LoDTensorArray is
@@ -987,9 +1134,37 @@ void ProgramInterpreter::RunInstruction(const Instruction& instr_node) {
     instr_node.WaitEvent(place_);
 
     if (!instr_node.IsArtificial()) {
+      // NOTE: for async device kernels only the launch time is measured
+      bool profile_cost = critical_path_schedule_ &&
+                          critical_path_profiled_steps_ <
+                              FLAGS_new_executor_critical_path_profile_steps;
+      auto start = profile_cost ? std::chrono::steady_clock::now()
+                                : std::chrono::steady_clock::time_point();
+      uint64_t start_ns = 0;
+      int64_t start_allocated_bytes = 0;
+      if (instruction_statistics_) {
+        start_ns = InstructionStatistics::NowNs();
+        start_allocated_bytes = InstructionStatistics::ThreadAllocatedBytes(
+            instr_node.DeviceContext().GetPlace());
+      }
       RunOperator(instr_node);
+      if (instruction_statistics_) {
+        instruction_statistics_->Record(
+            instr_node.Id(),
+            start_ns,
+            InstructionStatistics::NowNs(),
+            InstructionStatistics::ThreadAllocatedBytes(
+                instr_node.DeviceContext().GetPlace()) -
+                start_allocated_bytes);
+      }
       CheckGC(instr_node);
       interpreter::LogDeviceMemoryStats(place_);
+      if (profile_cost) {
+        instr_cost_us_[instr_node.Id()] +=
+            std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+      }
     }
 
     instr_node.RecordEvent(place_);
@@ -1037,18 +1212,35 @@ void ProgramInterpreter::ExecuteInstructionList(
 
   exception_holder_.Clear();
 
+  std::vector<size_t> ready_instr_ids;
   for (size_t i = 0; i < dependecy_count_->size(); ++i) {
     if ((*dependecy_count_)[i] == 0) {
       // NOTE(zhiqiu): hot fix for jit input var
       RecordMemcpyD2H(vec_instr.at(i));
+      if (instruction_statistics_) {
+        instruction_statistics_->RecordReady(i);
+      }
       if (FLAGS_new_executor_serial_run) {
         RunInstructionAsync(i);
+      } else if (critical_path_schedule_) {
+        ready_instr_ids.push_back(i);
       } else {
         async_work_queue_->AddTask(vec_instr.at(i).KernelType(),
                                    [this, i] { RunInstructionAsync(i); });
       }
     }
   }
+  if (critical_path_schedule_) {
+    // start the longest chains first, each on its own thread
+    SortByCriticalPath(&ready_instr_ids);
+    for (size_t k = 0; k < ready_instr_ids.size(); ++k) {
+      size_t i = ready_instr_ids[k];
+      async_work_queue_->AddTaskWithHint(
+          vec_instr.at(i).KernelType(), k, [this, i] {
+            RunInstructionAsync(i);
+          });
+    }
+  }
 
   // For debug hang in main_thread_blocker_.WaitEvent(),
   // launch async task to log deps every
@@ -1110,13 +1302,23 @@ void ProgramInterpreter::ExecuteInstructionList(
 
 void ProgramInterpreter::RunNextInstructions(
     const Instruction& instr, SchedulingQueue* reserved_next_ops) {
+  if (critical_path_schedule_) {
+    RunNextInstructionsByCriticalPath(instr, reserved_next_ops);
+    return;
+  }
   platform::RecordEvent record(
       "RunNextInstructions", platform::TracerEventType::UserDefined, 10);
 
   auto IsReady = [this](size_t next_id) {
     VLOG(4) << "op_id: " << next_id
             << ", remain deps: " << deps_[next_id]->DynamicDep();
-    return deps_[next_id]->CheckAndDecrease();
+    if (!deps_[next_id]->CheckAndDecrease()) {
+      return false;
+    }
+    if (instruction_statistics_) {
+      instruction_statistics_->RecordReady(next_id);
+    }
+    return true;
   };
 
   for (size_t next_instr_id : instr.NextInstrsInDifferenceThread()) {
@@ -1134,6 +1336,61 @@ void ProgramInterpreter::RunNextInstructions(
   }
 }
 
+// Unlike RunNextInstructions, the host op kept in the current thread is not
+// fixed when building, it is the ready one with the longest critical path.
+void ProgramInterpreter::RunNextInstructionsByCriticalPath(
+    const Instruction& instr, SchedulingQueue* reserved_next_ops) {
+  platform::RecordEvent record("RunNextInstructionsByCriticalPath",
+                               platform::TracerEventType::UserDefined,
+                               10);
+
+  auto IsReady = [this](size_t next_id) {
+    VLOG(4) << "op_id: " << next_id
+            << ", remain deps: " << deps_[next_id]->DynamicDep();
+    if (!deps_[next_id]->CheckAndDecrease()) {
+      return false;
+    }
+    if (instruction_statistics_) {
+      instruction_statistics_->RecordReady(next_id);
+    }
+    return true;
+  };
+
+  bool is_async_instr = instr.KernelType() == OpFuncType::kGpuAsync;
+  std::vector<size_t> ready_instr_ids;
+  for (size_t next_instr_id : instr.NextInstrsInDifferenceThread()) {
+    if (IsReady(next_instr_id)) {
+      ready_instr_ids.push_back(next_instr_id);
+    }
+  }
+  for (size_t next_instr_id : instr.NextInstrsInSameThread()) {
+    if (IsReady(next_instr_id)) {
+      // keep the async ops following an async op in the same thread
+      if (is_async_instr) {
+        reserved_next_ops->push(next_instr_id);
+      } else {
+        ready_instr_ids.push_back(next_instr_id);
+      }
+    }
+  }
+
+  SortByCriticalPath(&ready_instr_ids);
+  // Tasks added by a worker are pushed to the front of its own queue and idle
+  // threads steal from the back, so the more critical ops are added first.
+  bool has_reserved_op = is_async_instr;
+  for (size_t next_instr_id : ready_instr_ids) {
+    if (!has_reserved_op &&
+        vec_instruction_[next_instr_id].KernelType() != OpFuncType::kGpuAsync) {
+      reserved_next_ops->push(next_instr_id);
+      has_reserved_op = true;
+      continue;
+    }
+    async_work_queue_->AddTask(
+        vec_instruction_[next_instr_id].KernelType(),
+        [this, next_instr_id]() { RunInstructionAsync(next_instr_id); });
+  }
+}
+
 void ProgramInterpreter::RunInstructionAsync(size_t instr_id) {
   // NOTE(Ruibiao): Due to the uncertain order in multi-threading asynchronous
   // scheduling, the priority order involved cross-thread scheduling is not
@@ -1289,6 +1546,11 @@ void ProgramInterpreter::CheckGC(const Instruction& instr) {
       continue;
     }
     if (is_ready) {
+      // the planned vars keep their buffer in the arena
+      if (var_id < memory_plan_skip_gc_.size() &&
+          memory_plan_skip_gc_[var_id]) {
+        continue;
+      }
       VLOG(6) << "Async delete variable with name : "
               << var_scope.GetNameById(var_id);
       gc_->Add(refs_[var_id]->Var(), instr);
@@ -1296,6 +1558,179 @@ void ProgramInterpreter::CheckGC(const Instruction& instr) {
   }
 }
 
+void ProgramInterpreter::PrepareStaticMemoryPlan() {
+  memory_plan_state_ = MemoryPlanState::kDisabled;
+  if (!FLAGS_new_executor_static_memory_plan) {
+    return;
+  }
+  // NOTE: the planned buffers are not allocated by the stream safe allocator,
+  // only plan for CPU now
+  if (!platform::is_cpu_place(place_) ||
+      execution_config_.used_for_control_flow_op) {
+    VLOG(1) << "Static memory plan is not supported on " << place_;
+    return;
+  }
+  for (auto& instr : vec_instruction_) {
+    // ops of sub blocks read and write vars out of the instruction list
+    if (instr.OpBase()->HasAttr("sub_block")) {
+      VLOG(1) << "Static memory plan is not supported for the program with "
+              << instr.OpBase()->Type() << " op";
+      return;
+    }
+  }
+
+  // the candidates are all the dense tensors freed by gc, they are kept alive
+  // in the next run, so that their sizes are known and the ones sharing
+  // buffers can be found
+  memory_plan_skip_gc_.assign(var_scope_.VarSize(), false);
+  memory_plan_vars_.clear();
+  for (auto& instr : vec_instruction_) {
+    for (size_t var_id : instr.GCCheckVars()) {
+      if (memory_plan_skip_gc_[var_id]) {
+        continue;
+      }
+      auto* var_desc = var_scope_.VarDesc(var_id);
+      if (var_desc == nullptr || var_desc->Persistable() ||
+          var_desc->GetType() != proto::VarType::LOD_TENSOR ||
+          execution_config_.skip_gc_vars.count(
+              var_scope_.GetNameById(var_id))) {
+        continue;
+      }
+      memory_plan_skip_gc_[var_id] = true;
+      memory_plan_vars_.push_back(var_id);
+    }
+  }
+  if (!memory_plan_vars_.empty()) {
+    memory_plan_state_ = MemoryPlanState::kProfiling;
+  }
+}
+
+void ProgramInterpreter::BuildStaticMemoryPlan() {
+  std::vector<size_t> planned_vars;
+  std::vector<size_t> sizes;
+  for (size_t var_id : memory_plan_vars_) {
+    Variable* var = var_scope_.VarRef(var_id);
+    if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+      memory_plan_skip_gc_[var_id] = false;
+      continue;
+    }
+    auto* tensor = var->GetMutable<phi::DenseTensor>();
+    const auto& holder = tensor->Holder();
+    // a buffer shared with another var or out of the program can not be
+    // reused when this var dies
+    if (holder != nullptr && holder->ptr() != nullptr &&
+        holder.use_count() == 1 && tensor->meta().offset == 0 &&
+        tensor->numel() > 0 && platform::is_cpu_place(holder->place())) {
+      planned_vars.push_back(var_id);
+      sizes.push_back(tensor->numel() * phi::SizeOf(tensor->dtype()));
+    } else {
+      memory_plan_skip_gc_[var_id] = false;
+    }
+    // free the buffers kept for profiling as gc does
+    tensor->MoveMemoryHolder();
+  }
+  memory_plan_vars_ = planned_vars;
+  if (memory_plan_vars_.empty()) {
+    ReleaseStaticMemoryPlan();
+    return;
+  }
+
+  // the ops reading or writing every planned var
+  std::unordered_map<size_t, size_t> var_index;
+  for (size_t i = 0; i < memory_plan_vars_.size(); ++i) {
+    var_index[memory_plan_vars_[i]] = i;
+  }
+  std::vector<std::vector<size_t>> var_ops(memory_plan_vars_.size());
+  for (size_t instr_id = 0; instr_id < vec_instruction_.size(); ++instr_id) {
+    const Instruction& instr = vec_instruction_[instr_id];
+    for (auto* var_map : {&instr.Inputs(), &instr.Outputs()}) {
+      for (auto& item : *var_map) {
+        for (int var_id : item.second) {
+          if (var_id < 0) {
+            continue;
+          }
+          auto iter = var_index.find(var_id);
+          if (iter == var_index.end()) {
+            continue;
+          }
+          auto& ops = var_ops[iter->second];
+          if (ops.empty() || ops.back() != instr_id) {
+            ops.push_back(instr_id);
+          }
+        }
+      }
+    }
+  }
+
+  // two vars can share bytes only if all the ops of one happen before all the
+  // ops of the other, no matter how the ops are scheduled
+  auto all_happen_before = [this](const std::vector<size_t>& prior_ops,
+                                  const std::vector<size_t>& posterior_ops) {
+    for (size_t prior : prior_ops) {
+      for (size_t posterior : posterior_ops) {
+        if (prior == posterior ||
+            !dependency_builder_.OpHappensBefore(prior, posterior)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+  memory_plan_.Build(sizes, [&](size_t i, size_t j) {
+    if (var_ops[i].empty() || var_ops[j].empty()) {
+      return true;
+    }
+    return !all_happen_before(var_ops[i], var_ops[j]) &&
+           !all_happen_before(var_ops[j], var_ops[i]);
+  });
+
+  memory_plan_arena_ = memory::AllocShared(place_, memory_plan_.ArenaBytes());
+  memory_plan_slices_.clear();
+  for (size_t i = 0; i < memory_plan_vars_.size(); ++i) {
+    memory_plan_slices_.push_back(
+        std::make_shared<interpreter::StaticMemoryPlanSlice>(
+            memory_plan_arena_, memory_plan_.Offset(i), memory_plan_.Size(i)));
+    var_scope_.VarRef(memory_plan_vars_[i])
+        ->GetMutable<phi::DenseTensor>()
+        ->ResetHolder(memory_plan_slices_.back());
+  }
+  memory_plan_state_ = MemoryPlanState::kPlanned;
+  LOG(INFO) << "Static memory plan of " << memory_plan_vars_.size()
+            << " variables: " << memory_plan_.ArenaBytes()
+            << " bytes planned, " << memory_plan_.NaiveBytes()
+            << " bytes without reuse.";
+}
+
+void ProgramInterpreter::CheckStaticMemoryPlan() {
+  for (size_t i = 0; i < memory_plan_vars_.size(); ++i) {
+    Variable* var = var_scope_.VarRef(memory_plan_vars_[i]);
+    if (!var->IsType<phi::DenseTensor>() ||
+        var->Get<phi::DenseTensor>().Holder() != memory_plan_slices_[i]) {
+      LOG(WARNING) << "Variable "
+                   << var_scope_.GetNameById(memory_plan_vars_[i])
+                   << " is out of its planned buffer, the shapes of the "
+                      "program may be dynamic. Disable static memory plan.";
+      ReleaseStaticMemoryPlan();
+      return;
+    }
+  }
+}
+
+void ProgramInterpreter::ReleaseStaticMemoryPlan() {
+  for (size_t i = 0; i < memory_plan_slices_.size(); ++i) {
+    Variable* var = var_scope_.VarRef(memory_plan_vars_[i]);
+    if (var->IsType<phi::DenseTensor>() &&
+        var->Get<phi::DenseTensor>().Holder() == memory_plan_slices_[i]) {
+      var->GetMutable<phi::DenseTensor>()->MoveMemoryHolder();
+    }
+  }
+  memory_plan_slices_.clear();
+  memory_plan_arena_.reset();
+  memory_plan_vars_.clear();
+  memory_plan_skip_gc_.clear();
+  memory_plan_state_ = MemoryPlanState::kDisabled;
+}
+
 void ProgramInterpreter::Prepare(
     const std::vector<std::string>& feed_names,
     const std::vector<phi::DenseTensor>& feed_tensors,
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
 #include "paddle/fluid/framework/new_executor/interpreter_base_impl.h"
 
 namespace paddle {
@@ -81,6 +82,20 @@ class ProgramInterpreter : public InterpreterBaseImpl {
     hookfuncs_ = hookfuncs;
   }
 
+  // critical path scheduling, empty if it is off or before the build
+  const std::vector<double>& GetCriticalPath() const { return critical_path_; }
+
+  // sort the ready instructions in the order they are dispatched, the most
+  // critical one first
+  void SortByCriticalPath(std::vector<size_t>* instr_ids) const;
+
+  // the static memory plan the vars run with, null if there is no plan or it
+  // is dropped
+  const interpreter::StaticMemoryPlan* GetStaticMemoryPlan() const {
+    return memory_plan_state_ == MemoryPlanState::kPlanned ? &memory_plan_
+                                                           : nullptr;
+  }
+
  private:
   // build graph
   void Convert(std::vector<paddle::framework::OpFuncNode>* op_func_nodes);
@@ -89,6 +104,9 @@ class ProgramInterpreter : public InterpreterBaseImpl {
   void BuildSkipShareLoDInfo();
   void UpdateSyncOpNum();
   void AnalyseExecuteOrderForTrace();
+  // critical path scheduling
+  void BuildCriticalPath(const std::vector<double>& instr_cost);
+  void UpdateCriticalPathByProfile();
 
   // inplace
   void BuildInplace();
@@ -107,6 +125,8 @@ class ProgramInterpreter : public InterpreterBaseImpl {
   void RunInstruction(const Instruction& instr_node);
   void RunNextInstructions(const Instruction& instr_id,
                            SchedulingQueue* reserved_next_ops);
+  void RunNextInstructionsByCriticalPath(const Instruction& instr_node,
+                                         SchedulingQueue* reserved_next_ops);
   void RunOperator(const Instruction& instr_node);
   // Trace
   void TraceInstructionList(const std::vector<Instruction>& vec_instr);
@@ -123,6 +143,15 @@ class ProgramInterpreter : public InterpreterBaseImpl {
   void CheckGC(const Instruction& instr);
   void ClearLoDTensorArrayInLocalScope();
 
+  // create or destroy the statistics by the flag before a run
+  void PrepareInstructionStatistics();
+
+  // static memory plan
+  void PrepareStaticMemoryPlan();
+  void BuildStaticMemoryPlan();
+  void CheckStaticMemoryPlan();
+  void ReleaseStaticMemoryPlan();
+
   // workqueue
   std::shared_ptr<interpreter::AsyncWorkQueue> GetWorkQueue();
 
@@ -189,6 +218,28 @@ class ProgramInterpreter : public InterpreterBaseImpl {
 
   InstructionSchedulingPriorityLess instruction_scheduling_priority_less;
 
+  // used for critical path scheduling, critical_path_[i] is the estimated
+  // cost of the longest op chain starting from the i-th instruction
+  bool critical_path_schedule_{false};
+  std::vector<double> critical_path_;
+  // host time of every instruction in us, summed over the profiled runs
+  std::vector<double> instr_cost_us_;
+  int critical_path_profiled_steps_{0};
+
+  // used for static memory plan, the planned vars hold fixed slices of one
+  // arena instead of being freed by gc and allocated again every step
+  enum class MemoryPlanState { kUnplanned, kProfiling, kPlanned, kDisabled };
+  MemoryPlanState memory_plan_state_{MemoryPlanState::kUnplanned};
+  // ids of the vars skipping gc, the candidates while profiling
+  std::vector<size_t> memory_plan_vars_;
+  std::vector<bool> memory_plan_skip_gc_;
+  interpreter::StaticMemoryPlan memory_plan_;
+  std::shared_ptr<phi::Allocation> memory_plan_arena_;
+  std::vector<std::shared_ptr<phi::Allocation>> memory_plan_slices_;
+
+  // always-on counters of every instruction, null if disabled
+  std::unique_ptr<InstructionStatistics> instruction_statistics_;
+
   std::vector<HookFunc> hookfuncs_;
 };
 
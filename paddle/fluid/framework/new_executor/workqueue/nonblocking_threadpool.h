@@ -19,6 +19,7 @@
 #include "paddle/fluid/framework/new_executor/workqueue/thread_environment.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/phi/core/parallel_for.h"
 
 namespace paddle {
 namespace framework {
@@ -45,7 +46,8 @@ class ThreadPoolTempl {
         ec_(num_threads),
         num_threads_(num_threads),
         thread_data_(num_threads),
-        name_(name) {
+        name_(name),
+        intra_op_pool_(this) {
     // Calculate coprimes of all numbers [1, num_threads].
     // Coprimes are used for random walks over all threads in Steal
     // and NonEmptyQueueIndex. Iteration is based on the fact that if we take
@@ -224,6 +226,23 @@ class ThreadPoolTempl {
 
   typedef typename Environment::EnvThread Thread;
 
+  // Lets the kernels run on the workers split their loops over this pool.
+  // Tasks added by a worker go to the front of its own queue, where the idle
+  // workers steal them from.
+  class IntraOpPool : public phi::IntraOpThreadPool {
+   public:
+    explicit IntraOpPool(ThreadPoolTempl* pool) : pool_(pool) {}
+
+    int NumThreads() const override { return pool_->num_threads_; }
+
+    void Schedule(std::function<void()> fn) override {
+      pool_->AddTask(std::move(fn));
+    }
+
+   private:
+    ThreadPoolTempl* pool_;
+  };
+
   struct PerThread {
     constexpr PerThread() : pool(NULL), rand(0), thread_id(-1) {}
     ThreadPoolTempl* pool;  // Parent pool, or null for normal threads.
@@ -251,6 +270,7 @@ class ThreadPoolTempl {
   const int num_threads_;
   std::vector<ThreadData> thread_data_;
   std::string name_;
+  IntraOpPool intra_op_pool_;
 
   // Main worker thread loop.
   void WorkerLoop(int thread_id) {
@@ -261,6 +281,7 @@ class ThreadPoolTempl {
     pt->pool = this;
     pt->rand = GlobalThreadIdHash();
     pt->thread_id = thread_id;
+    phi::SetIntraOpThreadPool(&intra_op_pool_);
     Queue& q = thread_data_[thread_id].queue;
     EventCount::Waiter* waiter = ec_.GetWaiter(thread_id);
     // TODO(dvyukov,rmlarsen): The time spent in NonEmptyQueueIndex() is
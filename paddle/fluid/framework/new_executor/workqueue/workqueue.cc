@@ -98,6 +98,11 @@ class WorkQueueGroupImpl : public WorkQueueGroup {
 
   void AddTask(size_t queue_idx, std::function<void()> fn) override;
 
+  void AddTaskWithHint(size_t queue_idx,
+                       std::function<void()> fn,
+                       int start,
+                       int limit) override;
+
   size_t QueueNumThreads(size_t queue_idx) const override;
 
   size_t QueueGroupNumThreads() const override;
@@ -179,6 +184,35 @@ void WorkQueueGroupImpl::AddTask(size_t queue_idx, std::function<void()> fn) {
   queues_[queue_idx]->AddTask(std::move(fn));
 }
 
+void WorkQueueGroupImpl::AddTaskWithHint(size_t queue_idx,
+                                         std::function<void()> fn,
+                                         int start,
+                                         int limit) {
+  platform::RecordEvent record("WorkQueue::AddTaskWithHint",
+                               platform::TracerEventType::UserDefined,
+                               10 /*level*/);
+  assert(queue_idx < queues_.size());
+  PADDLE_ENFORCE_NOT_NULL(
+      queues_.at(queue_idx),
+      platform::errors::NotFound("Workqueue of index %d is not initialized.",
+                                 queue_idx));
+  PADDLE_ENFORCE_EQ(
+      start >= 0 && start < limit &&
+          limit <= static_cast<int>(queues_[queue_idx]->NumThreads()),
+      true,
+      platform::errors::InvalidArgument(
+          "Invalid thread range [%d, %d) of workqueue %d with %d threads.",
+          start,
+          limit,
+          queue_idx,
+          queues_[queue_idx]->NumThreads()));
+  if (queues_options_.at(queue_idx).track_task) {
+    fn = [task = std::move(fn),
+          raii = CounterGuard<TaskTracker>(tracker_)]() mutable { task(); };
+  }
+  queues_[queue_idx]->AddTaskWithHint(std::move(fn), start, limit);
+}
+
 size_t WorkQueueGroupImpl::QueueNumThreads(size_t queue_idx) const {
   assert(queue_idx < queues_.size());
   if (!queues_.at(queue_idx)) {
@@ -155,6 +155,14 @@ class WorkQueueGroup {
 
   virtual void AddTask(size_t queue_idx, std::function<void()> fn) = 0;
 
+  // Push the task onto one of the threads in [start, limit) of the queue.
+  // Only honored when called outside the queue, a worker thread always pushes
+  // onto its own local queue.
+  virtual void AddTaskWithHint(size_t queue_idx,
+                               std::function<void()> fn,
+                               int start,
+                               int limit) = 0;
+
   // Higher cost than AddTask
   template <typename F, typename... Args>
   std::future<typename std::result_of<F(Args...)>::type> AddAwaitableTask(
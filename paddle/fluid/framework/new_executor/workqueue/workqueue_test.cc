@@ -20,6 +20,10 @@
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
+#include "paddle/phi/core/flags.h"
+#include "paddle/phi/core/parallel_for.h"
+
+PHI_DECLARE_bool(enable_intra_op_parallel);
 
 TEST(WorkQueueUtils, TestEventsWaiter) {
   using paddle::framework::EventsWaiter;
@@ -204,3 +208,70 @@ TEST(WorkQueue, TestWorkQueueGroup) {
   queue_group.reset();
   waiter_thread.join();
 }
+
+TEST(WorkQueue, TestWorkQueueGroupAddTaskWithHint) {
+  using paddle::framework::CreateWorkQueueGroup;
+  using paddle::framework::EventsWaiter;
+  using paddle::framework::WorkQueueOptions;
+  constexpr int kThreadNum = 4;
+  constexpr unsigned kTaskNum = 1000;
+  std::atomic<unsigned> counter{0};
+  EventsWaiter events_waiter;
+  WorkQueueOptions mq_options(/*name*/ "MultiThreadedWorkQueueForTesting",
+                              /*num_threads*/ kThreadNum,
+                              /*allow_spinning*/ true,
+                              /*always_spinning*/ false,
+                              /*track_task*/ true,
+                              /*detached*/ false,
+                              &events_waiter);
+  auto queue_group = CreateWorkQueueGroup({mq_options});
+  // AddTaskWithHint
+  for (unsigned i = 0; i < kTaskNum; ++i) {
+    int start = i % kThreadNum;
+    queue_group->AddTaskWithHint(
+        0, [&counter]() { ++counter; }, start, start + 1);
+  }
+  // WaitQueueGroupEmpty
+  events_waiter.WaitEvent();
+  EXPECT_EQ(counter.load(), kTaskNum);
+  // invalid hint
+  EXPECT_ANY_THROW(queue_group->AddTaskWithHint(
+      0, [&counter]() { ++counter; }, 0, kThreadNum + 1));
+  EXPECT_ANY_THROW(queue_group->AddTaskWithHint(
+      0, [&counter]() { ++counter; }, 2, 2));
+  queue_group.reset();
+}
+
+TEST(WorkQueue, TestIntraOpParallelFor) {
+  using paddle::framework::CreateMultiThreadedWorkQueue;
+  using paddle::framework::EventsWaiter;
+  using paddle::framework::WorkQueueOptions;
+  constexpr int64_t kNum = 100000;
+  FLAGS_enable_intra_op_parallel = true;
+  EventsWaiter events_waiter;
+  WorkQueueOptions options(/*name*/ "MultiThreadedWorkQueueForTesting",
+                           /*num_threads*/ 4,
+                           /*allow_spinning*/ true,
+                           /*always_spinning*/ false,
+                           /*track_task*/ true,
+                           /*detached*/ false,
+                           &events_waiter);
+  auto work_queue = CreateMultiThreadedWorkQueue(options);
+  // the workers of the queue run the chunks of the loops of their tasks
+  EXPECT_EQ(phi::GetIntraOpParallelism(), 1);
+  std::atomic<int64_t> sum{0};
+  std::atomic<int> parallelism{0};
+  for (int i = 0; i < 8; ++i) {
+    work_queue->AddTask([&sum, &parallelism, kNum]() {
+      parallelism = phi::GetIntraOpParallelism();
+      phi::ParallelFor(0, kNum, 100, [&sum](int64_t begin, int64_t end) {
+        sum += end - begin;
+      });
+    });
+  }
+  events_waiter.WaitEvent();
+  EXPECT_EQ(parallelism.load(), 4);
+  EXPECT_EQ(sum.load(), 8 * kNum);
+  work_queue.reset();
+  FLAGS_enable_intra_op_parallel = false;
+}
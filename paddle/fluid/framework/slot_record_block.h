@@ -0,0 +1,141 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// The values of one slot of the instances in a SlotRecordBlock, the values of
+// the i-th instance are values[offsets[i], offsets[i + 1]).
+template <typename T>
+struct SlotColumn {
+  std::vector<T> values;
+  std::vector<uint32_t> offsets{0};
+
+  size_t ins_num() const { return offsets.size() - 1; }
+
+  void Append(const T* data, size_t num) {
+    values.insert(values.end(), data, data + num);
+    offsets.push_back(static_cast<uint32_t>(values.size()));
+  }
+
+  const T* Get(size_t ins, size_t* num) const {
+    *num = offsets[ins + 1] - offsets[ins];
+    return values.data() + offsets[ins];
+  }
+
+  // The values of the instances in [begin, end), which are contiguous.
+  const T* Range(size_t begin, size_t end, size_t* num) const {
+    *num = offsets[end] - offsets[begin];
+    return values.data() + offsets[begin];
+  }
+
+  // Whether every instance in [begin, end) has a value.
+  bool NoEmpty(size_t begin, size_t end) const {
+    for (size_t i = begin; i < end; ++i) {
+      if (offsets[i + 1] == offsets[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The LoD of the instances in [begin, end) is the prefix sums of their
+  // value numbers, i.e. their offsets rebased to 0.
+  void RangeLoD(size_t begin, size_t end, std::vector<size_t>* lod) const {
+    lod->resize(end - begin + 1);
+    uint32_t base = offsets[begin];
+    for (size_t i = begin; i <= end; ++i) {
+      (*lod)[i - begin] = offsets[i] - base;
+    }
+  }
+
+  void Reserve(const SlotColumn<T>& like) {
+    values.reserve(like.values.size());
+    offsets.reserve(like.offsets.size());
+  }
+};
+
+// A block of instances loaded by SlotRecordInMemoryDataFeed in columnar
+// layout: the values of one slot of all the instances are contiguous.
+// Instances are appended by the loading thread only, and the block is read
+// only once the loading finishes. The SlotRecords of the instances refer to
+// the block instead of owning their values, so loading allocates per block
+// rather than per instance, and a batch of consecutive instances is a range of
+// every column.
+class SlotRecordBlock {
+ public:
+  SlotRecordBlock(int uint64_slot_num, int float_slot_num)
+      : uint64_slots_(uint64_slot_num), float_slots_(float_slot_num) {}
+
+  size_t ins_num() const { return ins_num_; }
+
+  const SlotColumn<uint64_t>& uint64_slot(int slot) const {
+    return uint64_slots_[slot];
+  }
+  const SlotColumn<float>& float_slot(int slot) const {
+    return float_slots_[slot];
+  }
+
+  // The columns to fill directly, e.g. from a file, after which set_ins_num
+  // has to be called with the number of instances in every column.
+  SlotColumn<uint64_t>* mutable_uint64_slot(int slot) {
+    return &uint64_slots_[slot];
+  }
+  SlotColumn<float>* mutable_float_slot(int slot) {
+    return &float_slots_[slot];
+  }
+  void set_ins_num(size_t ins_num) { ins_num_ = ins_num; }
+
+  int uint64_slot_num() const { return static_cast<int>(uint64_slots_.size()); }
+  int float_slot_num() const { return static_cast<int>(float_slots_.size()); }
+
+  // Append an instance and return its index in the block.
+  uint32_t AddInstance(
+      const std::vector<std::vector<uint64_t>>& uint64_feasigns,
+      const std::vector<std::vector<float>>& float_feasigns) {
+    for (size_t i = 0; i < uint64_slots_.size(); ++i) {
+      uint64_slots_[i].Append(uint64_feasigns[i].data(),
+                              uint64_feasigns[i].size());
+    }
+    for (size_t i = 0; i < float_slots_.size(); ++i) {
+      float_slots_[i].Append(float_feasigns[i].data(),
+                             float_feasigns[i].size());
+    }
+    return static_cast<uint32_t>(ins_num_++);
+  }
+
+  // Reserve the capacity of a similar block to avoid growing the columns.
+  void Reserve(const SlotRecordBlock& like) {
+    for (size_t i = 0; i < uint64_slots_.size(); ++i) {
+      uint64_slots_[i].Reserve(like.uint64_slots_[i]);
+    }
+    for (size_t i = 0; i < float_slots_.size(); ++i) {
+      float_slots_[i].Reserve(like.float_slots_[i]);
+    }
+  }
+
+ private:
+  std::vector<SlotColumn<uint64_t>> uint64_slots_;
+  std::vector<SlotColumn<float>> float_slots_;
+  size_t ins_num_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,97 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/slot_record_block.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(SlotRecordBlock, AddInstance) {
+  SlotRecordBlock block(2, 1);
+  std::vector<std::vector<uint64_t>> uint64_feasigns = {{1, 2}, {3}};
+  std::vector<std::vector<float>> float_feasigns = {{0.5}};
+  ASSERT_EQ(block.AddInstance(uint64_feasigns, float_feasigns), 0U);
+  uint64_feasigns = {{4}, {}};
+  float_feasigns = {{1.5, 2.5}};
+  ASSERT_EQ(block.AddInstance(uint64_feasigns, float_feasigns), 1U);
+  uint64_feasigns = {{5, 6, 7}, {8}};
+  float_feasigns = {{}};
+  ASSERT_EQ(block.AddInstance(uint64_feasigns, float_feasigns), 2U);
+  ASSERT_EQ(block.ins_num(), 3UL);
+
+  size_t num = 0;
+  const uint64_t* values = block.uint64_slot(0).Get(2, &num);
+  ASSERT_EQ(num, 3UL);
+  ASSERT_EQ(values[0], 5UL);
+  ASSERT_EQ(values[2], 7UL);
+  block.uint64_slot(1).Get(1, &num);
+  ASSERT_EQ(num, 0UL);
+  const float* float_values = block.float_slot(0).Get(1, &num);
+  ASSERT_EQ(num, 2UL);
+  ASSERT_EQ(float_values[1], 2.5);
+}
+
+TEST(SlotRecordBlock, Range) {
+  SlotRecordBlock block(2, 0);
+  for (uint64_t i = 0; i < 10; ++i) {
+    std::vector<std::vector<uint64_t>> uint64_feasigns(2);
+    uint64_feasigns[0].assign(i + 1, i);
+    if (i % 3 != 0) {
+      uint64_feasigns[1].push_back(i);
+    }
+    block.AddInstance(uint64_feasigns, {});
+  }
+
+  // the values of a range are contiguous and the lod starts at 0
+  auto& column = block.uint64_slot(0);
+  size_t num = 0;
+  const uint64_t* values = column.Range(2, 5, &num);
+  ASSERT_EQ(num, 3UL + 4UL + 5UL);
+  ASSERT_EQ(values[0], 2UL);
+  ASSERT_EQ(values[num - 1], 4UL);
+  std::vector<size_t> lod;
+  column.RangeLoD(2, 5, &lod);
+  ASSERT_EQ(lod, std::vector<size_t>({0, 3, 7, 12}));
+  ASSERT_TRUE(column.NoEmpty(0, 10));
+
+  // the instances 3, 6 and 9 have no value in slot 1
+  auto& sparse_column = block.uint64_slot(1);
+  ASSERT_TRUE(sparse_column.NoEmpty(1, 3));
+  ASSERT_FALSE(sparse_column.NoEmpty(1, 4));
+  sparse_column.RangeLoD(3, 7, &lod);
+  ASSERT_EQ(lod, std::vector<size_t>({0, 0, 1, 2, 2}));
+}
+
+TEST(SlotRecordBlock, Reserve) {
+  SlotRecordBlock block(1, 1);
+  for (int i = 0; i < 100; ++i) {
+    block.AddInstance({{1, 2, 3}}, {{1.0}});
+  }
+  SlotRecordBlock next_block(1, 1);
+  next_block.Reserve(block);
+  const uint64_t* data = next_block.uint64_slot(0).values.data();
+  for (int i = 0; i < 100; ++i) {
+    next_block.AddInstance({{1, 2, 3}}, {{1.0}});
+  }
+  // the columns do not grow within the reserved capacity
+  ASSERT_EQ(next_block.uint64_slot(0).values.data(), data);
+  ASSERT_EQ(next_block.ins_num(), 100UL);
+}
+
+}  // namespace framework
+}  // namespace paddle
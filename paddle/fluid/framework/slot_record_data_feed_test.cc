@@ -0,0 +1,265 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed_factory.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+PHI_DECLARE_bool(enable_slotrecord_columnar);
+
+namespace paddle {
+namespace framework {
+
+#ifdef _LINUX
+// the instances take two blocks of the binary cache
+static const int kInsNum = OBJPOOL_BLOCK_SIZE + 500;
+static const char* kDataPath = "slot_record_data_feed_test.txt";
+static const char* kCacheDir = "slot_record_data_feed_test_cache";
+// the pipe command copies every parsed line to the log
+static const char* kParseLog = "slot_record_data_feed_test.log";
+
+struct ExpectedInstance {
+  std::vector<uint64_t> feasigns;
+  std::vector<uint64_t> clicks;
+  std::vector<float> scores;
+};
+
+static DataFeedDesc MakeDataFeedDesc() {
+  DataFeedDesc desc;
+  desc.set_name("SlotRecordInMemoryDataFeed");
+  desc.set_batch_size(32);
+  desc.set_pipe_command(std::string("tee -a ") + kParseLog);
+  auto* multi_slot_desc = desc.mutable_multi_slot_desc();
+  auto add_slot = [multi_slot_desc](const std::string& name,
+                                    const std::string& type,
+                                    bool is_used) {
+    auto* slot = multi_slot_desc->add_slots();
+    slot->set_name(name);
+    slot->set_type(type);
+    slot->set_is_dense(false);
+    slot->set_is_used(is_used);
+  };
+  add_slot("feasign", "uint64", true);
+  add_slot("unused", "uint64", false);
+  add_slot("click", "uint64", true);
+  add_slot("score", "float", true);
+  return desc;
+}
+
+static std::vector<ExpectedInstance> WriteDataFile(int ins_num, int seed) {
+  std::vector<ExpectedInstance> expected(ins_num);
+  std::ofstream file(kDataPath);
+  for (int i = 0; i < ins_num; ++i) {
+    auto& ins = expected[i];
+    for (int j = 0; j <= (i + seed) % 4; ++j) {
+      ins.feasigns.push_back(static_cast<uint64_t>(i) * 131 + j + seed + 1);
+    }
+    ins.clicks.push_back((i + seed) % 2 + 1);
+    ins.scores.push_back(0.5f * (i % 7 + 1));
+    ins.scores.push_back(0.25f * (seed + 1));
+    file << "1 ins_" << i << " " << ins.feasigns.size();
+    for (auto feasign : ins.feasigns) {
+      file << " " << feasign;
+    }
+    file << " 1 7 1 " << ins.clicks[0] << " 2 " << ins.scores[0] << " "
+         << ins.scores[1] << "\n";
+  }
+  return expected;
+}
+
+static int ParsedLines() {
+  std::ifstream file(kParseLog);
+  std::string line;
+  int lines = 0;
+  while (std::getline(file, line)) {
+    ++lines;
+  }
+  return lines;
+}
+
+static void LoadAndCheck(const std::vector<ExpectedInstance>& expected) {
+  std::shared_ptr<DataFeed> feed =
+      DataFeedFactory::CreateDataFeed("SlotRecordInMemoryDataFeed");
+  feed->Init(MakeDataFeedDesc());
+  std::mutex mutex;
+  size_t file_idx = 0;
+  feed->SetFileListMutex(&mutex);
+  feed->SetFileListIndex(&file_idx);
+  feed->SetFileList({kDataPath});
+  feed->SetThreadId(0);
+  feed->SetParseInsId(true);
+  feed->SetBinaryCacheDir(kCacheDir, true);
+  auto channel = MakeChannel<SlotRecord>();
+  feed->SetInputChannel(channel.get());
+  feed->LoadIntoMemory();
+  channel->Close();
+
+  std::vector<SlotRecord> records;
+  channel->ReadAll(records);
+  ASSERT_EQ(records.size(), expected.size());
+  std::vector<int> seen(expected.size(), 0);
+  for (auto rec : records) {
+    int i = std::stoi(rec->ins_id_.substr(4));
+    ASSERT_LT(i, static_cast<int>(expected.size()));
+    ++seen[i];
+    size_t num = 0;
+    const uint64_t* feasigns = rec->get_uint64_values(0, &num);
+    ASSERT_EQ(std::vector<uint64_t>(feasigns, feasigns + num),
+              expected[i].feasigns);
+    const uint64_t* clicks = rec->get_uint64_values(1, &num);
+    ASSERT_EQ(std::vector<uint64_t>(clicks, clicks + num), expected[i].clicks);
+    const float* scores = rec->get_float_values(0, &num);
+    ASSERT_EQ(std::vector<float>(scores, scores + num), expected[i].scores);
+  }
+  for (auto count : seen) {
+    ASSERT_EQ(count, 1);
+  }
+  SlotRecordPool().put(&records);
+}
+
+static void CorruptCache() {
+  auto files = localfs_list(kCacheDir);
+  ASSERT_EQ(files.size(), 1UL);
+  // flip a byte of the last block, the first block is still valid
+  std::fstream file(files[0], std::ios::in | std::ios::out | std::ios::binary);
+  file.seekg(-10, std::ios::end);
+  char c = static_cast<char>(file.get());
+  file.seekp(-10, std::ios::end);
+  file.put(static_cast<char>(c ^ 0x5a));
+}
+
+TEST(SlotRecordInMemoryDataFeed, BinaryCache) {
+  localfs_remove(kCacheDir);
+  localfs_remove(kParseLog);
+  localfs_mkdir(kCacheDir);
+  auto expected = WriteDataFile(kInsNum, 0);
+
+  // the first load parses the file and writes the cache
+  LoadAndCheck(expected);
+  ASSERT_EQ(ParsedLines(), kInsNum);
+  ASSERT_EQ(localfs_list(kCacheDir).size(), 1UL);
+
+  // the later loads read the cache in both layouts
+  LoadAndCheck(expected);
+  FLAGS_enable_slotrecord_columnar = true;
+  LoadAndCheck(expected);
+  FLAGS_enable_slotrecord_columnar = false;
+  ASSERT_EQ(ParsedLines(), kInsNum);
+
+  // a broken cache is parsed again without duplicated instances, and
+  // rewritten
+  CorruptCache();
+  LoadAndCheck(expected);
+  ASSERT_EQ(ParsedLines(), 2 * kInsNum);
+  LoadAndCheck(expected);
+  ASSERT_EQ(ParsedLines(), 2 * kInsNum);
+
+  // the cache of a rewritten data file is stale
+  expected = WriteDataFile(kInsNum + 1, 1);
+  LoadAndCheck(expected);
+  ASSERT_EQ(ParsedLines(), 3 * kInsNum + 1);
+  LoadAndCheck(expected);
+  ASSERT_EQ(ParsedLines(), 3 * kInsNum + 1);
+
+  localfs_remove(kCacheDir);
+  localfs_remove(kParseLog);
+  localfs_remove(kDataPath);
+}
+
+TEST(SlotRecordInMemoryDataFeed, UnwritableBinaryCache) {
+  // the cache dir does not exist, so the cache can not be written
+  localfs_remove(kCacheDir);
+  localfs_remove(kParseLog);
+  auto expected = WriteDataFile(kInsNum, 0);
+
+  // the instances are still fed, and parsed again by every load
+  LoadAndCheck(expected);
+  ASSERT_EQ(ParsedLines(), kInsNum);
+  LoadAndCheck(expected);
+  ASSERT_EQ(ParsedLines(), 2 * kInsNum);
+  ASSERT_FALSE(localfs_exists(kCacheDir));
+
+  localfs_remove(kParseLog);
+  localfs_remove(kDataPath);
+}
+
+TEST(SlotRecordInMemoryDataFeed, GetNextBatchFeasigns) {
+  localfs_remove(kParseLog);
+  const int ins_num = 10;
+  auto expected = WriteDataFile(ins_num, 0);
+  std::shared_ptr<DataFeed> feed =
+      DataFeedFactory::CreateDataFeed("SlotRecordInMemoryDataFeed");
+  feed->Init(MakeDataFeedDesc());
+  std::mutex mutex;
+  size_t file_idx = 0;
+  feed->SetFileListMutex(&mutex);
+  feed->SetFileListIndex(&file_idx);
+  feed->SetFileList({kDataPath});
+  feed->SetThreadId(0);
+  feed->SetParseInsId(true);
+  auto channel = MakeChannel<SlotRecord>();
+  feed->SetInputChannel(channel.get());
+  feed->LoadIntoMemory();
+  channel->Close();
+  std::vector<SlotRecord> records;
+  channel->ReadAll(records);
+  ASSERT_EQ(records.size(), static_cast<size_t>(ins_num));
+
+  // the records are fed in batches of 4, 4 and 2
+  auto* in_memory_feed =
+      dynamic_cast<InMemoryDataFeed<SlotRecord>*>(feed.get());
+  ASSERT_NE(in_memory_feed, nullptr);
+  in_memory_feed->SetRecord(records.data());
+  const int batch_size = 4;
+  for (int begin = 0; begin < ins_num; begin += batch_size) {
+    in_memory_feed->AddBatchOffset(
+        {begin, std::min(batch_size, ins_num - begin)});
+  }
+  ASSERT_TRUE(feed->Start());
+
+  std::vector<uint64_t> feasigns;
+  for (int begin = 0; begin < ins_num; begin += batch_size) {
+    // the unused slot and the float slot are skipped
+    ASSERT_TRUE(
+        feed->GetNextBatchFeasigns({"feasign", "unused", "score"}, &feasigns));
+    std::vector<uint64_t> batch_feasigns;
+    for (int i = begin; i < std::min(begin + batch_size, ins_num); ++i) {
+      auto& ins = expected[std::stoi(records[i]->ins_id_.substr(4))];
+      batch_feasigns.insert(
+          batch_feasigns.end(), ins.feasigns.begin(), ins.feasigns.end());
+    }
+    ASSERT_EQ(feasigns, batch_feasigns);
+    // looking ahead does not consume the batch
+    ASSERT_EQ(feed->Next(), std::min(batch_size, ins_num - begin));
+  }
+  ASSERT_FALSE(feed->GetNextBatchFeasigns({"feasign"}, &feasigns));
+  ASSERT_EQ(feed->Next(), 0);
+
+  SlotRecordPool().put(&records);
+  localfs_remove(kParseLog);
+  localfs_remove(kDataPath);
+}
+#endif
+
+}  // namespace framework
+}  // namespace paddle
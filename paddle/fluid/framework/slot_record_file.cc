@@ -0,0 +1,433 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/slot_record_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "zlib.h"  // NOLINT
+
+namespace paddle {
+namespace framework {
+
+static constexpr char kSlotRecordFileMagic[8] = {
+    'P', 'D', 'S', 'L', 'O', 'T', 'R', 'F'};
+static constexpr uint32_t kSlotRecordFileVersion = 1;
+
+// the flags of the file
+static constexpr uint32_t kHasInsId = 1;
+static constexpr uint32_t kHasLogKey = 2;
+// the flags of a block
+static constexpr uint32_t kZlibCompressed = 1;
+
+struct SlotRecordFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t uint64_slot_num;
+  uint32_t float_slot_num;
+  uint32_t signature_size;
+};
+
+struct SlotRecordFileBlockHeader {
+  uint32_t ins_num;
+  uint32_t flags;
+  uint64_t raw_size;
+  uint64_t stored_size;
+  uint32_t crc;
+  uint32_t reserved;
+};
+
+template <typename T>
+static void AppendColumn(const T* data, size_t num, std::string* buffer) {
+  uint64_t size = num * sizeof(T);
+  buffer->append(reinterpret_cast<const char*>(&size), sizeof(size));
+  buffer->append(reinterpret_cast<const char*>(data), size);
+}
+
+SlotRecordFileWriter::SlotRecordFileWriter(const std::string& path,
+                                           const std::string& signature,
+                                           int uint64_slot_num,
+                                           int float_slot_num,
+                                           bool has_ins_id,
+                                           bool has_log_key,
+                                           bool compress)
+    : path_(path),
+      uint64_slot_num_(uint64_slot_num),
+      float_slot_num_(float_slot_num),
+      has_ins_id_(has_ins_id),
+      has_log_key_(has_log_key),
+      compress_(compress) {
+  // the processes sharing the files write their own temporary files
+  tmp_path_ = path + ".tmp." + std::to_string(getpid());
+  fp_ = fopen(tmp_path_.c_str(), "wb");
+  PADDLE_ENFORCE_NOT_NULL(
+      fp_,
+      platform::errors::Unavailable(
+          "Fail to open %s to write the slot records.", tmp_path_));
+
+  SlotRecordFileHeader header;
+  memcpy(header.magic, kSlotRecordFileMagic, sizeof(header.magic));
+  header.version = kSlotRecordFileVersion;
+  header.flags = (has_ins_id ? kHasInsId : 0) | (has_log_key ? kHasLogKey : 0);
+  header.uint64_slot_num = uint64_slot_num;
+  header.float_slot_num = float_slot_num;
+  header.signature_size = signature.size();
+  buffer_.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+  buffer_.append(signature);
+  if (fwrite(buffer_.data(), 1, buffer_.size(), fp_) != buffer_.size()) {
+    // the destructor is not run for a throwing constructor
+    fclose(fp_);
+    remove(tmp_path_.c_str());
+    PADDLE_THROW(
+        platform::errors::Unavailable("Fail to write %s.", tmp_path_));
+  }
+}
+
+SlotRecordFileWriter::~SlotRecordFileWriter() {
+  if (fp_ != nullptr) {
+    fclose(fp_);
+    remove(tmp_path_.c_str());
+  }
+}
+
+void SlotRecordFileWriter::Write(const SlotRecordFileBlock& block) {
+  const SlotRecordBlock& slots = *block.slots;
+  size_t ins_num = slots.ins_num();
+  PADDLE_ENFORCE_EQ(slots.uint64_slot_num() == uint64_slot_num_ &&
+                        slots.float_slot_num() == float_slot_num_,
+                    true,
+                    platform::errors::InvalidArgument(
+                        "The block has %d uint64 slots and %d float slots, "
+                        "but the file has %d and %d.",
+                        slots.uint64_slot_num(),
+                        slots.float_slot_num(),
+                        uint64_slot_num_,
+                        float_slot_num_));
+  buffer_.clear();
+  if (has_ins_id_) {
+    PADDLE_ENFORCE_EQ(block.ins_ids.size(),
+                      ins_num,
+                      platform::errors::InvalidArgument(
+                          "The block has %d ins ids but %d instances.",
+                          block.ins_ids.size(),
+                          ins_num));
+    std::vector<uint32_t> lengths(ins_num);
+    std::string ins_ids;
+    for (size_t i = 0; i < ins_num; ++i) {
+      lengths[i] = block.ins_ids[i].size();
+      ins_ids.append(block.ins_ids[i]);
+    }
+    AppendColumn(lengths.data(), lengths.size(), &buffer_);
+    AppendColumn(ins_ids.data(), ins_ids.size(), &buffer_);
+  }
+  if (has_log_key_) {
+    PADDLE_ENFORCE_EQ(block.search_ids.size() == ins_num &&
+                          block.cmatches.size() == ins_num &&
+                          block.ranks.size() == ins_num,
+                      true,
+                      platform::errors::InvalidArgument(
+                          "The block has not the log keys of %d instances.",
+                          ins_num));
+    AppendColumn(block.search_ids.data(), ins_num, &buffer_);
+    AppendColumn(block.cmatches.data(), ins_num, &buffer_);
+    AppendColumn(block.ranks.data(), ins_num, &buffer_);
+  }
+  for (int i = 0; i < uint64_slot_num_; ++i) {
+    auto& column = slots.uint64_slot(i);
+    AppendColumn(column.offsets.data(), column.offsets.size(), &buffer_);
+    AppendColumn(column.values.data(), column.values.size(), &buffer_);
+  }
+  for (int i = 0; i < float_slot_num_; ++i) {
+    auto& column = slots.float_slot(i);
+    AppendColumn(column.offsets.data(), column.offsets.size(), &buffer_);
+    AppendColumn(column.values.data(), column.values.size(), &buffer_);
+  }
+
+  SlotRecordFileBlockHeader header;
+  header.ins_num = ins_num;
+  header.flags = 0;
+  header.raw_size = buffer_.size();
+  header.reserved = 0;
+  const std::string* stored = &buffer_;
+  if (compress_) {
+    uLongf compressed_size = compressBound(buffer_.size());
+    compressed_buffer_.resize(compressed_size);
+    PADDLE_ENFORCE_EQ(
+        compress2(reinterpret_cast<Bytef*>(&compressed_buffer_[0]),
+                  &compressed_size,
+                  reinterpret_cast<const Bytef*>(buffer_.data()),
+                  buffer_.size(),
+                  Z_BEST_SPEED),
+        Z_OK,
+        platform::errors::External("Fail to compress the slot records."));
+    compressed_buffer_.resize(compressed_size);
+    header.flags |= kZlibCompressed;
+    stored = &compressed_buffer_;
+  }
+  header.stored_size = stored->size();
+  header.crc = crc32(0L,
+                     reinterpret_cast<const Bytef*>(stored->data()),
+                     stored->size());
+  PADDLE_ENFORCE_EQ(
+      fwrite(&header, sizeof(header), 1, fp_) == 1 &&
+          fwrite(stored->data(), 1, stored->size(), fp_) == stored->size(),
+      true,
+      platform::errors::Unavailable("Fail to write %s.", tmp_path_));
+}
+
+void SlotRecordFileWriter::Close() {
+  int ret = fclose(fp_);
+  fp_ = nullptr;
+  if (ret != 0 || rename(tmp_path_.c_str(), path_.c_str()) != 0) {
+    remove(tmp_path_.c_str());
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Fail to close %s and rename it to %s.", tmp_path_, path_));
+  }
+}
+
+SlotRecordFileReader::~SlotRecordFileReader() { Close(); }
+
+void SlotRecordFileReader::Close() {
+#ifndef _WIN32
+  if (data_ != nullptr && buffer_.empty()) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  pos_ = 0;
+  buffer_.clear();
+}
+
+bool SlotRecordFileReader::Open(const std::string& path,
+                                const std::string& signature) {
+  Close();
+  path_ = path;
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      madvise(data, st.st_size, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(data);
+      size_ = st.st_size;
+    }
+  }
+  close(fd);
+#endif
+  if (data_ == nullptr) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    buffer_ = ss.str();
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+
+  SlotRecordFileHeader header;
+  if (size_ < sizeof(header)) {
+    Close();
+    return false;
+  }
+  memcpy(&header, data_, sizeof(header));
+  if (memcmp(header.magic, kSlotRecordFileMagic, sizeof(header.magic)) != 0 ||
+      header.version != kSlotRecordFileVersion ||
+      header.signature_size != signature.size() ||
+      size_ < sizeof(header) + signature.size() ||
+      memcmp(data_ + sizeof(header), signature.data(), signature.size()) !=
+          0) {
+    VLOG(3) << "The slot record file " << path << " is stale.";
+    Close();
+    return false;
+  }
+  uint64_slot_num_ = header.uint64_slot_num;
+  float_slot_num_ = header.float_slot_num;
+  has_ins_id_ = header.flags & kHasInsId;
+  has_log_key_ = header.flags & kHasLogKey;
+  pos_ = sizeof(header) + signature.size();
+  return true;
+}
+
+// The column at *pos of [data, data + size), which has num elements of T if
+// num is not 0.
+template <typename T>
+static const T* ReadColumn(const char* data,
+                           size_t size,
+                           size_t* pos,
+                           size_t* num,
+                           const std::string& path) {
+  uint64_t column_size = 0;
+  PADDLE_ENFORCE_LE(*pos + sizeof(column_size),
+                    size,
+                    platform::errors::InvalidArgument(
+                        "The slot record file %s is corrupted.", path));
+  memcpy(&column_size, data + *pos, sizeof(column_size));
+  *pos += sizeof(column_size);
+  PADDLE_ENFORCE_EQ(
+      column_size <= size - *pos && column_size % sizeof(T) == 0 &&
+          (*num == 0 || column_size == *num * sizeof(T)),
+      true,
+      platform::errors::InvalidArgument(
+          "The slot record file %s is corrupted.", path));
+  const T* column = reinterpret_cast<const T*>(data + *pos);
+  *pos += column_size;
+  *num = column_size / sizeof(T);
+  return column;
+}
+
+template <typename T>
+static void ReadSlotColumn(const char* data,
+                           size_t size,
+                           size_t* pos,
+                           size_t ins_num,
+                           const std::string& path,
+                           SlotColumn<T>* column) {
+  size_t num = ins_num + 1;
+  const uint32_t* offsets =
+      ReadColumn<uint32_t>(data, size, pos, &num, path);
+  num = 0;
+  const T* values = ReadColumn<T>(data, size, pos, &num, path);
+  // the columns are unaligned in the file, so they are only read by memcpy
+  column->offsets.resize(ins_num + 1);
+  memcpy(column->offsets.data(), offsets, (ins_num + 1) * sizeof(uint32_t));
+  PADDLE_ENFORCE_EQ(
+      column->offsets[0] == 0 && column->offsets[ins_num] == num,
+      true,
+      platform::errors::InvalidArgument(
+          "The slot record file %s is corrupted.", path));
+  column->values.resize(num);
+  memcpy(column->values.data(), values, num * sizeof(T));
+}
+
+bool SlotRecordFileReader::Next(SlotRecordFileBlock* block) {
+  if (data_ == nullptr || pos_ == size_) {
+    return false;
+  }
+  SlotRecordFileBlockHeader header;
+  PADDLE_ENFORCE_LE(pos_ + sizeof(header),
+                    size_,
+                    platform::errors::InvalidArgument(
+                        "The slot record file %s is corrupted.", path_));
+  memcpy(&header, data_ + pos_, sizeof(header));
+  pos_ += sizeof(header);
+  PADDLE_ENFORCE_EQ(
+      header.stored_size <= size_ - pos_ &&
+          crc32(0L,
+                reinterpret_cast<const Bytef*>(data_ + pos_),
+                header.stored_size) == header.crc,
+      true,
+      platform::errors::InvalidArgument(
+          "The slot record file %s is corrupted.", path_));
+  const char* raw = data_ + pos_;
+  pos_ += header.stored_size;
+  if (header.flags & kZlibCompressed) {
+    decompressed_buffer_.resize(header.raw_size);
+    uLongf raw_size = header.raw_size;
+    PADDLE_ENFORCE_EQ(
+        uncompress(reinterpret_cast<Bytef*>(&decompressed_buffer_[0]),
+                   &raw_size,
+                   reinterpret_cast<const Bytef*>(raw),
+                   header.stored_size) == Z_OK &&
+            raw_size == header.raw_size,
+        true,
+        platform::errors::InvalidArgument(
+            "The slot record file %s is corrupted.", path_));
+    raw = decompressed_buffer_.data();
+  } else {
+    PADDLE_ENFORCE_EQ(header.raw_size,
+                      header.stored_size,
+                      platform::errors::InvalidArgument(
+                          "The slot record file %s is corrupted.", path_));
+  }
+
+  size_t ins_num = header.ins_num;
+  size_t size = header.raw_size;
+  size_t pos = 0;
+  *block = SlotRecordFileBlock(uint64_slot_num_, float_slot_num_);
+  if (has_ins_id_) {
+    size_t num = ins_num;
+    const uint32_t* lengths =
+        ReadColumn<uint32_t>(raw, size, &pos, &num, path_);
+    num = 0;
+    const char* ins_ids = ReadColumn<char>(raw, size, &pos, &num, path_);
+    block->ins_ids.resize(ins_num);
+    size_t offset = 0;
+    for (size_t i = 0; i < ins_num; ++i) {
+      uint32_t length = 0;
+      memcpy(&length, lengths + i, sizeof(length));
+      PADDLE_ENFORCE_LE(offset + length,
+                        num,
+                        platform::errors::InvalidArgument(
+                            "The slot record file %s is corrupted.", path_));
+      block->ins_ids[i].assign(ins_ids + offset, length);
+      offset += length;
+    }
+  }
+  if (has_log_key_) {
+    size_t num = ins_num;
+    const uint64_t* search_ids =
+        ReadColumn<uint64_t>(raw, size, &pos, &num, path_);
+    block->search_ids.resize(ins_num);
+    memcpy(block->search_ids.data(), search_ids, ins_num * sizeof(uint64_t));
+    const uint32_t* cmatches =
+        ReadColumn<uint32_t>(raw, size, &pos, &num, path_);
+    block->cmatches.resize(ins_num);
+    memcpy(block->cmatches.data(), cmatches, ins_num * sizeof(uint32_t));
+    const uint32_t* ranks = ReadColumn<uint32_t>(raw, size, &pos, &num, path_);
+    block->ranks.resize(ins_num);
+    memcpy(block->ranks.data(), ranks, ins_num * sizeof(uint32_t));
+  }
+  for (int i = 0; i < uint64_slot_num_; ++i) {
+    ReadSlotColumn(raw,
+                   size,
+                   &pos,
+                   ins_num,
+                   path_,
+                   block->slots->mutable_uint64_slot(i));
+  }
+  for (int i = 0; i < float_slot_num_; ++i) {
+    ReadSlotColumn(
+        raw, size, &pos, ins_num, path_, block->slots->mutable_float_slot(i));
+  }
+  PADDLE_ENFORCE_EQ(pos,
+                    size,
+                    platform::errors::InvalidArgument(
+                        "The slot record file %s is corrupted.", path_));
+  block->slots->set_ins_num(ins_num);
+  return true;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,121 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/slot_record_block.h"
+
+namespace paddle {
+namespace framework {
+
+// The instances of a block in a slot record file.
+struct SlotRecordFileBlock {
+  SlotRecordFileBlock(int uint64_slot_num, int float_slot_num)
+      : slots(std::make_shared<SlotRecordBlock>(uint64_slot_num,
+                                                float_slot_num)) {}
+
+  size_t ins_num() const { return slots->ins_num(); }
+
+  // empty if the file has no ins ids
+  std::vector<std::string> ins_ids;
+  // empty if the file has no log keys
+  std::vector<uint64_t> search_ids;
+  std::vector<uint32_t> cmatches;
+  std::vector<uint32_t> ranks;
+  std::shared_ptr<SlotRecordBlock> slots;
+};
+
+// A slot record file keeps the instances parsed from a data file in binary
+// blocks, so that the data file is loaded again without the pipe command and
+// the text parser. The file is the header and the blocks:
+//
+//   header: magic, version, flags, uint64 and float slot numbers, signature
+//   block:  instance number, flags, raw size, stored size, crc32, columns
+//
+// A block is the columns, each of which is the byte length followed by the
+// bytes: the ins ids and the log keys if the file has them, then the offsets
+// and the values of every uint64 slot and every float slot. The columns are
+// compressed by zlib if the file is compressed. The signature is what the
+// instances are parsed with, e.g. the data file, the pipe command and the
+// slots, a file of another signature is stale.
+class SlotRecordFileWriter {
+ public:
+  // The file is written to a temporary file and renamed to path on Close, so
+  // that a file at path is always complete.
+  SlotRecordFileWriter(const std::string& path,
+                       const std::string& signature,
+                       int uint64_slot_num,
+                       int float_slot_num,
+                       bool has_ins_id,
+                       bool has_log_key,
+                       bool compress);
+  // Discard the file if it is not closed.
+  ~SlotRecordFileWriter();
+
+  void Write(const SlotRecordFileBlock& block);
+  void Close();
+
+ private:
+  std::string path_;
+  std::string tmp_path_;
+  FILE* fp_;
+  int uint64_slot_num_;
+  int float_slot_num_;
+  bool has_ins_id_;
+  bool has_log_key_;
+  bool compress_;
+  std::string buffer_;
+  std::string compressed_buffer_;
+};
+
+class SlotRecordFileReader {
+ public:
+  SlotRecordFileReader() = default;
+  ~SlotRecordFileReader();
+
+  // Map the file at path, returns false if there is no such file or the file
+  // is stale, i.e. of another version or signature.
+  bool Open(const std::string& path, const std::string& signature);
+  // Read the next block into block, returns false at the end of the file.
+  bool Next(SlotRecordFileBlock* block);
+  // Unmap the file.
+  void Close();
+
+  int uint64_slot_num() const { return uint64_slot_num_; }
+  int float_slot_num() const { return float_slot_num_; }
+  bool has_ins_id() const { return has_ins_id_; }
+  bool has_log_key() const { return has_log_key_; }
+
+ private:
+  std::string path_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  // the buffer of the file if it can not be mapped
+  std::string buffer_;
+  std::string decompressed_buffer_;
+  int uint64_slot_num_ = 0;
+  int float_slot_num_ = 0;
+  bool has_ins_id_ = false;
+  bool has_log_key_ = false;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,151 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/slot_record_file.h"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+static SlotRecordFileBlock MakeBlock(int ins_num, int seed) {
+  SlotRecordFileBlock block(3, 2);
+  std::mt19937 rng(seed);
+  for (int i = 0; i < ins_num; ++i) {
+    block.ins_ids.push_back("ins_" + std::to_string(rng() % 100000));
+    block.search_ids.push_back(rng());
+    block.cmatches.push_back(rng() % 1000);
+    block.ranks.push_back(rng() % 100);
+    std::vector<std::vector<uint64_t>> uint64_feasigns(3);
+    std::vector<std::vector<float>> float_feasigns(2);
+    for (auto& feasigns : uint64_feasigns) {
+      feasigns.resize(rng() % 5);
+      for (auto& feasign : feasigns) {
+        feasign = (static_cast<uint64_t>(rng()) << 32) | rng();
+      }
+    }
+    for (auto& feasigns : float_feasigns) {
+      feasigns.resize(rng() % 3);
+      for (auto& feasign : feasigns) {
+        feasign = static_cast<float>(rng()) / 1000.0f;
+      }
+    }
+    block.slots->AddInstance(uint64_feasigns, float_feasigns);
+  }
+  return block;
+}
+
+static void ExpectSameBlock(const SlotRecordFileBlock& block,
+                            const SlotRecordFileBlock& expected,
+                            bool has_log_key) {
+  ASSERT_EQ(block.ins_num(), expected.ins_num());
+  EXPECT_EQ(block.ins_ids, expected.ins_ids);
+  if (has_log_key) {
+    EXPECT_EQ(block.search_ids, expected.search_ids);
+    EXPECT_EQ(block.cmatches, expected.cmatches);
+    EXPECT_EQ(block.ranks, expected.ranks);
+  } else {
+    EXPECT_TRUE(block.search_ids.empty());
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(block.slots->uint64_slot(i).offsets,
+              expected.slots->uint64_slot(i).offsets);
+    EXPECT_EQ(block.slots->uint64_slot(i).values,
+              expected.slots->uint64_slot(i).values);
+  }
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(block.slots->float_slot(i).offsets,
+              expected.slots->float_slot(i).offsets);
+    EXPECT_EQ(block.slots->float_slot(i).values,
+              expected.slots->float_slot(i).values);
+  }
+}
+
+static void TestRoundTrip(bool has_log_key, bool compress) {
+  std::string path = "slot_record_file_test.slotrecord";
+  std::vector<SlotRecordFileBlock> blocks;
+  blocks.push_back(MakeBlock(1000, 0));
+  blocks.push_back(MakeBlock(0, 1));
+  blocks.push_back(MakeBlock(17, 2));
+  {
+    SlotRecordFileWriter writer(
+        path, "signature", 3, 2, true, has_log_key, compress);
+    for (auto& block : blocks) {
+      writer.Write(block);
+    }
+    writer.Close();
+  }
+
+  SlotRecordFileReader reader;
+  ASSERT_FALSE(reader.Open(path, "another signature"));
+  ASSERT_TRUE(reader.Open(path, "signature"));
+  ASSERT_EQ(reader.uint64_slot_num(), 3);
+  ASSERT_EQ(reader.float_slot_num(), 2);
+  ASSERT_TRUE(reader.has_ins_id());
+  ASSERT_EQ(reader.has_log_key(), has_log_key);
+  SlotRecordFileBlock block(3, 2);
+  for (auto& expected : blocks) {
+    ASSERT_TRUE(reader.Next(&block));
+    ExpectSameBlock(block, expected, has_log_key);
+  }
+  ASSERT_FALSE(reader.Next(&block));
+  std::remove(path.c_str());
+}
+
+TEST(SlotRecordFile, RoundTrip) {
+  TestRoundTrip(false, false);
+  TestRoundTrip(true, false);
+  TestRoundTrip(true, true);
+}
+
+TEST(SlotRecordFile, Incomplete) {
+  std::string path = "slot_record_file_test_incomplete.slotrecord";
+  {
+    SlotRecordFileWriter writer(path, "signature", 3, 2, true, true, false);
+    writer.Write(MakeBlock(10, 0));
+  }
+  // the file is discarded without Close
+  SlotRecordFileReader reader;
+  ASSERT_FALSE(reader.Open(path, "signature"));
+}
+
+TEST(SlotRecordFile, Corrupted) {
+  std::string path = "slot_record_file_test_corrupted.slotrecord";
+  {
+    SlotRecordFileWriter writer(path, "signature", 3, 2, true, true, true);
+    writer.Write(MakeBlock(100, 0));
+    writer.Close();
+  }
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(-10, std::ios::end);
+    char c = static_cast<char>(file.get());
+    file.seekp(-10, std::ios::end);
+    file.put(static_cast<char>(c ^ 0x5a));
+  }
+  SlotRecordFileReader reader;
+  ASSERT_TRUE(reader.Open(path, "signature"));
+  SlotRecordFileBlock block(3, 2);
+  ASSERT_ANY_THROW(reader.Next(&block));
+  std::remove(path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,192 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// The parsing of the numbers and the tokens in the MultiSlot text format, in
+// which a line is the slots separated by spaces and a slot is the number of
+// its values followed by the values. The numbers are parsed exactly as
+// strtoull and strtof parse them, but the common forms, i.e. at most 19
+// decimal digits and the floats without exponents that are exact in single
+// precision, are parsed without them.
+//
+// All the functions take the line [str, end) with *end == '\0', which is
+// what std::string::c_str() gives, and never read beyond end.
+
+namespace paddle {
+namespace framework {
+
+namespace slot_text_parser_internal {
+
+inline bool IsDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+// the same characters as isspace in the "C" locale
+inline bool IsSpace(char c) {
+  return c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+}
+
+inline const char* SkipSpaces(const char* str) {
+  while (IsSpace(*str)) {
+    ++str;
+  }
+  return str;
+}
+
+// Parse 8 digits at once if the next 8 characters are digits.
+inline bool ParseEightDigits(const char* str,
+                             const char* end,
+                             uint64_t* value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (end - str < 8) {
+    return false;
+  }
+  uint64_t chars = 0;
+  memcpy(&chars, str, sizeof(chars));
+  // every byte is in ['0', '9'] if its high nibble is 3 and adding 6 to it
+  // does not carry into the high nibble
+  if ((chars & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL ||
+      ((chars + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) !=
+          0x3030303030303030ULL) {
+    return false;
+  }
+  chars -= 0x3030303030303030ULL;
+  // combine the adjacent digits, then the pairs, then the quads
+  chars = (chars * 10) + (chars >> 8);
+  constexpr uint64_t kMask = 0x000000FF000000FFULL;
+  chars = (((chars & kMask) * (100 + (1000000ULL << 32))) +
+           (((chars >> 16) & kMask) * (1 + (10000ULL << 32)))) >>
+          32;
+  *value = *value * 100000000ULL + chars;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Parse the decimal digits from str into value and return the number of
+// them, at most max_digits + 1 digits are consumed.
+inline int ParseDigits(const char* str,
+                       const char* end,
+                       int max_digits,
+                       uint64_t* value) {
+  int num = 0;
+  while (num + 8 <= max_digits && ParseEightDigits(str + num, end, value)) {
+    num += 8;
+  }
+  while (num <= max_digits && IsDigit(str[num])) {
+    *value = *value * 10 + (str[num] - '0');
+    ++num;
+  }
+  return num;
+}
+
+}  // namespace slot_text_parser_internal
+
+// The same as strtoull(str, endptr, 10).
+inline uint64_t ParseUint64(const char* str, const char* end, char** endptr) {
+  namespace internal = slot_text_parser_internal;
+  const char* ptr = internal::SkipSpaces(str);
+  uint64_t value = 0;
+  // 19 digits never overflow
+  int num = internal::ParseDigits(ptr, end, 19, &value);
+  if (num == 0 || num > 19) {
+    // signs, no digits and overflows
+    return strtoull(str, endptr, 10);
+  }
+  *endptr = const_cast<char*>(ptr + num);
+  return value;
+}
+
+// The same as strtof(str, endptr) in the "C" locale.
+inline float ParseFloat(const char* str, const char* end, char** endptr) {
+  namespace internal = slot_text_parser_internal;
+  // the powers of 10 exact in single precision
+  static constexpr float kExactPowersOf10[] = {
+      1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+  constexpr uint64_t kMaxExactInteger = 1ULL << 24;
+  constexpr int kMaxExactPower = 10;
+
+  const char* ptr = internal::SkipSpaces(str);
+  bool negative = *ptr == '-';
+  if (*ptr == '-' || *ptr == '+') {
+    ++ptr;
+  }
+  uint64_t mantissa = 0;
+  int int_num = internal::ParseDigits(ptr, end, 19, &mantissa);
+  ptr += int_num;
+  int frac_num = 0;
+  if (*ptr == '.') {
+    ++ptr;
+    frac_num = internal::ParseDigits(ptr, end, 19 - int_num, &mantissa);
+    ptr += frac_num;
+  }
+  // the integer of the significant digits and the power of 10 dividing it
+  // are exact, so is the quotient after the only rounding of the division
+  if (int_num + frac_num == 0 || int_num + frac_num > 19 || *ptr == 'e' ||
+      *ptr == 'E' || *ptr == 'x' || *ptr == 'X') {
+    // no digits, hexadecimal, exponents, infinities, nans and too many digits
+    return strtof(str, endptr);
+  }
+  while (frac_num > kMaxExactPower && mantissa % 10 == 0) {
+    mantissa /= 10;
+    --frac_num;
+  }
+  if (mantissa > kMaxExactInteger || frac_num > kMaxExactPower) {
+    return strtof(str, endptr);
+  }
+  float value = static_cast<float>(mantissa) / kExactPowersOf10[frac_num];
+  *endptr = const_cast<char*>(ptr);
+  return negative ? -value : value;
+}
+
+// Return the n-th space from str, or end if there are less than n spaces.
+inline const char* FindSpace(const char* str, const char* end, int n) {
+  if (n <= 0) {
+    return str;
+  }
+#if defined(__SSE2__)
+  const __m128i spaces = _mm_set1_epi8(' ');
+  while (end - str >= 16) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+    unsigned mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chars, spaces)));
+    int count = __builtin_popcount(mask);
+    if (count >= n) {
+      for (int i = 1; i < n; ++i) {
+        mask &= mask - 1;
+      }
+      return str + __builtin_ctz(mask);
+    }
+    n -= count;
+    str += 16;
+  }
+#endif
+  for (; str < end; ++str) {
+    if (*str == ' ' && --n == 0) {
+      return str;
+    }
+  }
+  return end;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,229 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/slot_text_parser.h"
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+// run with --slot_text_bench_lines=1000000 for the full benchmark
+DEFINE_int32(slot_text_bench_lines,
+             20000,
+             "number of lines in the synthetic multi-slot file");
+
+namespace paddle {
+namespace framework {
+
+static void ExpectSameAsStrtoull(const std::string& str) {
+  char* expected_end = nullptr;
+  char* end = nullptr;
+  uint64_t expected = strtoull(str.c_str(), &expected_end, 10);
+  EXPECT_EQ(ParseUint64(str.c_str(), str.c_str() + str.size(), &end),
+            expected)
+      << str;
+  EXPECT_EQ(end, expected_end) << str;
+}
+
+static void ExpectSameAsStrtof(const std::string& str) {
+  char* expected_end = nullptr;
+  char* end = nullptr;
+  float expected = strtof(str.c_str(), &expected_end);
+  float value = ParseFloat(str.c_str(), str.c_str() + str.size(), &end);
+  if (std::isnan(expected)) {
+    EXPECT_TRUE(std::isnan(value)) << str;
+  } else {
+    // the same bits, which tells 0 from -0
+    EXPECT_EQ(memcmp(&value, &expected, sizeof(float)), 0)
+        << str << ": " << value << " vs " << expected;
+  }
+  EXPECT_EQ(end, expected_end) << str;
+}
+
+TEST(SlotTextParser, ParseUint64) {
+  for (const char* str : {"",
+                          " ",
+                          "0",
+                          "7",
+                          "007",
+                          " \t42 ",
+                          "+5",
+                          "-1",
+                          "12a",
+                          "abc",
+                          "12345678",
+                          "123456781234",
+                          "9999999999999999999",
+                          "18446744073709551615",
+                          "18446744073709551616",
+                          "99999999999999999999"}) {
+    ExpectSameAsStrtoull(str);
+  }
+  std::mt19937_64 rng(0);
+  for (int i = 0; i < 100000; ++i) {
+    ExpectSameAsStrtoull(std::to_string(rng() >> (rng() % 64)) + " 1");
+  }
+}
+
+TEST(SlotTextParser, ParseFloat) {
+  for (const char* str : {"",
+                          ".",
+                          "-",
+                          "0",
+                          "-0",
+                          "-0.0",
+                          "1.",
+                          ".5",
+                          "+2.5",
+                          "0.1",
+                          "3.14159265358979",
+                          "16777216",
+                          "16777217",
+                          "0.00000000001",
+                          "1.00000000000000000000",
+                          "1.5.3",
+                          "1e5",
+                          "1E-3",
+                          "0x1p3",
+                          "inf",
+                          "-nan"}) {
+    ExpectSameAsStrtof(str);
+  }
+  std::mt19937_64 rng(0);
+  char buf[64];
+  for (int i = 0; i < 100000; ++i) {
+    double value = static_cast<double>(rng() % 100000000) /
+                   std::pow(10.0, static_cast<int>(rng() % 12));
+    snprintf(buf, sizeof(buf), "%.*f", static_cast<int>(rng() % 12), value);
+    ExpectSameAsStrtof(buf);
+    snprintf(buf, sizeof(buf), "%.9g", -value);
+    ExpectSameAsStrtof(buf);
+  }
+}
+
+TEST(SlotTextParser, FindSpace) {
+  std::mt19937 rng(0);
+  for (int i = 0; i < 10000; ++i) {
+    std::string line;
+    int length = rng() % 80;
+    for (int j = 0; j < length; ++j) {
+      line.push_back(rng() % 4 == 0 ? ' ' : '1');
+    }
+    const char* str = line.c_str();
+    const char* end = str + line.size();
+    int n = rng() % 10;
+    size_t expected = 0;
+    for (int j = 0; j < n; ++j) {
+      expected = line.find(' ', j == 0 ? 0 : expected + 1);
+      if (expected == std::string::npos) {
+        expected = line.size();
+        break;
+      }
+    }
+    ASSERT_EQ(FindSpace(str, end, n) - str, static_cast<int64_t>(expected));
+  }
+}
+
+// The lines of 100 slots of 1 to 10 values, like the ctr samples, a tenth of
+// them are float slots.
+static std::string WriteMultiSlotFile(int line_num) {
+  std::string filename = "slot_text_parser_test_data.txt";
+  std::ofstream file(filename);
+  std::mt19937_64 rng(0);
+  for (int i = 0; i < line_num; ++i) {
+    for (int slot = 0; slot < 100; ++slot) {
+      int num = rng() % 10 + 1;
+      file << (slot == 0 ? "" : " ") << num;
+      for (int j = 0; j < num; ++j) {
+        if (slot % 10 == 0) {
+          file << " " << (rng() % 1000000) / 1000.0;
+        } else {
+          file << " " << (rng() >> 1);
+        }
+      }
+    }
+    file << "\n";
+  }
+  return filename;
+}
+
+template <typename ParseUint64Func, typename ParseFloatFunc>
+static uint64_t ParseMultiSlotLine(const std::string& line,
+                                   ParseUint64Func parse_uint64,
+                                   ParseFloatFunc parse_float) {
+  const char* str = line.c_str();
+  const char* end = str + line.size();
+  char* endptr = const_cast<char*>(str);
+  uint64_t checksum = 0;
+  for (int slot = 0; slot < 100; ++slot) {
+    int num = static_cast<int>(parse_uint64(endptr, end, &endptr));
+    for (int j = 0; j < num; ++j) {
+      if (slot % 10 == 0) {
+        checksum += static_cast<uint64_t>(parse_float(endptr, end, &endptr));
+      } else {
+        checksum += parse_uint64(endptr, end, &endptr);
+      }
+    }
+  }
+  return checksum;
+}
+
+TEST(SlotTextParser, ParseThroughput) {
+  std::string filename = WriteMultiSlotFile(FLAGS_slot_text_bench_lines);
+  std::vector<std::string> lines;
+  size_t bytes = 0;
+  std::ifstream file(filename);
+  for (std::string line; std::getline(file, line);) {
+    bytes += line.size() + 1;
+    lines.emplace_back(std::move(line));
+  }
+  std::remove(filename.c_str());
+
+  auto benchmark = [&lines, bytes](const char* name,
+                                   auto parse_uint64,
+                                   auto parse_float) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (auto& line : lines) {
+      checksum += ParseMultiSlotLine(line, parse_uint64, parse_float);
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    LOG(INFO) << name << ": " << bytes / seconds / (1 << 20) << " MB/s, "
+              << lines.size() / seconds << " lines/s";
+    return checksum;
+  };
+  uint64_t expected = benchmark(
+      "strtoull and strtof",
+      [](const char* str, const char* end, char** endptr) {
+        return static_cast<uint64_t>(strtoull(str, endptr, 10));
+      },
+      [](const char* str, const char* end, char** endptr) {
+        return strtof(str, endptr);
+      });
+  uint64_t checksum = benchmark("slot text parser", ParseUint64, ParseFloat);
+  ASSERT_EQ(checksum, expected);
+}
+
+}  // namespace framework
+}  // namespace paddle
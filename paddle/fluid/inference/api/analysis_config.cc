@@ -433,6 +433,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
                                   // params_file_ fields.
   CP_MEMBER(save_optimized_model_);
   CP_MEMBER(opt_cache_dir_);
+  CP_MEMBER(optim_program_cache_);
+  CP_MEMBER(optim_program_cache_capacity_);
   CP_MEMBER(prog_file_);
   CP_MEMBER(params_file_);
 
@@ -453,6 +455,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(enable_low_precision_io_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(mmap_params_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -538,6 +541,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(specify_input_name_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
+  CP_MEMBER(cpu_huge_page_);
+  CP_MEMBER(cpu_numa_aware_allocation_);
 
   CP_MEMBER(serialized_info_cache_);
 
@@ -1061,6 +1066,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << mmap_params_;
   ss << trt_engine_memory_sharing_;
 
   ss << use_mkldnn_;
@@ -1087,6 +1093,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
+  ss << cpu_huge_page_;
+  ss << cpu_numa_aware_allocation_;
 
   ss << use_lite_;
   ss << use_xpu_;
@@ -1142,6 +1150,16 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::EnableCpuHugePage(bool explicit_huge_page) {
+  cpu_huge_page_ = explicit_huge_page ? "explicit" : "transparent";
+  Update();
+}
+
+void AnalysisConfig::EnableCpuNumaAwareAllocation(bool x) {
+  cpu_numa_aware_allocation_ = x;
+  Update();
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   // Get the GPU memory details and calculate the fraction of memory for the
@@ -1258,6 +1276,9 @@ std::string AnalysisConfig::Summary() {
   // cpu info
   os.InsertRow(
       {"cpu_math_thread", std::to_string(cpu_math_library_num_threads_)});
+  os.InsertRow({"cpu_huge_page", cpu_huge_page_});
+  os.InsertRow({"cpu_numa_aware_allocation",
+                cpu_numa_aware_allocation_ ? "true" : "false"});
   os.InsertRow({"enable_mkldnn", use_mkldnn_ ? "true" : "false"});
   os.InsertRow(
       {"mkldnn_cache_capacity", std::to_string(mkldnn_cache_capacity_)});
@@ -1400,9 +1421,14 @@ std::string AnalysisConfig::Summary() {
   // ir info
   os.InsertRow(
       {"save_optimized_model", save_optimized_model_ ? "true" : "false"});
+  os.InsertRow({"optim_program_cache",
+                optim_program_cache_
+                    ? std::to_string(optim_program_cache_capacity_)
+                    : "false"});
   os.InsertRow({"ir_optim", enable_ir_optim_ ? "true" : "false"});
   os.InsertRow({"ir_debug", ir_debug_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  os.InsertRow({"mmap_params", mmap_params_ ? "true" : "false"});
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
@@ -21,6 +21,7 @@
 #include <fstream>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -43,11 +44,13 @@
 #include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/infer_context.h"
+#include "paddle/fluid/inference/api/optim_program_cache.h"
 #include "paddle/fluid/inference/api/paddle_analysis_config.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
 #include "paddle/fluid/inference/api/resource_manager.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
+#include "paddle/fluid/inference/utils/mmap_params.h"
 #include "paddle/fluid/inference/utils/model_utils.h"
 #include "paddle/fluid/inference/utils/singleton.h"
 #include "paddle/fluid/memory/memcpy.h"
@@ -57,6 +60,7 @@
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/phi/api/include/tensor.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
 #include "paddle/phi/common/backend.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/common/place.h"
@@ -1365,6 +1369,7 @@ void AnalysisPredictor::PrepareArgument() {
     argument_->SetModelProgramPath(config_.prog_file());
     argument_->SetModelParamsPath(config_.params_file());
   }
+  argument_->SetMmapParams(config_.mmap_params_);
   // For JITLayer
   argument_->SetSkipLoadParams(config_.skip_load_params_);
 
@@ -1623,6 +1628,62 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
             << inference::tensorrt::TensorRTEngine::predictor_id_per_thread;
   }
 #endif
+  std::string cache_key;
+  auto program_cache = CreateOptimProgramCache(&cache_key);
+  framework::proto::ProgramDesc cached_program;
+  inference::OptimProgramCache::ReuseTable reuse_table;
+  if (program_cache && program_cache->Load(cache_key,
+                                           config_.mmap_params_,
+                                           &cached_program,
+                                           &reuse_table,
+                                           scope_.get())) {
+    LOG(INFO) << "Load the optimized program from the cache, the analysis "
+                 "passes are skipped.";
+    optim_program_cache_hit_ = true;
+    inference_program_.reset(new framework::ProgramDesc(cached_program));
+    if (config_.enable_memory_optim_) {
+      inference::analysis::PassResultInfoForRuntime::Instance()->Set(
+          root_predictor_id_, "memory_optimize_pass", reuse_table);
+    }
+    // the persistable variables created by the passes
+    executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+  } else {
+    RunAnalysis();
+    if (program_cache) {
+      if (config_.enable_memory_optim_) {
+        reuse_table =
+            inference::analysis::PassResultInfoForRuntime::Instance()
+                ->Get<inference::OptimProgramCache::ReuseTable>(
+                    root_predictor_id_, "memory_optimize_pass");
+      }
+      program_cache->Save(cache_key,
+                          argument_->ir_analyzed_program(),
+                          reuse_table,
+                          scope_.get());
+    }
+  }
+  // The config and argument take a lot of storage,
+  // when the predictor settings are complete, we release these stores.
+  config_.PartiallyRelease();
+#if defined(PADDLE_WITH_TESTING)
+  fusion_statis_ = *argument_->fusion_statis_ptr();
+#endif
+
+#if defined(_WIN32)
+  argument_->PartiallyRelease();
+#else
+  if (config_.mkldnn_enabled() ||
+      (config_.tensorrt_engine_enabled() &&
+       config_.tensorrt_precision_mode_ == AnalysisConfig::Precision::kInt8)) {
+    argument_->PartiallyRelease();
+  } else {
+    argument_.reset(nullptr);
+  }
+#endif
+  LOG(INFO) << "======= optimize end =======";
+}
+
+void AnalysisPredictor::RunAnalysis() {
   Analyzer().Run(argument_.get());
   PADDLE_ENFORCE_EQ(
       argument_->scope_valid(),
@@ -1657,25 +1718,81 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
 #endif
         delete prog;
       });
-  // The config and argument take a lot of storage,
-  // when the predictor settings are complete, we release these stores.
-  config_.PartiallyRelease();
-#if defined(PADDLE_WITH_TESTING)
-  fusion_statis_ = *argument_->fusion_statis_ptr();
-#endif
+}
 
-#if defined(_WIN32)
-  argument_->PartiallyRelease();
-#else
-  if (config_.mkldnn_enabled() ||
-      (config_.tensorrt_engine_enabled() &&
-       config_.tensorrt_precision_mode_ == AnalysisConfig::Precision::kInt8)) {
-    argument_->PartiallyRelease();
-  } else {
-    argument_.reset(nullptr);
+std::unique_ptr<inference::OptimProgramCache>
+AnalysisPredictor::CreateOptimProgramCache(std::string *key) {
+  // the programs of the other places hold the device resources, such as the
+  // engines of the subgraphs, which can not be cached
+  if (!config_.optim_program_cache_ || config_.skip_load_params_ ||
+      !platform::is_cpu_place(place_) || config_.lite_engine_enabled() ||
+      config_.dlnne_enabled() || config_.mkldnn_quantizer_enabled()) {
+    return nullptr;
   }
-#endif
-  LOG(INFO) << "======= optimize end =======";
+
+  std::stringstream ss;
+  ss << paddle::get_version() << ";";
+  ss << config_.SerializeInfoCache() << ";";
+  for (auto &pass : argument_->analysis_passes()) ss << pass << ",";
+  ss << ";";
+  for (auto &pass : argument_->ir_analysis_passes()) ss << pass << ",";
+  ss << ";";
+  // the passes and kernels chosen by the CPU ISA
+  using phi::backends::cpu::cpu_isa_t;
+  for (auto isa : {cpu_isa_t::sse42,
+                   cpu_isa_t::avx,
+                   cpu_isa_t::avx2,
+                   cpu_isa_t::avx512f,
+                   cpu_isa_t::avx512_core,
+                   cpu_isa_t::avx512_core_vnni,
+                   cpu_isa_t::avx512_bf16}) {
+    ss << phi::backends::cpu::MayIUse(isa);
+  }
+  ss << ";";
+
+  // the models from memory are in the config
+  std::string model_root;
+  if (!config_.model_from_memory()) {
+    std::vector<std::string> model_files;
+    if (!config_.model_dir().empty()) {
+      model_root = config_.model_dir();
+      model_files.push_back(model_root + "/__model__");
+      for (auto *var : inference_program_->Block(0).AllVars()) {
+        if (IsPersistable(var)) {
+          model_files.push_back(model_root + "/" + var->Name());
+        }
+      }
+    } else {
+      model_root = inference::analysis::GetDirRoot(config_.prog_file());
+      model_files.push_back(config_.prog_file());
+      model_files.push_back(config_.params_file());
+    }
+    for (auto &file : model_files) {
+      std::string hash = inference::HashFileContent(file);
+      if (hash.empty()) {
+        LOG(WARNING) << "Can not read the model file " << file
+                     << ", the cache of the optimized programs is not used.";
+        return nullptr;
+      }
+      ss << hash << ",";
+    }
+  }
+
+  std::string cache_dir = config_.opt_cache_dir_;
+  if (cache_dir.empty() && !model_root.empty()) {
+    cache_dir = model_root + "/_opt_cache";
+  }
+  if (cache_dir.empty() ||
+      (!inference::analysis::PathExists(cache_dir) &&
+       MKDIR(cache_dir.c_str()) == -1)) {
+    LOG(WARNING) << "Can not create the optimization cache directory "
+                 << cache_dir
+                 << ", the cache of the optimized programs is not used.";
+    return nullptr;
+  }
+  *key = inference::HashString(ss.str());
+  return std::make_unique<inference::OptimProgramCache>(
+      cache_dir, std::max(config_.optim_program_cache_capacity_, 1));
 }
 
 template <>
@@ -1712,6 +1829,14 @@ CreatePaddlePredictor<AnalysisConfig, PaddleEngineKind::kAnalysis>(
       FLAGS_minloglevel = 2;  // GLOG_ERROR
     }
 
+    // the CPU memory placement is process wide, a predictor only enables it
+    if (config.cpu_huge_page() != "none") {
+      SetGflag("cpu_huge_page", config.cpu_huge_page().c_str());
+    }
+    if (config.cpu_numa_aware_allocation_enabled()) {
+      SetGflag("cpu_numa_aware_allocation", "true");
+    }
+
     if (config.use_gpu()) {
       static std::once_flag gflags_initialized;
       static bool process_level_allocator_enabled;
@@ -2442,10 +2567,13 @@ bool AnalysisPredictor::LoadParameters() {
       new framework::ProgramDesc());
   framework::BlockDesc *load_block = load_program->MutableBlock(0);
   std::vector<std::string> params;
+  bool all_lod_tensor = true;
 
   for (auto *var : global_block->AllVars()) {
     if (IsPersistable(var)) {
       VLOG(3) << "persistable variable's name: " << var->Name();
+      all_lod_tensor = all_lod_tensor &&
+                       var->GetType() == framework::proto::VarType::LOD_TENSOR;
 
       framework::VarDesc *new_var = load_block->Var(var->Name());
       new_var->SetShape(var->GetShape());
@@ -2481,7 +2609,14 @@ bool AnalysisPredictor::LoadParameters() {
   // Use NaiveExecutor to Load parameters.
   framework::NaiveExecutor e(place_);
   e.Prepare(scope_.get(), *load_program, 0, false);
-  e.Run();
+  if (config_.mmap_params_ && !config_.params_file().empty() &&
+      !config_.model_from_memory() && all_lod_tensor &&
+      platform::is_cpu_place(place_)) {
+    inference::LoadCombinedParamsByMmap(
+        config_.params_file(), params, scope_.get(), [&e] { e.Run(); });
+  } else {
+    e.Run();
+  }
   VLOG(3) << "get " << scope_->LocalVarNames().size() << " vars after load";
 
   return true;
@@ -3120,6 +3255,11 @@ PredictorPool::PredictorPool(const Config &config, size_t size) {
       preds_.emplace_back(main_pred_->Clone());
     }
   }
+  // the last idle predictor is taken first, which is most likely warm
+  for (size_t i = preds_.size(); i > 0; --i) {
+    idle_preds_.push_back(preds_[i - 1].get());
+  }
+  idle_preds_.push_back(main_pred_.get());
 }
 
 Predictor *PredictorPool::Retrive(size_t idx) {
@@ -3135,6 +3275,39 @@ Predictor *PredictorPool::Retrive(size_t idx) {
   }
   return preds_[idx - 1].get();
 }
+
+bool PredictorPool::Run(const std::function<bool(Predictor *)> &func,
+                        bool clear_intermediate_tensor) {
+  Predictor *pred = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cond_.wait(lock, [this] { return !idle_preds_.empty(); });
+    pred = idle_preds_.back();
+    idle_preds_.pop_back();
+  }
+  // give the predictor back even if func throws
+  struct IdleGuard {
+    ~IdleGuard() {
+      // the guard may run while unwinding, where a throw would terminate
+      if (clear_intermediate_tensor) {
+        try {
+          pred->ClearIntermediateTensor();
+        } catch (const std::exception &e) {
+          LOG(ERROR) << "Fail to clear the intermediate tensors: " << e.what();
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(pool->idle_mutex_);
+        pool->idle_preds_.push_back(pred);
+      }
+      pool->idle_cond_.notify_one();
+    }
+    PredictorPool *pool;
+    Predictor *pred;
+    bool clear_intermediate_tensor;
+  } guard{this, pred, clear_intermediate_tensor};
+  return func(pred);
+}
 }  // namespace services
 
 namespace experimental {
@@ -28,6 +28,7 @@
 #include "paddle/fluid/inference/api/api_impl.h"
 #include "paddle/fluid/inference/api/details/reset_tensor_array.h"
 #include "paddle/fluid/inference/api/helper.h"
+#include "paddle/fluid/inference/api/optim_program_cache.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/resource_manager.h"
 #include "paddle/fluid/platform/device/gpu/gpu_types.h"
@@ -261,6 +262,19 @@ class AnalysisPredictor : public PaddlePredictor {
   /// to get the optimized model program
   ///
   void OptimizeInferenceProgram();
+  ///
+  /// \brief Create the cache of the optimized programs if it is turned on and
+  /// works with the config, the key of the model and the config is returned
+  /// by key.
+  ///
+  /// \return the cache, or nullptr if the cache is not used.
+  ///
+  std::unique_ptr<inference::OptimProgramCache> CreateOptimProgramCache(
+      std::string *key);
+  ///
+  /// \brief Run the analysis passes to get the optimized model program
+  ///
+  void RunAnalysis();
 
   ///
   /// \brief Clear the intermediate tensors of the predictor
@@ -494,6 +508,7 @@ class AnalysisPredictor : public PaddlePredictor {
   FRIEND_TEST(AnalysisPredictor, analysis_off);
   FRIEND_TEST(AnalysisPredictor, analysis_on);
   FRIEND_TEST(AnalysisPredictor, with_gpu);
+  FRIEND_TEST(AnalysisPredictor, optim_program_cache);
 #endif
 
  protected:
@@ -559,6 +574,8 @@ class AnalysisPredictor : public PaddlePredictor {
   AnalysisConfig config_;
   std::unique_ptr<Argument> argument_;
   Argument::fusion_statis_t fusion_statis_;
+  // Whether the optimized program is loaded from the OptimProgramCache.
+  bool optim_program_cache_hit_{false};
   std::unique_ptr<NaiveExecutor> executor_;
   platform::Place place_;
   std::shared_ptr<framework::Scope> scope_;
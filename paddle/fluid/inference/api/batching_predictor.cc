@@ -0,0 +1,424 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle_infer {
+namespace services {
+
+namespace {
+
+using paddle::PaddleTensor;
+
+size_t SizeOfDataType(DataType dtype) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return sizeof(float);
+    case DataType::FLOAT64:
+      return sizeof(double);
+    case DataType::INT64:
+      return sizeof(int64_t);
+    case DataType::INT32:
+      return sizeof(int32_t);
+    case DataType::UINT8:
+      return sizeof(uint8_t);
+    case DataType::INT8:
+      return sizeof(int8_t);
+    case DataType::BOOL:
+      return sizeof(bool);
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type (%d) in BatchingPredictor.", dtype));
+  }
+}
+
+void CopyFromCpu(Tensor* tensor, DataType dtype, const void* data) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      tensor->CopyFromCpu(static_cast<const float*>(data));
+      break;
+    case DataType::FLOAT64:
+      tensor->CopyFromCpu(static_cast<const double*>(data));
+      break;
+    case DataType::INT64:
+      tensor->CopyFromCpu(static_cast<const int64_t*>(data));
+      break;
+    case DataType::INT32:
+      tensor->CopyFromCpu(static_cast<const int32_t*>(data));
+      break;
+    case DataType::UINT8:
+      tensor->CopyFromCpu(static_cast<const uint8_t*>(data));
+      break;
+    case DataType::INT8:
+      tensor->CopyFromCpu(static_cast<const int8_t*>(data));
+      break;
+    case DataType::BOOL:
+      tensor->CopyFromCpu(static_cast<const bool*>(data));
+      break;
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type (%d) in BatchingPredictor.", dtype));
+  }
+}
+
+void CopyToCpu(const Tensor& tensor, void* data) {
+  switch (tensor.type()) {
+    case DataType::FLOAT32:
+      tensor.CopyToCpu(static_cast<float*>(data));
+      break;
+    case DataType::FLOAT64:
+      tensor.CopyToCpu(static_cast<double*>(data));
+      break;
+    case DataType::INT64:
+      tensor.CopyToCpu(static_cast<int64_t*>(data));
+      break;
+    case DataType::INT32:
+      tensor.CopyToCpu(static_cast<int32_t*>(data));
+      break;
+    case DataType::UINT8:
+      tensor.CopyToCpu(static_cast<uint8_t*>(data));
+      break;
+    case DataType::INT8:
+      tensor.CopyToCpu(static_cast<int8_t*>(data));
+      break;
+    case DataType::BOOL:
+      tensor.CopyToCpu(static_cast<bool*>(data));
+      break;
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type (%d) in BatchingPredictor.", tensor.type()));
+  }
+}
+
+size_t Numel(const std::vector<int>& shape) {
+  size_t numel = 1;
+  for (int dim : shape) {
+    numel *= dim;
+  }
+  return numel;
+}
+
+struct Request {
+  Request(const std::vector<PaddleTensor>* inputs,
+          std::vector<PaddleTensor>* outputs)
+      : inputs(inputs),
+        outputs(outputs),
+        arrival(std::chrono::steady_clock::now()) {
+    // a request is batched by the first dim, which should be the same for
+    // all the inputs
+    batchable = !inputs->empty() && !inputs->front().shape.empty();
+    for (size_t i = 0; batchable && i < inputs->size(); ++i) {
+      auto& input = (*inputs)[i];
+      if (input.shape.empty() || input.shape[0] <= 0 || !input.lod.empty() ||
+          input.shape[0] != inputs->front().shape[0]) {
+        batchable = false;
+      }
+    }
+    rows = batchable ? inputs->front().shape[0] : 1;
+  }
+
+  // whether the request can be in the same batch with other
+  bool CanBatchWith(const Request& other) const {
+    if (!batchable || !other.batchable ||
+        inputs->size() != other.inputs->size()) {
+      return false;
+    }
+    for (size_t i = 0; i < inputs->size(); ++i) {
+      auto& input = (*inputs)[i];
+      auto& other_input = (*other.inputs)[i];
+      if (input.name != other_input.name || input.dtype != other_input.dtype ||
+          !std::equal(input.shape.begin() + 1,
+                      input.shape.end(),
+                      other_input.shape.begin() + 1,
+                      other_input.shape.end())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const std::vector<PaddleTensor>* inputs;
+  std::vector<PaddleTensor>* outputs;
+  std::chrono::steady_clock::time_point arrival;
+  bool batchable;
+  int rows;
+  std::promise<bool> done;
+};
+
+}  // namespace
+
+struct BatchingPredictor::Impl {
+  Impl(const Config& config,
+       size_t max_batch_size,
+       int64_t max_wait_us,
+       size_t pool_size)
+      : pool(config, pool_size),
+        max_batch_size(max_batch_size),
+        max_wait(max_wait_us) {}
+
+  void Worker(Predictor* predictor);
+  // Take the first request and the following requests which can be in the
+  // same batch with it, up to max_batch_size rows.
+  void TakeBatch(std::vector<Request*>* batch);
+  bool RunBatch(Predictor* predictor, const std::vector<Request*>& batch);
+
+  PredictorPool pool;
+  size_t max_batch_size;
+  std::chrono::microseconds max_wait;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<Request*> queue;
+  size_t queued_rows = 0;
+  bool stop = false;
+};
+
+void BatchingPredictor::Impl::Worker(Predictor* predictor) {
+  std::vector<Request*> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this] { return stop || !queue.empty(); });
+      if (queue.empty()) {
+        return;
+      }
+      // wait for more requests until the batch is full or the first request
+      // has waited long enough
+      while (!stop && !queue.empty() && queued_rows < max_batch_size) {
+        auto deadline = queue.front()->arrival + max_wait;
+        if (cond.wait_until(lock, deadline) == std::cv_status::timeout) {
+          break;
+        }
+      }
+      // the requests are taken by the other workers
+      if (queue.empty()) {
+        continue;
+      }
+      TakeBatch(&batch);
+    }
+    // there may be requests left for the other workers
+    cond.notify_one();
+
+    bool ok = false;
+    try {
+      ok = RunBatch(predictor, batch);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "BatchingPredictor failed to run a batch of "
+                 << batch.size() << " requests: " << e.what();
+    }
+    for (auto* request : batch) {
+      request->done.set_value(ok);
+    }
+    batch.clear();
+  }
+}
+
+void BatchingPredictor::Impl::TakeBatch(std::vector<Request*>* batch) {
+  Request* first = queue.front();
+  queue.pop_front();
+  queued_rows -= first->rows;
+  batch->push_back(first);
+  size_t rows = first->rows;
+  for (auto it = queue.begin(); it != queue.end() && rows < max_batch_size;) {
+    Request* request = *it;
+    if (rows + request->rows <= max_batch_size &&
+        first->CanBatchWith(*request)) {
+      rows += request->rows;
+      queued_rows -= request->rows;
+      batch->push_back(request);
+      it = queue.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool BatchingPredictor::Impl::RunBatch(Predictor* predictor,
+                                       const std::vector<Request*>& batch) {
+  const Request& first = *batch.front();
+  int rows = 0;
+  for (auto* request : batch) {
+    rows += request->rows;
+  }
+
+  // concatenate the inputs along the first dim
+  std::vector<char> buffer;
+  for (size_t i = 0; i < first.inputs->size(); ++i) {
+    const PaddleTensor& input = (*first.inputs)[i];
+    auto tensor = predictor->GetInputHandle(input.name);
+    if (batch.size() == 1) {
+      tensor->Reshape(input.shape);
+      CopyFromCpu(tensor.get(), input.dtype, input.data.data());
+      tensor->SetLoD(input.lod);
+      continue;
+    }
+    std::vector<int> shape = input.shape;
+    shape[0] = rows;
+    size_t row_bytes =
+        Numel(input.shape) / input.shape[0] * SizeOfDataType(input.dtype);
+    buffer.resize(row_bytes * rows);
+    char* dst = buffer.data();
+    for (auto* request : batch) {
+      const PaddleTensor& request_input = (*request->inputs)[i];
+      size_t bytes = row_bytes * request->rows;
+      PADDLE_ENFORCE_GE(request_input.data.length(),
+                        bytes,
+                        paddle::platform::errors::InvalidArgument(
+                            "The input (%s) has (%d) bytes, which should be "
+                            "(%d) bytes of its shape.",
+                            input.name,
+                            request_input.data.length(),
+                            bytes));
+      std::memcpy(dst, request_input.data.data(), bytes);
+      dst += bytes;
+    }
+    tensor->Reshape(shape);
+    CopyFromCpu(tensor.get(), input.dtype, buffer.data());
+    // the batched requests have no lod, clear the one left by the last run
+    tensor->SetLoD({});
+  }
+
+  if (!predictor->Run()) {
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Tensor>> outputs;
+  for (auto& name : predictor->GetOutputNames()) {
+    outputs.emplace_back(predictor->GetOutputHandle(name));
+  }
+  // an output which does not keep the rows can not be split, so run the
+  // requests one by one
+  if (batch.size() > 1) {
+    for (auto& output : outputs) {
+      std::vector<int> shape = output->shape();
+      if (shape.empty() || shape[0] != rows || !output->lod().empty()) {
+        VLOG(3) << "BatchingPredictor can not split the output ("
+                << output->name() << "), run the requests one by one";
+        bool ok = true;
+        for (auto* request : batch) {
+          ok = RunBatch(predictor, {request}) && ok;
+        }
+        return ok;
+      }
+    }
+  }
+
+  // split the outputs along the first dim
+  for (auto* request : batch) {
+    request->outputs->resize(outputs.size());
+  }
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    const Tensor& output = *outputs[i];
+    std::vector<int> shape = output.shape();
+    size_t dtype_size = SizeOfDataType(output.type());
+    if (batch.size() == 1) {
+      PaddleTensor& request_output = (*first.outputs)[i];
+      request_output.name = output.name();
+      request_output.shape = shape;
+      request_output.dtype = output.type();
+      request_output.lod = output.lod();
+      request_output.data.Resize(Numel(shape) * dtype_size);
+      CopyToCpu(output, request_output.data.data());
+      continue;
+    }
+    size_t row_bytes = Numel(shape) / rows * dtype_size;
+    buffer.resize(row_bytes * rows);
+    CopyToCpu(output, buffer.data());
+    const char* src = buffer.data();
+    for (auto* request : batch) {
+      PaddleTensor& request_output = (*request->outputs)[i];
+      request_output.name = output.name();
+      request_output.shape = shape;
+      request_output.shape[0] = request->rows;
+      request_output.dtype = output.type();
+      request_output.lod.clear();
+      size_t bytes = row_bytes * request->rows;
+      request_output.data.Resize(bytes);
+      std::memcpy(request_output.data.data(), src, bytes);
+      src += bytes;
+    }
+  }
+  return true;
+}
+
+BatchingPredictor::BatchingPredictor(const Config& config,
+                                     size_t max_batch_size,
+                                     int64_t max_wait_us,
+                                     size_t pool_size) {
+  PADDLE_ENFORCE_GE(
+      max_batch_size,
+      1UL,
+      paddle::platform::errors::InvalidArgument(
+          "The max batch size should be at least 1, but it's (%d)",
+          max_batch_size));
+  PADDLE_ENFORCE_GE(
+      max_wait_us,
+      0,
+      paddle::platform::errors::InvalidArgument(
+          "The max wait time should not be negative, but it's (%d)",
+          max_wait_us));
+  impl_ = std::make_unique<Impl>(config, max_batch_size, max_wait_us, pool_size);
+  for (size_t i = 0; i < pool_size; ++i) {
+    impl_->workers.emplace_back(
+        &Impl::Worker, impl_.get(), impl_->pool.Retrive(i));
+  }
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->stop = true;
+  }
+  impl_->cond.notify_all();
+  for (auto& worker : impl_->workers) {
+    worker.join();
+  }
+}
+
+bool BatchingPredictor::Run(const std::vector<paddle::PaddleTensor>& inputs,
+                            std::vector<paddle::PaddleTensor>* outputs) {
+  PADDLE_ENFORCE_NOT_NULL(
+      outputs,
+      paddle::platform::errors::InvalidArgument(
+          "The outputs of BatchingPredictor::Run should not be null."));
+  Request request(&inputs, outputs);
+  std::future<bool> done = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->queue.push_back(&request);
+    impl_->queued_rows += request.rows;
+    // the waiting workers take the batch once it is full
+    if (impl_->queued_rows < impl_->max_batch_size) {
+      impl_->cond.notify_one();
+    } else {
+      impl_->cond.notify_all();
+    }
+  }
+  return done.get();
+}
+
+}  // namespace services
+}  // namespace paddle_infer
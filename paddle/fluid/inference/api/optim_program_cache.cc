@@ -0,0 +1,354 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/optim_program_cache.h"
+
+#include <glog/logging.h>
+#include <xxhash.h>
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/inference/utils/mmap_params.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace inference {
+
+namespace {
+
+constexpr char kEntryPrefix[] = "optim_program_";
+constexpr char kManifestSuffix[] = ".manifest";
+
+std::string HashToHex(uint64_t hash) {
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+  return hex;
+}
+
+bool ReadFile(const std::string& path, std::string* content) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  if (!fin.is_open()) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << fin.rdbuf();
+  *content = buffer.str();
+  return !fin.bad();
+}
+
+// A temporary file name no other writer uses, the predictors of one process
+// may save the same entry at the same time.
+std::string TmpPath(const std::string& path) {
+  static std::atomic<uint64_t> save_count{0};
+  size_t thread_hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return path + ".tmp." + std::to_string(getpid()) + "." +
+         std::to_string(thread_hash) + "." +
+         std::to_string(save_count.fetch_add(1));
+}
+
+// Write content to a temporary file and rename it to path, so that a reader
+// never sees a part of the content.
+bool WriteFile(const std::string& path, const std::string& content) {
+  std::string tmp_path = TmpPath(path);
+  {
+    std::ofstream fout(tmp_path, std::ios::out | std::ios::binary);
+    if (!fout.is_open() || !fout.write(content.data(), content.size())) {
+      fout.close();
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool IsPersistable(const framework::VarDesc* var) {
+  return var->Persistable() &&
+         var->GetType() != framework::proto::VarType::FEED_MINIBATCH &&
+         var->GetType() != framework::proto::VarType::FETCH_LIST &&
+         var->GetType() != framework::proto::VarType::RAW;
+}
+
+}  // namespace
+
+std::string HashFileContent(const std::string& path) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  if (!fin.is_open()) {
+    return "";
+  }
+  XXH64_state_t* state = XXH64_createState();
+  XXH64_reset(state, 0);
+  std::vector<char> buffer(4 << 20);
+  while (fin) {
+    fin.read(buffer.data(), buffer.size());
+    XXH64_update(state, buffer.data(), fin.gcount());
+  }
+  uint64_t hash = XXH64_digest(state);
+  XXH64_freeState(state);
+  return fin.bad() ? "" : HashToHex(hash);
+}
+
+std::string HashString(const std::string& str) {
+  return HashToHex(XXH64(str.data(), str.size(), 0));
+}
+
+std::string OptimProgramCache::EntryPath(const std::string& key,
+                                         const std::string& suffix) const {
+  return dir_ + "/" + kEntryPrefix + key + suffix;
+}
+
+bool OptimProgramCache::Load(const std::string& key,
+                             bool mmap_params,
+                             framework::proto::ProgramDesc* program,
+                             ReuseTable* reuse_table,
+                             framework::Scope* scope) {
+  // the manifest: key, the hashes of the program, the parameters and the
+  // reuse table, and the names of the parameters
+  std::string manifest;
+  if (!ReadFile(EntryPath(key, kManifestSuffix), &manifest)) {
+    return false;
+  }
+  std::vector<std::string> lines;
+  std::istringstream manifest_stream(manifest);
+  for (std::string line; std::getline(manifest_stream, line);) {
+    lines.push_back(line);
+  }
+  std::string program_str;
+  std::string reuse_str;
+  if (lines.size() < 4 || lines[0] != key ||
+      !ReadFile(EntryPath(key, ".pdmodel"), &program_str) ||
+      HashString(program_str) != lines[1] ||
+      !ReadFile(EntryPath(key, ".reuse"), &reuse_str) ||
+      HashString(reuse_str) != lines[3] ||
+      HashFileContent(EntryPath(key, ".pdiparams")) != lines[2] ||
+      !program->ParseFromString(program_str)) {
+    LOG(WARNING) << "The optimized program cache entry " << key
+                 << " is broken, it will be rewritten.";
+    return false;
+  }
+
+  reuse_table->clear();
+  std::istringstream reuse_stream(reuse_str);
+  for (std::string line; std::getline(reuse_stream, line);) {
+    auto pos = line.find('\t');
+    if (pos != std::string::npos) {
+      (*reuse_table)[line.substr(0, pos)] = line.substr(pos + 1);
+    }
+  }
+
+  std::vector<std::string> params(lines.begin() + 4, lines.end());
+  if (!params.empty()) {
+    framework::ProgramDesc load_program;
+    auto* load_block = load_program.MutableBlock(0);
+    for (auto& name : params) {
+      auto* var = load_block->Var(name);
+      var->SetType(framework::proto::VarType::LOD_TENSOR);
+      var->SetPersistable(true);
+    }
+    auto* op = load_block->AppendOp();
+    op->SetType("load_combine");
+    op->SetOutput("Out", params);
+    op->SetAttr("file_path", EntryPath(key, ".pdiparams"));
+    op->CheckAttrs();
+
+    framework::Executor exe(platform::CPUPlace{});
+    auto load_params = [&] { exe.Run(load_program, scope, 0, true, true); };
+    try {
+      if (mmap_params) {
+        LoadCombinedParamsByMmap(
+            EntryPath(key, ".pdiparams"), params, scope, load_params);
+      } else {
+        load_params();
+      }
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Fail to load the parameters of the optimized program "
+                   << key << ": " << e.what();
+      return false;
+    }
+  }
+
+#ifndef _WIN32
+  // the time an entry is last used, which tells the entries to evict
+  utime(EntryPath(key, kManifestSuffix).c_str(), nullptr);
+#endif
+  VLOG(3) << "Load the optimized program of " << key << " with "
+          << params.size() << " parameters from " << dir_;
+  return true;
+}
+
+bool OptimProgramCache::Save(const std::string& key,
+                             const framework::proto::ProgramDesc& program,
+                             const ReuseTable& reuse_table,
+                             framework::Scope* scope) {
+  framework::ProgramDesc program_desc(program);
+  std::set<std::string> param_set;
+  for (size_t i = 0; i < program_desc.Size(); ++i) {
+    for (auto* var : program_desc.Block(i).AllVars()) {
+      if (!IsPersistable(var)) {
+        continue;
+      }
+      if (var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+        VLOG(3) << "Do not cache the optimized program of " << key
+                << ", which has the persistable variable " << var->Name()
+                << " of type " << var->GetType();
+        return false;
+      }
+      // the persistable variables not initialized are created by the
+      // predictor as usual
+      auto* param = scope->FindVar(var->Name());
+      if (param != nullptr && param->IsType<phi::DenseTensor>() &&
+          param->Get<phi::DenseTensor>().IsInitialized()) {
+        param_set.insert(var->Name());
+      }
+    }
+  }
+  std::vector<std::string> params(param_set.begin(), param_set.end());
+
+  std::string program_str = program.SerializeAsString();
+  std::string reuse_str;
+  std::vector<std::pair<std::string, std::string>> reuse_items(
+      reuse_table.begin(), reuse_table.end());
+  std::sort(reuse_items.begin(), reuse_items.end());
+  for (auto& item : reuse_items) {
+    reuse_str += item.first + "\t" + item.second + "\n";
+  }
+
+  std::string params_path = EntryPath(key, ".pdiparams");
+  std::string params_tmp_path = TmpPath(params_path);
+  try {
+    if (params.empty()) {
+      if (!WriteFile(params_path, "")) {
+        return false;
+      }
+    } else {
+      framework::ProgramDesc save_program;
+      auto* save_block = save_program.MutableBlock(0);
+      for (auto& name : params) {
+        auto* var = save_block->Var(name);
+        var->SetType(framework::proto::VarType::LOD_TENSOR);
+        var->SetPersistable(true);
+      }
+      auto* op = save_block->AppendOp();
+      op->SetType("save_combine");
+      op->SetInput("X", params);
+      op->SetAttr("file_path", params_tmp_path);
+      op->CheckAttrs();
+      framework::Executor exe(platform::CPUPlace{});
+      exe.Run(save_program, scope, 0, true, true);
+      if (std::rename(params_tmp_path.c_str(), params_path.c_str()) != 0) {
+        std::remove(params_tmp_path.c_str());
+        return false;
+      }
+    }
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Fail to save the parameters of the optimized program to "
+                 << params_path << ": " << e.what();
+    std::remove(params_tmp_path.c_str());
+    return false;
+  }
+
+  std::string manifest = key + "\n" + HashString(program_str) + "\n" +
+                         HashFileContent(params_path) + "\n" +
+                         HashString(reuse_str) + "\n";
+  for (auto& name : params) {
+    manifest += name + "\n";
+  }
+  if (!WriteFile(EntryPath(key, ".pdmodel"), program_str) ||
+      !WriteFile(EntryPath(key, ".reuse"), reuse_str) ||
+      !WriteFile(EntryPath(key, kManifestSuffix), manifest)) {
+    LOG(WARNING) << "Fail to save the optimized program to " << dir_;
+    return false;
+  }
+  LOG(INFO) << "Save the optimized program of " << key << " to " << dir_;
+
+  Evict(key);
+  return true;
+}
+
+void OptimProgramCache::Evict(const std::string& saved_key) {
+#ifndef _WIN32
+  DIR* dir = opendir(dir_.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  std::vector<std::string> files;
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.compare(0, strlen(kEntryPrefix), kEntryPrefix) == 0) {
+      files.push_back(name);
+    }
+  }
+  closedir(dir);
+
+  // the keys other than saved_key by the time they are last used, the
+  // times are in seconds, so saved_key is never evicted as an older entry
+  const size_t prefix_size = strlen(kEntryPrefix);
+  const size_t suffix_size = strlen(kManifestSuffix);
+  std::vector<std::pair<time_t, std::string>> entries;
+  for (auto& name : files) {
+    struct stat st;
+    if (name.size() > prefix_size + suffix_size &&
+        name.compare(name.size() - suffix_size, suffix_size, kManifestSuffix) ==
+            0 &&
+        stat((dir_ + "/" + name).c_str(), &st) == 0) {
+      std::string key =
+          name.substr(prefix_size, name.size() - prefix_size - suffix_size);
+      if (key != saved_key) {
+        entries.emplace_back(st.st_mtime, key);
+      }
+    }
+  }
+  if (entries.size() < capacity_) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end());
+  for (size_t i = 0; i + capacity_ <= entries.size(); ++i) {
+    const std::string& key = entries[i].second;
+    // remove the manifest first, so that the entry is never used again
+    std::remove(EntryPath(key, kManifestSuffix).c_str());
+    std::string key_prefix = kEntryPrefix + key + ".";
+    for (auto& name : files) {
+      if (name.compare(0, key_prefix.size(), key_prefix) == 0) {
+        std::remove((dir_ + "/" + name).c_str());
+      }
+    }
+    VLOG(3) << "Evict the optimized program of " << key << " from " << dir_;
+  }
+#endif
+}
+
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,91 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace inference {
+
+// The hex of the hash of the content of the file at path, empty if the file
+// can not be read.
+std::string HashFileContent(const std::string& path);
+
+// The hex of the hash of str.
+std::string HashString(const std::string& str);
+
+///
+/// \class OptimProgramCache
+///
+/// \brief OptimProgramCache keeps the programs optimized by the analysis
+/// passes and their parameters on disk, so that a predictor of the same model
+/// and config skips the analysis passes.
+///
+/// An entry is the files of the prefix optim_program_<key> in the cache
+/// directory: the optimized program, the combined parameters, the reuse table
+/// of memory_optimize_pass, and a manifest with the hashes of the other
+/// files, which is written last and checked before the entry is used. The key
+/// should tell the model, the config and everything else the optimized
+/// program depends on. The entries over the capacity are evicted by the time
+/// they are last used.
+///
+class OptimProgramCache {
+ public:
+  using ReuseTable = std::unordered_map<std::string, std::string>;
+
+  OptimProgramCache(const std::string& dir, size_t capacity)
+      : dir_(dir), capacity_(capacity) {}
+
+  ///
+  /// \brief Load the entry of key, the parameters are loaded to scope.
+  ///
+  /// \param[in] mmap_params whether to load the parameters by mmap.
+  /// \return false if there is no valid entry of key.
+  ///
+  bool Load(const std::string& key,
+            bool mmap_params,
+            framework::proto::ProgramDesc* program,
+            ReuseTable* reuse_table,
+            framework::Scope* scope);
+
+  ///
+  /// \brief Save program and the persistable dense tensors of it in scope as
+  /// the entry of key, and evict the entries over the capacity.
+  ///
+  /// \return false if the program has other persistable variables or the
+  /// entry fails to be written.
+  ///
+  bool Save(const std::string& key,
+            const framework::proto::ProgramDesc& program,
+            const ReuseTable& reuse_table,
+            framework::Scope* scope);
+
+ private:
+  std::string EntryPath(const std::string& key,
+                        const std::string& suffix) const;
+  // Evict the entries over the capacity, saved_key is kept.
+  void Evict(const std::string& saved_key);
+
+  std::string dir_;
+  size_t capacity_;
+};
+
+}  // namespace inference
+}  // namespace paddle
@@ -294,6 +294,30 @@ struct PD_INFER_DECL AnalysisConfig {
     opt_cache_dir_ = opt_cache_dir;
   }
   ///
+  /// \brief Turn on the cache of the optimized programs. A predictor on CPU
+  /// looks up the program optimized by the analysis passes and its parameters
+  /// in the optimization cache directory, which is the directory set by
+  /// SetOptimCacheDir or _opt_cache in the model directory, and only runs the
+  /// analysis passes and saves the result on a miss. The cache is keyed by
+  /// the hashes of the model files, the config, the passes, the CPU ISA and
+  /// the version of Paddle.
+  ///
+  /// \param x whether to enable the cache of the optimized programs.
+  /// \param capacity the max number of the cached programs, the least
+  /// recently used ones are evicted.
+  ///
+  void EnableOptimProgramCache(bool x = true, int capacity = 4) {
+    optim_program_cache_ = x;
+    optim_program_cache_capacity_ = capacity;
+  }
+  ///
+  /// \brief A boolean state telling whether the cache of the optimized
+  /// programs is turned on.
+  ///
+  /// \return bool Whether the cache of the optimized programs is turned on.
+  ///
+  bool optim_program_cache_enabled() const { return optim_program_cache_; }
+  ///
   /// \brief Get the model directory path.
   ///
   /// \return const std::string& The model directory path.
@@ -924,6 +948,41 @@ struct PD_INFER_DECL AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  ///
+  /// \brief Back the CPU tensors of at least 2MB with 2MB huge pages to reduce
+  /// the TLB misses. It sets the process wide FLAGS_cpu_huge_page when the
+  /// predictor is created.
+  ///
+  /// \param explicit_huge_page Whether to use the huge pages reserved in
+  /// /proc/sys/vm/nr_hugepages instead of transparent huge pages.
+  ///
+  void EnableCpuHugePage(bool explicit_huge_page = false);
+  ///
+  /// \brief The huge page mode of the CPU tensors.
+  ///
+  /// \return std::string One of "none", "transparent" and "explicit".
+  ///
+  const std::string& cpu_huge_page() const { return cpu_huge_page_; }
+
+  ///
+  /// \brief Place the CPU tensors of at least 2MB on the NUMA node of the
+  /// thread allocating them, to avoid the cross socket traffic when the
+  /// predictor threads are bound to the CPUs of one node. It sets the process
+  /// wide FLAGS_cpu_numa_aware_allocation when the predictor is created.
+  ///
+  /// \param x Whether to enable the NUMA aware allocation.
+  ///
+  void EnableCpuNumaAwareAllocation(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the NUMA aware allocation of the
+  /// CPU tensors is enabled.
+  ///
+  /// \return bool Whether the NUMA aware allocation is enabled.
+  ///
+  bool cpu_numa_aware_allocation_enabled() const {
+    return cpu_numa_aware_allocation_;
+  }
+
   ///
   /// \brief Transform the AnalysisConfig to NativeConfig.
   ///
@@ -1050,6 +1109,24 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Turn on loading the combined parameters by mmap. The parameters
+  /// are written to an aligned parameter file next to the params file the
+  /// first time, which is mapped by the later predictors instead of reading
+  /// and copying the parameters, so the predictors of the same model in a
+  /// host share the pages of the parameters. Only works on Linux with a
+  /// params file of dense tensors.
+  ///
+  /// \param x Whether to load the parameters by mmap.
+  ///
+  void EnableMmapParams(bool x = true) { mmap_params_ = x; }
+  ///
+  /// \brief A boolean state telling whether the parameters are loaded by mmap.
+  ///
+  /// \return bool Whether the parameters are loaded by mmap.
+  ///
+  bool mmap_params_enabled() const { return mmap_params_; }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -1237,6 +1314,7 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool mmap_params_{false};
   bool trt_engine_memory_sharing_{false};
   int trt_engine_memory_sharing_identifier_{0};
 
@@ -1252,6 +1330,8 @@ struct PD_INFER_DECL AnalysisConfig {
   bool specify_input_name_{false};
 
   int cpu_math_library_num_threads_{1};
+  std::string cpu_huge_page_{"none"};
+  bool cpu_numa_aware_allocation_{false};
 
   bool with_profile_{false};
 
@@ -1333,6 +1413,8 @@ struct PD_INFER_DECL AnalysisConfig {
   mutable bool is_valid_{true};
   bool save_optimized_model_{false};
   std::string opt_cache_dir_;
+  bool optim_program_cache_{false};
+  int optim_program_cache_capacity_{4};
   friend class paddle_infer::experimental::InternalUtils;
 
   // fleet exe related
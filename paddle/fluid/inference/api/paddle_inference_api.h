@@ -22,8 +22,11 @@ limitations under the License. */
 #pragma once
 
 #include <cassert>
+#include <condition_variable>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -254,7 +257,11 @@ namespace services {
 /// \brief PredictorPool is a simple encapsulation of Predictor, suitable for
 /// use in multi-threaded situations. According to the thread id, the
 /// corresponding Predictor is taken out from PredictorPool to complete the
-/// prediction.
+/// prediction, or Run hands an idle Predictor to the prediction.
+///
+/// The predictors are cloned from the first one unless TensorRT is enabled,
+/// so they share the parameters and the optimized program, and a predictor
+/// only holds its own intermediate tensors.
 ///
 class PD_INFER_DECL PredictorPool {
  public:
@@ -268,9 +275,82 @@ class PD_INFER_DECL PredictorPool {
   /// \brief Get \param id-th predictor.
   Predictor* Retrive(size_t idx);
 
+  ///
+  /// \brief Run \param func with an idle predictor of the pool, blocks until
+  /// a predictor is idle. thread safe, but the predictors should not be used
+  /// through Retrive at the same time.
+  ///
+  /// \param[in] func sets the inputs, runs and gets the outputs.
+  /// \param[in] clear_intermediate_tensor whether to clear the intermediate
+  /// tensors after func, so that only the busy predictors hold the memory of
+  /// the intermediate tensors.
+  /// \return the return value of func.
+  ///
+  bool Run(const std::function<bool(Predictor*)>& func,
+           bool clear_intermediate_tensor = false);
+
  private:
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
+  std::vector<Predictor*> idle_preds_;
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cond_;
+};
+
+///
+/// \class BatchingPredictor
+///
+/// \brief BatchingPredictor queues the requests of many threads and runs the
+/// queued requests as one batch on a predictor of a PredictorPool, which
+/// makes a better use of the CPU than running the small requests of online
+/// serving one by one.
+///
+/// A batch is taken when it has max_batch_size rows or its first request
+/// has waited for max_wait_us microseconds. The inputs of the requests in a
+/// batch are concatenated along the first dim, and the outputs are split
+/// along the first dim, so the rows of the model should be independent of
+/// each other. A request with LoD, or whose inputs are of different first
+/// dims, is run alone.
+///
+/// Usage:
+///
+/// \code{.cpp}
+/// services::BatchingPredictor predictor(config, 32, 1000, 2);
+/// // in every serving thread
+/// std::vector<PaddleTensor> outputs;
+/// predictor.Run(inputs, &outputs);
+/// \endcode
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  BatchingPredictor() = delete;
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  ///
+  /// \brief Construct the batching predictor running the batches on \param
+  /// pool_size predictor instances.
+  ///
+  BatchingPredictor(const Config& config,
+                    size_t max_batch_size,
+                    int64_t max_wait_us,
+                    size_t pool_size = 1);
+  /// \brief Run the queued requests and stop.
+  ~BatchingPredictor();
+
+  ///
+  /// \brief Run a request, blocks until its batch is done. thread safe.
+  ///
+  /// \param[in] inputs the inputs of the request, matched by name.
+  /// \param[out] outputs the outputs of the request.
+  /// \return Whether the run is successful
+  ///
+  bool Run(const std::vector<paddle::PaddleTensor>& inputs,
+           std::vector<paddle::PaddleTensor>* outputs);
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
 };
 }  // namespace services
 
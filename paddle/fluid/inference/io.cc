@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/version.h"
+#include "paddle/fluid/inference/utils/mmap_params.h"
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/pybind/pybind.h"
@@ -81,12 +82,14 @@ void LoadPersistables(framework::Executor* executor,
                       const framework::ProgramDesc& main_program,
                       const std::string& dirname,
                       const std::string& param_filename,
-                      bool model_from_memory = false) {
+                      bool model_from_memory,
+                      bool mmap_params) {
   const framework::BlockDesc& global_block = main_program.Block(0);
 
   framework::ProgramDesc* load_program = new framework::ProgramDesc();
   framework::BlockDesc* load_block = load_program->MutableBlock(0);
   std::vector<std::string> paramlist;
+  bool all_lod_tensor = true;
 
   for (auto* var : global_block.AllVars()) {
     if (IsPersistable(var)) {
@@ -108,6 +111,8 @@ void LoadPersistables(framework::Executor* executor,
 
       if (!param_filename.empty()) {
         paramlist.push_back(new_var->Name());
+        all_lod_tensor = all_lod_tensor &&
+                         var_type == framework::proto::VarType::LOD_TENSOR;
       } else {
         // append_op
         framework::OpDesc* op = load_block->AppendOp();
@@ -131,7 +136,15 @@ void LoadPersistables(framework::Executor* executor,
     op->CheckAttrs();
   }
 
-  executor->Run(*load_program, scope, 0, true, true);
+  // the aligned parameter file only keeps dense tensors on CPU
+  if (mmap_params && !param_filename.empty() && !model_from_memory &&
+      all_lod_tensor && platform::is_cpu_place(executor->GetPlace())) {
+    LoadCombinedParamsByMmap(param_filename, paramlist, scope, [&] {
+      executor->Run(*load_program, scope, 0, true, true);
+    });
+  } else {
+    executor->Run(*load_program, scope, 0, true, true);
+  }
 
   delete load_program;
 }
@@ -166,7 +179,8 @@ std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
                                              framework::Scope* scope,
                                              const std::string& prog_filename,
                                              const std::string& param_filename,
-                                             bool load_params) {
+                                             bool load_params,
+                                             bool mmap_params) {
   std::string program_desc_str;
   ReadBinaryFile(prog_filename, &program_desc_str);
 
@@ -183,7 +197,8 @@ std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
                      *main_program,
                      "",
                      param_filename,
-                     false /* model_from_memory */);
+                     false /* model_from_memory */,
+                     mmap_params);
   }
   return main_program;
 }
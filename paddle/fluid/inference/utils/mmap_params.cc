@@ -0,0 +1,425 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/utils/mmap_params.h"
+
+#include <xxhash.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>  // NOLINT
+#include <unordered_map>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace inference {
+
+namespace {
+
+constexpr char kAlignedParamsMagic[8] = {
+    'P', 'D', 'P', 'A', 'R', 'A', 'M', 'A'};
+constexpr uint32_t kAlignedParamsVersion = 2;
+
+struct AlignedParamsHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t signature_size;
+  uint64_t tensor_num;
+  uint64_t index_size;
+  // XXH64 of the data, from the aligned end of the index to the file end
+  uint64_t data_checksum;
+};
+
+struct AlignedParamsEntry {
+  int32_t dtype;
+  std::vector<int64_t> dims;
+  uint64_t offset;
+  uint64_t size;
+};
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignedParamsAlignment - 1) / kAlignedParamsAlignment *
+         kAlignedParamsAlignment;
+}
+
+template <typename T>
+void AppendPod(std::string* buffer, const T& value) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Read a T at *pos of [data, data + size), returns false if it is out of
+// the range.
+template <typename T>
+bool ReadPod(const char* data, size_t size, size_t* pos, T* value) {
+  if (size - *pos < sizeof(T)) {
+    return false;
+  }
+  memcpy(value, data + *pos, sizeof(T));
+  *pos += sizeof(T);
+  return true;
+}
+
+// Whether the dtype, the dims and the size of entry agree, the entries of a
+// damaged file are rejected before they are bound to tensors.
+bool IsValidEntry(const AlignedParamsEntry& entry) {
+  if (!framework::proto::VarType::Type_IsValid(entry.dtype)) {
+    return false;
+  }
+  auto dtype = framework::TransToPhiDataType(
+      static_cast<framework::proto::VarType::Type>(entry.dtype));
+  if (dtype == phi::DataType::UNDEFINED || dtype == phi::DataType::PSTRING) {
+    return false;
+  }
+  uint64_t size = phi::SizeOf(dtype);
+  for (auto dim : entry.dims) {
+    if (dim < 0) {
+      return false;
+    }
+    uint64_t udim = static_cast<uint64_t>(dim);
+    if (udim > 0 && size > std::numeric_limits<uint64_t>::max() / udim) {
+      return false;
+    }
+    size *= udim;
+  }
+  return size == entry.size;
+}
+
+#ifndef _WIN32
+// The mapping of an aligned parameter file, which is unmapped when all the
+// tensors bound to it are released.
+class MappedFile {
+ public:
+  MappedFile(void* data, size_t size) : data_(data), size_(size) {}
+  ~MappedFile() { munmap(data_, size_); }
+
+  const char* data() const { return static_cast<const char*>(data_); }
+  size_t size() const { return size_; }
+
+ private:
+  void* data_;
+  size_t size_;
+};
+
+class MappedParamsAllocation : public phi::Allocation {
+ public:
+  MappedParamsAllocation(const std::shared_ptr<MappedFile>& file,
+                         const char* ptr,
+                         size_t size)
+      : phi::Allocation(const_cast<char*>(ptr), size, platform::CPUPlace()),
+        file_(file) {}
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+};
+#endif
+
+// The size and the modification time of the combined parameter file, empty
+// if there is no such file.
+std::string ParamsFileSignature(const std::string& params_file) {
+#ifndef _WIN32
+  struct stat st;
+  if (stat(params_file.c_str(), &st) != 0) {
+    return "";
+  }
+#ifdef __APPLE__
+  const struct timespec& mtime = st.st_mtimespec;
+#else
+  const struct timespec& mtime = st.st_mtim;
+#endif
+  return std::to_string(st.st_size) + ":" + std::to_string(mtime.tv_sec) +
+         "." + std::to_string(mtime.tv_nsec);
+#else
+  return "";
+#endif
+}
+
+}  // namespace
+
+bool SaveAlignedParams(const std::string& path,
+                       const std::string& signature,
+                       const framework::Scope& scope,
+                       const std::vector<std::string>& names) {
+  std::vector<const phi::DenseTensor*> tensors;
+  for (auto& name : names) {
+    auto* var = scope.FindVar(name);
+    if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+      VLOG(3) << "The parameter " << name << " is not a dense tensor.";
+      return false;
+    }
+    auto& tensor = var->Get<phi::DenseTensor>();
+    if (!tensor.lod().empty() ||
+        (tensor.numel() > 0 && !platform::is_cpu_place(tensor.place()))) {
+      VLOG(3) << "The parameter " << name << " has LoD or is not on CPU.";
+      return false;
+    }
+    tensors.push_back(&tensor);
+  }
+
+  std::string index;
+  uint64_t offset = 0;
+  for (size_t i = 0; i < names.size(); ++i) {
+    const phi::DenseTensor& tensor = *tensors[i];
+    uint64_t size = tensor.numel() * phi::SizeOf(tensor.dtype());
+    AppendPod(&index, static_cast<uint32_t>(names[i].size()));
+    index.append(names[i]);
+    AppendPod(&index,
+              static_cast<int32_t>(framework::TransToProtoVarType(
+                  tensor.dtype())));
+    auto dims = phi::vectorize(tensor.dims());
+    AppendPod(&index, static_cast<uint32_t>(dims.size()));
+    for (int64_t dim : dims) {
+      AppendPod(&index, dim);
+    }
+    // the offsets from the data begin, which are moved to the file begin
+    // once the index size is known
+    AppendPod(&index, offset);
+    AppendPod(&index, size);
+    offset = AlignUp(offset + size);
+  }
+
+  const std::string padding(kAlignedParamsAlignment, '\0');
+  XXH64_state_t* state = XXH64_createState();
+  XXH64_reset(state, 0);
+  for (auto* tensor : tensors) {
+    size_t size = tensor->numel() * phi::SizeOf(tensor->dtype());
+    if (size > 0) {
+      XXH64_update(state, tensor->data(), size);
+    }
+    XXH64_update(state, padding.data(), AlignUp(size) - size);
+  }
+
+  AlignedParamsHeader header;
+  memcpy(header.magic, kAlignedParamsMagic, sizeof(header.magic));
+  header.version = kAlignedParamsVersion;
+  header.signature_size = signature.size();
+  header.tensor_num = names.size();
+  header.index_size = index.size();
+  header.data_checksum = XXH64_digest(state);
+  XXH64_freeState(state);
+  size_t data_begin = AlignUp(sizeof(header) + signature.size() + index.size());
+  // move the offsets of the index, which are the last 16 bytes of every entry
+  size_t pos = 0;
+  for (size_t i = 0; i < names.size(); ++i) {
+    uint32_t name_size = 0;
+    uint32_t rank = 0;
+    ReadPod(index.data(), index.size(), &pos, &name_size);
+    pos += name_size + sizeof(int32_t);
+    ReadPod(index.data(), index.size(), &pos, &rank);
+    pos += rank * sizeof(int64_t);
+    uint64_t data_offset = 0;
+    memcpy(&data_offset, &index[pos], sizeof(data_offset));
+    data_offset += data_begin;
+    memcpy(&index[pos], &data_offset, sizeof(data_offset));
+    pos += sizeof(uint64_t) * 2;
+  }
+
+  // write to a temporary file and rename it, so that a file at path is
+  // always complete. The name is unique to the thread and the call, the
+  // predictors in a process may save the same file at the same time.
+  static std::atomic<uint64_t> save_count{0};
+  std::string tmp_path =
+      path + ".tmp." + std::to_string(getpid()) + "." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+      "." + std::to_string(save_count.fetch_add(1));
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (fp == nullptr) {
+    LOG(WARNING) << "Fail to open " << tmp_path
+                 << " to save the aligned parameters.";
+    return false;
+  }
+  std::string head;
+  AppendPod(&head, header);
+  head.append(signature);
+  head.append(index);
+  head.resize(data_begin, '\0');
+  bool ok = fwrite(head.data(), 1, head.size(), fp) == head.size();
+  for (size_t i = 0; i < tensors.size() && ok; ++i) {
+    size_t size = tensors[i]->numel() * phi::SizeOf(tensors[i]->dtype());
+    if (size > 0) {
+      ok = fwrite(tensors[i]->data(), 1, size, fp) == size;
+    }
+    size_t padding_size = AlignUp(size) - size;
+    if (ok && padding_size > 0) {
+      ok = fwrite(padding.data(), 1, padding_size, fp) == padding_size;
+    }
+  }
+  ok = fclose(fp) == 0 && ok;
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Fail to save the aligned parameters to " << path;
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  VLOG(3) << "Save " << names.size() << " aligned parameters to " << path;
+  return true;
+}
+
+bool LoadAlignedParams(const std::string& path,
+                       const std::string& signature,
+                       const std::vector<std::string>& names,
+                       framework::Scope* scope,
+                       bool verify_data) {
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    // a private writable mapping, a pass writing to a parameter gets a copy
+    // of the page instead of a fault
+    data = mmap(nullptr,
+                st.st_size,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE,
+                fd,
+                0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  auto file = std::make_shared<MappedFile>(data, st.st_size);
+
+  AlignedParamsHeader header;
+  size_t pos = 0;
+  if (!ReadPod(file->data(), file->size(), &pos, &header) ||
+      memcmp(header.magic, kAlignedParamsMagic, sizeof(header.magic)) != 0 ||
+      header.version != kAlignedParamsVersion ||
+      header.signature_size != signature.size() ||
+      file->size() - pos < signature.size() ||
+      memcmp(file->data() + pos, signature.data(), signature.size()) != 0) {
+    VLOG(3) << "The aligned parameter file " << path << " is stale.";
+    return false;
+  }
+  pos += signature.size();
+
+  std::unordered_map<std::string, AlignedParamsEntry> entries;
+  for (uint64_t i = 0; i < header.tensor_num; ++i) {
+    uint32_t name_size = 0;
+    uint32_t rank = 0;
+    AlignedParamsEntry entry;
+    if (!ReadPod(file->data(), file->size(), &pos, &name_size) ||
+        file->size() - pos < name_size) {
+      return false;
+    }
+    std::string name(file->data() + pos, name_size);
+    pos += name_size;
+    if (!ReadPod(file->data(), file->size(), &pos, &entry.dtype) ||
+        !ReadPod(file->data(), file->size(), &pos, &rank)) {
+      return false;
+    }
+    entry.dims.resize(rank);
+    for (auto& dim : entry.dims) {
+      if (!ReadPod(file->data(), file->size(), &pos, &dim)) {
+        return false;
+      }
+    }
+    if (!ReadPod(file->data(), file->size(), &pos, &entry.offset) ||
+        !ReadPod(file->data(), file->size(), &pos, &entry.size) ||
+        entry.offset > file->size() ||
+        file->size() - entry.offset < entry.size) {
+      return false;
+    }
+    if (!IsValidEntry(entry)) {
+      VLOG(3) << "The aligned parameter file " << path << " has a broken "
+              << name << ", dtype: " << entry.dtype
+              << ", size: " << entry.size;
+      return false;
+    }
+    entries.emplace(std::move(name), std::move(entry));
+  }
+  for (auto& name : names) {
+    if (entries.count(name) == 0) {
+      VLOG(3) << "The aligned parameter file " << path << " has no " << name;
+      return false;
+    }
+  }
+  // hashing the data faults in every page of the file, the entries above
+  // are checked against the file size already
+  if (verify_data) {
+    if (header.index_size > file->size()) {
+      return false;
+    }
+    size_t data_begin =
+        AlignUp(sizeof(header) + signature.size() + header.index_size);
+    if (data_begin > file->size() ||
+        XXH64(file->data() + data_begin, file->size() - data_begin, 0) !=
+            header.data_checksum) {
+      VLOG(3) << "The aligned parameter file " << path
+              << " does not match its checksum.";
+      return false;
+    }
+  }
+
+  for (auto& name : names) {
+    auto& entry = entries[name];
+    auto* tensor = scope->Var(name)->GetMutable<phi::DenseTensor>();
+    tensor->Resize(phi::make_ddim(entry.dims));
+    tensor->ResetHolderWithType(
+        std::make_shared<MappedParamsAllocation>(
+            file, file->data() + entry.offset, entry.size),
+        framework::TransToPhiDataType(
+            static_cast<framework::proto::VarType::Type>(entry.dtype)));
+  }
+  VLOG(3) << "Map " << names.size() << " aligned parameters from " << path;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void LoadCombinedParamsByMmap(const std::string& params_file,
+                              const std::vector<std::string>& names,
+                              framework::Scope* scope,
+                              const std::function<void()>& load_params) {
+  std::string path = params_file + ".aligned";
+  std::string signature = ParamsFileSignature(params_file);
+  if (!signature.empty() &&
+      LoadAlignedParams(path, signature, names, scope)) {
+    return;
+  }
+  load_params();
+  if (signature.empty() ||
+      !SaveAlignedParams(path, signature, *scope, names)) {
+    return;
+  }
+  // bind the tensors to the pages of the new file, which frees the tensors
+  // just loaded. The pages were just written and are still in the page
+  // cache, check the data once here.
+  if (!LoadAlignedParams(path, signature, names, scope, true)) {
+    LOG(WARNING) << "Fail to map the aligned parameters of " << path;
+  }
+}
+
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,68 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace inference {
+
+// An aligned parameter file keeps the dense tensors of a combined parameter
+// file behind an index, with the data of every tensor aligned, so that the
+// tensors are bound to the pages of the mapped file instead of being read
+// and copied. The file is mapped privately, the predictors of the same file
+// share the pages in the page cache until a pass writes to a page.
+//
+//   header: magic, version, signature, tensor number, checksum of the data
+//   index:  name, data type, dims, offset and size of the data of every tensor
+//   data:   the data of the tensors, aligned to kAlignedParamsAlignment
+//
+// The signature tells the combined parameter file the tensors come from, a
+// file of another signature is stale. A file whose data does not match the
+// checksum is broken. Files are renamed into place once complete, so the
+// data is only checked on request, checking it reads every page of the file.
+constexpr size_t kAlignedParamsAlignment = 64;
+
+// Write the dense tensors of names in scope to the aligned parameter file at
+// path. Returns false if a tensor is not a dense tensor on CPU without LoD.
+bool SaveAlignedParams(const std::string& path,
+                       const std::string& signature,
+                       const framework::Scope& scope,
+                       const std::vector<std::string>& names);
+
+// Bind the tensors of names in scope to the mapped aligned parameter file at
+// path. Returns false if there is no such file, or it is stale, or it does
+// not have all the names, or verify_data is set and the data does not match
+// the checksum.
+bool LoadAlignedParams(const std::string& path,
+                       const std::string& signature,
+                       const std::vector<std::string>& names,
+                       framework::Scope* scope,
+                       bool verify_data = false);
+
+// Load the tensors of names from the combined parameter file params_file by
+// mapping its aligned parameter file, which is written next to params_file
+// from the tensors loaded by load_params if it does not exist or is stale.
+void LoadCombinedParamsByMmap(const std::string& params_file,
+                              const std::vector<std::string>& names,
+                              framework::Scope* scope,
+                              const std::function<void()>& load_params);
+
+}  // namespace inference
+}  // namespace paddle
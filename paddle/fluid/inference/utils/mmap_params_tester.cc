@@ -0,0 +1,232 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/utils/mmap_params.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace inference {
+namespace {
+
+template <typename T>
+void SetTensor(framework::Scope* scope,
+               const std::string& name,
+               const std::vector<int64_t>& dims) {
+  auto* tensor = scope->Var(name)->GetMutable<phi::DenseTensor>();
+  tensor->Resize(phi::make_ddim(dims));
+  T* data = tensor->mutable_data<T>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = static_cast<T>(i * 3 + name.size());
+  }
+}
+
+template <typename T>
+void ExpectSameTensor(const framework::Scope& expected,
+                      const framework::Scope& actual,
+                      const std::string& name) {
+  auto& a = expected.FindVar(name)->Get<phi::DenseTensor>();
+  auto& b = actual.FindVar(name)->Get<phi::DenseTensor>();
+  ASSERT_EQ(a.dims(), b.dims());
+  ASSERT_EQ(a.dtype(), b.dtype());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b.data<T>()) % kAlignedParamsAlignment,
+            0UL);
+  for (int64_t i = 0; i < a.numel(); ++i) {
+    EXPECT_EQ(a.data<T>()[i], b.data<T>()[i]);
+  }
+}
+
+// Copy the aligned parameter file at path to dst with value written to the
+// field at field_offset after name in the index, the fields after the name
+// are the dtype, the rank, the dims, the offset and the size.
+template <typename T>
+void CopyWithEntryField(const std::string& path,
+                        const std::string& dst,
+                        const std::string& name,
+                        size_t field_offset,
+                        T value) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(fin)),
+                      std::istreambuf_iterator<char>());
+  size_t pos = content.find(name);
+  ASSERT_NE(pos, std::string::npos);
+  memcpy(&content[pos + name.size() + field_offset], &value, sizeof(T));
+  std::ofstream fout(dst, std::ios::out | std::ios::binary);
+  fout.write(content.data(), content.size());
+}
+
+}  // namespace
+
+TEST(AlignedParams, SaveLoad) {
+  const std::string path = "./aligned_params_save_load";
+  const std::vector<std::string> names = {"w", "b", "emb", "empty"};
+  framework::Scope scope;
+  SetTensor<float>(&scope, "w", {3, 5});
+  SetTensor<double>(&scope, "b", {7});
+  SetTensor<int64_t>(&scope, "emb", {11, 2});
+  SetTensor<float>(&scope, "empty", {0, 4});
+  ASSERT_TRUE(SaveAlignedParams(path, "signature", scope, names));
+
+  framework::Scope loaded;
+  ASSERT_TRUE(LoadAlignedParams(path, "signature", names, &loaded));
+  ExpectSameTensor<float>(scope, loaded, "w");
+  ExpectSameTensor<double>(scope, loaded, "b");
+  ExpectSameTensor<int64_t>(scope, loaded, "emb");
+  EXPECT_EQ(loaded.FindVar("empty")->Get<phi::DenseTensor>().numel(), 0);
+
+  // the mapping is private, writing to a tensor does not change the file
+  auto* w = loaded.FindVar("w")->GetMutable<phi::DenseTensor>();
+  w->data<float>()[0] = -1.f;
+  framework::Scope reloaded;
+  ASSERT_TRUE(LoadAlignedParams(path, "signature", {"w"}, &reloaded));
+  ExpectSameTensor<float>(scope, reloaded, "w");
+  std::remove(path.c_str());
+}
+
+TEST(AlignedParams, Stale) {
+  const std::string path = "./aligned_params_stale";
+  framework::Scope scope;
+  SetTensor<float>(&scope, "w", {4, 4});
+  ASSERT_TRUE(SaveAlignedParams(path, "signature", scope, {"w"}));
+
+  framework::Scope loaded;
+  EXPECT_FALSE(LoadAlignedParams(path, "other signature", {"w"}, &loaded));
+  EXPECT_FALSE(LoadAlignedParams(path, "signature", {"w", "b"}, &loaded));
+  EXPECT_FALSE(
+      LoadAlignedParams("./aligned_params_none", "signature", {"w"}, &loaded));
+  std::remove(path.c_str());
+}
+
+TEST(AlignedParams, BrokenEntry) {
+  const std::string path = "./aligned_params_broken";
+  const std::string broken_path = "./aligned_params_broken_copy";
+  const std::string name = "broken_w";
+  framework::Scope scope;
+  SetTensor<float>(&scope, name, {4, 4});
+  ASSERT_TRUE(SaveAlignedParams(path, "signature", scope, {name}));
+
+  // dtype: 0, rank: 4, dims: 8 and 16, offset: 24, size: 32
+  {
+    framework::Scope loaded;
+    CopyWithEntryField(path,
+                       broken_path,
+                       name,
+                       0,
+                       static_cast<int32_t>(framework::proto::VarType::FP32));
+    EXPECT_TRUE(LoadAlignedParams(broken_path, "signature", {name}, &loaded));
+  }
+  // the file is rejected, so the parameters are loaded by load_combine
+  framework::Scope loaded;
+  CopyWithEntryField(path, broken_path, name, 0, static_cast<int32_t>(12345));
+  EXPECT_FALSE(LoadAlignedParams(broken_path, "signature", {name}, &loaded));
+  CopyWithEntryField(path,
+                     broken_path,
+                     name,
+                     0,
+                     static_cast<int32_t>(framework::proto::VarType::FP64));
+  EXPECT_FALSE(LoadAlignedParams(broken_path, "signature", {name}, &loaded));
+  CopyWithEntryField(path, broken_path, name, 8, static_cast<int64_t>(-4));
+  EXPECT_FALSE(LoadAlignedParams(broken_path, "signature", {name}, &loaded));
+  CopyWithEntryField(path, broken_path, name, 32, static_cast<uint64_t>(60));
+  EXPECT_FALSE(LoadAlignedParams(broken_path, "signature", {name}, &loaded));
+  std::remove(broken_path.c_str());
+  std::remove(path.c_str());
+}
+
+TEST(AlignedParams, BrokenData) {
+  const std::string path = "./aligned_params_broken_data";
+  framework::Scope scope;
+  SetTensor<float>(&scope, "w", {4, 4});
+  ASSERT_TRUE(SaveAlignedParams(path, "signature", scope, {"w"}));
+
+  // flip a byte of the last value, which is in the data
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekg(0, std::ios::end);
+  std::streamoff size = file.tellg();
+  file.seekg(size - kAlignedParamsAlignment + 16 * sizeof(float) - 1);
+  char byte = 0;
+  file.read(&byte, 1);
+  byte ^= 0x5a;
+  file.seekp(size - kAlignedParamsAlignment + 16 * sizeof(float) - 1);
+  file.write(&byte, 1);
+  file.close();
+
+  framework::Scope loaded;
+  EXPECT_FALSE(LoadAlignedParams(path, "signature", {"w"}, &loaded, true));
+  std::remove(path.c_str());
+}
+
+TEST(AlignedParams, ConcurrentSave) {
+  const std::string path = "./aligned_params_concurrent";
+  const std::vector<std::string> names = {"w", "emb"};
+  framework::Scope scope;
+  SetTensor<float>(&scope, "w", {64, 64});
+  SetTensor<int64_t>(&scope, "emb", {128, 16});
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 4; ++j) {
+        EXPECT_TRUE(SaveAlignedParams(path, "signature", scope, names));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  framework::Scope loaded;
+  ASSERT_TRUE(LoadAlignedParams(path, "signature", names, &loaded, true));
+  ExpectSameTensor<float>(scope, loaded, "w");
+  ExpectSameTensor<int64_t>(scope, loaded, "emb");
+  std::remove(path.c_str());
+}
+
+TEST(AlignedParams, LoadCombinedParamsByMmap) {
+  const std::string params_file = "./aligned_params_combined";
+  FILE* fp = fopen(params_file.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  fputs("combined", fp);
+  fclose(fp);
+
+  framework::Scope expected;
+  SetTensor<float>(&expected, "w", {8, 3});
+  int load_times = 0;
+  for (int i = 0; i < 2; ++i) {
+    framework::Scope scope;
+    LoadCombinedParamsByMmap(params_file, {"w"}, &scope, [&] {
+      ++load_times;
+      SetTensor<float>(&scope, "w", {8, 3});
+    });
+    ExpectSameTensor<float>(expected, scope, "w");
+  }
+  // the second time maps the aligned parameter file written the first time
+  EXPECT_EQ(load_times, 1);
+  std::remove((params_file + ".aligned").c_str());
+  std::remove(params_file.c_str());
+}
+
+}  // namespace inference
+}  // namespace paddle
@@ -36,9 +36,13 @@ static AllocatorStrategy GetStrategyFromFlag() {
     return AllocatorStrategy::kThreadLocal;
   }
 
+  if (FLAGS_allocator_strategy == "size_class") {
+    return AllocatorStrategy::kSizeClass;
+  }
+
   PADDLE_THROW(platform::errors::InvalidArgument(
       "Unsupported allocator strategy: %s, condicates are naive_best_fit, "
-      "auto_growth or thread_local.",
+      "auto_growth, thread_local or size_class.",
       FLAGS_allocator_strategy));
 }
 
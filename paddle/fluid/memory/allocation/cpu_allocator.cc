@@ -16,6 +16,7 @@
 
 #include <stdlib.h>
 
+#include "paddle/fluid/memory/allocation/cpu_memory_placement.h"
 #include "paddle/fluid/memory/stats.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -23,11 +24,33 @@ namespace paddle {
 namespace memory {
 namespace allocation {
 
+// The allocation mapped by MapCPUMemory.
+class MappedCPUAllocation : public Allocation {
+ public:
+  MappedCPUAllocation(void *ptr, size_t size, size_t mapped_size)
+      : Allocation(ptr, size, platform::CPUPlace()),
+        mapped_size_(mapped_size) {}
+
+  size_t mapped_size() const { return mapped_size_; }
+
+ private:
+  size_t mapped_size_;
+};
+
 bool CPUAllocator::IsAllocThreadSafe() const { return true; }
 
 void CPUAllocator::FreeImpl(phi::Allocation *allocation) {
   auto size = allocation->size();
   void *p = allocation->ptr();
+  if (size >= kCPUHugePageSize) {
+    auto *mapped_allocation = dynamic_cast<MappedCPUAllocation *>(allocation);
+    if (mapped_allocation != nullptr) {
+      UnmapCPUMemory(p, mapped_allocation->mapped_size());
+      HOST_MEMORY_STAT_UPDATE(Reserved, 0, -size);
+      delete allocation;
+      return;
+    }
+  }
 #ifdef _WIN32
   _aligned_free(p);
 #else
@@ -39,6 +62,12 @@ void CPUAllocator::FreeImpl(phi::Allocation *allocation) {
 
 phi::Allocation *CPUAllocator::AllocateImpl(size_t size) {
   void *p;
+  if (UseMappedCPUMemory(size)) {
+    size_t mapped_size = 0;
+    p = MapCPUMemory(size, &mapped_size);
+    HOST_MEMORY_STAT_UPDATE(Reserved, 0, size);
+    return new MappedCPUAllocation(p, size, mapped_size);
+  }
 #ifdef _WIN32
   p = _aligned_malloc(size, kAlignment);
 #else
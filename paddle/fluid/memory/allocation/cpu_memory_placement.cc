@@ -0,0 +1,195 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/cpu_memory_placement.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <string>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/core/flags.h"
+
+PHI_DECLARE_string(cpu_huge_page);
+PHI_DECLARE_bool(cpu_numa_aware_allocation);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+#ifdef __linux__
+
+// the mbind policy allocating on the given node first, from <numaif.h>
+static constexpr int kMpolPreferred = 1;
+static constexpr size_t kMaxNumaNodeNum = 1024;
+
+static size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+static bool IsHugePageEnabled() {
+  const std::string& huge_page = FLAGS_cpu_huge_page;
+  if (huge_page == "none") {
+    return false;
+  }
+  PADDLE_ENFORCE_EQ(
+      huge_page == "transparent" || huge_page == "explicit",
+      true,
+      platform::errors::InvalidArgument(
+          "Unsupported FLAGS_cpu_huge_page %s, it should be one of none, "
+          "transparent and explicit.",
+          huge_page));
+  return true;
+}
+
+bool UseMappedCPUMemory(size_t size) {
+  return size >= kCPUHugePageSize &&
+         (FLAGS_cpu_numa_aware_allocation || IsHugePageEnabled());
+}
+
+// Set the policy before the pages are touched, so that they are allocated on
+// the node no matter which thread touches them first.
+static void PreferCurrentNumaNode(void* ptr, size_t size) {
+#ifdef SYS_mbind
+  int node = CurrentNumaNode();
+  if (node < 0 || static_cast<size_t>(node) >= kMaxNumaNodeNum) {
+    return;
+  }
+  constexpr size_t kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT
+  unsigned long node_mask[kMaxNumaNodeNum / kBitsPerWord] = {0};  // NOLINT
+  node_mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  // the kernel reads maxnode - 1 bits of the mask
+  if (syscall(SYS_mbind,
+              ptr,
+              size,
+              kMpolPreferred,
+              node_mask,
+              kMaxNumaNodeNum + 1,
+              0) != 0) {
+    VLOG(4) << "Fail to prefer NUMA node " << node << " for " << size
+            << " bytes, errno " << errno;
+  }
+#endif
+}
+
+void* MapCPUMemory(size_t size, size_t* mapped_size) {
+  size_t aligned_size = AlignUp(size, kCPUHugePageSize);
+  void* ptr = MAP_FAILED;
+  bool huge_page = IsHugePageEnabled();
+#ifdef MAP_HUGETLB
+  if (FLAGS_cpu_huge_page == "explicit") {
+    ptr = mmap(nullptr,
+               aligned_size,
+               PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+               -1,
+               0);
+    if (ptr == MAP_FAILED) {
+      LOG_FIRST_N(WARNING, 1)
+          << "Fail to map " << aligned_size
+          << " bytes of explicit huge pages, fall back to transparent huge "
+             "pages. Please reserve more in /proc/sys/vm/nr_hugepages.";
+    }
+  }
+#endif
+  if (ptr == MAP_FAILED) {
+    // map one more huge page and trim it, so that the memory starts at a huge
+    // page boundary which transparent huge pages require
+    size_t reserved_size = aligned_size + kCPUHugePageSize;
+    void* base = mmap(nullptr,
+                      reserved_size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1,
+                      0);
+    PADDLE_ENFORCE_NE(
+        base,
+        MAP_FAILED,
+        platform::errors::ResourceExhausted(
+            "Fail to map %ld bytes of CPU memory, errno is %d.", size, errno));
+    uintptr_t begin = reinterpret_cast<uintptr_t>(base);
+    uintptr_t aligned_begin = AlignUp(begin, kCPUHugePageSize);
+    size_t head = aligned_begin - begin;
+    size_t tail = reserved_size - head - aligned_size;
+    if (head > 0) {
+      munmap(base, head);
+    }
+    if (tail > 0) {
+      munmap(reinterpret_cast<void*>(aligned_begin + aligned_size), tail);
+    }
+    ptr = reinterpret_cast<void*>(aligned_begin);
+#ifdef MADV_HUGEPAGE
+    if (huge_page && madvise(ptr, aligned_size, MADV_HUGEPAGE) != 0) {
+      VLOG(4) << "Fail to enable transparent huge pages, errno " << errno;
+    }
+#endif
+  }
+  if (FLAGS_cpu_numa_aware_allocation) {
+    PreferCurrentNumaNode(ptr, aligned_size);
+  }
+  *mapped_size = aligned_size;
+  return ptr;
+}
+
+void UnmapCPUMemory(void* ptr, size_t mapped_size) {
+  PADDLE_ENFORCE_EQ(
+      munmap(ptr, mapped_size),
+      0,
+      platform::errors::Fatal(
+          "Fail to unmap %ld bytes of CPU memory, errno is %d.",
+          mapped_size,
+          errno));
+}
+
+int CurrentNumaNode() {
+#ifdef SYS_getcpu
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return -1;
+}
+
+#else
+
+bool UseMappedCPUMemory(size_t size) { return false; }
+
+void* MapCPUMemory(size_t size, size_t* mapped_size) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Mapping CPU memory with huge pages or NUMA placement is only "
+      "supported on Linux."));
+}
+
+void UnmapCPUMemory(void* ptr, size_t mapped_size) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Mapping CPU memory with huge pages or NUMA placement is only "
+      "supported on Linux."));
+}
+
+int CurrentNumaNode() { return -1; }
+
+#endif
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,42 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+constexpr size_t kCPUHugePageSize = 2UL << 20;
+
+// Whether a CPU allocation of size should be mapped by MapCPUMemory, which is
+// true for the allocations of at least kCPUHugePageSize when
+// FLAGS_cpu_huge_page or FLAGS_cpu_numa_aware_allocation is set on Linux.
+bool UseMappedCPUMemory(size_t size);
+
+// Map at least size bytes aligned to kCPUHugePageSize from the system, backed
+// by huge pages and placed on the NUMA node of the calling thread as the
+// flags require. mapped_size returns the bytes to pass to UnmapCPUMemory.
+void* MapCPUMemory(size_t size, size_t* mapped_size);
+
+void UnmapCPUMemory(void* ptr, size_t mapped_size);
+
+// The NUMA node of the CPU the calling thread runs on, -1 if unknown.
+int CurrentNumaNode();
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,106 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/cpu_memory_placement.h"
+
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/memory/allocation/system_allocator.h"
+#include "paddle/phi/core/flags.h"
+
+PHI_DECLARE_string(cpu_huge_page);
+PHI_DECLARE_bool(cpu_numa_aware_allocation);
+PHI_DECLARE_bool(use_pinned_memory);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+class CPUMemoryPlacementTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    FLAGS_cpu_huge_page = "none";
+    FLAGS_cpu_numa_aware_allocation = false;
+    FLAGS_use_pinned_memory = false;
+  }
+};
+
+static void TestCPUAllocator(bool expect_mapped) {
+  CPUAllocator allocator;
+  for (size_t size : {4096UL, kCPUHugePageSize, 3 * kCPUHugePageSize + 1}) {
+    auto allocation = allocator.Allocate(size);
+    ASSERT_EQ(allocation->size(), size);
+    auto ptr = reinterpret_cast<uintptr_t>(allocation->ptr());
+    if (expect_mapped && size >= kCPUHugePageSize) {
+      ASSERT_EQ(ptr % kCPUHugePageSize, 0UL);
+    } else {
+      ASSERT_EQ(ptr % CPUAllocator::kAlignment, 0UL);
+    }
+    memset(allocation->ptr(), 1, size);
+  }
+}
+
+TEST_F(CPUMemoryPlacementTest, Disabled) {
+  EXPECT_FALSE(UseMappedCPUMemory(kCPUHugePageSize));
+  TestCPUAllocator(false);
+}
+
+TEST_F(CPUMemoryPlacementTest, HugePage) {
+  for (std::string huge_page : {"transparent", "explicit"}) {
+    FLAGS_cpu_huge_page = huge_page;
+    EXPECT_FALSE(UseMappedCPUMemory(kCPUHugePageSize - 1));
+    EXPECT_TRUE(UseMappedCPUMemory(kCPUHugePageSize));
+    // explicit falls back to transparent huge pages without reserved ones
+    TestCPUAllocator(true);
+  }
+  FLAGS_cpu_huge_page = "unknown";
+  EXPECT_ANY_THROW(UseMappedCPUMemory(kCPUHugePageSize));
+}
+
+TEST_F(CPUMemoryPlacementTest, NumaAware) {
+#ifdef __linux__
+  EXPECT_GE(CurrentNumaNode(), 0);
+#endif
+  FLAGS_cpu_numa_aware_allocation = true;
+  EXPECT_TRUE(UseMappedCPUMemory(kCPUHugePageSize));
+  TestCPUAllocator(true);
+
+  size_t mapped_size = 0;
+  void* ptr = MapCPUMemory(kCPUHugePageSize + 1, &mapped_size);
+  EXPECT_EQ(mapped_size, 2 * kCPUHugePageSize);
+  memset(ptr, 1, mapped_size);
+  UnmapCPUMemory(ptr, mapped_size);
+}
+
+TEST_F(CPUMemoryPlacementTest, SystemAllocator) {
+  FLAGS_cpu_huge_page = "transparent";
+  for (bool use_pinned_memory : {false, true}) {
+    FLAGS_use_pinned_memory = use_pinned_memory;
+    detail::CPUAllocator allocator;
+    for (size_t size : {2048UL, 3 * kCPUHugePageSize}) {
+      size_t index = 0;
+      void* ptr = allocator.Alloc(&index, size);
+      ASSERT_NE(ptr, nullptr);
+      memset(ptr, 1, size);
+      allocator.Free(ptr, size, index);
+    }
+  }
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
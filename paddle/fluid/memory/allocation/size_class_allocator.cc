@@ -0,0 +1,426 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/size_class_allocator.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "paddle/fluid/memory/stats.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// The classes up to 1KB are multiples of kAlignment, then every power of two
+// is split into 4 classes, so at most 25% of a block is wasted.
+static constexpr size_t kSmallClassNum = 16;
+static constexpr size_t kSmallClassMaxSize =
+    kSmallClassNum * SizeClassAllocator::kAlignment;
+static constexpr size_t kSmallClassMaxShift = 10;
+static_assert(kSmallClassMaxSize == (1UL << kSmallClassMaxShift),
+              "the small classes should end at a power of two");
+
+static size_t Log2Floor(size_t value) {
+  size_t shift = 0;
+  while ((value >> (shift + 1)) != 0) {
+    ++shift;
+  }
+  return shift;
+}
+
+size_t SizeClassAllocator::SizeClass(size_t size) {
+  PADDLE_ENFORCE_LE(
+      size,
+      kMaxClassSize,
+      platform::errors::InvalidArgument(
+          "The size %d is larger than the max class size %d.",
+          size,
+          kMaxClassSize));
+  if (size <= kSmallClassMaxSize) {
+    return size == 0 ? 0 : (size + kAlignment - 1) / kAlignment - 1;
+  }
+  size_t shift = Log2Floor(size - 1);
+  size_t step = 1UL << (shift - 2);
+  size_t index_in_octave = (size - (1UL << shift) + step - 1) / step - 1;
+  return kSmallClassNum + (shift - kSmallClassMaxShift) * 4 + index_in_octave;
+}
+
+size_t SizeClassAllocator::ClassSize(size_t size_class) {
+  if (size_class < kSmallClassNum) {
+    return (size_class + 1) * kAlignment;
+  }
+  size_t shift = kSmallClassMaxShift + (size_class - kSmallClassNum) / 4;
+  size_t index_in_octave = (size_class - kSmallClassNum) % 4;
+  return (1UL << shift) + (index_in_octave + 1) * (1UL << (shift - 2));
+}
+
+static_assert(SizeClassAllocator::kMaxClassSize ==
+                  (1UL << (kSmallClassMaxShift +
+                           (SizeClassAllocator::kSizeClassNum -
+                            kSmallClassNum) /
+                               4)),
+              "kSizeClassNum does not match kMaxClassSize");
+
+// Number of blocks moved between a thread cache and the central pool at once,
+// about 64KB but at least 2 and at most 32 blocks.
+static size_t BatchSize(size_t size_class) {
+  size_t batch_size = (64UL << 10) / SizeClassAllocator::ClassSize(size_class);
+  return std::min<size_t>(std::max<size_t>(batch_size, 2), 32);
+}
+
+static size_t SpanSize(size_t size_class) {
+  return std::max<size_t>(64UL << 10,
+                          8 * SizeClassAllocator::ClassSize(size_class));
+}
+
+struct SizeClassAllocator::Span {
+  DecoratedAllocationPtr allocation;
+  std::vector<std::unique_ptr<Block>> blocks;
+};
+
+// The free blocks of every class shared by all threads, each class has its
+// own lock.
+class SizeClassAllocator::CentralPool {
+ public:
+  explicit CentralPool(std::shared_ptr<Allocator> underlying_allocator)
+      : underlying_allocator_(std::move(underlying_allocator)) {}
+
+  ~CentralPool() {
+    for (auto& free_list : free_lists_) {
+      HOST_MEMORY_STAT_UPDATE(
+          Cached, 0, -static_cast<int64_t>(free_list.cached_bytes));
+    }
+  }
+
+  // Pop at most num blocks of size_class, a new span is carved if there is
+  // no free block.
+  Block* Fetch(size_t size_class, size_t num, size_t* fetched_num) {
+    FreeList& free_list = free_lists_[size_class];
+    std::lock_guard<std::mutex> guard(free_list.mutex);
+    if (free_list.head == nullptr) {
+      NewSpan(size_class, &free_list);
+    }
+    Block* head = free_list.head;
+    Block* tail = head;
+    size_t count = 1;
+    while (count < num && tail->next != nullptr) {
+      tail = tail->next;
+      ++count;
+    }
+    free_list.head = tail->next;
+    tail->next = nullptr;
+    free_list.length -= count;
+    size_t bytes = count * ClassSize(size_class);
+    free_list.cached_bytes -= bytes;
+    HOST_MEMORY_STAT_UPDATE(Cached, 0, -static_cast<int64_t>(bytes));
+    central_fetches_.fetch_add(1, std::memory_order_relaxed);
+    *fetched_num = count;
+    return head;
+  }
+
+  // Push the num blocks linked from head.
+  void Return(size_t size_class, Block* head, size_t num) {
+    if (head == nullptr) {
+      return;
+    }
+    Block* tail = head;
+    while (tail->next != nullptr) {
+      tail = tail->next;
+    }
+    FreeList& free_list = free_lists_[size_class];
+    std::lock_guard<std::mutex> guard(free_list.mutex);
+    tail->next = free_list.head;
+    free_list.head = head;
+    free_list.length += num;
+    size_t bytes = num * ClassSize(size_class);
+    free_list.cached_bytes += bytes;
+    HOST_MEMORY_STAT_UPDATE(Cached, 0, static_cast<int64_t>(bytes));
+  }
+
+  // Free the spans whose blocks are all in the central pool.
+  uint64_t Release() {
+    uint64_t released_bytes = 0;
+    for (size_t size_class = 0; size_class < kSizeClassNum; ++size_class) {
+      FreeList& free_list = free_lists_[size_class];
+      std::lock_guard<std::mutex> guard(free_list.mutex);
+      std::unordered_map<Span*, size_t> free_block_num;
+      for (Block* block = free_list.head; block != nullptr;
+           block = block->next) {
+        ++free_block_num[block->span];
+      }
+      auto is_idle = [&free_block_num](Span* span) {
+        auto iter = free_block_num.find(span);
+        return iter != free_block_num.end() &&
+               iter->second == span->blocks.size();
+      };
+      Block dummy(nullptr, 0, platform::CPUPlace());
+      Block* tail = &dummy;
+      size_t length = 0;
+      for (Block* block = free_list.head; block != nullptr;
+           block = block->next) {
+        if (!is_idle(block->span)) {
+          tail->next = block;
+          tail = block;
+          ++length;
+        }
+      }
+      tail->next = nullptr;
+      free_list.head = dummy.next;
+      size_t released_block_bytes =
+          (free_list.length - length) * ClassSize(size_class);
+      free_list.length = length;
+      free_list.cached_bytes -= released_block_bytes;
+      HOST_MEMORY_STAT_UPDATE(
+          Cached, 0, -static_cast<int64_t>(released_block_bytes));
+
+      uint64_t released_span_bytes = 0;
+      auto& spans = free_list.spans;
+      for (auto iter = spans.begin(); iter != spans.end();) {
+        if (is_idle(iter->get())) {
+          released_span_bytes += (*iter)->allocation->size();
+          iter = spans.erase(iter);
+        } else {
+          ++iter;
+        }
+      }
+      span_bytes_.fetch_sub(released_span_bytes, std::memory_order_relaxed);
+      released_bytes += released_span_bytes;
+    }
+    return released_bytes;
+  }
+
+  Stats GetStats() {
+    Stats stats;
+    stats.span_bytes = span_bytes_.load(std::memory_order_relaxed);
+    stats.central_fetches = central_fetches_.load(std::memory_order_relaxed);
+    for (auto& free_list : free_lists_) {
+      std::lock_guard<std::mutex> guard(free_list.mutex);
+      stats.central_cached_bytes += free_list.cached_bytes;
+    }
+    return stats;
+  }
+
+ private:
+  struct FreeList {
+    std::mutex mutex;
+    Block* head{nullptr};
+    size_t length{0};
+    size_t cached_bytes{0};
+    std::vector<std::unique_ptr<Span>> spans;
+  };
+
+  void NewSpan(size_t size_class, FreeList* free_list) {
+    size_t class_size = ClassSize(size_class);
+    size_t span_size = SpanSize(size_class);
+    auto span = std::make_unique<Span>();
+    span->allocation = static_unique_ptr_cast<Allocation>(
+        underlying_allocator_->Allocate(span_size));
+    // the span may be larger than requested
+    size_t block_num = span->allocation->size() / class_size;
+    char* base = static_cast<char*>(span->allocation->ptr());
+    PADDLE_ENFORCE_EQ(
+        reinterpret_cast<uintptr_t>(base) % kAlignment,
+        0,
+        platform::errors::PreconditionNotMet(
+            "The underlying allocator of SizeClassAllocator should allocate "
+            "memory aligned to %d bytes.",
+            kAlignment));
+    span->blocks.reserve(block_num);
+    for (size_t i = 0; i < block_num; ++i) {
+      auto block = std::make_unique<Block>(
+          base + i * class_size, class_size, span->allocation->place());
+      block->span = span.get();
+      block->size_class = size_class;
+      block->next = free_list->head;
+      free_list->head = block.get();
+      span->blocks.emplace_back(std::move(block));
+    }
+    free_list->length += block_num;
+    free_list->cached_bytes += block_num * class_size;
+    HOST_MEMORY_STAT_UPDATE(
+        Cached, 0, static_cast<int64_t>(block_num * class_size));
+    span_bytes_.fetch_add(span->allocation->size(), std::memory_order_relaxed);
+    free_list->spans.emplace_back(std::move(span));
+  }
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::array<FreeList, kSizeClassNum> free_lists_;
+  std::atomic<uint64_t> span_bytes_{0};
+  std::atomic<uint64_t> central_fetches_{0};
+};
+
+// The free blocks cached by one thread, only touched by the thread.
+class SizeClassAllocator::ThreadCache {
+ public:
+  explicit ThreadCache(std::shared_ptr<CentralPool> central_pool)
+      : central_pool_(std::move(central_pool)) {}
+
+  ~ThreadCache() {
+    for (size_t size_class = 0; size_class < kSizeClassNum; ++size_class) {
+      central_pool_->Return(size_class,
+                            free_lists_[size_class].head,
+                            free_lists_[size_class].length);
+    }
+  }
+
+  Block* Allocate(size_t size_class) {
+    FreeList& free_list = free_lists_[size_class];
+    if (free_list.head == nullptr) {
+      free_list.head = central_pool_->Fetch(
+          size_class, BatchSize(size_class), &free_list.length);
+    }
+    Block* block = free_list.head;
+    free_list.head = block->next;
+    --free_list.length;
+    block->next = nullptr;
+    return block;
+  }
+
+  void Free(Block* block) {
+    size_t size_class = block->size_class;
+    FreeList& free_list = free_lists_[size_class];
+    block->next = free_list.head;
+    free_list.head = block;
+    ++free_list.length;
+    size_t batch_size = BatchSize(size_class);
+    if (free_list.length > 2 * batch_size) {
+      // keep the recently freed blocks, which are likely still in cache
+      Block* tail = free_list.head;
+      for (size_t i = 1; i < batch_size; ++i) {
+        tail = tail->next;
+      }
+      Block* returned = tail->next;
+      tail->next = nullptr;
+      central_pool_->Return(
+          size_class, returned, free_list.length - batch_size);
+      free_list.length = batch_size;
+    }
+  }
+
+ private:
+  struct FreeList {
+    Block* head{nullptr};
+    size_t length{0};
+  };
+
+  std::shared_ptr<CentralPool> central_pool_;
+  std::array<FreeList, kSizeClassNum> free_lists_;
+};
+
+namespace {
+
+template <typename ThreadCache>
+struct ThreadCacheMap {
+  ThreadCacheMap() {
+    // The thread caches free blocks and spans when the thread exits, which
+    // updates these thread local stats. Touch them first so that they are
+    // destroyed after this map.
+    HOST_MEMORY_STAT_UPDATE(Cached, 0, 0);
+    HOST_MEMORY_STAT_UPDATE(Reserved, 0, 0);
+  }
+
+  ~ThreadCacheMap() { destroyed = true; }
+
+  std::unordered_map<uint64_t, std::unique_ptr<ThreadCache>> caches;
+  uint64_t last_id{UINT64_MAX};
+  ThreadCache* last_cache{nullptr};
+
+  // set when the thread is exiting, the blocks are freed to the central pool
+  // directly then
+  static thread_local bool destroyed;
+};
+
+template <typename ThreadCache>
+thread_local bool ThreadCacheMap<ThreadCache>::destroyed = false;
+
+}  // namespace
+
+SizeClassAllocator::SizeClassAllocator(
+    const std::shared_ptr<Allocator>& underlying_allocator)
+    : id_([] {
+        static std::atomic<uint64_t> next_id{0};
+        return next_id.fetch_add(1);
+      }()),
+      underlying_allocator_(underlying_allocator),
+      central_pool_(std::make_shared<CentralPool>(underlying_allocator)) {}
+
+// NOTE: the threads still caching blocks keep the central pool alive until
+// they exit.
+SizeClassAllocator::~SizeClassAllocator() = default;
+
+SizeClassAllocator::ThreadCache* SizeClassAllocator::GetThreadCache() {
+  using CacheMap = ThreadCacheMap<ThreadCache>;
+  if (CacheMap::destroyed) {
+    return nullptr;
+  }
+  thread_local CacheMap cache_map;
+  if (cache_map.last_id == id_) {
+    return cache_map.last_cache;
+  }
+  auto& cache = cache_map.caches[id_];
+  if (cache == nullptr) {
+    cache = std::make_unique<ThreadCache>(central_pool_);
+  }
+  cache_map.last_id = id_;
+  cache_map.last_cache = cache.get();
+  return cache_map.last_cache;
+}
+
+phi::Allocation* SizeClassAllocator::AllocateImpl(size_t size) {
+  if (size > kMaxClassSize) {
+    auto allocation = static_unique_ptr_cast<Allocation>(
+        underlying_allocator_->Allocate(size));
+    auto* block = new Block(
+        allocation->ptr(), allocation->size(), allocation->place());
+    block->large_allocation = std::move(allocation);
+    return block;
+  }
+  size_t size_class = SizeClass(size);
+  ThreadCache* cache = GetThreadCache();
+  if (UNLIKELY(cache == nullptr)) {
+    size_t fetched_num = 0;
+    return central_pool_->Fetch(size_class, 1, &fetched_num);
+  }
+  return cache->Allocate(size_class);
+}
+
+void SizeClassAllocator::FreeImpl(phi::Allocation* allocation) {
+  auto* block = static_cast<Block*>(allocation);
+  if (block->span == nullptr) {
+    delete block;
+    return;
+  }
+  ThreadCache* cache = GetThreadCache();
+  if (UNLIKELY(cache == nullptr)) {
+    block->next = nullptr;
+    central_pool_->Return(block->size_class, block, 1);
+    return;
+  }
+  cache->Free(block);
+}
+
+uint64_t SizeClassAllocator::ReleaseImpl(const platform::Place& place) {
+  return central_pool_->Release() + underlying_allocator_->Release(place);
+}
+
+SizeClassAllocator::Stats SizeClassAllocator::GetStats() const {
+  return central_pool_->GetStats();
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,98 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// A tcmalloc style allocator for many threads allocating small blocks.
+//
+// The sizes up to kMaxClassSize are rounded up to one of kSizeClassNum size
+// classes. Every thread caches the free blocks of each class in a list, so
+// most allocations and frees take no lock. The blocks are carved from spans
+// of the underlying allocator by a central pool, which also takes the blocks
+// overflowing the thread caches in batches. Larger sizes go to the underlying
+// allocator directly.
+//
+// Release frees the spans whose blocks are all in the central pool, the
+// blocks cached by threads are returned when the threads exit.
+class SizeClassAllocator : public Allocator {
+ public:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kMaxClassSize = 256 << 10;
+  static constexpr size_t kSizeClassNum = 48;
+
+  explicit SizeClassAllocator(
+      const std::shared_ptr<Allocator>& underlying_allocator);
+  ~SizeClassAllocator() override;
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // The class of size, size must not be larger than kMaxClassSize.
+  static size_t SizeClass(size_t size);
+  static size_t ClassSize(size_t size_class);
+
+  struct Stats {
+    // bytes allocated from the underlying allocator for spans
+    uint64_t span_bytes = 0;
+    // bytes of the free blocks in the central pool
+    uint64_t central_cached_bytes = 0;
+    // batches moved from the central pool to the thread caches
+    uint64_t central_fetches = 0;
+  };
+
+  Stats GetStats() const;
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+  void FreeImpl(phi::Allocation* allocation) override;
+  uint64_t ReleaseImpl(const platform::Place& place) override;
+
+ private:
+  class CentralPool;
+  class ThreadCache;
+  struct Span;
+
+  struct Block : public Allocation {
+    Block(void* ptr, size_t size, const platform::Place& place)
+        : Allocation(ptr, size, place) {}
+
+    // the owner of a class block, nullptr for large blocks
+    Span* span{nullptr};
+    size_t size_class{0};
+    Block* next{nullptr};
+    // only for large blocks
+    DecoratedAllocationPtr large_allocation;
+  };
+
+  ThreadCache* GetThreadCache();
+
+  const uint64_t id_;
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::shared_ptr<CentralPool> central_pool_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
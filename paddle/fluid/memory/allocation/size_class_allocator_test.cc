@@ -0,0 +1,244 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/size_class_allocator.h"
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
+
+// run with --size_class_bench_iterations=10000000 for the full benchmark
+DEFINE_int32(size_class_bench_iterations,
+             200000,
+             "number of allocations done by every thread in the benchmark");
+DEFINE_int32(size_class_bench_max_threads,
+             16,
+             "the benchmark runs with 1, 2, 4, ... up to this many threads");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// Counts the bytes alive in the underlying allocator.
+class RecordedAllocator : public Allocator {
+ public:
+  bool IsAllocThreadSafe() const override { return true; }
+
+  int64_t AllocatedSize() const { return allocated_size_.load(); }
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override {
+    allocated_size_ += size;
+    return cpu_allocator_.Allocate(size).release();
+  }
+
+  void FreeImpl(phi::Allocation *allocation) override {
+    allocated_size_ -= allocation->size();
+    cpu_allocator_.Free(allocation);
+  }
+
+ private:
+  CPUAllocator cpu_allocator_;
+  std::atomic<int64_t> allocated_size_{0};
+};
+
+TEST(SizeClassAllocator, SizeClass) {
+  size_t last_class_size = 0;
+  for (size_t size_class = 0; size_class < SizeClassAllocator::kSizeClassNum;
+       ++size_class) {
+    size_t class_size = SizeClassAllocator::ClassSize(size_class);
+    ASSERT_GT(class_size, last_class_size);
+    ASSERT_EQ(class_size % SizeClassAllocator::kAlignment, 0UL);
+    ASSERT_EQ(SizeClassAllocator::SizeClass(class_size), size_class);
+    ASSERT_EQ(SizeClassAllocator::SizeClass(last_class_size + 1), size_class);
+    last_class_size = class_size;
+  }
+  ASSERT_EQ(last_class_size, SizeClassAllocator::kMaxClassSize);
+  ASSERT_EQ(SizeClassAllocator::SizeClass(0), 0UL);
+
+  for (size_t size = 1; size <= SizeClassAllocator::kMaxClassSize;
+       size += 37) {
+    size_t class_size =
+        SizeClassAllocator::ClassSize(SizeClassAllocator::SizeClass(size));
+    ASSERT_GE(class_size, size);
+    // at most 25% wasted beyond the small classes
+    ASSERT_LE(class_size, std::max<size_t>(size * 5 / 4 + 1, size + 63));
+  }
+  ASSERT_ANY_THROW(
+      SizeClassAllocator::SizeClass(SizeClassAllocator::kMaxClassSize + 1));
+}
+
+TEST(SizeClassAllocator, AllocateAndReuse) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto allocator = std::make_shared<SizeClassAllocator>(recorded_allocator);
+
+  std::vector<AllocationPtr> allocations;
+  std::set<void *> ptrs;
+  for (size_t size : {1, 64, 65, 1000, 1025, 5000, 100000, 256 << 10}) {
+    for (int i = 0; i < 10; ++i) {
+      auto allocation = allocator->Allocate(size);
+      ASSERT_GE(allocation->size(), size);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(allocation->ptr()) %
+                    SizeClassAllocator::kAlignment,
+                0UL);
+      ASSERT_TRUE(ptrs.insert(allocation->ptr()).second);
+      memset(allocation->ptr(), 0xff, size);
+      allocations.emplace_back(std::move(allocation));
+    }
+  }
+  int64_t span_bytes = recorded_allocator->AllocatedSize();
+  ASSERT_EQ(allocator->GetStats().span_bytes,
+            static_cast<uint64_t>(span_bytes));
+
+  // the freed blocks are reused without allocating new spans
+  void *ptr = allocations.back()->ptr();
+  allocations.pop_back();
+  ASSERT_EQ(allocator->Allocate(256 << 10)->ptr(), ptr);
+  allocations.clear();
+  for (int i = 0; i < 10; ++i) {
+    allocations.emplace_back(allocator->Allocate(5000));
+  }
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), span_bytes);
+  allocations.clear();
+
+  // large allocations bypass the size classes
+  auto large = allocator->Allocate(SizeClassAllocator::kMaxClassSize + 1);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(),
+            span_bytes + static_cast<int64_t>(large->size()));
+  large.reset();
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), span_bytes);
+}
+
+TEST(SizeClassAllocator, FreeInOtherThreads) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto allocator = std::make_shared<SizeClassAllocator>(recorded_allocator);
+
+  std::vector<AllocationPtr> allocations;
+  std::thread([&allocator, &allocations] {
+    for (int i = 0; i < 1000; ++i) {
+      allocations.emplace_back(allocator->Allocate(128));
+    }
+  }).join();
+  std::thread([&allocations] { allocations.clear(); }).join();
+
+  // the exited threads returned their blocks, so all spans are idle
+  ASSERT_GT(allocator->GetStats().central_cached_bytes, 0UL);
+  allocator->Release(platform::CPUPlace());
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0);
+  ASSERT_EQ(allocator->GetStats().span_bytes, 0UL);
+}
+
+TEST(SizeClassAllocator, MultiThread) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto allocator = std::make_shared<SizeClassAllocator>(recorded_allocator);
+
+  const int thread_num = 8;
+  std::vector<std::thread> threads;
+  for (int thread_id = 0; thread_id < thread_num; ++thread_id) {
+    threads.emplace_back([&allocator, thread_id] {
+      std::mt19937 rng(thread_id);
+      std::uniform_int_distribution<size_t> size_dist(1, 300 << 10);
+      std::vector<std::pair<AllocationPtr, uint8_t>> allocations;
+      for (int i = 0; i < 20000; ++i) {
+        if (allocations.size() < 64 && rng() % 3 != 0) {
+          // mostly small sizes
+          size_t size = size_dist(rng) >> (rng() % 10);
+          auto allocation = allocator->Allocate(size);
+          uint8_t value = static_cast<uint8_t>(rng());
+          memset(allocation->ptr(), value, allocation->size());
+          allocations.emplace_back(std::move(allocation), value);
+        } else if (!allocations.empty()) {
+          size_t index = rng() % allocations.size();
+          auto &allocation = allocations[index].first;
+          auto *data = static_cast<uint8_t *>(allocation->ptr());
+          for (size_t j = 0; j < allocation->size(); j += 61) {
+            ASSERT_EQ(data[j], allocations[index].second);
+          }
+          std::swap(allocations[index], allocations.back());
+          allocations.pop_back();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  allocator->Release(platform::CPUPlace());
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0);
+}
+
+// Every thread keeps a window of live small allocations and frees the oldest
+// one after each allocation, like the tensors of a running model.
+static double BenchmarkThroughput(const std::shared_ptr<Allocator> &allocator,
+                                  int thread_num) {
+  const int iterations = FLAGS_size_class_bench_iterations;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int thread_id = 0; thread_id < thread_num; ++thread_id) {
+    threads.emplace_back([&allocator, iterations, thread_id] {
+      std::mt19937 rng(thread_id);
+      std::vector<AllocationPtr> window(32);
+      for (int i = 0; i < iterations; ++i) {
+        size_t size = (rng() % 4096) + 1;
+        window[i % window.size()] = allocator->Allocate(size);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return static_cast<double>(iterations) * thread_num / seconds;
+}
+
+// Only logs timings, run it with --gtest_also_run_disabled_tests.
+TEST(SizeClassAllocator, DISABLED_ContentionBenchmark) {
+  std::vector<std::pair<std::string, std::shared_ptr<Allocator>>> allocators;
+  allocators.emplace_back("cpu", std::make_shared<CPUAllocator>());
+  allocators.emplace_back(
+      "naive_best_fit",
+      std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace()));
+  allocators.emplace_back("auto_growth",
+                          std::make_shared<AutoGrowthBestFitAllocator>(
+                              std::make_shared<CPUAllocator>(), 64));
+  allocators.emplace_back(
+      "size_class",
+      std::make_shared<SizeClassAllocator>(std::make_shared<CPUAllocator>()));
+
+  for (int thread_num = 1; thread_num <= FLAGS_size_class_bench_max_threads;
+       thread_num *= 2) {
+    for (auto &allocator : allocators) {
+      double throughput = BenchmarkThroughput(allocator.second, thread_num);
+      LOG(INFO) << "allocator " << allocator.first << ", threads "
+                << thread_num << ": " << throughput / 1e6
+                << " M allocations/s";
+    }
+  }
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -28,6 +28,7 @@ limitations under the License. */
 #endif
 
 #include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_memory_placement.h"
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/phi/backends/cpu/cpu_info.h"
@@ -73,6 +74,10 @@ void* AlignedMalloc(size_t size) {
   return p;
 }
 
+// The bits of the index of CPU memory.
+static constexpr size_t kLockedCPUMemory = 1;
+static constexpr size_t kMappedCPUMemory = 2;
+
 void* CPUAllocator::Alloc(size_t* index, size_t size) {
   // According to http://www.cplusplus.com/reference/cstdlib/malloc/,
   // malloc might not return nullptr if size is zero, but the returned
@@ -81,11 +86,18 @@ void* CPUAllocator::Alloc(size_t* index, size_t size) {
 
   *index = 0;  // unlock memory
 
-  void* p = AlignedMalloc(size);
+  void* p = nullptr;
+  if (allocation::UseMappedCPUMemory(size)) {
+    size_t mapped_size = 0;
+    p = allocation::MapCPUMemory(size, &mapped_size);
+    *index = kMappedCPUMemory;
+  } else {
+    p = AlignedMalloc(size);
+  }
 
   if (p != nullptr) {
     if (FLAGS_use_pinned_memory) {
-      *index = 1;
+      *index |= kLockedCPUMemory;
 #ifdef _WIN32
       VirtualLock(p, size);
 #else
@@ -101,7 +113,7 @@ void* CPUAllocator::Alloc(size_t* index, size_t size) {
 }
 
 void CPUAllocator::Free(void* p, size_t size, size_t index) {
-  if (p != nullptr && index == 1) {
+  if (p != nullptr && (index & kLockedCPUMemory)) {
 #ifdef _WIN32
     VirtualUnlock(p, size);
 #else
@@ -111,6 +123,14 @@ void CPUAllocator::Free(void* p, size_t size, size_t index) {
   HOST_MEMORY_STAT_UPDATE(Reserved, 0, -size);
   platform::RecordMemEvent(
       p, CPUPlace(), size, platform::TracerMemEventType::ReservedFree);
+  if (index & kMappedCPUMemory) {
+    // the mapped size is size aligned to huge pages
+    allocation::UnmapCPUMemory(
+        p,
+        (size + allocation::kCPUHugePageSize - 1) /
+            allocation::kCPUHugePageSize * allocation::kCPUHugePageSize);
+    return;
+  }
 #ifdef _WIN32
   _aligned_free(p);
 #else
@@ -136,6 +136,7 @@ int RegisterAllStats() {
 
   HOST_MEMORY_STAT_REGISTER(Allocated);
   HOST_MEMORY_STAT_REGISTER(Reserved);
+  HOST_MEMORY_STAT_REGISTER(Cached);
   return 0;
 }
 
@@ -41,6 +41,8 @@ class StatBase {
 
   virtual int64_t GetCurrentValue() = 0;
   virtual int64_t GetPeakValue() = 0;
+  // the sum of the updates made by the current thread
+  virtual int64_t GetThreadLocalValue() = 0;
   virtual void Update(int64_t) = 0;
 
  private:
@@ -68,6 +70,12 @@ class Stat : public StatBase {
 
   int64_t GetPeakValue() override { return peak_value_; }
 
+  int64_t GetThreadLocalValue() override {
+    return ThreadDataRegistry<ThreadLocalStatType>::GetInstance()
+        .GetCurrentThreadData()
+        .current;
+  }
+
   void Update(int64_t increment) override {
     auto& thread_data_registry =
         ThreadDataRegistry<ThreadLocalStatType>::GetInstance();
@@ -162,6 +170,8 @@ void HostMemoryStatUpdate(const std::string& stat_type,
   DEVICE_MEMORY_STAT_FUNC(item, id, GetCurrentValue)
 #define DEVICE_MEMORY_STAT_PEAK_VALUE(item, id) \
   DEVICE_MEMORY_STAT_FUNC(item, id, GetPeakValue)
+#define DEVICE_MEMORY_STAT_THREAD_LOCAL_VALUE(item, id) \
+  DEVICE_MEMORY_STAT_FUNC(item, id, GetThreadLocalValue)
 #define DEVICE_MEMORY_STAT_UPDATE(item, id, increment) \
   DEVICE_MEMORY_STAT_FUNC(item, id, Update, increment)
 
@@ -182,6 +192,8 @@ void HostMemoryStatUpdate(const std::string& stat_type,
   HOST_MEMORY_STAT_FUNC(item, id, GetCurrentValue)
 #define HOST_MEMORY_STAT_PEAK_VALUE(item, id) \
   HOST_MEMORY_STAT_FUNC(item, id, GetPeakValue)
+#define HOST_MEMORY_STAT_THREAD_LOCAL_VALUE(item, id) \
+  HOST_MEMORY_STAT_FUNC(item, id, GetThreadLocalValue)
 #define HOST_MEMORY_STAT_UPDATE(item, id, increment) \
   HOST_MEMORY_STAT_FUNC(item, id, Update, increment)
 
@@ -216,6 +228,8 @@ DEVICE_MEMORY_STAT_DECLARE(Reserved);
 
 HOST_MEMORY_STAT_DECLARE(Allocated);
 HOST_MEMORY_STAT_DECLARE(Reserved);
+// bytes of the free blocks in the central pool of SizeClassAllocator
+HOST_MEMORY_STAT_DECLARE(Cached);
 
 }  // namespace memory
 }  // namespace paddle
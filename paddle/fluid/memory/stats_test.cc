@@ -173,5 +173,25 @@ TEST_F(StatsTest, HostReservedTest) {
   RunTests();
 }
 
+TEST(StatsTest, ThreadLocalValueTest) {
+  int64_t main_thread_value = HOST_MEMORY_STAT_THREAD_LOCAL_VALUE(Reserved, 0);
+  HOST_MEMORY_STAT_UPDATE(Reserved, 0, 100);
+  std::thread thread([]() {
+    int64_t value = HOST_MEMORY_STAT_THREAD_LOCAL_VALUE(Reserved, 0);
+    HOST_MEMORY_STAT_UPDATE(Reserved, 0, 1000);
+    EXPECT_EQ(HOST_MEMORY_STAT_THREAD_LOCAL_VALUE(Reserved, 0), value + 1000);
+  });
+  thread.join();
+  EXPECT_EQ(HOST_MEMORY_STAT_THREAD_LOCAL_VALUE(Reserved, 0),
+            main_thread_value + 100);
+  HOST_MEMORY_STAT_UPDATE(Reserved, 0, -100);
+
+  int64_t device_value = DEVICE_MEMORY_STAT_THREAD_LOCAL_VALUE(Allocated, 3);
+  DEVICE_MEMORY_STAT_UPDATE(Allocated, 3, 64);
+  EXPECT_EQ(DEVICE_MEMORY_STAT_THREAD_LOCAL_VALUE(Allocated, 3),
+            device_value + 64);
+  DEVICE_MEMORY_STAT_UPDATE(Allocated, 3, -64);
+}
+
 }  // namespace memory
 }  // namespace paddle
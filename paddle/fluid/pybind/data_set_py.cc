@@ -314,6 +314,9 @@ void BindDataset(py::module *m) {
       .def("set_merge_by_sid",
            &framework::Dataset::SetMergeBySid,
            py::call_guard<py::gil_scoped_release>())
+      .def("set_binary_cache_dir",
+           &framework::Dataset::SetBinaryCacheDir,
+           py::call_guard<py::gil_scoped_release>())
       .def("set_shuffle_by_uid",
            &framework::Dataset::SetShuffleByUid,
            py::call_guard<py::gil_scoped_release>())
@@ -827,6 +827,10 @@ void BindAnalysisConfig(py::module *m) {
       .def("enable_memory_optim",
            &AnalysisConfig::EnableMemoryOptim,
            py::arg("x") = true)
+      .def("enable_mmap_params",
+           &AnalysisConfig::EnableMmapParams,
+           py::arg("x") = true)
+      .def("mmap_params_enabled", &AnalysisConfig::mmap_params_enabled)
       .def("enable_profile", &AnalysisConfig::EnableProfile)
       .def("disable_glog_info", &AnalysisConfig::DisableGlogInfo)
       .def("glog_info_disabled", &AnalysisConfig::glog_info_disabled)
@@ -925,6 +929,15 @@ void BindAnalysisConfig(py::module *m) {
            &AnalysisConfig::SetCpuMathLibraryNumThreads)
       .def("cpu_math_library_num_threads",
            &AnalysisConfig::cpu_math_library_num_threads)
+      .def("enable_cpu_huge_page",
+           &AnalysisConfig::EnableCpuHugePage,
+           py::arg("explicit_huge_page") = false)
+      .def("cpu_huge_page", &AnalysisConfig::cpu_huge_page)
+      .def("enable_cpu_numa_aware_allocation",
+           &AnalysisConfig::EnableCpuNumaAwareAllocation,
+           py::arg("x") = true)
+      .def("cpu_numa_aware_allocation_enabled",
+           &AnalysisConfig::cpu_numa_aware_allocation_enabled)
       .def("to_native_config", &AnalysisConfig::ToNativeConfig)
       .def("enable_quantizer", &AnalysisConfig::EnableMkldnnQuantizer)
       .def("enable_mkldnn_bfloat16", &AnalysisConfig::EnableMkldnnBfloat16)
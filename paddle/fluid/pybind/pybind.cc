@@ -2763,6 +2763,11 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("clear_low_precision_op_list",
         [] { phi::KernelFactory::Instance().ClearLowPrecisionKernelList(); });
 
+  m.def("instruction_statistics_to_json",
+        &framework::InstructionStatisticsToJson);
+  m.def("instruction_statistics_to_prometheus",
+        &framework::InstructionStatisticsToPrometheus);
+
   m.def("enable_autotune", [] {
     return phi::autotune::AutoTuneStatus::Instance().EnableAutoTune();
   });
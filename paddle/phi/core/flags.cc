@@ -35,6 +35,21 @@ PHI_DEFINE_EXPORTED_int32(inner_op_parallelism,
                           0,
                           "number of threads for inner op");
 
+/**
+ * Operator related FLAG
+ * Name: FLAGS_enable_intra_op_parallel
+ * Since Version: 2.6.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_enable_intra_op_parallel=true, CPU kernels split their loops
+ * over the idle threads of the new executor's host thread pool.
+ * Note: No thread is created for intra op parallelism, ops run outside the
+ * new executor are always single threaded.
+ */
+PHI_DEFINE_EXPORTED_bool(enable_intra_op_parallel,
+                         false,
+                         "Whether CPU kernels run their loops in parallel on "
+                         "the thread pool of the new executor.");
+
 /**
  * NOTE(paddle-dev): This file is designed to define all public FLAGS.
  */
@@ -377,6 +392,31 @@ PHI_DEFINE_EXPORTED_bool(
 PHI_DEFINE_EXPORTED_int32(communicator_send_queue_size,
                           20,
                           "queue size to recv gradient before send");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_send_pipeline_depth
+ * Since Version: 2.6.0
+ * Value Range: int32, default=0
+ * Example:
+ * Note: Number of merged gradients of one variable the AsyncCommunicator
+ *       may still be sending while it merges the next batch from the queue.
+ *       0 sends every batch right after merging it, as before.
+ */
+PHI_DEFINE_EXPORTED_int32(communicator_send_pipeline_depth,
+                          0,
+                          "merged batches per var in flight while merging");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_merge_thread_num
+ * Since Version: 2.6.0
+ * Value Range: int32, default=1
+ * Example:
+ * Note: Threads used to merge one batch of queued gradients. Dense tensors
+ *       are summed by ranges, SelectedRows are hash merged by row shards.
+ */
+PHI_DEFINE_EXPORTED_int32(communicator_merge_thread_num,
+                          1,
+                          "threads to merge the gradients of one batch");
 #endif
 
 /**
@@ -465,8 +505,8 @@ PHI_DEFINE_EXPORTED_double(
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
  * Since Version: 1.2
- * Value Range: string, {naive_best_fit, auto_growth, thread_local},
- * default=auto_growth
+ * Value Range: string, {naive_best_fit, auto_growth, thread_local,
+ * size_class}, default=auto_growth
  * Example:
  * Note: For selecting allocator policy of PaddlePaddle.
  */
@@ -484,7 +524,43 @@ PHI_DEFINE_EXPORTED_string(
     "size of models may be larger). auto_growth strategy would allocate "
     "GPU memory on demand, which allows users to start several Paddle jobs "
     "on the same GPU card but may lead to more memory fragmentation "
-    "(i.e., maximum batch size of models may be smaller).");
+    "(i.e., maximum batch size of models may be smaller). "
+    "size_class caches the small CPU allocations in size classed free lists "
+    "of every thread, for many threads allocating small tensors, the devices "
+    "use the naive_best_fit allocators with it.");
+
+/**
+ * Memory related FLAG
+ * Name: FLAGS_cpu_huge_page
+ * Since Version: 2.6
+ * Value Range: string, {none, transparent, explicit}, default=none
+ * Example: FLAGS_cpu_huge_page=transparent
+ * Note: Back the CPU allocations of at least 2MB with 2MB huge pages.
+ *       transparent maps them with madvise(MADV_HUGEPAGE), explicit uses the
+ *       huge pages reserved in /proc/sys/vm/nr_hugepages and falls back to
+ *       transparent when they are exhausted.
+ */
+PHI_DEFINE_EXPORTED_string(
+    cpu_huge_page,
+    "none",
+    "The huge page mode of the CPU allocations of at least 2MB, enum in "
+    "[none, transparent, explicit].");
+
+/**
+ * Memory related FLAG
+ * Name: FLAGS_cpu_numa_aware_allocation
+ * Since Version: 2.6
+ * Value Range: bool, default=false
+ * Example: FLAGS_cpu_numa_aware_allocation=true
+ * Note: Place the CPU allocations of at least 2MB on the NUMA node of the
+ *       CPU the allocating thread runs on, instead of the node of the thread
+ *       touching them first. The other nodes are used when the node is full.
+ */
+PHI_DEFINE_EXPORTED_bool(
+    cpu_numa_aware_allocation,
+    false,
+    "Whether to place the CPU allocations of at least 2MB on the NUMA node "
+    "of the allocating thread.");
 
 /**
  * Memory related FLAG
@@ -881,6 +957,21 @@ PHI_DEFINE_EXPORTED_bool(
     false,
     "It controls get all neighbor id when running sub part graph.");
 
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_graph_edges_in_csr
+ * Since Version: 2.6.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Control whether GraphTable packs the edges of each shard into one
+ *       CSR storage after load_edges, instead of keeping an edge blob and a
+ *       sampler per node. It saves memory for graphs with many small nodes.
+ */
+PHI_DEFINE_EXPORTED_bool(graph_edges_in_csr,
+                         false,
+                         "It controls whether GraphTable stores edges of each "
+                         "shard in csr format after loading.");
+
 /**
  * Distributed related FLAG
  * Name: enable_exit_when_partial_worker
@@ -895,6 +986,23 @@ PHI_DEFINE_EXPORTED_bool(
     false,
     "It controls whether exit trainer when an worker has no ins.");
 
+/**
+ * Distributed related FLAG
+ * Name: enable_sparse_prefetch
+ * Since Version: 2.6.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Control whether the downpour lite worker asks the pservers to
+ *       prefetch the sparse keys of the next batch while it trains the
+ *       current one. It only works with data feeds that can look ahead,
+ *       such as SlotRecordInMemoryDataFeed.
+ */
+PHI_DEFINE_EXPORTED_bool(
+    enable_sparse_prefetch,
+    false,
+    "It controls whether the worker prefetches the sparse keys of the next "
+    "batch.");
+
 /**
  * Distributed related FLAG
  * Name: enable_exit_when_partial_worker
@@ -1069,6 +1177,16 @@ DEFINE_bool(enable_slotrecord_reset_shrink,  // NOLINT
 DEFINE_bool(enable_ins_parser_file,  // NOLINT
             false,
             "enable parser ins file, default false");
+DEFINE_bool(enable_slotrecord_columnar,  // NOLINT
+            false,
+            "enable loading slotrecord objects into columnar blocks, so that "
+            "a batch of consecutive objects is fed without gathering, only "
+            "for the cpu slotrecord data feed, default false");
+DEFINE_bool(slotrecord_columnar_zero_copy,  // NOLINT
+            false,
+            "enable feeding the columnar slotrecord values on cpu without "
+            "copying, the feed tensors share the loaded memory and must not "
+            "be modified in place, default false");
 PHI_DEFINE_EXPORTED_bool(
     gpugraph_enable_hbm_table_collision_stat,
     false,
@@ -0,0 +1,100 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/parallel_for.h"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "paddle/phi/core/flags.h"
+
+PHI_DECLARE_bool(enable_intra_op_parallel);
+
+namespace phi {
+
+static thread_local IntraOpThreadPool* intra_op_thread_pool = nullptr;
+
+IntraOpThreadPool* GetIntraOpThreadPool() { return intra_op_thread_pool; }
+
+void SetIntraOpThreadPool(IntraOpThreadPool* pool) {
+  intra_op_thread_pool = pool;
+}
+
+int GetIntraOpParallelism() {
+  if (!FLAGS_enable_intra_op_parallel || intra_op_thread_pool == nullptr) {
+    return 1;
+  }
+  return intra_op_thread_pool->NumThreads();
+}
+
+namespace detail {
+
+// Shared by the caller and the helper tasks. A helper may be popped from the
+// queue after the loop is done, so it only touches fn after taking a chunk.
+struct ParallelRunState {
+  const std::function<void(int64_t)>* fn;
+  int64_t num_chunks;
+  std::atomic<int64_t> next_chunk{0};
+  std::atomic<int64_t> done_chunks{0};
+  std::mutex mutex;
+  std::exception_ptr exception;
+
+  void RunChunks() {
+    for (int64_t chunk_id = next_chunk.fetch_add(1); chunk_id < num_chunks;
+         chunk_id = next_chunk.fetch_add(1)) {
+      try {
+        (*fn)(chunk_id);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+      done_chunks.fetch_add(1, std::memory_order_release);
+    }
+  }
+};
+
+void ParallelRun(int64_t num_chunks, const std::function<void(int64_t)>& fn) {
+  IntraOpThreadPool* pool = intra_op_thread_pool;
+  if (pool == nullptr || num_chunks <= 1) {
+    for (int64_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id) {
+      fn(chunk_id);
+    }
+    return;
+  }
+
+  auto state = std::make_shared<ParallelRunState>();
+  state->fn = &fn;
+  state->num_chunks = num_chunks;
+  int64_t num_helpers =
+      std::min<int64_t>(num_chunks, pool->NumThreads()) - 1;
+  for (int64_t i = 0; i < num_helpers; ++i) {
+    pool->Schedule([state]() { state->RunChunks(); });
+  }
+  state->RunChunks();
+  // the left chunks are running in other threads
+  while (state->done_chunks.load(std::memory_order_acquire) < num_chunks) {
+    std::this_thread::yield();
+  }
+  if (state->exception) {
+    std::rethrow_exception(state->exception);
+  }
+}
+
+}  // namespace detail
+}  // namespace phi
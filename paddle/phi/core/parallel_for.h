@@ -0,0 +1,138 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace phi {
+
+// Items of a chunk of an element wise loop, enough to amortize the cost of
+// scheduling the chunk on another thread.
+constexpr int64_t kIntraOpGrainSize = 32768;
+
+// The thread pool that runs the tasks of intra op parallel loops.
+//
+// A pool registers itself in each of its worker threads, the kernels running
+// on those threads then split their loops over the same threads. So inter op
+// and intra op parallelism share one pool and never oversubscribe the cores.
+class IntraOpThreadPool {
+ public:
+  virtual ~IntraOpThreadPool() = default;
+
+  // Number of threads of the pool, including the calling one.
+  virtual int NumThreads() const = 0;
+
+  // Schedule fn on the pool. It is called from a worker thread of the pool,
+  // the task should be pushed to a place the idle threads steal from.
+  virtual void Schedule(std::function<void()> fn) = 0;
+};
+
+// The pool registered in the current thread, nullptr if none.
+IntraOpThreadPool* GetIntraOpThreadPool();
+void SetIntraOpThreadPool(IntraOpThreadPool* pool);
+
+// Number of threads ParallelFor may use in the current thread, 1 when
+// FLAGS_enable_intra_op_parallel is off or no pool is registered.
+int GetIntraOpParallelism();
+
+namespace detail {
+
+// Run fn(0), ..., fn(num_chunks - 1) on the pool of the current thread and
+// wait for all of them. The caller runs chunks too, so it never waits for a
+// chunk nobody has started. The first exception is rethrown in the caller.
+void ParallelRun(int64_t num_chunks, const std::function<void(int64_t)>& fn);
+
+}  // namespace detail
+
+// Call fn(chunk_begin, chunk_end) on disjoint ranges covering [begin, end).
+// Every range has at least grain_size items except the last one, so a loop
+// smaller than grain_size runs in the calling thread directly.
+template <typename F>
+void ParallelFor(int64_t begin, int64_t end, int64_t grain_size, const F& fn) {
+  if (begin >= end) {
+    return;
+  }
+  int64_t num = end - begin;
+  grain_size = grain_size > 0 ? grain_size : 1;
+  int parallelism = GetIntraOpParallelism();
+  int64_t num_chunks = (num + grain_size - 1) / grain_size;
+  // a few chunks per thread to balance the load of threads stealing late
+  num_chunks = std::min<int64_t>(num_chunks, 4 * parallelism);
+  if (parallelism <= 1 || num_chunks <= 1) {
+    fn(begin, end);
+    return;
+  }
+  int64_t chunk_size = (num + num_chunks - 1) / num_chunks;
+  num_chunks = (num + chunk_size - 1) / chunk_size;
+  detail::ParallelRun(num_chunks, [&](int64_t chunk_id) {
+    int64_t chunk_begin = begin + chunk_id * chunk_size;
+    int64_t chunk_end = std::min(end, chunk_begin + chunk_size);
+    fn(chunk_begin, chunk_end);
+  });
+}
+
+// Reduce [begin, end) by reduce(..., f(chunk_begin, chunk_end, ident)).
+// The chunks only depend on the size of the range and grain_size, and the
+// partial results are combined in order, so the result is the same with any
+// number of threads.
+template <typename T, typename F, typename R>
+T ParallelReduce(int64_t begin,
+                 int64_t end,
+                 int64_t grain_size,
+                 const T& ident,
+                 const F& f,
+                 const R& reduce) {
+  constexpr int64_t kMaxReduceChunks = 64;
+  if (begin >= end) {
+    return ident;
+  }
+  int64_t num = end - begin;
+  grain_size = grain_size > 0 ? grain_size : 1;
+  int64_t num_chunks = (num + grain_size - 1) / grain_size;
+  num_chunks = std::min(num_chunks, kMaxReduceChunks);
+  if (num_chunks <= 1) {
+    return f(begin, end, ident);
+  }
+  int64_t chunk_size = (num + num_chunks - 1) / num_chunks;
+  num_chunks = (num + chunk_size - 1) / chunk_size;
+  // NOTE: wrapped so that std::vector<bool> is not used, its items can not
+  // be written by different threads
+  struct Partial {
+    T value;
+  };
+  std::vector<Partial> results(num_chunks, Partial{ident});
+  auto run_chunk = [&](int64_t chunk_id) {
+    int64_t chunk_begin = begin + chunk_id * chunk_size;
+    int64_t chunk_end = std::min(end, chunk_begin + chunk_size);
+    results[chunk_id].value = f(chunk_begin, chunk_end, ident);
+  };
+  if (GetIntraOpParallelism() > 1) {
+    detail::ParallelRun(num_chunks, run_chunk);
+  } else {
+    for (int64_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id) {
+      run_chunk(chunk_id);
+    }
+  }
+  T result = ident;
+  for (const Partial& partial : results) {
+    result = reduce(result, partial.value);
+  }
+  return result;
+}
+
+}  // namespace phi
@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/parallel_for.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
 #include "paddle/phi/kernels/funcs/broadcast_function.h"
 #include "paddle/phi/kernels/funcs/common_shape.h"
@@ -44,8 +45,14 @@ struct SameDimsAddFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VADD(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    const T* x_data = x.data<T>();
+    const T* y_data = y.data<T>();
+    T* z_data = dev_ctx.template Alloc<T>(z);
+    phi::ParallelFor(
+        0, x.numel(), kIntraOpGrainSize, [&](int64_t begin, int64_t end) {
+          blas.VADD(
+              end - begin, x_data + begin, y_data + begin, z_data + begin);
+        });
   }
 };
 
@@ -86,8 +93,14 @@ struct SameDimsSubtractFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VSUB(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    const T* x_data = x.data<T>();
+    const T* y_data = y.data<T>();
+    T* z_data = dev_ctx.template Alloc<T>(z);
+    phi::ParallelFor(
+        0, x.numel(), kIntraOpGrainSize, [&](int64_t begin, int64_t end) {
+          blas.VSUB(
+              end - begin, x_data + begin, y_data + begin, z_data + begin);
+        });
   }
 };
 
@@ -142,8 +155,14 @@ struct SameDimsDivideFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VDIV(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    const T* x_data = x.data<T>();
+    const T* y_data = y.data<T>();
+    T* z_data = dev_ctx.template Alloc<T>(z);
+    phi::ParallelFor(
+        0, x.numel(), kIntraOpGrainSize, [&](int64_t begin, int64_t end) {
+          blas.VDIV(
+              end - begin, x_data + begin, y_data + begin, z_data + begin);
+        });
   }
 };
 
@@ -166,8 +185,14 @@ struct SameDimsMultiplyFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VMUL(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    const T* x_data = x.data<T>();
+    const T* y_data = y.data<T>();
+    T* z_data = dev_ctx.template Alloc<T>(z);
+    phi::ParallelFor(
+        0, x.numel(), kIntraOpGrainSize, [&](int64_t begin, int64_t end) {
+          blas.VMUL(
+              end - begin, x_data + begin, y_data + begin, z_data + begin);
+        });
   }
 };
 
@@ -17,6 +17,7 @@
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/core/parallel_for.h"
 #include "paddle/phi/core/utils/data_type.h"
 #include "paddle/phi/kernels/funcs/embedding_util.h"
 
@@ -71,11 +72,7 @@ struct EmbeddingCPUFunctor {
       }
     }
 
-#if defined(_OPENMP) && !defined(PADDLE_WITH_CUDA)
-#pragma omp parallel for
-#endif
-
-    for (int64_t i = 0; i < ids_numel; ++i) {
+    auto lookup = [&](int64_t i) {
       if (padding_idx_ != kNoPadding && ids[i] == padding_idx_) {
         memset(output + i * row_width, 0, row_width * sizeof(T));
       } else {
@@ -83,6 +80,26 @@ struct EmbeddingCPUFunctor {
                table + ids[i] * row_width,
                row_width * sizeof(T));
       }
+    };
+
+    // share the threads of the executor instead of starting OpenMP threads
+    if (GetIntraOpParallelism() > 1) {
+      int64_t grain_size =
+          kIntraOpGrainSize / std::max<int64_t>(row_width, 1) + 1;
+      ParallelFor(0, ids_numel, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          lookup(i);
+        }
+      });
+      return;
+    }
+
+#if defined(_OPENMP) && !defined(PADDLE_WITH_CUDA)
+#pragma omp parallel for
+#endif
+
+    for (int64_t i = 0; i < ids_numel; ++i) {
+      lookup(i);
     }
   }
 
@@ -18,6 +18,7 @@
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "paddle/phi/api/profiler/device_tracer.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/enforce.h"
@@ -114,8 +115,18 @@ void BenchAllImpls(const typename KernelTuple::attr_type& attr, Args... args) {
   std::vector<std::pair<std::string, double>> infos;
   auto funcs = jit::GetAllCandidateFuncsWithTypes<KernelTuple, PlaceType>(attr);
   for (auto f : funcs) {
+    // the jitcode is benchmarked below with the others of every ISA
+    if (f.first == "JitCode") {
+      continue;
+    }
     infos.push_back(std::make_pair(f.first, benchmark(f.second, args...)));
   }
+  auto codes = jit::CreateAllJitCodes<KernelTuple, PlaceType>(attr);
+  for (auto& code : codes) {
+    auto func = code->template getCode<typename KernelTuple::func_type>();
+    infos.push_back(std::make_pair("JitCode(" + code->name() + ")",
+                                   benchmark(func, args...)));
+  }
 
   // Test result from Get function
   auto tgt = jit::KernelFuncs<KernelTuple, PlaceType>::Cache().At(attr);
@@ -124,12 +135,22 @@ void BenchAllImpls(const typename KernelTuple::attr_type& attr, Args... args) {
   }
   infos.push_back(std::make_pair("Target", benchmark(tgt, args...)));
 
-  // print
+  // print, with the speedup over the refer code
+  double refer_time = 0;
+  for (auto pair : infos) {
+    if (pair.first == "Refer") {
+      refer_time = pair.second;
+    }
+  }
   std::ostringstream loginfos;
   loginfos << "Kernel Type " << jit::to_string(KernelTuple::kernel_type) << ": "
            << attr << ": ";
   for (auto pair : infos) {
-    loginfos << pair.first << " takes " << pair.second << " us; ";
+    loginfos << pair.first << " takes " << pair.second << " us";
+    if (refer_time > 0 && pair.second > 0) {
+      loginfos << " (" << refer_time / pair.second << "x)";
+    }
+    loginfos << "; ";
   }
   LOG(INFO) << loginfos.str();
 }
@@ -550,6 +571,10 @@ int main(int argc, char* argv[]) {
   google::InitGoogleLogging(argv[0]);
   LOG(INFO) << "Burning " << FLAGS_burning << " times, Repeat " << FLAGS_repeat
             << " times.";
+  using phi::backends::cpu::MayIUse;
+  LOG(INFO) << "ISA: avx " << MayIUse(phi::backends::cpu::avx) << ", avx2 "
+            << MayIUse(phi::backends::cpu::avx2) << ", avx512f "
+            << MayIUse(phi::backends::cpu::avx512f);
 
   RUN_ALL_BENCHMARK();
 }
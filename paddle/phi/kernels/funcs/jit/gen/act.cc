@@ -47,13 +47,23 @@ int ALIGN32_BEG g_tmp_mem[16] ALIGN32_END = {0};      // NOLINT
 
 void VActJitCode::genCode() {
   int offset = 0;
-  for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
+  int rest = num_;
+  if (use_avx512_) {
+    for (int i = 0; i < num_ / ZMM_FLOAT_BLOCK; ++i) {
+      vmovups(zmm_src, ptr[param1 + offset]);
+      act_zmm(zmm_dst, zmm_src, type_);
+      vmovups(ptr[param2 + offset], zmm_dst);
+      offset += sizeof(float) * ZMM_FLOAT_BLOCK;
+    }
+    rest = num_ % ZMM_FLOAT_BLOCK;
+  }
+  for (int i = 0; i < rest / YMM_FLOAT_BLOCK; ++i) {
     vmovups(ymm_src, ptr[param1 + offset]);
     act<ymm_t>(ymm_dst, ymm_src, type_);
     vmovups(ptr[param2 + offset], ymm_dst);
     offset += sizeof(float) * YMM_FLOAT_BLOCK;
   }
-  int rest = num_ % YMM_FLOAT_BLOCK;
+  rest = rest % YMM_FLOAT_BLOCK;
   while (rest > 0) {
     int block = XMM_FLOAT_BLOCK;
     if (rest >= 4) {
@@ -77,6 +87,10 @@ void VActJitCode::genCode() {
     offset += sizeof(float) * block;
     rest -= block;
   }
+  if (use_avx512_) {
+    // avoid the penalty of the sse code after the dirty upper zmm
+    vzeroupper();
+  }
   ret();
 }
 
@@ -86,7 +100,17 @@ void VActJitCode::genCode() {
     bool CanBeUsed(const int& attr) const override;                          \
     size_t CodeSize(const int& d) const override;                            \
     std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
-      return make_unique<name##JitCode>(attr, CodeSize(attr));               \
+      return make_unique<name##JitCode>(attr, false, CodeSize(attr));        \
+    }                                                                        \
+  };                                                                         \
+  class name##AVX512Creator : public name##Creator {                         \
+   public:                                                                   \
+    bool CanBeUsed(const int& attr) const override {                         \
+      return phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f) &&     \
+             attr >= ZMM_FLOAT_BLOCK && name##Creator::CanBeUsed(attr);      \
+    }                                                                        \
+    std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
+      return make_unique<name##JitCode>(attr, true, CodeSize(attr));         \
     }                                                                        \
   }
 
@@ -155,9 +179,15 @@ size_t VTanhCreator::CodeSize(const int& d) const {
 
 namespace gen = phi::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kVRelu, gen::VReluCreator);
-REGISTER_JITKERNEL_GEN(kVSquare, gen::VSquareCreator);
-REGISTER_JITKERNEL_GEN(kVIdentity, gen::VIdentityCreator);
-REGISTER_JITKERNEL_GEN(kVExp, gen::VExpCreator);
-REGISTER_JITKERNEL_GEN(kVSigmoid, gen::VSigmoidCreator);
-REGISTER_JITKERNEL_GEN(kVTanh, gen::VTanhCreator);
+REGISTER_JITKERNEL_GEN(kVRelu, gen::VReluAVX512Creator, gen::VReluCreator);
+REGISTER_JITKERNEL_GEN(kVSquare,
+                       gen::VSquareAVX512Creator,
+                       gen::VSquareCreator);
+REGISTER_JITKERNEL_GEN(kVIdentity,
+                       gen::VIdentityAVX512Creator,
+                       gen::VIdentityCreator);
+REGISTER_JITKERNEL_GEN(kVExp, gen::VExpAVX512Creator, gen::VExpCreator);
+REGISTER_JITKERNEL_GEN(kVSigmoid,
+                       gen::VSigmoidAVX512Creator,
+                       gen::VSigmoidCreator);
+REGISTER_JITKERNEL_GEN(kVTanh, gen::VTanhAVX512Creator, gen::VTanhCreator);
@@ -242,6 +242,129 @@ class VActFunc : public JitCode {
     // dst.setIdx(src.getIdx());
   }
 
+  // compute EXP with zmm, which takes the constants by broadcast and rounds
+  // down by vrndscaleps, so that only avx512f is required
+  void exp_zmm(zmm_t& dst,  // NOLINT
+               zmm_t& src,  // NOLINT
+               int src_idx = 11,
+               int fx_idx = 12,
+               int fy_idx = 13,
+               int tmp_idx = 14) {
+    zmm_t zmm_src = zmm_t(src_idx);
+    zmm_t zmm_fx = zmm_t(fx_idx);
+    zmm_t zmm_fy = zmm_t(fy_idx);
+    zmm_t zmm_z = zmm_t(tmp_idx);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vminps(zmm_src, src, zword_b[reg_ptr_global + OFFSET_EXP_HIG]);
+    vmaxps(zmm_src, zmm_src, zword_b[reg_ptr_global + OFFSET_EXP_LOW]);
+    // express exp(x) as exp(g + n*log(2))
+    vmulps(zmm_fx, zmm_src, zword_b[reg_ptr_global + OFFSET_EXP_LOG2EF]);
+    vaddps(zmm_fx, zmm_fx, zword_b[reg_ptr_global + OFFSET_EXP_0P5]);
+    vrndscaleps(zmm_fx, zmm_fx, 0x01);
+    vmulps(zmm_fy, zmm_fx, zword_b[reg_ptr_global + OFFSET_EXP_C1]);
+    vmulps(zmm_z, zmm_fx, zword_b[reg_ptr_global + OFFSET_EXP_C2]);
+    vsubps(zmm_src, zmm_src, zmm_fy);
+    vsubps(zmm_src, zmm_src, zmm_z);
+    vmulps(zmm_z, zmm_src, zmm_src);
+    vmulps(dst, zmm_src, zword_b[reg_ptr_global + OFFSET_EXP_P0]);
+    for (size_t i = OFFSET_EXP_P1; i < OFFSET_EXP_P5;
+         i += (YMM_FLOAT_BLOCK * sizeof(float))) {
+      vaddps(dst, dst, zword_b[reg_ptr_global + i]);  // P1~P4
+      vmulps(dst, dst, zmm_src);
+    }
+    vaddps(dst, dst, zword_b[reg_ptr_global + OFFSET_EXP_P5]);
+    vmulps(dst, dst, zmm_z);
+    vaddps(dst, dst, zmm_src);
+    vaddps(dst, dst, zword_b[reg_ptr_global + OFFSET_EXP_ONE]);
+    // build 2^n
+    vcvttps2dq(zmm_fx, zmm_fx);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_int_0x7f));
+    vpaddd(zmm_fx, zmm_fx, zword_b[reg_ptr_global]);
+    vpslld(zmm_fx, zmm_fx, 23);
+    vmulps(dst, dst, zmm_fx);
+    pop(reg_ptr_global);
+  }
+
+  // compute SIGMOID with zmm
+  void sigmoid_zmm(zmm_t& dst,  // NOLINT
+                   zmm_t& src,  // NOLINT
+                   int src_idx = 11,
+                   int fx_idx = 12,
+                   int fy_idx = 13,
+                   int tmp_idx = 14) {
+    // y = 1 / (1 + e^-x)
+    zmm_t zmm_src = zmm_t(src_idx);
+    zmm_t zmm_tmp = zmm_t(tmp_idx);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vminps(zmm_src, src, zword_b[reg_ptr_global + OFFSET_SIGMOID_MAX]);
+    vmaxps(zmm_src, zmm_src, zword_b[reg_ptr_global + OFFSET_SIGMOID_MIN]);
+    vpxord(zmm_tmp, zmm_tmp, zmm_tmp);
+    vsubps(zmm_src, zmm_tmp, zmm_src);
+    exp_zmm(dst, zmm_src, src_idx, fx_idx, fy_idx, tmp_idx);
+    vbroadcastss(zmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vaddps(dst, dst, zmm_tmp);
+    vdivps(dst, zmm_tmp, dst);
+    pop(reg_ptr_global);
+  }
+
+  // compute TANH with zmm
+  void tanh_zmm(zmm_t& dst,  // NOLINT
+                zmm_t& src,  // NOLINT
+                int src_idx = 11,
+                int fx_idx = 12,
+                int fy_idx = 13,
+                int tmp_idx = 14) {
+    // y = 2 / (1 + e^(-2x)) - 1
+    zmm_t zmm_src = zmm_t(src_idx);
+    zmm_t zmm_tmp = zmm_t(tmp_idx);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vmulps(zmm_src, src, zword_b[reg_ptr_global + OFFSET_EXP_TWO]);
+    vpxord(zmm_tmp, zmm_tmp, zmm_tmp);
+    vsubps(zmm_src, zmm_tmp, zmm_src);
+    exp_zmm(dst, zmm_src, src_idx, fx_idx, fy_idx, tmp_idx);
+    vaddps(dst, dst, zword_b[reg_ptr_global + OFFSET_EXP_ONE]);
+    vbroadcastss(zmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
+    vdivps(dst, zmm_tmp, dst);
+    vsubps(dst, dst, zword_b[reg_ptr_global + OFFSET_EXP_ONE]);
+    pop(reg_ptr_global);
+  }
+
+  void act_zmm(zmm_t& dst, zmm_t& src, operand_type type) {  // NOLINT
+    // use 11~15
+    zmm_t zero = zmm_t(15);
+    switch (type) {
+      case operand_type::RELU:
+        vpxord(zero, zero, zero);
+        vmaxps(dst, src, zero);
+        break;
+      case operand_type::SQUARE:
+        vmulps(dst, src, src);
+        break;
+      case operand_type::EXP:
+        exp_zmm(dst, src, 11, 12, 13, 14);
+        break;
+      case operand_type::SIGMOID:
+        sigmoid_zmm(dst, src, 11, 12, 13, 14);
+        break;
+      case operand_type::TANH:
+        tanh_zmm(dst, src, 11, 12, 13, 14);
+        break;
+      case operand_type::IDENTITY:
+        vmovaps(dst, src);
+        break;
+      default:
+        PADDLE_THROW(phi::errors::Unimplemented(
+            "Do not support operand type code: %d.", type));
+        break;
+    }
+  }
+
   template <typename JMM>
   void act(JMM& dst, JMM& src, operand_type type) {  // NOLINT
     // use 11~15
@@ -276,9 +399,13 @@ class VActJitCode : public VActFunc {
  public:
   explicit VActJitCode(int d,
                        operand_type type,
+                       bool use_avx512,
                        size_t code_size,
                        void* code_ptr = nullptr)
-      : VActFunc(code_size, code_ptr), num_(d), type_(type) {
+      : VActFunc(code_size, code_ptr),
+        num_(d),
+        type_(type),
+        use_avx512_(use_avx512) {
     if (!(type_ == operand_type::RELU || type_ == operand_type::EXP ||
           type_ == operand_type::SIGMOID || type_ == operand_type::TANH ||
           type_ == operand_type::IDENTITY || type_ == operand_type::SQUARE)) {
@@ -312,6 +439,7 @@ class VActJitCode : public VActFunc {
       default:
         break;
     }
+    base += (use_avx512_ ? "_AVX512" : "");
     return base;
   }
   void genCode() override;
@@ -319,6 +447,7 @@ class VActJitCode : public VActFunc {
  protected:
   int num_;
   operand_type type_;
+  bool use_avx512_;
   reg64_t param1{abi_param1};
   reg64_t param2{abi_param2};
 
@@ -327,13 +456,19 @@ class VActJitCode : public VActFunc {
 
   xmm_t xmm_dst = xmm_t(1);
   ymm_t ymm_dst = ymm_t(1);
+
+  zmm_t zmm_src = zmm_t(0);
+  zmm_t zmm_dst = zmm_t(1);
 };
 
 #define DECLARE_ACT_JITCODE(name, op_type)                                    \
   class name##JitCode : public VActJitCode {                                  \
    public:                                                                    \
-    explicit name##JitCode(int d, size_t code_size, void* code_ptr = nullptr) \
-        : VActJitCode(d, op_type, code_size, code_ptr) {}                     \
+    explicit name##JitCode(int d,                                             \
+                           bool use_avx512,                                   \
+                           size_t code_size,                                  \
+                           void* code_ptr = nullptr)                          \
+        : VActJitCode(d, op_type, use_avx512, code_size, code_ptr) {}         \
   };
 
 DECLARE_ACT_JITCODE(VRelu, operand_type::RELU);
@@ -26,34 +26,38 @@ void VXXJitCode::genCode() {
   // do not need push stack, and do not need save avx512reg if do not use avx512
   int offset = 0;
   if (with_relu_) {
-    vxorps(ymm_zero, ymm_zero, ymm_zero);
+    if (use_avx512_) {
+      vpxord(zmm_zero, zmm_zero, zmm_zero);
+    } else {
+      vxorps(ymm_zero, ymm_zero, ymm_zero);
+    }
   }
   if (scalar_index_ == 1) {
-    vbroadcastss(ymm_src1, ptr[param1]);
-  } else if (scalar_index_ == 2) {
-    vbroadcastss(ymm_src2, ptr[param2]);
-  }
-  for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
-    if (scalar_index_ != 1) {
-      vmovups(ymm_src1, ptr[param1 + offset]);
-    }
-    if (scalar_index_ != 2) {
-      vmovups(ymm_src2, ptr[param2 + offset]);
+    if (use_avx512_) {
+      vbroadcastss(zmm_src1, ptr[param1]);
+    } else {
+      vbroadcastss(ymm_src1, ptr[param1]);
     }
-    if (type_ == operand_type::MUL) {
-      vmulps(ymm_dst, ymm_src1, ymm_src2);
-    } else if (type_ == operand_type::ADD) {
-      vaddps(ymm_dst, ymm_src1, ymm_src2);
-    } else if (type_ == operand_type::SUB) {
-      vsubps(ymm_dst, ymm_src1, ymm_src2);
+  } else if (scalar_index_ == 2) {
+    if (use_avx512_) {
+      vbroadcastss(zmm_src2, ptr[param2]);
+    } else {
+      vbroadcastss(ymm_src2, ptr[param2]);
     }
-    if (with_relu_) {
-      vmaxps(ymm_dst, ymm_zero, ymm_dst);
+  }
+  int rest = num_;
+  if (use_avx512_) {
+    for (int i = 0; i < num_ / ZMM_FLOAT_BLOCK; ++i) {
+      compute_block<zmm_t>(offset);
+      offset += sizeof(float) * ZMM_FLOAT_BLOCK;
     }
-    vmovups(ptr[param3 + offset], ymm_dst);
+    rest = num_ % ZMM_FLOAT_BLOCK;
+  }
+  for (int i = 0; i < rest / YMM_FLOAT_BLOCK; ++i) {
+    compute_block<ymm_t>(offset);
     offset += sizeof(float) * YMM_FLOAT_BLOCK;
   }
-  int rest = num_ % YMM_FLOAT_BLOCK;
+  rest = rest % YMM_FLOAT_BLOCK;
   while (rest > 0) {
     int block = XMM_FLOAT_BLOCK;
     if (rest >= 4) {
@@ -107,6 +111,10 @@ void VXXJitCode::genCode() {
     offset += sizeof(float) * block;
     rest -= block;
   }
+  if (use_avx512_) {
+    // avoid the penalty of the sse code after the dirty upper zmm
+    vzeroupper();
+  }
   ret();
 }
 
@@ -121,7 +129,17 @@ void VXXJitCode::genCode() {
       return 96 + d / YMM_FLOAT_BLOCK * 4 * 8;                               \
     }                                                                        \
     std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
-      return make_unique<name##JitCode>(attr, CodeSize(attr));               \
+      return make_unique<name##JitCode>(attr, false, CodeSize(attr));        \
+    }                                                                        \
+  };                                                                         \
+  class name##AVX512Creator : public name##Creator {                         \
+   public:                                                                   \
+    bool CanBeUsed(const int& attr) const override {                         \
+      return phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f) &&     \
+             attr >= ZMM_FLOAT_BLOCK && attr <= 1024;                        \
+    }                                                                        \
+    std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
+      return make_unique<name##JitCode>(attr, true, CodeSize(attr));         \
     }                                                                        \
   }
 
@@ -140,9 +158,13 @@ DECLARE_BLAS_CREATOR(VAddBias);
 
 namespace gen = phi::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kVMul, gen::VMulCreator);
-REGISTER_JITKERNEL_GEN(kVAdd, gen::VAddCreator);
-REGISTER_JITKERNEL_GEN(kVSub, gen::VSubCreator);
-REGISTER_JITKERNEL_GEN(kVAddRelu, gen::VAddReluCreator);
-REGISTER_JITKERNEL_GEN(kVScal, gen::VScalCreator);
-REGISTER_JITKERNEL_GEN(kVAddBias, gen::VAddBiasCreator);
+REGISTER_JITKERNEL_GEN(kVMul, gen::VMulAVX512Creator, gen::VMulCreator);
+REGISTER_JITKERNEL_GEN(kVAdd, gen::VAddAVX512Creator, gen::VAddCreator);
+REGISTER_JITKERNEL_GEN(kVSub, gen::VSubAVX512Creator, gen::VSubCreator);
+REGISTER_JITKERNEL_GEN(kVAddRelu,
+                       gen::VAddReluAVX512Creator,
+                       gen::VAddReluCreator);
+REGISTER_JITKERNEL_GEN(kVScal, gen::VScalAVX512Creator, gen::VScalCreator);
+REGISTER_JITKERNEL_GEN(kVAddBias,
+                       gen::VAddBiasAVX512Creator,
+                       gen::VAddBiasCreator);
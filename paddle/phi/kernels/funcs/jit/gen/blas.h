@@ -31,13 +31,15 @@ class VXXJitCode : public JitCode {
                       operand_type type,
                       int scalar_index,
                       bool with_relu,
+                      bool use_avx512 = false,
                       size_t code_size = 256 * 1024,
                       void* code_ptr = nullptr)
       : JitCode(code_size, code_ptr),
         num_(d),
         type_(type),
         scalar_index_(scalar_index),
-        with_relu_(with_relu) {
+        with_relu_(with_relu),
+        use_avx512_(use_avx512) {
     if (!(type_ == operand_type::MUL || type_ == operand_type::ADD ||
           type_ == operand_type::SUB)) {
       PADDLE_THROW(phi::errors::Unimplemented(
@@ -67,15 +69,43 @@ class VXXJitCode : public JitCode {
     }
     base += (with_relu_ ? "_Relu" : "");
     base += "_D" + std::to_string(num_);
+    base += (use_avx512_ ? "_AVX512" : "");
     return base;
   }
   void genCode() override;
 
  private:
+  // compute one block of JMM at offset, the src of scalar is broadcasted
+  template <typename JMM>
+  void compute_block(int offset) {
+    JMM src1 = JMM(xmm_src1.getIdx());
+    JMM src2 = JMM(xmm_src2.getIdx());
+    JMM dst = JMM(xmm_dst.getIdx());
+    JMM zero = JMM(xmm_zero.getIdx());
+    if (scalar_index_ != 1) {
+      vmovups(src1, ptr[param1 + offset]);
+    }
+    if (scalar_index_ != 2) {
+      vmovups(src2, ptr[param2 + offset]);
+    }
+    if (type_ == operand_type::MUL) {
+      vmulps(dst, src1, src2);
+    } else if (type_ == operand_type::ADD) {
+      vaddps(dst, src1, src2);
+    } else if (type_ == operand_type::SUB) {
+      vsubps(dst, src1, src2);
+    }
+    if (with_relu_) {
+      vmaxps(dst, zero, dst);
+    }
+    vmovups(ptr[param3 + offset], dst);
+  }
+
   int num_;
   operand_type type_;
   int scalar_index_;
   bool with_relu_;
+  bool use_avx512_;
   reg64_t param1{abi_param1};
   reg64_t param2{abi_param2};
   reg64_t param3{abi_param3};
@@ -89,14 +119,26 @@ class VXXJitCode : public JitCode {
   ymm_t ymm_src2 = ymm_t(1);
   ymm_t ymm_dst = ymm_t(2);
   ymm_t ymm_zero = ymm_t(3);
+
+  zmm_t zmm_src1 = zmm_t(0);
+  zmm_t zmm_src2 = zmm_t(1);
+  zmm_t zmm_zero = zmm_t(3);
 };
 
 #define DECLARE_BLAS_JITCODE(name, op_type, scalar_idx, with_relu)             \
   class name##JitCode : public VXXJitCode {                                    \
    public:                                                                     \
-    explicit name##JitCode(int d, size_t code_size, void* code_ptr = nullptr)  \
-        : VXXJitCode(d, op_type, scalar_idx, with_relu, code_size, code_ptr) { \
-    }                                                                          \
+    explicit name##JitCode(int d,                                              \
+                           bool use_avx512,                                    \
+                           size_t code_size,                                   \
+                           void* code_ptr = nullptr)                           \
+        : VXXJitCode(d,                                                        \
+                     op_type,                                                  \
+                     scalar_idx,                                               \
+                     with_relu,                                                \
+                     use_avx512,                                               \
+                     code_size,                                                \
+                     code_ptr) {}                                              \
   };
 
 DECLARE_BLAS_JITCODE(VMul, operand_type::MUL, 0, false);
@@ -27,11 +27,13 @@ namespace gen {
 class EmbSeqPoolJitCode : public JitCode {
  public:
   explicit EmbSeqPoolJitCode(const emb_seq_pool_attr_t& attr,
+                             bool use_avx512 = false,
                              size_t code_size = 256 * 1024,
                              void* code_ptr = nullptr)
       : JitCode(code_size, code_ptr),
         tbl_w_(attr.table_width),
-        type_(attr.pool_type) {
+        type_(attr.pool_type),
+        use_avx512_(use_avx512) {
     if (type_ != SeqPoolType::kSum) {
       PADDLE_THROW(phi::errors::Unimplemented("Only supports sum pool yet."));
     }
@@ -48,13 +50,19 @@ class EmbSeqPoolJitCode : public JitCode {
       base += "_Sqrt";
     }
     base += ("_W" + std::to_string(tbl_w_));
+    base += (use_avx512_ ? "_AVX512" : "");
     return base;
   }
   void genCode() override;
 
  private:
+  // pool the num_regs blocks of JMM at dst_offset of every output row
+  template <typename JMM>
+  void pool_group(int num_regs, size_t dst_offset);
+
   int tbl_w_;
   SeqPoolType type_;
+  bool use_avx512_;
   reg64_t param_tbl{abi_param1};
   reg64_t param_idx{abi_param2};
   reg64_t param_dst{abi_param3};
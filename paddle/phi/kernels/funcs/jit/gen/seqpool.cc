@@ -23,7 +23,7 @@ namespace jit {
 namespace gen {
 
 void SeqPoolJitCode::genCode() {
-  constexpr int block = YMM_FLOAT_BLOCK;
+  const int block = use_avx512_ ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
   constexpr int max_num_regs = 8;
   const int num_block = w_ / block;
   const int num_groups = num_block / max_num_regs;
@@ -44,19 +44,36 @@ void SeqPoolJitCode::genCode() {
   }
   const int group_len = max_num_regs * block * sizeof(float);
   for (int g = 0; g < num_groups; ++g) {
-    pool_height<ymm_t>(g * group_len, block, max_num_regs);
+    if (use_avx512_) {
+      pool_height<zmm_t>(g * group_len, block, max_num_regs);
+    } else {
+      pool_height<ymm_t>(g * group_len, block, max_num_regs);
+    }
   }
   if (rest_num_regs > 0) {
-    pool_height<ymm_t>(num_groups * group_len, block, rest_num_regs);
+    if (use_avx512_) {
+      pool_height<zmm_t>(num_groups * group_len, block, rest_num_regs);
+    } else {
+      pool_height<ymm_t>(num_groups * group_len, block, rest_num_regs);
+    }
   }
   // part of rest_w * height
-  const int rest = w_ % block;
+  int rest = w_ % block;
+  if (rest >= YMM_FLOAT_BLOCK) {
+    pool_height<ymm_t>((w_ - rest) * sizeof(float), YMM_FLOAT_BLOCK, 1);
+    rest -= YMM_FLOAT_BLOCK;
+  }
   pool_height_of_rest_width(rest, (w_ - rest) * sizeof(float), max_num_regs);
+  if (use_avx512_) {
+    // avoid the penalty of the sse code after the dirty upper zmm
+    vzeroupper();
+  }
   ret();
 }
 
 class SeqPoolCreator : public JitCodeCreator<seq_pool_attr_t> {
  public:
+  explicit SeqPoolCreator(bool use_avx512 = false) : use_avx512_(use_avx512) {}
   bool CanBeUsed(const seq_pool_attr_t& attr) const override {
     return phi::backends::cpu::MayIUse(phi::backends::cpu::avx);
   }
@@ -80,7 +97,19 @@ class SeqPoolCreator : public JitCodeCreator<seq_pool_attr_t> {
         phi::errors::InvalidArgument("The attribute height of SeqPool should "
                                      "be larger than 0. But it is %d.",
                                      attr.h));
-    return make_unique<SeqPoolJitCode>(attr, CodeSize(attr));
+    return make_unique<SeqPoolJitCode>(attr, use_avx512_, CodeSize(attr));
+  }
+
+ private:
+  bool use_avx512_;
+};
+
+class SeqPoolAVX512Creator : public SeqPoolCreator {
+ public:
+  SeqPoolAVX512Creator() : SeqPoolCreator(true) {}
+  bool CanBeUsed(const seq_pool_attr_t& attr) const override {
+    return phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f) &&
+           attr.w >= ZMM_FLOAT_BLOCK;
   }
 };
 
@@ -90,4 +119,6 @@ class SeqPoolCreator : public JitCodeCreator<seq_pool_attr_t> {
 
 namespace gen = phi::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kSeqPool, gen::SeqPoolCreator);
+REGISTER_JITKERNEL_GEN(kSeqPool,
+                       gen::SeqPoolAVX512Creator,
+                       gen::SeqPoolCreator);
@@ -27,9 +27,13 @@ namespace gen {
 class SeqPoolJitCode : public JitCode {
  public:
   explicit SeqPoolJitCode(const seq_pool_attr_t& attr,
+                          bool use_avx512 = false,
                           size_t code_size = 256 * 1024,
                           void* code_ptr = nullptr)
-      : JitCode(code_size, code_ptr), w_(attr.w), type_(attr.type) {
+      : JitCode(code_size, code_ptr),
+        w_(attr.w),
+        type_(attr.type),
+        use_avx512_(use_avx512) {
     if (!(type_ == SeqPoolType::kSum || type_ == SeqPoolType::kAvg ||
           type_ == SeqPoolType::kSqrt)) {
       PADDLE_THROW(phi::errors::Unimplemented(
@@ -49,6 +53,7 @@ class SeqPoolJitCode : public JitCode {
       base += "_Sqrt";
     }
     base += ("_W" + std::to_string(w_));
+    base += (use_avx512_ ? "_AVX512" : "");
     return base;
   }
   void genCode() override;
@@ -206,6 +211,7 @@ class SeqPoolJitCode : public JitCode {
   float ALIGN32_BEG fp_h_[1] ALIGN32_END;
   int w_;
   SeqPoolType type_;
+  bool use_avx512_;
   reg64_t param_src{abi_param1};
   reg64_t param_dst{abi_param2};
   reg64_t param_attr{abi_param3};
@@ -78,6 +78,44 @@ GetJitCode(const typename KernelTuple::attr_type& attr UNUSED) {
   return nullptr;
 }
 
+// Create the jitcodes of all the creators can be used with this attr, in the
+// order of registration, which is from the highest ISA to the lowest.
+// They are not inserted to the JitCodePool, but only used to test and
+// benchmark every ISA of a kernel.
+template <typename KernelTuple, typename PlaceType>
+inline typename std::enable_if<
+    std::is_same<typename KernelTuple::data_type, float>::value &&
+        std::is_same<PlaceType, phi::CPUPlace>::value,
+    std::vector<std::unique_ptr<GenBase>>>::type
+CreateAllJitCodes(const typename KernelTuple::attr_type& attr) {
+  using Attr = typename KernelTuple::attr_type;
+  std::vector<std::unique_ptr<GenBase>> res;
+  KernelKey kkey(KernelTuple::kernel_type, PlaceType());
+  auto& creator_map = JitCodeCreatorPool::Instance().AllCreators();
+  auto iter = creator_map.find(kkey);
+  if (iter != creator_map.end()) {
+    for (auto& cur : iter->second) {
+      auto i = dynamic_cast<const JitCodeCreator<Attr>*>(cur.get());
+      if (i && i->CanBeUsed(attr)) {
+        auto p = i->CreateJitCode(attr);
+        if (p) {
+          res.emplace_back(std::move(p));
+        }
+      }
+    }
+  }
+  return res;
+}
+
+template <typename KernelTuple, typename PlaceType>
+inline typename std::enable_if<
+    !std::is_same<typename KernelTuple::data_type, float>::value ||
+        !std::is_same<PlaceType, phi::CPUPlace>::value,
+    std::vector<std::unique_ptr<GenBase>>>::type
+CreateAllJitCodes(const typename KernelTuple::attr_type& attr UNUSED) {
+  return std::vector<std::unique_ptr<GenBase>>();
+}
+
 // Refer code do not related with attr, which is just for cast
 // Refer is always on CPUPlace
 template <typename KernelTuple>
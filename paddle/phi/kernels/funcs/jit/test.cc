@@ -79,6 +79,13 @@ void TestAllImpls(const typename KernelTuple::attr_type& attr,
     VLOG(10) << "Test Kernel " << f.first;
     verifier(f.second, args...);
   }
+  // test the jitcode of every ISA, not only the one used by default
+  auto codes = jit::CreateAllJitCodes<KernelTuple, PlaceType>(attr);
+  for (auto& code : codes) {
+    VLOG(10) << "Test JitCode " << code->name();
+    verifier(code->template getCode<typename KernelTuple::func_type>(),
+             args...);
+  }
 }
 
 template <typename KernelTuple, typename PlaceType>
@@ -1154,6 +1161,29 @@ TEST(JITKernel_helper, KernelFuncs) {
 #endif
 }
 
+TEST(JITKernel_helper, CreateAllJitCodes) {
+  auto fp_codes = jit::CreateAllJitCodes<jit::VMulTuple<float>, CPUPlace>(32);
+  size_t expected_size = 0;
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(__OSX__)
+  if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f)) {
+    expected_size = 2;  // avx512, avx
+  } else if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
+    expected_size = 1;  // avx
+  }
+#endif
+  ASSERT_EQ(fp_codes.size(), expected_size);
+  if (expected_size == 2) {
+    EXPECT_NE(fp_codes[0]->name().find("_AVX512"), std::string::npos);
+    EXPECT_EQ(fp_codes[1]->name().find("_AVX512"), std::string::npos);
+  }
+  // the avx512 jitcode is not used for the size less than a zmm
+  auto small_codes = jit::CreateAllJitCodes<jit::VMulTuple<float>, CPUPlace>(8);
+  EXPECT_LE(small_codes.size(), 1UL);
+
+  auto db_codes = jit::CreateAllJitCodes<jit::VMulTuple<double>, CPUPlace>(32);
+  EXPECT_TRUE(db_codes.empty());
+}
+
 TEST(JITKernel_helper, GetAllCandidateFuncs) {
   auto funcs = jit::GetAllCandidateFuncs<jit::VExpTuple<float>, CPUPlace>(10);
   auto kers = jit::GetAllCandidateKernels<jit::VExpTuple<float>, CPUPlace>(10);
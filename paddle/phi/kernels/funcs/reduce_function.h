@@ -57,9 +57,13 @@ using dim3 = phi::kps::dim3;
 
 #endif
 
+#include <type_traits>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/core/kernel_utils.h"
+#include "paddle/phi/core/parallel_for.h"
 #include "paddle/phi/core/utils/array.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
@@ -1324,6 +1328,66 @@ void HandleLargeDim(const Context& dev_ctx,
 
 ////////////// ReduceKernel
 
+// Reduce the trailing dims of a CPU tensor row by row on the intra op thread
+// pool. Returns false when the reduced dims are not the trailing ones or there
+// is no pool to run on. Other contexts never run on the pool, the overloads
+// are picked by enable_if since this header is also built as C++14.
+template <typename Context, typename OutT, typename Functor>
+typename std::enable_if<!std::is_same<Context, phi::CPUContext>::value,
+                        bool>::type
+ParallelReduceLastDims(const Context& dev_ctx,
+                       const phi::DenseTensor& input,
+                       phi::DenseTensor* output,
+                       const std::vector<int64_t>& dims) {
+  return false;
+}
+
+template <typename Context, typename OutT, typename Functor>
+typename std::enable_if<std::is_same<Context, phi::CPUContext>::value,
+                        bool>::type
+ParallelReduceLastDims(const Context& dev_ctx,
+                       const phi::DenseTensor& input,
+                       phi::DenseTensor* output,
+                       const std::vector<int64_t>& dims) {
+  if (GetIntraOpParallelism() <= 1) {
+    return false;
+  }
+  int ndim = input.dims().size();
+  std::vector<int64_t> reduce_dims;
+  for (int64_t dim : dims) {
+    reduce_dims.push_back(dim < 0 ? dim + ndim : dim);
+  }
+  std::sort(reduce_dims.begin(), reduce_dims.end());
+  reduce_dims.erase(std::unique(reduce_dims.begin(), reduce_dims.end()),
+                    reduce_dims.end());
+  int rdim = reduce_dims.size();
+  if (rdim == 0 || rdim == ndim) {
+    return false;
+  }
+  int64_t inner = 1;
+  for (int i = 0; i < rdim; ++i) {
+    if (reduce_dims[i] != ndim - rdim + i) {
+      return false;
+    }
+    inner *= input.dims()[reduce_dims[i]];
+  }
+  int64_t rows = input.numel() / inner;
+
+  const OutT* in_data = input.data<OutT>();
+  OutT* out_data = output->data<OutT>();
+  auto& dev = *dev_ctx.eigen_device();
+  auto reduce_dim = Eigen::array<int, 1>({{1}});
+  int64_t grain_size = kIntraOpGrainSize / inner + 1;
+  ParallelFor(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+    typename EigenTensor<OutT, 2>::ConstType x(
+        in_data + begin * inner, end - begin, inner);
+    typename EigenTensor<OutT, 1>::Type out(out_data + begin, end - begin);
+    Functor functor;
+    functor(dev, &x, &out, reduce_dim);
+  });
+  return true;
+}
+
 template <typename Context, typename T, typename OutT, typename Functor>
 void ReduceKernelImpl(const Context& dev_ctx,
                       const phi::DenseTensor& input,
@@ -1348,6 +1412,10 @@ void ReduceKernelImpl(const Context& dev_ctx,
     Functor functor;
     functor(dev, &x, &out, reduce_dim);
   } else {
+    if (ParallelReduceLastDims<Context, OutT, Functor>(
+            dev_ctx, input, output, dims)) {
+      return;
+    }
     int ndim = input.dims().size();
     int rdim = dims.size();
     if (ndim > 6) {
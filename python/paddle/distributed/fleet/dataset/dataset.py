@@ -377,6 +377,8 @@ class InMemoryDataset(DatasetBase):
         self.enable_pv_merge = False
         self.merge_by_lineid = False
         self.fleet_send_sleep_seconds = None
+        self.binary_cache_dir = ""
+        self.binary_cache_compress = False
 
     def _init_distributed_settings(self, **kwargs):
         """
@@ -396,6 +398,8 @@ class InMemoryDataset(DatasetBase):
             fea_eval(bool): Set if Dataset need to do feature importance evaluation using slots shuffle.
                             default is False.
             candidate_size(int): if fea_eval is set True, set the candidate size used in slots shuffle.
+            binary_cache_dir(str): Set the local directory caching the parsed files in binary, only for
+                                   SlotRecordInMemoryDataFeed. default is "", which disables the cache.
 
         Examples:
             .. code-block:: python
@@ -439,6 +443,10 @@ class InMemoryDataset(DatasetBase):
             candidate_size = kwargs.get("candidate_size", 10000)
             self._set_fea_eval(candidate_size, True)
 
+        binary_cache_dir = kwargs.get("binary_cache_dir", "")
+        if binary_cache_dir:
+            self._set_binary_cache_dir(binary_cache_dir)
+
     def update_settings(self, **kwargs):
         """
         :api_attr: Static Graph
@@ -469,6 +477,8 @@ class InMemoryDataset(DatasetBase):
             fea_eval(bool): Set if Dataset need to do feature importance evaluation using slots shuffle.
                             default is False.
             candidate_size(int): if fea_eval is set True, set the candidate size used in slots shuffle.
+            binary_cache_dir(str): Set the local directory caching the parsed files in binary, only for
+                                   SlotRecordInMemoryDataFeed. default is "", which disables the cache.
 
         Examples:
             .. code-block:: python
@@ -519,6 +529,8 @@ class InMemoryDataset(DatasetBase):
             elif key == "fea_eval" and kwargs[key]:
                 candidate_size = kwargs.get("candidate_size", 10000)
                 self._set_fea_eval(candidate_size, True)
+            elif key == "binary_cache_dir":
+                self._set_binary_cache_dir(kwargs[key])
 
     def init(self, **kwargs):
         """
@@ -638,6 +650,9 @@ class InMemoryDataset(DatasetBase):
         self.dataset.set_parse_logkey(self.parse_logkey)
         self.dataset.set_merge_by_sid(self.merge_by_sid)
         self.dataset.set_enable_pv_merge(self.enable_pv_merge)
+        self.dataset.set_binary_cache_dir(
+            self.binary_cache_dir, self.binary_cache_compress
+        )
         self.dataset.set_data_feed_desc(self._desc())
         self.dataset.create_channel()
         self.dataset.create_readers()
@@ -695,6 +710,29 @@ class InMemoryDataset(DatasetBase):
         """
         self.parse_ins_id = parse_ins_id
 
+    def _set_binary_cache_dir(self, binary_cache_dir, compress=False):
+        """
+        Set the local directory caching the parsed files in binary. The first load of a
+        file parses it and writes the parsed instances into the directory, and the later
+        loads of it read them back without the pipe command. Only SlotRecordInMemoryDataFeed
+        supports the cache.
+
+        Args:
+            binary_cache_dir(str): the local directory, "" to disable the cache
+            compress(bool): whether to compress the cached instances by zlib. default is False.
+
+        Examples:
+            .. code-block:: python
+
+              import paddle
+              paddle.enable_static()
+              dataset = paddle.distributed.InMemoryDataset()
+              dataset._set_binary_cache_dir("./binary_cache")
+
+        """
+        self.binary_cache_dir = binary_cache_dir
+        self.binary_cache_compress = compress
+
     def _set_parse_content(self, parse_content):
         """
         Set if Dataset need to parse content
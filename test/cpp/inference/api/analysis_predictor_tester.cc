@@ -19,7 +19,14 @@
 #endif
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#ifndef _WIN32
+#include <dirent.h>
+#include <unistd.h>
+#endif
 
+#include <cstdio>
+#include <fstream>
+#include <set>
 #include <thread>  // NOLINT
 
 #include "paddle/fluid/framework/ir/pass.h"
@@ -128,6 +135,108 @@ TEST(AnalysisPredictor, analysis_on) {
   inference::CompareTensor(outputs.front(), naive_outputs.front());
 }
 
+#ifndef _WIN32
+// The manifests of the entries in the cache of the optimized programs.
+static std::vector<std::string> OptimCacheManifests(const std::string& dir) {
+  std::vector<std::string> manifests;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return manifests;
+  }
+  while (struct dirent* entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name.size() > 9 && name.substr(name.size() - 9) == ".manifest") {
+      manifests.push_back(dir + "/" + name);
+    }
+  }
+  closedir(d);
+  return manifests;
+}
+
+static void RemoveOptimCacheDir(const std::string& dir) {
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return;
+  }
+  while (struct dirent* entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      std::remove((dir + "/" + name).c_str());
+    }
+  }
+  closedir(d);
+  rmdir(dir.c_str());
+}
+
+TEST(AnalysisPredictor, optim_program_cache) {
+  const std::string cache_dir = "./optim_program_cache";
+  RemoveOptimCacheDir(cache_dir);
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.SwitchIrOptim(true);
+  config.EnableMemoryOptim(true);
+  config.SetOptimCacheDir(cache_dir);
+  config.EnableOptimProgramCache(true, 1);
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  std::vector<PaddleTensor> expected_outputs;
+  std::string expected_program;
+  auto run_predictor = [&](const AnalysisConfig& predictor_config,
+                           bool cache_hit) {
+    auto _predictor = CreatePaddlePredictor<AnalysisConfig>(predictor_config);
+    auto* predictor = static_cast<AnalysisPredictor*>(_predictor.get());
+    ASSERT_EQ(predictor->optim_program_cache_hit_, cache_hit);
+    std::vector<PaddleTensor> outputs;
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    if (expected_outputs.empty()) {
+      expected_outputs = outputs;
+      expected_program = predictor->GetSerializedProgram();
+    } else if (&predictor_config == &config) {
+      ASSERT_EQ(predictor->GetSerializedProgram(), expected_program);
+    }
+    inference::CompareResult(outputs, expected_outputs);
+  };
+
+  // The first predictor runs the analysis passes and saves the optimized
+  // program, the second one loads it from the cache.
+  run_predictor(config, false);
+  auto manifests = OptimCacheManifests(cache_dir);
+  ASSERT_EQ(manifests.size(), 1UL);
+  run_predictor(config, true);
+
+  // A corrupted entry is not used, and is rewritten.
+  std::string manifest = manifests[0];
+  std::string program_path =
+      manifest.substr(0, manifest.size() - 9) + ".pdmodel";
+  {
+    std::ofstream fout(program_path, std::ios::out | std::ios::app);
+    fout << "corrupted";
+  }
+  run_predictor(config, false);
+  run_predictor(config, true);
+  ASSERT_EQ(OptimCacheManifests(cache_dir), manifests);
+
+  // The entry of another config evicts the entry at capacity 1.
+  AnalysisConfig other_config(config);
+  other_config.EnableMemoryOptim(false);
+  run_predictor(other_config, false);
+  auto other_manifests = OptimCacheManifests(cache_dir);
+  ASSERT_EQ(other_manifests.size(), 1UL);
+  ASSERT_NE(other_manifests[0], manifest);
+  run_predictor(other_config, true);
+  run_predictor(config, false);
+
+  RemoveOptimCacheDir(cache_dir);
+}
+#endif
+
 #ifdef PADDLE_WITH_XPU
 TEST(AnalysisPredictor, save_optimized_model_on) {
   AnalysisConfig config;
@@ -478,6 +587,64 @@ TEST(Predictor, Run) {
   predictor->TryShrinkMemory();
 }
 
+TEST(PredictorPool, Run) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  services::PredictorPool pool(config, 4);
+
+  auto run = [](Predictor* predictor, int64_t word, std::vector<float>* out) {
+    for (auto& name : predictor->GetInputNames()) {
+      auto input = predictor->GetInputHandle(name);
+      input->Reshape({1, 1});
+      input->CopyFromCpu(&word);
+    }
+    if (!predictor->Run()) {
+      return false;
+    }
+    auto output = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+    std::vector<int> shape = output->shape();
+    out->resize(std::accumulate(
+        shape.begin(), shape.end(), 1, std::multiplies<int>()));
+    output->CopyToCpu(out->data());
+    return true;
+  };
+  std::vector<std::vector<float>> expected(8);
+  for (int64_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(run(pool.Retrive(0), i, &expected[i]));
+  }
+
+  std::mutex mutex;
+  std::set<Predictor*> busy;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 20; ++i) {
+        int64_t word = (t + i) % 8;
+        std::vector<float> out;
+        bool ok = pool.Run(
+            [&](Predictor* predictor) {
+              {
+                // a predictor is never handed to two threads at once
+                std::lock_guard<std::mutex> lock(mutex);
+                EXPECT_TRUE(busy.insert(predictor).second);
+                EXPECT_LE(busy.size(), 4UL);
+              }
+              bool ret = run(predictor, word, &out);
+              std::lock_guard<std::mutex> lock(mutex);
+              busy.erase(predictor);
+              return ret;
+            },
+            i % 2 == 0);
+        ASSERT_TRUE(ok);
+        ASSERT_EQ(out, expected[word]);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 TEST(Predictor, EnableONNXRuntime) {
   Config config;
   config.SetModel(FLAGS_dirname);
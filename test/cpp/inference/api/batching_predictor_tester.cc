@@ -0,0 +1,225 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <numeric>
+#include <random>
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "dirname to tests.");
+DEFINE_int32(batching_clients, 16, "number of the closed loop clients");
+DEFINE_int32(batching_requests, 200, "number of the requests of a client");
+DEFINE_int32(batching_max_batch_size, 32, "max batch size of the batching");
+DEFINE_int32(batching_max_wait_us, 500, "max wait time of the batching");
+DEFINE_int32(batching_pool_size, 1, "number of the batching predictors");
+
+namespace paddle_infer {
+
+using paddle::PaddleTensor;
+
+static Config GetConfig() {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(1);
+  return config;
+}
+
+// a request of the word2vec model, which has 4 inputs of [rows, 1] words
+static std::vector<PaddleTensor> MakeRequest(int rows, int seed) {
+  std::mt19937 rng(seed);
+  std::vector<PaddleTensor> inputs(4);
+  const char* names[] = {"firstw", "secondw", "thirdw", "forthw"};
+  for (int i = 0; i < 4; ++i) {
+    inputs[i].name = names[i];
+    inputs[i].shape = {rows, 1};
+    inputs[i].dtype = PaddleDType::INT64;
+    inputs[i].data.Resize(rows * sizeof(int64_t));
+    auto* data = static_cast<int64_t*>(inputs[i].data.data());
+    for (int j = 0; j < rows; ++j) {
+      data[j] = rng() % 2000;
+    }
+  }
+  return inputs;
+}
+
+// run a request on its own, as the services do without batching
+static void RunAlone(Predictor* predictor,
+                     const std::vector<PaddleTensor>& inputs,
+                     std::vector<float>* output) {
+  for (auto& input : inputs) {
+    auto tensor = predictor->GetInputHandle(input.name);
+    tensor->Reshape(input.shape);
+    tensor->CopyFromCpu(static_cast<const int64_t*>(input.data.data()));
+  }
+  ASSERT_TRUE(predictor->Run());
+  auto tensor = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  std::vector<int> shape = tensor->shape();
+  int numel =
+      std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>());
+  output->resize(numel);
+  tensor->CopyToCpu(output->data());
+}
+
+TEST(BatchingPredictor, SameAsPredictor) {
+  Config config = GetConfig();
+  auto predictor = CreatePredictor(config);
+  const int request_num = 64;
+  std::vector<std::vector<PaddleTensor>> requests;
+  std::vector<std::vector<float>> expected(request_num);
+  for (int i = 0; i < request_num; ++i) {
+    requests.push_back(MakeRequest(i % 3 + 1, i));
+    RunAlone(predictor.get(), requests[i], &expected[i]);
+  }
+
+  services::BatchingPredictor batching(config, 8, 1000, 2);
+  std::vector<std::vector<PaddleTensor>> outputs(request_num);
+  std::vector<std::thread> clients;
+  for (int t = 0; t < 8; ++t) {
+    clients.emplace_back([&, t] {
+      for (int i = t; i < request_num; i += 8) {
+        ASSERT_TRUE(batching.Run(requests[i], &outputs[i]));
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  for (int i = 0; i < request_num; ++i) {
+    ASSERT_EQ(outputs[i].size(), 1UL);
+    ASSERT_EQ(outputs[i][0].shape[0], i % 3 + 1);
+    ASSERT_EQ(outputs[i][0].data.length(), expected[i].size() * sizeof(float));
+    auto* data = static_cast<const float*>(outputs[i][0].data.data());
+    for (size_t j = 0; j < expected[i].size(); ++j) {
+      EXPECT_NEAR(data[j], expected[i][j], 1e-5);
+    }
+  }
+}
+
+TEST(BatchingPredictor, LoDThenBatch) {
+  Config config = GetConfig();
+  auto predictor = CreatePredictor(config);
+  const int request_num = 8;
+  std::vector<std::vector<PaddleTensor>> requests;
+  std::vector<std::vector<float>> expected(request_num);
+  for (int i = 0; i < request_num; ++i) {
+    requests.push_back(MakeRequest(1, i));
+    RunAlone(predictor.get(), requests[i], &expected[i]);
+  }
+
+  // one predictor, so the batches run on the inputs the lod request used
+  services::BatchingPredictor batching(config, request_num, 100000, 1);
+  auto lod_request = MakeRequest(3, request_num);
+  for (auto& input : lod_request) {
+    input.lod = {{0, 1, 3}};
+  }
+  std::vector<PaddleTensor> lod_outputs;
+  ASSERT_TRUE(batching.Run(lod_request, &lod_outputs));
+
+  std::vector<std::vector<PaddleTensor>> outputs(request_num);
+  std::vector<std::thread> clients;
+  for (int i = 0; i < request_num; ++i) {
+    clients.emplace_back(
+        [&, i] { ASSERT_TRUE(batching.Run(requests[i], &outputs[i])); });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  for (int i = 0; i < request_num; ++i) {
+    ASSERT_EQ(outputs[i].size(), 1UL);
+    ASSERT_EQ(outputs[i][0].shape[0], 1);
+    EXPECT_TRUE(outputs[i][0].lod.empty());
+    ASSERT_EQ(outputs[i][0].data.length(), expected[i].size() * sizeof(float));
+    auto* data = static_cast<const float*>(outputs[i][0].data.data());
+    for (size_t j = 0; j < expected[i].size(); ++j) {
+      EXPECT_NEAR(data[j], expected[i][j], 1e-5);
+    }
+  }
+}
+
+// Closed loop load of FLAGS_batching_clients clients, each of which sends a
+// request of one row once its last request is done, returns the requests per
+// second.
+template <typename RunFunc>
+static double RunClosedLoop(const char* name, RunFunc run) {
+  std::vector<std::vector<double>> latencies(FLAGS_batching_clients);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> clients;
+  for (int t = 0; t < FLAGS_batching_clients; ++t) {
+    clients.emplace_back([&, t] {
+      for (int i = 0; i < FLAGS_batching_requests; ++i) {
+        auto request = MakeRequest(1, t * FLAGS_batching_requests + i);
+        auto begin = std::chrono::steady_clock::now();
+        run(t, request);
+        latencies[t].push_back(std::chrono::duration<double, std::micro>(
+                                   std::chrono::steady_clock::now() - begin)
+                                   .count());
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  std::vector<double> all;
+  for (auto& client_latencies : latencies) {
+    all.insert(all.end(), client_latencies.begin(), client_latencies.end());
+  }
+  std::sort(all.begin(), all.end());
+  double qps = all.size() / seconds;
+  LOG(INFO) << name << ": " << qps << " requests/s, p50 latency "
+            << all[all.size() / 2] << " us, p99 latency "
+            << all[all.size() * 99 / 100] << " us";
+  return qps;
+}
+
+// Only logs timings, run it with --gtest_also_run_disabled_tests.
+TEST(BatchingPredictor, DISABLED_ClosedLoopBenchmark) {
+  Config config = GetConfig();
+  {
+    // one request per run, every client has its own predictor
+    services::PredictorPool pool(config, FLAGS_batching_clients);
+    RunClosedLoop("one request per run",
+                  [&pool](int client, const std::vector<PaddleTensor>& in) {
+                    std::vector<float> output;
+                    RunAlone(pool.Retrive(client), in, &output);
+                  });
+  }
+  {
+    services::BatchingPredictor batching(config,
+                                         FLAGS_batching_max_batch_size,
+                                         FLAGS_batching_max_wait_us,
+                                         FLAGS_batching_pool_size);
+    RunClosedLoop("batching",
+                  [&batching](int, const std::vector<PaddleTensor>& in) {
+                    std::vector<PaddleTensor> outputs;
+                    ASSERT_TRUE(batching.Run(in, &outputs));
+                  });
+  }
+}
+
+}  // namespace paddle_infer
@@ -0,0 +1,290 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/fluid/framework/new_executor/program_interpreter.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+USE_OP_ITSELF(elementwise_add);
+USE_OP_ITSELF(matmul_v2);
+USE_OP_ITSELF(tanh);
+
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(matmul, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(tanh, CPU, ALL_LAYOUT);
+
+DECLARE_bool(new_executor_critical_path_schedule);
+DECLARE_int32(new_executor_critical_path_profile_steps);
+
+namespace paddle {
+namespace framework {
+
+static void AppendOp(BlockDesc* block,
+                     const std::string& type,
+                     const std::vector<std::string>& inputs,
+                     const std::string& output) {
+  VarDesc* var = block->Var(output);
+  var->SetType(proto::VarType::LOD_TENSOR);
+  OpDesc* op = block->AppendOp();
+  op->SetType(type);
+  op->SetInput("X", {inputs[0]});
+  if (type != "tanh") {
+    op->SetInput("Y", {inputs[1]});
+  }
+  op->SetOutput("Out", {output});
+}
+
+// Many cheap branches come first in program order, the deep matmul chain
+// which decides the latency comes last.
+static ProgramDesc WideAndDeepProgram(int wide_num,
+                                      int deep_num,
+                                      std::vector<std::string>* outputs) {
+  ProgramDesc program;
+  BlockDesc* block = program.MutableBlock(0);
+  block->Var("x")->SetType(proto::VarType::LOD_TENSOR);
+  for (int i = 0; i < wide_num; ++i) {
+    std::string out = "wide_" + std::to_string(i);
+    AppendOp(block, "elementwise_add", {"x", "x"}, out);
+    outputs->push_back(out);
+  }
+  std::string last = "x";
+  for (int i = 0; i < deep_num; ++i) {
+    std::string mm = "deep_mm_" + std::to_string(i);
+    std::string act = "deep_act_" + std::to_string(i);
+    AppendOp(block, "matmul_v2", {last, "x"}, mm);
+    AppendOp(block, "tanh", {mm}, act);
+    last = act;
+  }
+  outputs->push_back(last);
+  return program;
+}
+
+// Chains of different length fanned out from the same input, the shortest
+// chains come first in program order.
+static ProgramDesc FanOutProgram(int chain_num,
+                                 std::vector<std::string>* outputs) {
+  ProgramDesc program;
+  BlockDesc* block = program.MutableBlock(0);
+  block->Var("x")->SetType(proto::VarType::LOD_TENSOR);
+  for (int i = 0; i < chain_num; ++i) {
+    std::string last = "x";
+    for (int j = 0; j <= i; ++j) {
+      std::string out = "chain_" + std::to_string(i) + "_" + std::to_string(j);
+      AppendOp(block, j % 2 == 0 ? "matmul_v2" : "tanh", {last, "x"}, out);
+      last = out;
+    }
+    outputs->push_back(last);
+  }
+  return program;
+}
+
+// Towers of the same depth joined by an add at the end.
+static ProgramDesc MultiTowerProgram(int tower_num,
+                                     int depth,
+                                     std::vector<std::string>* outputs) {
+  ProgramDesc program;
+  BlockDesc* block = program.MutableBlock(0);
+  block->Var("x")->SetType(proto::VarType::LOD_TENSOR);
+  std::vector<std::string> tower_outs;
+  for (int i = 0; i < tower_num; ++i) {
+    std::string last = "x";
+    for (int j = 0; j < depth; ++j) {
+      std::string out = "tower_" + std::to_string(i) + "_" + std::to_string(j);
+      AppendOp(block, j % 2 == 0 ? "matmul_v2" : "tanh", {last, "x"}, out);
+      last = out;
+    }
+    tower_outs.push_back(last);
+  }
+  std::string sum = tower_outs[0];
+  for (int i = 1; i < tower_num; ++i) {
+    std::string out = "tower_sum_" + std::to_string(i);
+    AppendOp(block, "elementwise_add", {sum, tower_outs[i]}, out);
+    sum = out;
+  }
+  outputs->push_back(sum);
+  return program;
+}
+
+static phi::DenseTensor MakeInput() {
+  constexpr int kDim = 128;
+  phi::DenseTensor x;
+  float* x_data = x.mutable_data<float>(phi::make_ddim({kDim, kDim}),
+                                        platform::CPUPlace());
+  for (int i = 0; i < kDim * kDim; ++i) {
+    x_data[i] = static_cast<float>(i % 17) / (17.0f * kDim);
+  }
+  return x;
+}
+
+// Builds the program with critical path scheduling on, checks the length of
+// the longest chain and the order the root ops are dispatched in. The ops
+// cost 1 each, since no run is profiled.
+static void CheckSchedule(const ProgramDesc& program,
+                          const std::vector<std::string>& outputs,
+                          double critical_path_length,
+                          const std::vector<size_t>& root_order) {
+  int profile_steps = FLAGS_new_executor_critical_path_profile_steps;
+  FLAGS_new_executor_critical_path_schedule = true;
+  FLAGS_new_executor_critical_path_profile_steps = 0;
+  interpreter::ExecutionConfig execution_config;
+  execution_config.skip_gc_vars =
+      std::set<std::string>(outputs.begin(), outputs.end());
+  Scope scope;
+  InterpreterCore core(
+      platform::CPUPlace(), program.Block(0), &scope, execution_config);
+  core.Run({"x"}, {MakeInput()});
+  core.Run({"x"}, {MakeInput()});
+  FLAGS_new_executor_critical_path_schedule = false;
+  FLAGS_new_executor_critical_path_profile_steps = profile_steps;
+
+  auto* interpreter = dynamic_cast<const ProgramInterpreter*>(core.Impl());
+  ASSERT_NE(interpreter, nullptr);
+  // one instruction per op, in program order
+  auto dependency_count = interpreter->GetDependencyCount();
+  ASSERT_EQ(dependency_count->size(), program.Block(0).OpSize());
+  const std::vector<double>& critical_path = interpreter->GetCriticalPath();
+  ASSERT_EQ(critical_path.size(), dependency_count->size());
+  EXPECT_DOUBLE_EQ(
+      *std::max_element(critical_path.begin(), critical_path.end()),
+      critical_path_length);
+
+  std::vector<size_t> roots;
+  for (size_t i = 0; i < dependency_count->size(); ++i) {
+    if ((*dependency_count)[i] == 0) {
+      roots.push_back(i);
+    }
+  }
+  interpreter->SortByCriticalPath(&roots);
+  ASSERT_GE(roots.size(), root_order.size());
+  for (size_t i = 0; i < root_order.size(); ++i) {
+    EXPECT_EQ(roots[i], root_order[i]) << "the " << i << "-th root";
+  }
+  for (size_t i = 1; i < roots.size(); ++i) {
+    EXPECT_GE(critical_path[roots[i - 1]], critical_path[roots[i]]);
+  }
+}
+
+// Runs the program with critical path scheduling off or on, returns the
+// outputs and the average latency of steps runs in *latency_us.
+static std::vector<float> RunProgram(const ProgramDesc& program,
+                                     const std::vector<std::string>& outputs,
+                                     bool critical_path_schedule,
+                                     int steps,
+                                     double* latency_us) {
+  constexpr int kWarmupSteps = 5;
+  phi::DenseTensor x = MakeInput();
+  interpreter::ExecutionConfig execution_config;
+  execution_config.skip_gc_vars =
+      std::set<std::string>(outputs.begin(), outputs.end());
+
+  FLAGS_new_executor_critical_path_schedule = critical_path_schedule;
+  Scope scope;
+  InterpreterCore core(
+      platform::CPUPlace(), program.Block(0), &scope, execution_config);
+  for (int i = 0; i < kWarmupSteps; ++i) {
+    core.Run({"x"}, {x});
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < steps; ++i) {
+    core.Run({"x"}, {x});
+  }
+  std::chrono::duration<double, std::micro> diff =
+      std::chrono::steady_clock::now() - start;
+  *latency_us = diff.count() / steps;
+  FLAGS_new_executor_critical_path_schedule = false;
+
+  std::vector<float> result;
+  Scope* local_scope = scope.kids().back();
+  for (const std::string& out : outputs) {
+    auto& tensor = local_scope->FindVar(out)->Get<phi::DenseTensor>();
+    result.insert(result.end(),
+                  tensor.data<float>(),
+                  tensor.data<float>() + tensor.numel());
+  }
+  return result;
+}
+
+// Checks the outputs are the same with critical path scheduling off and on,
+// and logs the average latency of both when steps is large enough to time.
+static void RunAndCompare(const std::string& name,
+                          const ProgramDesc& program,
+                          const std::vector<std::string>& outputs,
+                          int steps) {
+  double latency_us[2];
+  std::vector<float> expected =
+      RunProgram(program, outputs, false, steps, &latency_us[0]);
+  std::vector<float> result =
+      RunProgram(program, outputs, true, steps, &latency_us[1]);
+  LOG(INFO) << name << " avg latency " << latency_us[0]
+            << " us, with critical_path_schedule " << latency_us[1] << " us";
+
+  ASSERT_EQ(expected.size(), result.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_FLOAT_EQ(expected[i], result[i]);
+  }
+}
+
+TEST(CriticalPathSchedule, wide_and_deep) {
+  std::vector<std::string> outputs;
+  ProgramDesc program = WideAndDeepProgram(64, 16, &outputs);
+  // the deep chain of 16 matmul and tanh pairs starts at op 64
+  CheckSchedule(program, outputs, 32, {64});
+  RunAndCompare("wide_and_deep", program, outputs, 1);
+}
+
+TEST(CriticalPathSchedule, fan_out) {
+  std::vector<std::string> outputs;
+  ProgramDesc program = FanOutProgram(12, &outputs);
+  // chain i has i + 1 ops and starts at op i * (i + 1) / 2
+  std::vector<size_t> root_order;
+  for (size_t i = 12; i > 0; --i) {
+    root_order.push_back((i - 1) * i / 2);
+  }
+  CheckSchedule(program, outputs, 12, root_order);
+  RunAndCompare("fan_out", program, outputs, 1);
+}
+
+TEST(CriticalPathSchedule, multi_tower) {
+  std::vector<std::string> outputs;
+  ProgramDesc program = MultiTowerProgram(6, 10, &outputs);
+  // tower i starts at op 10 * i, the first two towers go through all the 5
+  // adds and tie, the later ones skip an add each
+  CheckSchedule(program, outputs, 15, {10, 0, 20, 30, 40, 50});
+  RunAndCompare("multi_tower", program, outputs, 1);
+}
+
+// Only logs timings, run it with --gtest_also_run_disabled_tests.
+TEST(CriticalPathSchedule, DISABLED_benchmark) {
+  constexpr int kSteps = 50;
+  std::vector<std::string> outputs;
+  RunAndCompare(
+      "wide_and_deep", WideAndDeepProgram(64, 16, &outputs), outputs, kSteps);
+  outputs.clear();
+  RunAndCompare("fan_out", FanOutProgram(12, &outputs), outputs, kSteps);
+  outputs.clear();
+  RunAndCompare(
+      "multi_tower", MultiTowerProgram(6, 10, &outputs), outputs, kSteps);
+}
+
+}  // namespace framework
+}  // namespace paddle
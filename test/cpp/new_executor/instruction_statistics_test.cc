@@ -0,0 +1,123 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/executor_statistics.h"
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+USE_OP_ITSELF(elementwise_add);
+USE_OP_ITSELF(matmul_v2);
+
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(matmul, CPU, ALL_LAYOUT);
+
+DECLARE_bool(new_executor_instruction_statistics);
+
+namespace paddle {
+namespace framework {
+
+TEST(InstructionStatistics, summarize) {
+  InstructionStatistics statistics({"matmul_v2", "tanh", "relu"});
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&statistics]() {
+      for (uint64_t i = 1; i <= 100; ++i) {
+        statistics.RecordReady(0);
+        statistics.Record(0, 0, i * 1000, 64);
+      }
+      statistics.Record(1, 1000, 3000, -16);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto summaries = statistics.Summarize();
+  ASSERT_EQ(summaries.size(), 3UL);
+  EXPECT_EQ(summaries[0].op_type, "matmul_v2");
+  EXPECT_EQ(summaries[0].count, 400UL);
+  EXPECT_DOUBLE_EQ(summaries[0].latency_mean_us, 50.5);
+  // the quantiles are accurate to a bucket, 25% of the value
+  EXPECT_NEAR(summaries[0].latency_p50_us, 50, 12.5);
+  EXPECT_NEAR(summaries[0].latency_p99_us, 99, 25);
+  EXPECT_EQ(summaries[0].queue_wait_count, 400UL);
+  EXPECT_EQ(summaries[0].allocated_bytes, 400 * 64);
+
+  EXPECT_EQ(summaries[1].count, 4UL);
+  EXPECT_DOUBLE_EQ(summaries[1].latency_mean_us, 2);
+  EXPECT_EQ(summaries[1].queue_wait_count, 0UL);
+  EXPECT_EQ(summaries[1].allocated_bytes, -64);
+
+  EXPECT_EQ(summaries[2].count, 0UL);
+
+  std::string json = InstructionStatisticsToJson();
+  EXPECT_NE(json.find("\"op\":\"matmul_v2\",\"count\":400"), std::string::npos);
+  EXPECT_EQ(json.find("\"relu\""), std::string::npos);
+  std::string prometheus = InstructionStatisticsToPrometheus();
+  EXPECT_NE(prometheus.find("# TYPE paddle_instruction_latency_seconds "
+                            "summary"),
+            std::string::npos);
+  EXPECT_NE(prometheus.find("instruction=\"0\",op=\"matmul_v2\"} 400"),
+            std::string::npos);
+}
+
+TEST(InstructionStatistics, interpreter) {
+  ProgramDesc program;
+  BlockDesc* block = program.MutableBlock(0);
+  block->Var("x")->SetType(proto::VarType::LOD_TENSOR);
+  for (const std::string& out : {"mm", "out"}) {
+    block->Var(out)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  OpDesc* matmul = block->AppendOp();
+  matmul->SetType("matmul_v2");
+  matmul->SetInput("X", {"x"});
+  matmul->SetInput("Y", {"x"});
+  matmul->SetOutput("Out", {"mm"});
+  OpDesc* add = block->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"mm"});
+  add->SetInput("Y", {"x"});
+  add->SetOutput("Out", {"out"});
+
+  const platform::CPUPlace place = platform::CPUPlace();
+  phi::DenseTensor x;
+  float* x_data = x.mutable_data<float>(phi::make_ddim({32, 32}), place);
+  for (int i = 0; i < 32 * 32; ++i) {
+    x_data[i] = 1.0f;
+  }
+
+  FLAGS_new_executor_instruction_statistics = true;
+  {
+    Scope scope;
+    InterpreterCore core(place, program.Block(0), &scope);
+    for (int i = 0; i < 5; ++i) {
+      core.Run({"x"}, {x});
+    }
+    std::string json = InstructionStatisticsToJson();
+    EXPECT_NE(json.find("\"op\":\"matmul_v2\""), std::string::npos) << json;
+    EXPECT_NE(json.find("\"op\":\"elementwise_add\""), std::string::npos)
+        << json;
+  }
+  FLAGS_new_executor_instruction_statistics = false;
+  EXPECT_EQ(InstructionStatisticsToJson(), "{\"interpreters\":[]}");
+}
+
+}  // namespace framework
+}  // namespace paddle
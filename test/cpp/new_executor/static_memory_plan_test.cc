@@ -0,0 +1,200 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/fluid/framework/new_executor/program_interpreter.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+USE_OP_ITSELF(elementwise_add);
+USE_OP_ITSELF(matmul_v2);
+USE_OP_ITSELF(tanh);
+
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(matmul, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(tanh, CPU, ALL_LAYOUT);
+
+DECLARE_bool(new_executor_static_memory_plan);
+
+namespace paddle {
+namespace framework {
+
+static void ExpectNoOverlap(
+    const interpreter::StaticMemoryPlan& plan,
+    const std::function<bool(size_t, size_t)>& conflict) {
+  for (size_t i = 0; i < plan.BufferNum(); ++i) {
+    EXPECT_EQ(plan.Offset(i) % interpreter::StaticMemoryPlan::kAlignment, 0UL);
+    EXPECT_LE(plan.Offset(i) + plan.Size(i), plan.ArenaBytes());
+    for (size_t j = i + 1; j < plan.BufferNum(); ++j) {
+      if (!conflict(i, j)) {
+        continue;
+      }
+      bool disjoint = plan.Offset(i) + plan.Size(i) <= plan.Offset(j) ||
+                      plan.Offset(j) + plan.Size(j) <= plan.Offset(i);
+      EXPECT_TRUE(disjoint) << "buffer " << i << " overlaps buffer " << j;
+    }
+  }
+}
+
+TEST(StaticMemoryPlan, chain) {
+  // buffer i is only alive with buffer i - 1 and i + 1
+  std::vector<size_t> sizes = {1000, 4000, 100, 4000, 1000, 64, 3000};
+  auto conflict = [](size_t i, size_t j) {
+    return (i > j ? i - j : j - i) <= 1;
+  };
+  interpreter::StaticMemoryPlan plan;
+  plan.Build(sizes, conflict);
+  ExpectNoOverlap(plan, conflict);
+  EXPECT_EQ(plan.BufferNum(), sizes.size());
+  EXPECT_EQ(plan.Size(2), interpreter::StaticMemoryPlan::AlignedSize(100));
+  EXPECT_LT(plan.ArenaBytes(), plan.NaiveBytes());
+  // the two largest buffers never live together
+  EXPECT_EQ(plan.Offset(1), plan.Offset(3));
+}
+
+TEST(StaticMemoryPlan, all_conflict) {
+  std::vector<size_t> sizes = {128, 1, 640, 64, 65};
+  auto conflict = [](size_t i, size_t j) { return true; };
+  interpreter::StaticMemoryPlan plan;
+  plan.Build(sizes, conflict);
+  ExpectNoOverlap(plan, conflict);
+  EXPECT_EQ(plan.ArenaBytes(), plan.NaiveBytes());
+}
+
+TEST(StaticMemoryPlan, fill_gap) {
+  // 0 and 1 conflict, 2 conflicts with 1 only and fits in the bytes of 0
+  std::vector<size_t> sizes = {1024, 1024, 512};
+  auto conflict = [](size_t i, size_t j) {
+    return (i == 1 || j == 1) && i != j;
+  };
+  interpreter::StaticMemoryPlan plan;
+  plan.Build(sizes, conflict);
+  ExpectNoOverlap(plan, conflict);
+  EXPECT_EQ(plan.ArenaBytes(), 2048UL);
+}
+
+// Towers of tanh and matmul joined by an add at the end, the intermediate
+// results of a tower die early and their buffers can be reused.
+static ProgramDesc TowerProgram(int tower_num,
+                                int depth,
+                                std::string* output) {
+  ProgramDesc program;
+  BlockDesc* block = program.MutableBlock(0);
+  block->Var("x")->SetType(proto::VarType::LOD_TENSOR);
+  auto append_op = [block](const std::string& type,
+                           const std::vector<std::string>& inputs,
+                           const std::string& output) {
+    block->Var(output)->SetType(proto::VarType::LOD_TENSOR);
+    OpDesc* op = block->AppendOp();
+    op->SetType(type);
+    op->SetInput("X", {inputs[0]});
+    if (type != "tanh") {
+      op->SetInput("Y", {inputs[1]});
+    }
+    op->SetOutput("Out", {output});
+  };
+  std::string sum;
+  for (int i = 0; i < tower_num; ++i) {
+    std::string last = "x";
+    for (int j = 0; j < depth; ++j) {
+      std::string out = "tower_" + std::to_string(i) + "_" + std::to_string(j);
+      append_op(j % 2 == 0 ? "matmul_v2" : "tanh", {last, "x"}, out);
+      last = out;
+    }
+    if (i == 0) {
+      sum = last;
+    } else {
+      std::string out = "tower_sum_" + std::to_string(i);
+      append_op("elementwise_add", {sum, last}, out);
+      sum = out;
+    }
+  }
+  *output = sum;
+  return program;
+}
+
+// Runs the tower program, *planned tells whether it ends with a static memory
+// plan, which is copied to *plan.
+static std::vector<float> RunTowerProgram(int dim,
+                                          int steps,
+                                          bool* planned,
+                                          interpreter::StaticMemoryPlan* plan) {
+  const platform::CPUPlace place = platform::CPUPlace();
+  std::string output;
+  ProgramDesc program = TowerProgram(4, 6, &output);
+
+  phi::DenseTensor x;
+  float* x_data = x.mutable_data<float>(phi::make_ddim({dim, dim}), place);
+  for (int i = 0; i < dim * dim; ++i) {
+    x_data[i] = static_cast<float>(i % 13) / (13.0f * dim);
+  }
+
+  interpreter::ExecutionConfig execution_config;
+  execution_config.skip_gc_vars = {output};
+  Scope scope;
+  InterpreterCore core(place, program.Block(0), &scope, execution_config);
+  for (int i = 0; i < steps; ++i) {
+    core.Run({"x"}, {x});
+  }
+  auto* program_interpreter =
+      dynamic_cast<const ProgramInterpreter*>(core.Impl());
+  EXPECT_NE(program_interpreter, nullptr);
+  const interpreter::StaticMemoryPlan* core_plan =
+      program_interpreter == nullptr
+          ? nullptr
+          : program_interpreter->GetStaticMemoryPlan();
+  *planned = core_plan != nullptr;
+  if (core_plan != nullptr) {
+    *plan = *core_plan;
+  }
+  auto& tensor =
+      scope.kids().back()->FindVar(output)->Get<phi::DenseTensor>();
+  return std::vector<float>(tensor.data<float>(),
+                            tensor.data<float>() + tensor.numel());
+}
+
+TEST(StaticMemoryPlan, same_result) {
+  bool planned = false;
+  interpreter::StaticMemoryPlan plan;
+  FLAGS_new_executor_static_memory_plan = false;
+  std::vector<float> expected = RunTowerProgram(64, 4, &planned, &plan);
+  EXPECT_FALSE(planned);
+  FLAGS_new_executor_static_memory_plan = true;
+  // the first run builds the interpreter, the second one profiles the
+  // buffers and the others run with the planned buffers
+  std::vector<float> result = RunTowerProgram(64, 4, &planned, &plan);
+  FLAGS_new_executor_static_memory_plan = false;
+
+  // the plan is dropped once a var leaves its buffer, so it is still there
+  // only if the last runs used it. The outputs of the 4 towers of 6 ops are
+  // planned at least, and the towers reuse buffers.
+  ASSERT_TRUE(planned);
+  EXPECT_GE(plan.BufferNum(), 24UL);
+  EXPECT_LT(plan.ArenaBytes(), plan.NaiveBytes());
+
+  ASSERT_EQ(expected.size(), result.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_FLOAT_EQ(expected[i], result[i]);
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,214 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/phi/core/flags.h"
+#include "paddle/phi/core/parallel_for.h"
+
+PHI_DECLARE_bool(enable_intra_op_parallel);
+
+namespace phi {
+namespace tests {
+
+// A pool of plain threads, the thread creating it plays the worker calling
+// ParallelFor.
+class FakeIntraOpThreadPool : public IntraOpThreadPool {
+ public:
+  explicit FakeIntraOpThreadPool(int num_threads) : num_threads_(num_threads) {
+    for (int i = 1; i < num_threads; ++i) {
+      threads_.emplace_back([this] { Loop(); });
+    }
+  }
+
+  ~FakeIntraOpThreadPool() override {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      done_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  int NumThreads() const override { return num_threads_; }
+
+  void Schedule(std::function<void()> fn) override {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      tasks_.push_back(std::move(fn));
+    }
+    ++scheduled_;
+    cv_.notify_one();
+  }
+
+  int Scheduled() const { return scheduled_.load(); }
+
+ private:
+  void Loop() {
+    SetIntraOpThreadPool(this);
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return done_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  int num_threads_;
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool done_{false};
+  std::atomic<int> scheduled_{0};
+};
+
+class ParallelForTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FLAGS_enable_intra_op_parallel = true;
+    pool_ = std::make_unique<FakeIntraOpThreadPool>(4);
+    SetIntraOpThreadPool(pool_.get());
+  }
+
+  void TearDown() override {
+    SetIntraOpThreadPool(nullptr);
+    pool_.reset();
+    FLAGS_enable_intra_op_parallel = false;
+  }
+
+  std::unique_ptr<FakeIntraOpThreadPool> pool_;
+};
+
+TEST_F(ParallelForTest, cover_range) {
+  EXPECT_EQ(GetIntraOpParallelism(), 4);
+  for (int64_t num : {0, 1, 7, 100, 1000, 12345}) {
+    std::vector<std::atomic<int>> visited(num);
+    ParallelFor(3, num + 3, 10, [&](int64_t begin, int64_t end) {
+      EXPECT_LT(begin, end);
+      for (int64_t i = begin; i < end; ++i) {
+        ++visited[i - 3];
+      }
+    });
+    for (int64_t i = 0; i < num; ++i) {
+      ASSERT_EQ(visited[i].load(), 1);
+    }
+  }
+  EXPECT_GT(pool_->Scheduled(), 0);
+}
+
+TEST_F(ParallelForTest, small_range_in_caller) {
+  std::thread::id caller = std::this_thread::get_id();
+  ParallelFor(0, 100, 1000, [&](int64_t begin, int64_t end) {
+    EXPECT_EQ(begin, 0);
+    EXPECT_EQ(end, 100);
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+  });
+  EXPECT_EQ(pool_->Scheduled(), 0);
+}
+
+TEST_F(ParallelForTest, nested) {
+  std::atomic<int64_t> sum{0};
+  ParallelFor(0, 16, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      ParallelFor(0, 1000, 10, [&](int64_t inner_begin, int64_t inner_end) {
+        sum += inner_end - inner_begin;
+      });
+    }
+  });
+  EXPECT_EQ(sum.load(), 16 * 1000);
+}
+
+TEST_F(ParallelForTest, exception) {
+  EXPECT_ANY_THROW(ParallelFor(0, 1000, 1, [](int64_t begin, int64_t end) {
+    if (begin <= 500 && 500 < end) {
+      throw std::runtime_error("error in chunk");
+    }
+  }));
+  // the pool is still usable
+  std::atomic<int64_t> count{0};
+  ParallelFor(0, 1000, 1, [&](int64_t begin, int64_t end) {
+    count += end - begin;
+  });
+  EXPECT_EQ(count.load(), 1000);
+}
+
+TEST_F(ParallelForTest, reduce_deterministic) {
+  std::vector<float> data(100003);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = 1.0f / static_cast<float>(i % 1000 + 1);
+  }
+  auto partial_sum = [&](int64_t begin, int64_t end, float ident) {
+    float sum = ident;
+    for (int64_t i = begin; i < end; ++i) {
+      sum += data[i];
+    }
+    return sum;
+  };
+  auto add = [](float a, float b) { return a + b; };
+
+  float parallel =
+      ParallelReduce<float>(0, data.size(), 1000, 0.0f, partial_sum, add);
+  FLAGS_enable_intra_op_parallel = false;
+  EXPECT_EQ(GetIntraOpParallelism(), 1);
+  float serial =
+      ParallelReduce<float>(0, data.size(), 1000, 0.0f, partial_sum, add);
+  // bitwise equal, the chunks do not depend on the number of threads
+  EXPECT_EQ(parallel, serial);
+  EXPECT_NEAR(parallel, partial_sum(0, data.size(), 0.0f), 1e-2);
+
+  bool any = ParallelReduce<bool>(
+      0,
+      data.size(),
+      1000,
+      false,
+      [&](int64_t begin, int64_t end, bool ident) {
+        return ident || (begin <= 77777 && 77777 < end);
+      },
+      [](bool a, bool b) { return a || b; });
+  EXPECT_TRUE(any);
+}
+
+TEST(ParallelFor, without_pool) {
+  FLAGS_enable_intra_op_parallel = true;
+  EXPECT_EQ(GetIntraOpThreadPool(), nullptr);
+  EXPECT_EQ(GetIntraOpParallelism(), 1);
+  int calls = 0;
+  ParallelFor(0, 100000, 1, [&](int64_t begin, int64_t end) {
+    EXPECT_EQ(begin, 0);
+    EXPECT_EQ(end, 100000);
+    ++calls;
+  });
+  EXPECT_EQ(calls, 1);
+  FLAGS_enable_intra_op_parallel = false;
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,71 @@
+# Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import json
+import unittest
+
+import numpy as np
+
+import paddle
+from paddle import static
+from paddle.fluid import core
+
+paddle.enable_static()
+
+
+class TestInstructionStatistics(unittest.TestCase):
+    def setUp(self):
+        paddle.framework.set_flags(
+            {'FLAGS_new_executor_instruction_statistics': True}
+        )
+
+    def tearDown(self):
+        paddle.framework.set_flags(
+            {'FLAGS_new_executor_instruction_statistics': False}
+        )
+
+    def test_dump(self):
+        main_program = static.Program()
+        startup_program = static.Program()
+        with static.program_guard(main_program, startup_program):
+            x = static.data(name='x', shape=[4, 8], dtype='float32')
+            out = paddle.nn.functional.relu(paddle.matmul(x, x, False, True))
+
+        exe = static.Executor(paddle.CPUPlace())
+        exe.run(startup_program)
+        feed = {'x': np.random.random([4, 8]).astype('float32')}
+        for _ in range(3):
+            exe.run(main_program, feed=feed, fetch_list=[out])
+
+        stats = json.loads(core.instruction_statistics_to_json())
+        # the op is named relu or pd_op.relu depending on the interpreter
+        relu = [
+            instr
+            for interpreter in stats['interpreters']
+            for instr in interpreter['instructions']
+            if instr['op'].endswith('relu')
+        ]
+        self.assertGreater(len(relu), 0)
+        self.assertGreaterEqual(relu[0]['count'], 1)
+        self.assertGreaterEqual(
+            relu[0]['latency_us']['p99'], relu[0]['latency_us']['p50']
+        )
+
+        text = core.instruction_statistics_to_prometheus()
+        self.assertIn('# TYPE paddle_instruction_latency_seconds summary', text)
+        self.assertIn('relu"', text)
+
+
+if __name__ == '__main__':
+    unittest.main()